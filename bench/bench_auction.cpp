@@ -0,0 +1,68 @@
+// Call auction cost on a large crossed book: one indicative computation (what
+// is published after every order during the call) and the full uncross.
+//
+// g++ -O2 -std=c++17 -I./include bench/bench_auction.cpp src/order_book.cpp src/matching_engine.cpp -o bench_auction
+// ./bench_auction [orders] [price_levels]
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "matching_engine.hpp"
+
+using namespace ex;
+using Clock = std::chrono::steady_clock;
+
+static double msSince(Clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+int main(int argc, char** argv) {
+    const uint64_t num_orders = argc > 1 ? std::stoull(argv[1]) : 2000000;
+    const uint64_t num_levels = argc > 2 ? std::stoull(argv[2]) : 10000;
+
+    MatchingEngine engine(num_orders);
+    std::vector<EnvelopeOut> events;
+    OrderBook& b = engine.book("AAPL");
+    engine.startAuction(b, events);
+
+    // Both sides spread over the same price range, so about half of each side
+    // crosses. Orders are restored straight into the book, sorted the way
+    // restore expects, so building it does not publish an indicative per order.
+    auto t0 = Clock::now();
+    std::vector<RestingOrder> orders(num_orders);
+    uint64_t seed = 42;
+    for (uint64_t i = 0; i < num_orders; ++i) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        RestingOrder& r = orders[i];
+        r.order_id = i + 1;
+        r.price = 10000 + static_cast<Price>((seed >> 40) % num_levels);
+        r.qty = 1 + static_cast<Qty>((seed >> 20) % 100);
+        r.client_id = static_cast<ClientId>(i % 100);
+        r.side = (seed >> 33) & 1 ? Side::Buy : Side::Sell;
+    }
+    std::stable_sort(orders.begin(), orders.end(), [](const RestingOrder& a, const RestingOrder& b) {
+        return a.side != b.side ? a.side < b.side : a.price < b.price;
+    });
+    for (const RestingOrder& r : orders) engine.restore(b, r);
+    std::cout << "Built " << engine.restingCount() << " orders over " << num_levels
+              << " levels in " << msSince(t0) << " ms" << std::endl;
+
+    AuctionInfo info;
+    const int reps = 100;
+    t0 = Clock::now();
+    for (int i = 0; i < reps; ++i) engine.indicative(b, info);
+    std::cout << "Indicative: " << info.qty << " @ " << info.price << " (imbalance "
+              << info.imbalance << ") in " << msSince(t0) * 1000 / reps << " us" << std::endl;
+
+    events.clear();
+    events.reserve(num_orders * 2);
+    t0 = Clock::now();
+    const Qty executed = engine.uncross(b, events);
+    const double ms = msSince(t0);
+    std::cout << "Uncross: " << executed << " executed, " << events.size() << " events in "
+              << ms << " ms (" << ms * 1e6 / (events.size() ? events.size() : 1)
+              << " ns/event), " << engine.restingCount() << " left" << std::endl;
+    return 0;
+}
@@ -0,0 +1,93 @@
+// Multipart batching at batch sizes 1..256.
+//
+// Ingress: a PUSH client sends orders as multipart messages of B parts to a
+// real InputStream, which splits them onto the raw queue with one lock per
+// batch; a consumer thread stands in for the parse workers.
+// Egress: responses sent as multipart messages of B parts, as the matching
+// thread's Egress coalesces them, to a PULL receiver reading part by part.
+//
+// g++ -O2 -std=c++17 -I./include -I./include/lib/zmq bench/bench_batch.cpp src/input_stream.cpp src/shm_gateway.cpp -lzmq -lpthread -o bench_batch
+// ./bench_batch [messages]
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <zmq.hpp>
+#include "input_stream.hpp"
+
+using namespace ex;
+using Clock = std::chrono::steady_clock;
+
+static const std::string kOrder =
+    "{\"header\":{\"version\":1,\"type\":1,\"seq\":1,\"client_id\":7},\"body\":{\"client_order_id\":999,"
+    "\"symbol\":\"AAPL\",\"side\":\"B\",\"ord_type\":\"LMT\",\"qty\":10,\"limit_price\":10123}}";
+static const std::string kAck =
+    "{\"body\":{\"client_order_id\":999,\"order_id\":123456,\"symbol\":\"AAPL\"},"
+    "\"header\":{\"client_id\":7,\"seq\":1,\"type\":100,\"version\":1}}";
+
+static void sendBatched(zmq::socket_t& s, const std::string& msg, uint64_t n, size_t batch) {
+    for (uint64_t sent = 0; sent < n;) {
+        const uint64_t parts = std::min<uint64_t>(batch, n - sent);
+        for (uint64_t p = 0; p < parts; ++p) {
+            s.send(zmq::buffer(msg), p + 1 < parts ? zmq::send_flags::sndmore : zmq::send_flags::none);
+        }
+        sent += parts;
+    }
+}
+
+int main(int argc, char** argv) {
+    const uint64_t n = argc > 1 ? std::stoull(argv[1]) : 1000000;
+    const size_t batches[] = {1, 2, 4, 8, 16, 32, 64, 128, 256};
+
+    zmq::context_t context(1);
+    ThreadSafeQueue<InboundMessage> raw_queue(65536, OverflowPolicy::Block);
+    Sequencer sequencer(&raw_queue);
+    InputStream input(&sequencer, context, "tcp://127.0.0.1:15570");
+    std::thread(&InputStream::startListening, &input).detach();
+
+    std::atomic<uint64_t> consumed{0};
+    std::thread consumer([&] {
+        for (;;) {
+            if (raw_queue.pop().payload.empty()) return;
+            consumed.fetch_add(1, std::memory_order_release);
+        }
+    });
+
+    zmq::socket_t client(context, zmq::socket_type::push);
+    client.set(zmq::sockopt::sndhwm, 100000);
+    client.connect("tcp://127.0.0.1:15570");
+
+    zmq::socket_t egress_in(context, zmq::socket_type::pull);
+    egress_in.set(zmq::sockopt::rcvhwm, 100000);
+    egress_in.bind("tcp://127.0.0.1:15571");
+    zmq::socket_t egress_out(context, zmq::socket_type::push);
+    egress_out.set(zmq::sockopt::sndhwm, 100000);
+    egress_out.connect("tcp://127.0.0.1:15571");
+
+    std::cout << n << " messages per run\nbatch\tingress msgs/s\tegress msgs/s\n";
+    for (size_t b : batches) {
+        const uint64_t base = consumed.load();
+        auto t0 = Clock::now();
+        sendBatched(client, kOrder, n, b);
+        while (consumed.load(std::memory_order_acquire) - base < n) std::this_thread::yield();
+        const double in_secs = std::chrono::duration<double>(Clock::now() - t0).count();
+
+        t0 = Clock::now();
+        std::thread sender([&] { sendBatched(egress_out, kAck, n, b); });
+        zmq::message_t part;
+        for (uint64_t i = 0; i < n; ++i) (void)egress_in.recv(part, zmq::recv_flags::none);
+        sender.join();
+        const double out_secs = std::chrono::duration<double>(Clock::now() - t0).count();
+
+        std::cout << b << "\t" << static_cast<uint64_t>(n / in_secs) << "\t\t"
+                  << static_cast<uint64_t>(n / out_secs) << std::endl;
+    }
+
+    raw_queue.push(InboundMessage());
+    consumer.join();
+    std::_Exit(0); // the listener thread owns its socket until the process ends
+}
@@ -0,0 +1,121 @@
+// Outbound path with W parse workers (default 8) each sending M responses:
+// "socket" gives every worker its own PUSH socket, as before the egress
+// thread; "stage" hands them to EgressStage over its lock-free queues. Both
+// deliver to one PULL receiver over loopback tcp. Reports the rate the
+// workers get through their sends (what the parse threads pay), the rate
+// the receiver sees, and responses that arrived out of order for their
+// worker.
+//
+// g++ -O2 -std=c++17 -I./include -I./include/lib/zmq bench/bench_egress.cpp src/egress_stage.cpp src/shm_gateway.cpp src/tcp_gateway.cpp -lzmq -lpthread -o bench_egress
+// ./bench_egress [workers] [responses_per_worker]
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <zmq.hpp>
+#include "egress_stage.hpp"
+#include "net/codec_json.hpp"
+
+using namespace ex;
+using Clock = std::chrono::steady_clock;
+
+static const char* kEndpoint = "tcp://127.0.0.1:15580";
+
+// A parse reject, the largest thing a worker sends
+static std::string response(ClientId worker, uint64_t seq) {
+    return "{\"body\":{\"client_order_id\":" + std::to_string(seq) +
+           ",\"info\":{\"code\":4,\"reason\":\"Exchange overloaded\"},\"symbol\":\"AAPL\"},"
+           "\"header\":{\"client_id\":" + std::to_string(worker) + ",\"seq\":" + std::to_string(seq) +
+           ",\"type\":101,\"version\":1}}";
+}
+
+struct Result {
+    double worker_secs;
+    double total_secs;
+    uint64_t out_of_order;
+};
+
+template <class Send>
+static Result run(zmq::socket_t& receiver, size_t workers, uint64_t per_worker, Send&& send) {
+    const uint64_t total = workers * per_worker;
+    std::vector<uint64_t> last(workers + 1, 0);
+    uint64_t out_of_order = 0;
+    std::atomic<size_t> finished{0};
+    Clock::time_point workers_done;
+
+    const auto t0 = Clock::now();
+    std::vector<std::thread> threads;
+    for (size_t w = 1; w <= workers; ++w) {
+        threads.emplace_back([&, w] {
+            for (uint64_t i = 1; i <= per_worker; ++i) send(w, response(static_cast<ClientId>(w), i));
+            if (finished.fetch_add(1) + 1 == workers) workers_done = Clock::now();
+        });
+    }
+
+    zmq::message_t part;
+    for (uint64_t n = 0; n < total; ++n) {
+        (void)receiver.recv(part, zmq::recv_flags::none);
+        ClientId w = 0;
+        SeqNum seq = 0;
+        scan_client_id(static_cast<const char*>(part.data()), part.size(), w);
+        scan_seq(static_cast<const char*>(part.data()), part.size(), seq);
+        if (w == 0 || w > workers || seq != last[w] + 1) ++out_of_order;
+        else last[w] = seq;
+    }
+    const auto t1 = Clock::now();
+    for (auto& t : threads) t.join();
+
+    return Result{ std::chrono::duration<double>(workers_done - t0).count(),
+                   std::chrono::duration<double>(t1 - t0).count(), out_of_order };
+}
+
+static void report(const char* name, const Result& r, uint64_t total, size_t sockets) {
+    std::cout << name << " (" << sockets << " sockets):\tworkers " << static_cast<uint64_t>(total / r.worker_secs)
+              << " msgs/s, delivered " << static_cast<uint64_t>(total / r.total_secs)
+              << " msgs/s, out of order " << r.out_of_order << std::endl;
+}
+
+int main(int argc, char** argv) {
+    const size_t workers = argc > 1 ? std::stoul(argv[1]) : 8;
+    const uint64_t per_worker = argc > 2 ? std::stoull(argv[2]) : 100000;
+    const uint64_t total = workers * per_worker;
+
+    zmq::context_t context(2);
+    zmq::socket_t receiver(context, zmq::socket_type::pull);
+    receiver.set(zmq::sockopt::rcvhwm, 0);
+    receiver.bind(kEndpoint);
+
+    {
+        std::vector<zmq::socket_t> sockets;
+        for (size_t w = 0; w < workers; ++w) {
+            sockets.emplace_back(context, zmq::socket_type::push);
+            sockets.back().set(zmq::sockopt::sndhwm, 0);
+            sockets.back().connect(kEndpoint);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(200)); // let every socket connect
+        const Result r = run(receiver, workers, per_worker, [&](size_t w, std::string msg) {
+            sockets[w - 1].send(zmq::buffer(msg), zmq::send_flags::none);
+        });
+        report("socket per worker", r, total, workers);
+    }
+
+    {
+        EgressStage stage(context, kEndpoint);
+        std::vector<EgressStage::Producer*> producers;
+        for (size_t w = 0; w < workers; ++w) producers.push_back(stage.addProducer());
+        stage.start();
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        const Result r = run(receiver, workers, per_worker, [&](size_t w, std::string msg) {
+            producers[w - 1]->send(static_cast<ClientId>(w), std::move(msg));
+        });
+        stage.stop();
+        report("egress stage", r, total, 1);
+        const EgressCounters c = stage.counters();
+        std::cout << "  " << c.batches << " batches (" << (c.batches ? c.sent / c.batches : 0)
+                  << " per batch), " << c.producer_waits << " producer waits" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,67 @@
+// End-of-session sweep on a large book where only a fraction of the orders
+// expire: Day orders plus GTD orders dated today, the rest GTC or GTD later.
+//
+// g++ -O2 -std=c++17 -I./include bench/bench_expiry.cpp src/order_book.cpp src/matching_engine.cpp -o bench_expiry
+// ./bench_expiry [resting_orders] [expiring_percent] [batch]
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "matching_engine.hpp"
+
+using namespace ex;
+using Clock = std::chrono::steady_clock;
+
+static const uint32_t kToday = 20261019;
+
+int main(int argc, char** argv) {
+    const uint64_t num_orders = argc > 1 ? std::stoull(argv[1]) : 2000000;
+    const uint64_t expiring_pct = argc > 2 ? std::stoull(argv[2]) : 10;
+    const size_t batch = argc > 3 ? std::stoull(argv[3]) : 4096;
+
+    MatchingEngine engine(num_orders);
+    std::vector<EnvelopeOut> events;
+    for (uint64_t i = 1; i <= num_orders; ++i) {
+        const bool buy = i % 2 == 0;
+        const double px = buy ? 9000 + (i * 7) % 500 : 10000 + (i * 13) % 500;
+        Order o(i, i, i, "SYM" + std::to_string(i % 100), buy ? Side::Buy : Side::Sell,
+                MsgType::NewOrder, px, 100);
+        o.client_id = static_cast<ClientId>(i % 10);
+        const uint64_t bucket = i % 100;
+        if (bucket < expiring_pct / 2) {
+            o.tif = TimeInForce::Day;
+        } else if (bucket < expiring_pct) {
+            o.tif = TimeInForce::GTD;
+            o.expire_date = kToday;
+        } else if (bucket < 50) {
+            o.tif = TimeInForce::GTD;
+            o.expire_date = kToday + 1 + static_cast<uint32_t>(i % 20);
+        } else {
+            o.tif = TimeInForce::GTC;
+        }
+        engine.process(o, events);
+    }
+    events.clear();
+    std::cout << "Resting: " << engine.restingCount() << " orders, ~" << expiring_pct
+              << "% expiring" << std::endl;
+
+    size_t expired = 0, batches = 0, bytes = 0;
+    double encode_ms = 0;
+    auto t0 = Clock::now();
+    while (size_t n = engine.expire(kToday, batch, events)) {
+        expired += n;
+        batches++;
+        auto e0 = Clock::now();
+        for (const auto& e : events) bytes += dump_envelope(e).size();
+        encode_ms += std::chrono::duration<double, std::milli>(Clock::now() - e0).count();
+        events.clear();
+    }
+    const double total_ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+    const double engine_ms = total_ms - encode_ms;
+    std::cout << "Expired " << expired << " in " << batches << " batches: engine " << engine_ms
+              << " ms (" << engine_ms * 1e6 / (expired ? expired : 1) << " ns/order) | encode "
+              << encode_ms << " ms (" << bytes / 1024 << " KB) | " << engine.restingCount()
+              << " left" << std::endl;
+    return 0;
+}
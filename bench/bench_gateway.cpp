@@ -0,0 +1,188 @@
+// Connection scaling of the epoll TCP gateway: N sessions on loopback, each
+// keeping one framed order in flight, answered by a stand-in matching thread
+// that acks every frame back through TcpGateway::send. Reports acked orders
+// per second and round-trip percentiles per session count.
+//
+// g++ -O2 -std=c++17 -I./include bench/bench_gateway.cpp src/tcp_gateway.cpp -lpthread -o bench_gateway
+// ./bench_gateway [seconds_per_run] [sessions...]     (default 2s: 100 1000 10000)
+//
+// Every session costs two descriptors in this process; raise `ulimit -n`
+// past 2N for the largest run.
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "tcp_gateway.hpp"
+#include "net/codec_json.hpp"
+
+using namespace ex;
+using Clock = std::chrono::steady_clock;
+
+struct Conn {
+    int fd = -1;
+    ClientId client_id = 0;
+    SeqNum seq = 0;
+    Clock::time_point sent_at;
+    std::string in;
+};
+
+static std::string frame(const std::string& msg) {
+    const uint32_t be = htonl(static_cast<uint32_t>(msg.size()));
+    std::string f(reinterpret_cast<const char*>(&be), 4);
+    return f + msg;
+}
+
+static std::string order(ClientId client_id, SeqNum seq) {
+    return "{\"header\":{\"version\":1,\"type\":1,\"seq\":" + std::to_string(seq) +
+           ",\"client_id\":" + std::to_string(client_id) +
+           "},\"body\":{\"client_order_id\":" + std::to_string(seq) +
+           ",\"symbol\":\"AAPL\",\"side\":\"B\",\"ord_type\":\"LMT\",\"qty\":10,\"limit_price\":10123}}";
+}
+
+static void sendNext(Conn& c) {
+    const std::string f = frame(order(c.client_id, ++c.seq));
+    c.sent_at = Clock::now();
+    // Tiny frames on an idle socket: the kernel takes them whole
+    if (::send(c.fd, f.data(), f.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(f.size())) {
+        std::cerr << "short send on session " << c.client_id << std::endl;
+    }
+}
+
+static void run(uint16_t port, size_t sessions, ClientId first_id, double seconds) {
+    std::vector<Conn> conns;
+    conns.reserve(sessions);
+    for (size_t i = 0; i < sessions; ++i) {
+        const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            std::cerr << "connected " << i << " of " << sessions << ": " << std::strerror(errno) << std::endl;
+            if (fd >= 0) ::close(fd);
+            break;
+        }
+        const int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        Conn c;
+        c.fd = fd;
+        c.client_id = first_id + static_cast<ClientId>(i);
+        conns.push_back(std::move(c));
+    }
+
+    const int ep = ::epoll_create1(0);
+    for (Conn& c : conns) {
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.ptr = &c;
+        ::epoll_ctl(ep, EPOLL_CTL_ADD, c.fd, &ev);
+        sendNext(c);
+    }
+
+    std::vector<uint64_t> lat;
+    lat.reserve(4 << 20);
+    const auto start = Clock::now();
+    const auto end = start + std::chrono::duration<double>(seconds);
+    epoll_event events[512];
+    char buf[64 * 1024];
+    while (Clock::now() < end) {
+        const int n = ::epoll_wait(ep, events, 512, 10);
+        for (int i = 0; i < n; ++i) {
+            Conn& c = *static_cast<Conn*>(events[i].data.ptr);
+            const ssize_t got = ::recv(c.fd, buf, sizeof(buf), 0);
+            if (got <= 0) continue;
+            c.in.append(buf, static_cast<size_t>(got));
+            size_t pos = 0, acks = 0;
+            while (c.in.size() - pos >= 4) {
+                uint32_t be;
+                std::memcpy(&be, c.in.data() + pos, 4);
+                const uint32_t len = ntohl(be);
+                if (c.in.size() - pos - 4 < len) break;
+                pos += 4 + len;
+                ++acks;
+            }
+            c.in.erase(0, pos);
+            if (acks) {
+                lat.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - c.sent_at).count());
+                sendNext(c);
+            }
+        }
+    }
+    const double secs = std::chrono::duration<double>(Clock::now() - start).count();
+
+    for (Conn& c : conns) ::close(c.fd);
+    ::close(ep);
+
+    std::sort(lat.begin(), lat.end());
+    std::cout << conns.size() << " sessions:\t" << static_cast<uint64_t>(lat.size() / secs) << " orders/s";
+    if (!lat.empty()) {
+        std::cout << ", round trip p50 " << lat[lat.size() / 2] / 1000 << " us, p99 "
+                  << lat[lat.size() * 99 / 100] / 1000 << " us";
+    }
+    std::cout << std::endl;
+}
+
+int main(int argc, char** argv) {
+    const double seconds = argc > 1 ? std::stod(argv[1]) : 2.0;
+    std::vector<size_t> counts;
+    for (int i = 2; i < argc; ++i) counts.push_back(std::stoul(argv[i]));
+    if (counts.empty()) counts = {100, 1000, 10000};
+
+    rlimit rl{};
+    ::getrlimit(RLIMIT_NOFILE, &rl);
+    rl.rlim_cur = rl.rlim_max;
+    ::setrlimit(RLIMIT_NOFILE, &rl);
+
+    ThreadSafeQueue<InboundMessage> raw_queue(65536, OverflowPolicy::Block);
+    Sequencer sequencer(&raw_queue);
+    TcpGatewayConfig config;
+    config.port = 15557;
+    config.io_threads = 2;
+    TcpGateway gateway(&sequencer, config);
+    if (!gateway.start()) return 1;
+
+    // Stands in for parse + match: one ack per order, sent from another
+    // thread as the matching thread does
+    std::thread matcher([&] {
+        for (;;) {
+            const std::string raw = raw_queue.pop().payload;
+            if (raw.empty()) return;
+            ClientId client_id = 0;
+            SeqNum seq = 0;
+            scan_client_id(raw.data(), raw.size(), client_id);
+            scan_seq(raw.data(), raw.size(), seq);
+            const std::string ack = "{\"header\":{\"version\":1,\"type\":100,\"seq\":" + std::to_string(seq) +
+                                    ",\"client_id\":" + std::to_string(client_id) +
+                                    "},\"body\":{\"client_order_id\":" + std::to_string(seq) +
+                                    ",\"order_id\":1,\"symbol\":\"AAPL\"}}";
+            gateway.send(client_id, ack);
+        }
+    });
+
+    ClientId next_id = 1;
+    for (size_t n : counts) {
+        run(config.port, n, next_id, seconds);
+        next_id += static_cast<ClientId>(n);
+        std::this_thread::sleep_for(std::chrono::milliseconds(200)); // let the gateway reap
+    }
+
+    const TcpGatewayCounters g = gateway.counters();
+    std::cout << "gateway: " << g.accepted << " accepted, " << g.frames_in << " frames, "
+              << g.seq_rejects << " sequence rejects, " << g.dropped_sessions << " dropped" << std::endl;
+
+    raw_queue.push(InboundMessage());
+    matcher.join();
+    gateway.stop();
+    return 0;
+}
@@ -0,0 +1,60 @@
+// Matching throughput against books where a share of the resting orders are
+// icebergs, so most fills also replenish and re-queue the resting order.
+//
+// g++ -O2 -std=c++17 -I./include bench/bench_iceberg.cpp src/order_book.cpp src/matching_engine.cpp -o bench_iceberg
+// ./bench_iceberg [resting_orders] [iceberg_percent] [display_qty]
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "matching_engine.hpp"
+
+using namespace ex;
+using Clock = std::chrono::steady_clock;
+
+int main(int argc, char** argv) {
+    const uint64_t num_orders = argc > 1 ? std::stoull(argv[1]) : 200000;
+    const uint64_t iceberg_pct = argc > 2 ? std::stoull(argv[2]) : 50;
+    const uint32_t display = argc > 3 ? static_cast<uint32_t>(std::stoul(argv[3])) : 10;
+    const uint32_t order_qty = 100;
+
+    MatchingEngine engine(num_orders);
+    std::vector<EnvelopeOut> events;
+    events.reserve(64);
+
+    // Asks spread over 100 levels from 10000 up
+    for (uint64_t i = 1; i <= num_orders; ++i) {
+        Order o(i, i, i, "AAPL", Side::Sell, MsgType::NewOrder, 10000 + (i * 13) % 100, order_qty);
+        o.client_id = static_cast<ClientId>(i % 10);
+        if (i % 100 < iceberg_pct) o.display_qty = display;
+        engine.process(o, events);
+    }
+    events.clear();
+
+    uint64_t level_qty = 0;
+    for (const auto& [px, level] : engine.book("AAPL").levels(Side::Sell)) {
+        (void)px;
+        level_qty += static_cast<uint64_t>(level.total_qty);
+    }
+    std::cout << "Resting: " << engine.restingCount() << " asks, " << iceberg_pct
+              << "% icebergs (display " << display << "), displayed qty " << level_qty << std::endl;
+
+    // Small aggressive buys that each take a few slices off the best level
+    OrderId id = num_orders;
+    uint64_t fills = 0, n = 0;
+    auto t0 = Clock::now();
+    while (engine.restingCount() > 0) {
+        Order o(0, ++id, 0, "AAPL", Side::Buy, MsgType::NewOrder, 0, 25);
+        o.ord_type = OrdType::Market;
+        o.client_id = 99;
+        engine.process(o, events);
+        fills += events.size() / 2;
+        events.clear();
+        n++;
+    }
+    const double ns = std::chrono::duration<double, std::nano>(Clock::now() - t0).count();
+    std::cout << "Drained book with " << n << " orders, " << fills << " fills: "
+              << ns / n << " ns/order | " << ns / fills << " ns/fill" << std::endl;
+    return 0;
+}
@@ -0,0 +1,145 @@
+// Vectorized scanning for the ingress scanners, per kernel.
+//
+// Three message shapes: the compact new order of src/jsonExample.txt, the
+// same as clients format it (json.dumps spacing), and a 1 KB order
+// carrying a free-text field. For each shape and each quote kernel
+// (scalar, sse2, avx2 where the CPU has it):
+//   quotes      - QuoteCursor over the whole message, every quote visited
+//   scan_header - type, seq, client_id and symbol
+// reported in GB/s and msgs/s. Then the whole parse of each shape into an
+// EnvelopeIn, as the parse workers do it: try_parse_inbound_envelope, whose
+// NewOrder fast path reads the body fields straight off the bytes (the 1 KB
+// shape has a key it does not know and falls back), against nlohmann alone.
+//
+// g++ -O2 -std=c++17 -I./include bench/bench_json_simd.cpp -o bench_json_simd
+// ./bench_json_simd [messages] [rounds]
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "net/codec_json.hpp"
+
+using namespace ex;
+using Clock = std::chrono::steady_clock;
+
+static std::string compact(uint64_t i) {
+    return "{\"header\":{\"version\":1,\"type\":1,\"seq\":" + std::to_string(i) +
+           ",\"client_id\":7},\"body\":{\"client_order_id\":" + std::to_string(1000000000 + i * 7) +
+           ",\"symbol\":\"AAPL\",\"side\":\"B\",\"ord_type\":\"LMT\",\"qty\":" + std::to_string(1 + i % 5000) +
+           ",\"limit_price\":" + std::to_string(10000 + i % 997) + "}}";
+}
+
+static std::string spaced(uint64_t i) {
+    return "{\"header\": {\"version\": 1, \"type\": 1, \"seq\": " + std::to_string(i) +
+           ", \"client_id\": 7}, \"body\": {\"client_order_id\": " + std::to_string(1000000000 + i * 7) +
+           ", \"symbol\": \"AAPL\", \"side\": \"B\", \"ord_type\": \"LMT\", \"qty\": " + std::to_string(1 + i % 5000) +
+           ", \"limit_price\": " + std::to_string(10000 + i % 997) + ", \"tif\": \"DAY\"}}";
+}
+
+static std::string withText(uint64_t i) {
+    // Symbol after the text, so the scan has to cross it
+    return "{\"header\": {\"version\": 1, \"type\": 1, \"seq\": " + std::to_string(i) +
+           ", \"client_id\": 7}, \"body\": {\"client_order_id\": " + std::to_string(1000000000 + i * 7) +
+           ", \"text\": \"" + std::string(850, 'x') + "\", \"symbol\": \"AAPL\", \"side\": \"B\", \"ord_type\": \"LMT\"" +
+           ", \"qty\": " + std::to_string(1 + i % 5000) + ", \"limit_price\": " + std::to_string(10000 + i % 997) + "}}";
+}
+
+template <typename F>
+static double seconds(int rounds, F&& f) {
+    const auto t0 = Clock::now();
+    for (int r = 0; r < rounds; ++r) f();
+    return std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+static void report(const char* what, size_t msgs, size_t bytes, double secs) {
+    std::cout << "  " << std::left << std::setw(12) << what << std::right << std::fixed << std::setprecision(2)
+              << std::setw(6) << bytes / secs / 1e9 << " GB/s " << std::setw(8) << std::setprecision(1)
+              << msgs / secs / 1e6 << " M msgs/s" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    const uint64_t n = argc > 1 ? std::stoull(argv[1]) : 100000;
+    const int rounds = argc > 2 ? std::stoi(argv[2]) : 10;
+
+    std::vector<json_scan::Isa> isas = { json_scan::Isa::Scalar };
+#if defined(__x86_64__)
+    isas.push_back(json_scan::Isa::Sse2);
+    if (__builtin_cpu_supports("avx2")) isas.push_back(json_scan::Isa::Avx2);
+#endif
+    std::cout << "dispatch picks " << json_scan::isa_name(json_scan::dispatch().isa) << std::endl;
+
+    struct Shape { const char* name; std::string (*make)(uint64_t); };
+    for (const Shape& shape : { Shape{ "compact", compact }, Shape{ "spaced", spaced }, Shape{ "1 KB text", withText } }) {
+        std::vector<std::string> msgs;
+        size_t bytes = 0;
+        for (uint64_t i = 0; i < n; ++i) {
+            msgs.push_back(shape.make(i + 1));
+            bytes += msgs.back().size();
+        }
+        std::cout << shape.name << " (" << bytes / n << " bytes):" << std::endl;
+
+        for (json_scan::Isa isa : isas) {
+            json_scan::use_isa(isa);
+            std::cout << " " << json_scan::isa_name(isa) << std::endl;
+
+            uint64_t sink = 0;
+            double secs = seconds(rounds, [&] {
+                for (const std::string& m : msgs) {
+                    json_scan::QuoteCursor quotes(m.data(), m.size());
+                    while (quotes.next()) ++sink;
+                }
+            });
+            report("quotes", n * rounds, bytes * rounds, secs);
+
+            secs = seconds(rounds, [&] {
+                for (const std::string& m : msgs) {
+                    HeaderFields h;
+                    scan_header(m.data(), m.size(), h);
+                    sink += h.seq + h.symbol.size();
+                }
+            });
+            report("scan_header", n * rounds, bytes * rounds, secs);
+            if (sink == 42) std::cout << "";
+        }
+    }
+    json_scan::use_isa(json_scan::best_isa());
+
+    // Full parse, fast path against nlohmann, checked field by field
+    std::cout << "NewOrder parse:" << std::endl;
+    for (const Shape& shape : { Shape{ "compact", compact }, Shape{ "spaced", spaced }, Shape{ "1 KB text", withText } }) {
+        std::vector<std::string> msgs;
+        size_t bytes = 0;
+        for (uint64_t i = 0; i < n; ++i) {
+            msgs.push_back(shape.make(i + 1));
+            bytes += msgs.back().size();
+        }
+        uint64_t a = 0, b = 0;
+        const double fast = seconds(rounds, [&] {
+            for (const std::string& m : msgs) {
+                EnvelopeIn e;
+                if (try_parse_inbound_envelope(m, e) != ParseFailure::None) continue;
+                const NewOrderRequest& r = std::get<NewOrderRequest>(e.body);
+                a += e.header.seq + r.client_order_id + static_cast<uint64_t>(r.qty + r.limit_price) + r.symbol.size();
+            }
+        });
+        const double dom = seconds(rounds, [&] {
+            for (const std::string& m : msgs) {
+                const EnvelopeIn e = json::parse(m).get<EnvelopeIn>();
+                const NewOrderRequest& r = std::get<NewOrderRequest>(e.body);
+                b += e.header.seq + r.client_order_id + static_cast<uint64_t>(r.qty + r.limit_price) + r.symbol.size();
+            }
+        });
+        if (a != b) {
+            std::cerr << shape.name << ": fast path disagrees with nlohmann" << std::endl;
+            return 1;
+        }
+        const double count = static_cast<double>(n) * rounds;
+        std::cout << "  " << std::left << std::setw(10) << shape.name << std::right << std::fixed
+                  << std::setprecision(0) << " try_parse " << std::setw(6) << fast * 1e9 / count << " ns, nlohmann "
+                  << std::setw(6) << dom * 1e9 / count << " ns per message (" << std::setprecision(1)
+                  << count / fast / 1e6 << " vs " << count / dom / 1e6 << " M msgs/s)" << std::endl;
+    }
+    return 0;
+}
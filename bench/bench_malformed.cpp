@@ -0,0 +1,171 @@
+// Cost of answering a malformed message, on 100% malformed traffic.
+//
+// Each kind of malformed message a flood might carry, and then all of them
+// mixed, through what a parse worker does with it:
+//   exceptions - parse_inbound_envelope in a try block, the worker's log
+//                line formatted (into a null stream, so no terminal time
+//                is counted) and a Reject built and sent through dump_envelope
+//   error codes - try_parse_inbound_envelope, the ids scanned out and the
+//                Reject written from its template
+// A valid new order through parse_inbound_envelope is the reference for the
+// success path. Checks each template against dump_envelope first.
+//
+// g++ -O2 -std=c++17 -I./include bench/bench_malformed.cpp -o bench_malformed
+// ./bench_malformed [messages] [rounds]
+
+#include <chrono>
+#include <iostream>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "net/codec_json.hpp"
+
+using namespace ex;
+using Clock = std::chrono::steady_clock;
+
+struct Shape {
+    const char* name;
+    std::string (*make)(uint64_t);
+};
+
+static std::string seq(uint64_t i) { return std::to_string(i); }
+
+static const Shape kShapes[] = {
+    { "no seq (test script)", [](uint64_t) {
+        return std::string("{\"header\": {\"type\": 1}, \"body\": {\"garbage\": true}}");
+    } },
+    { "not JSON", [](uint64_t i) {
+        return "{\"header\": {\"version\": 1, \"type\": 1, \"seq\": " + seq(i) + ", \"client_id\": 7}, \"body\": {\"sym";
+    } },
+    { "missing qty", [](uint64_t i) {
+        return "{\"header\": {\"version\": 1, \"type\": 1, \"seq\": " + seq(i) + ", \"client_id\": 7}, "
+               "\"body\": {\"client_order_id\": " + seq(i) + ", \"symbol\": \"AAPL\", \"side\": \"B\", "
+               "\"ord_type\": \"LMT\", \"limit_price\": 10123}}";
+    } },
+    { "not a request", [](uint64_t i) {
+        return "{\"header\": {\"version\": 1, \"type\": 900, \"seq\": " + seq(i) + ", \"client_id\": 7}, \"body\": {}}";
+    } },
+    { "bad side value", [](uint64_t i) {
+        return "{\"header\": {\"version\": 1, \"type\": 1, \"seq\": " + seq(i) + ", \"client_id\": 7}, "
+               "\"body\": {\"client_order_id\": " + seq(i) + ", \"symbol\": \"AAPL\", \"side\": \"X\", "
+               "\"ord_type\": \"LMT\", \"qty\": 10, \"limit_price\": 10123}}";
+    } },
+};
+
+static std::string valid(uint64_t i) {
+    return "{\"header\": {\"version\": 1, \"type\": 1, \"seq\": " + seq(i) + ", \"client_id\": 7}, "
+           "\"body\": {\"client_order_id\": " + seq(i) + ", \"symbol\": \"AAPL\", \"side\": \"B\", "
+           "\"ord_type\": \"LMT\", \"qty\": 10, \"limit_price\": 10123}}";
+}
+
+// Discards what is written to it, after the formatting has been done
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+    std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+// The worker before error codes
+static size_t withExceptions(const std::string& raw, std::ostream& log) {
+    try {
+        const EnvelopeIn e = parse_inbound_envelope(raw);
+        return e.header.seq;
+    } catch (const std::exception& e) {
+        log << "[WORKER] Parse Error: " << e.what() << std::endl;
+        Reject rej_msg;
+        rej_msg.symbol = "UNKNOWN";
+        rej_msg.info.reason = e.what();
+        rej_msg.info.code = to_u(RejectCode::ParseError);
+        EnvelopeOut response;
+        response.header.type = MsgType::Reject;
+        response.body = rej_msg;
+        return dump_envelope(response).size();
+    }
+}
+
+// The worker now: OrderGenerator::convertToOrder and sendParseReject
+static size_t withErrorCodes(const std::string& raw) {
+    static constexpr char kClientOrderId[] = "\"client_order_id\"";
+    EnvelopeIn e;
+    const ParseFailure failure = try_parse_inbound_envelope(raw, e);
+    if (failure == ParseFailure::None) return e.header.seq;
+    HeaderFields h;
+    scan_header(raw.data(), raw.size(), h);
+    uint64_t client_order_id = 0;
+    scan_uint_field(raw.data(), raw.size(), kClientOrderId, sizeof(kClientOrderId) - 1, client_order_id);
+    std::string msg;
+    msg.reserve(parse_reject_template(failure).size() + 96);
+    append_parse_reject(msg, failure, client_order_id, h.has(HeaderFields::kClientId) ? h.client_id : 0,
+                        h.has(HeaderFields::kSeq) ? h.seq : 0);
+    return msg.size();
+}
+
+template <typename F>
+static double nsPerMsg(const std::vector<std::string>& msgs, int rounds, F&& f) {
+    uint64_t sink = 0;
+    const auto t0 = Clock::now();
+    for (int r = 0; r < rounds; ++r) {
+        for (const std::string& m : msgs) sink += f(m);
+    }
+    const double ns = std::chrono::duration<double, std::nano>(Clock::now() - t0).count();
+    if (sink == 42) std::cout << "";
+    return ns / (static_cast<double>(msgs.size()) * rounds);
+}
+
+int main(int argc, char** argv) {
+    const uint64_t n = argc > 1 ? std::stoull(argv[1]) : 20000;
+    const int rounds = argc > 2 ? std::stoi(argv[2]) : 5;
+
+    for (uint8_t f = 0; f < static_cast<uint8_t>(ParseFailure::Count); ++f) {
+        const ParseFailure failure = static_cast<ParseFailure>(f);
+        Reject r{ 12, "UNKNOWN", {} };
+        r.info.code = to_u(RejectCode::ParseError);
+        r.info.reason = parse_failure_reason(failure);
+        EnvelopeOut expected;
+        expected.header.type = MsgType::Reject;
+        expected.header.client_id = 7;
+        expected.header.seq = 34;
+        expected.body = r;
+        std::string msg;
+        append_parse_reject(msg, failure, 12, 7, 34);
+        if (msg != dump_envelope(expected)) {
+            std::cerr << "template disagrees with dump_envelope:\n  " << msg << "\n  "
+                      << dump_envelope(expected) << std::endl;
+            return 1;
+        }
+    }
+
+    NullBuffer null_buffer;
+    std::ostream log(&null_buffer);
+    std::cout << n << " messages of each kind, " << rounds << " rounds" << std::endl;
+
+    std::vector<std::string> good;
+    for (uint64_t i = 0; i < n; ++i) good.push_back(valid(i + 1));
+    const double success = nsPerMsg(good, rounds, [](const std::string& m) {
+        return parse_inbound_envelope(m).header.seq;
+    });
+    std::cout << "valid order (reference): " << success << " ns/msg" << std::endl;
+
+    std::vector<std::string> mix;
+    for (const Shape& shape : kShapes) {
+        std::vector<std::string> msgs;
+        for (uint64_t i = 0; i < n; ++i) msgs.push_back(shape.make(i + 1));
+        EnvelopeIn e;
+        if (try_parse_inbound_envelope(msgs.front(), e) == ParseFailure::None) {
+            std::cerr << shape.name << " parsed" << std::endl;
+            return 1;
+        }
+        mix.insert(mix.end(), msgs.begin(), msgs.end());
+
+        const double slow = nsPerMsg(msgs, rounds, [&](const std::string& m) { return withExceptions(m, log); });
+        const double fast = nsPerMsg(msgs, rounds, withErrorCodes);
+        std::cout << shape.name << " (" << parse_failure_reason(try_parse_inbound_envelope(msgs.front(), e))
+                  << "): exceptions " << slow << " ns, error codes " << fast << " ns/msg" << std::endl;
+    }
+
+    const double slow = nsPerMsg(mix, rounds, [&](const std::string& m) { return withExceptions(m, log); });
+    const double fast = nsPerMsg(mix, rounds, withErrorCodes);
+    std::cout << "mix: exceptions " << slow << " ns (" << slow / success << "x a valid order), error codes "
+              << fast << " ns (" << fast / success << "x) per msg" << std::endl;
+    return 0;
+}
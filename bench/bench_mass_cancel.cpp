@@ -0,0 +1,72 @@
+// Time to clear large books with mass cancels (engine work plus encoding the
+// Cancelled confirmations).
+//
+// g++ -O2 -std=c++17 -I./include bench/bench_mass_cancel.cpp src/order_book.cpp src/matching_engine.cpp -o bench_mass_cancel
+// ./bench_mass_cancel [resting_orders] [symbols] [clients]
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "matching_engine.hpp"
+
+using namespace ex;
+using Clock = std::chrono::steady_clock;
+
+static double msSince(Clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+static void report(const char* what, size_t n, double engine_ms, const std::vector<EnvelopeOut>& events) {
+    auto t0 = Clock::now();
+    size_t bytes = 0;
+    for (const auto& e : events) bytes += dump_envelope(e).size();
+    const double encode_ms = msSince(t0);
+    std::cout << what << ": " << n << " orders | engine " << engine_ms << " ms ("
+              << engine_ms * 1e6 / (n ? n : 1) << " ns/order) | encode " << encode_ms
+              << " ms (" << bytes / 1024 << " KB)" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    const uint64_t num_orders = argc > 1 ? std::stoull(argv[1]) : 1000000;
+    const int num_symbols = argc > 2 ? std::stoi(argv[2]) : 100;
+    const uint32_t num_clients = argc > 3 ? static_cast<uint32_t>(std::stoul(argv[3])) : 10;
+
+    std::vector<std::string> symbols;
+    for (int i = 0; i < num_symbols; ++i) symbols.push_back("SYM" + std::to_string(i));
+
+    MatchingEngine engine(num_orders);
+    std::vector<EnvelopeOut> events;
+    for (uint64_t i = 1; i <= num_orders; ++i) {
+        const bool buy = i % 2 == 0;
+        const double px = buy ? 9000 + (i * 7) % 500 : 10000 + (i * 13) % 500;
+        Order o(i, i, i, symbols[i % num_symbols], buy ? Side::Buy : Side::Sell,
+                MsgType::NewOrder, px, 100);
+        o.client_id = static_cast<ClientId>(i % num_clients);
+        engine.process(o, events);
+    }
+    std::cout << "Resting: " << engine.restingCount() << " orders, " << num_symbols
+              << " symbols, " << num_clients << " clients" << std::endl;
+
+    events.clear();
+    auto t0 = Clock::now();
+    size_t n = engine.cancelClient(3, nullptr, events);
+    report("Cancel client 3     ", n, msSince(t0), events);
+
+    events.clear();
+    t0 = Clock::now();
+    n = engine.cancelClient(4, &engine.book(symbols[4]), events);
+    report("Cancel client 4/SYM4", n, msSince(t0), events);
+
+    events.clear();
+    t0 = Clock::now();
+    n = engine.cancelBook(engine.book(symbols[1]), events);
+    report("Cancel symbol SYM1  ", n, msSince(t0), events);
+
+    events.clear();
+    t0 = Clock::now();
+    n = engine.cancelAll(events);
+    report("Cancel all          ", n, msSince(t0), events);
+
+    return engine.restingCount() == 0 ? 0 : 1;
+}
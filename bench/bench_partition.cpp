@@ -0,0 +1,170 @@
+// Scaling across symbol partitions, one process per partition.
+//
+// Forks P partition processes. Each one pulls orders on its own ipc endpoint,
+// parses them and runs them through a MatchingEngine, like a core started
+// with --partition. In this process a PartitionRouter reads a generated map
+// spreading S symbols over the P partitions, and a generator thread pushes
+// N orders (batches of 64 as multipart messages) into it. An EndOfSession at
+// the end is broadcast to every partition, and each reports its count. The
+// timed span runs from the first order sent to the last report.
+// "front end only" repeats the largest P with partitions that only count,
+// which shows the ceiling the router itself sets.
+//
+// g++ -O2 -std=c++17 -I./include -I./include/lib/zmq bench/bench_partition.cpp src/partition_router.cpp src/order_book.cpp src/matching_engine.cpp -lzmq -lpthread -o bench_partition
+// ./bench_partition [orders] [max_partitions] [symbols]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <zmq.hpp>
+#include "matching_engine.hpp"
+#include "partition_router.hpp"
+#include "net/codec_json.hpp"
+
+using namespace ex;
+using Clock = std::chrono::steady_clock;
+
+static const std::string kEnd =
+    "{\"header\":{\"version\":1,\"type\":7,\"seq\":0,\"client_id\":1},\"body\":{\"session_date\":0}}";
+
+static std::string order(uint64_t i, size_t symbols) {
+    // Alternate sides at one price so the books trade instead of growing
+    return "{\"header\":{\"version\":1,\"type\":1,\"seq\":" + std::to_string(i) +
+           ",\"client_id\":7},\"body\":{\"client_order_id\":" + std::to_string(i) +
+           ",\"symbol\":\"S" + std::to_string(i % symbols) + "\",\"side\":\"" + (i / symbols % 2 ? "S" : "B") +
+           "\",\"ord_type\":\"LMT\",\"qty\":10,\"limit_price\":10123}}";
+}
+
+// Named after this process, so forked children need it passed down
+static std::string endpoint(pid_t owner, const std::string& name) {
+    return "ipc:///tmp/bench_partition_" + std::to_string(owner) + "_" + name;
+}
+
+// Child process: what a --partition core does with each order, minus the
+// worker pool and the responses
+static void partition(const std::string& endpoint, const std::string& done, bool match) {
+    zmq::context_t ctx(1);
+    zmq::socket_t in(ctx, zmq::socket_type::pull);
+    in.set(zmq::sockopt::rcvhwm, 10000);
+    in.bind(endpoint);
+    zmq::socket_t out(ctx, zmq::socket_type::push);
+    out.connect(done);
+
+    MatchingEngine engine(1 << 16);
+    std::vector<EnvelopeOut> events;
+    OrderId id = 0;
+    uint64_t count = 0;
+    zmq::message_t part;
+    for (;;) {
+        (void)in.recv(part, zmq::recv_flags::none);
+        const std::string raw(static_cast<const char*>(part.data()), part.size());
+        if (raw == kEnd) break;
+        ++count;
+        if (!match) continue;
+
+        const EnvelopeIn e = parse_inbound_envelope(raw);
+        const NewOrderRequest& r = std::get<NewOrderRequest>(e.body);
+        Order o(r.client_order_id, ++id, 0, r.symbol, r.side, MsgType::NewOrder,
+                static_cast<double>(r.limit_price), static_cast<uint32_t>(r.qty));
+        o.client_id = e.header.client_id;
+        engine.process(o, events);
+        events.clear();
+    }
+    const std::string report = std::to_string(count);
+    out.send(zmq::buffer(report), zmq::send_flags::none);
+}
+
+static double run(const std::vector<std::string>& msgs, size_t partitions, size_t symbols, bool match) {
+    const pid_t self = getpid();
+    const std::string done = endpoint(self, "done");
+
+    // Fork before this process creates any ZMQ context
+    std::vector<pid_t> children;
+    for (size_t p = 0; p < partitions; ++p) {
+        const pid_t pid = fork();
+        if (pid == 0) {
+            partition(endpoint(self, std::to_string(p)), done, match);
+            _exit(0);
+        }
+        children.push_back(pid);
+    }
+
+    const std::string map_path = "/tmp/bench_partition_" + std::to_string(self) + ".conf";
+    {
+        std::ofstream map(map_path);
+        for (size_t p = 0; p < partitions; ++p) {
+            map << endpoint(self, std::to_string(p));
+            for (size_t s = p; s < symbols; s += partitions) map << " S" << s;
+            map << "\n";
+        }
+    }
+
+    zmq::context_t ctx(2);
+    zmq::socket_t reports(ctx, zmq::socket_type::pull);
+    reports.bind(done);
+    const std::string ingress = endpoint(self, "in");
+    PartitionRouter front(ctx, ingress, map_path);
+    if (!front.load()) return 0;
+    std::thread front_thread([&] { front.run(); });
+
+    zmq::socket_t push(ctx, zmq::socket_type::push);
+    push.set(zmq::sockopt::sndhwm, 10000);
+    push.connect(ingress);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200)); // let every connection come up
+
+    const auto t0 = Clock::now();
+    const size_t batch = 64;
+    for (size_t i = 0; i < msgs.size(); i += batch) {
+        const size_t end = std::min(msgs.size(), i + batch);
+        for (size_t j = i; j < end; ++j) {
+            push.send(zmq::buffer(msgs[j]), j + 1 < end ? zmq::send_flags::sndmore : zmq::send_flags::none);
+        }
+    }
+    push.send(zmq::buffer(kEnd), zmq::send_flags::none);
+
+    uint64_t total = 0;
+    zmq::message_t report;
+    for (size_t p = 0; p < partitions; ++p) {
+        (void)reports.recv(report, zmq::recv_flags::none);
+        total += std::stoull(report.to_string());
+    }
+    const double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+
+    front.stop();
+    front_thread.join();
+    for (pid_t pid : children) waitpid(pid, nullptr, 0);
+    std::remove(map_path.c_str());
+    std::remove((map_path + ".placement").c_str());
+    if (total != msgs.size()) std::cerr << "partitions saw " << total << " of " << msgs.size() << std::endl;
+    return msgs.size() / secs;
+}
+
+int main(int argc, char** argv) {
+    const uint64_t n = argc > 1 ? std::stoull(argv[1]) : 1000000;
+    const size_t max_partitions = argc > 2 ? std::stoul(argv[2]) : 4;
+    const size_t symbols = argc > 3 ? std::stoul(argv[3]) : 64;
+
+    std::vector<std::string> msgs;
+    msgs.reserve(n);
+    for (uint64_t i = 0; i < n; ++i) msgs.push_back(order(i + 1, symbols));
+
+    std::cout << n << " orders over " << symbols << " symbols, "
+              << std::thread::hardware_concurrency() << " cpus" << std::endl;
+    double single = 0;
+    for (size_t p = 1; p <= max_partitions; p *= 2) {
+        const double rate = run(msgs, p, symbols, true);
+        if (p == 1) single = rate;
+        std::cout << p << " partition" << (p > 1 ? "s: " : ":  ") << static_cast<uint64_t>(rate)
+                  << " orders/s (" << rate / single << "x)" << std::endl;
+    }
+    std::cout << "front end only, " << max_partitions << " partitions: "
+              << static_cast<uint64_t>(run(msgs, max_partitions, symbols, false)) << " orders/s" << std::endl;
+    return 0;
+}
@@ -0,0 +1,110 @@
+// Amend throughput: Replace (qty down in place, and price move) against the
+// cancel + new round trip clients had to use before.
+//
+// g++ -O2 -std=c++17 -I./include bench/bench_replace.cpp src/order_book.cpp src/matching_engine.cpp -o bench_replace
+// ./bench_replace [resting_orders] [amends]
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "matching_engine.hpp"
+
+using namespace ex;
+using Clock = std::chrono::steady_clock;
+
+static const uint32_t kStartQty = 1000000;
+
+// Resting bids 9000..9499 and asks 10000..10499 so price moves never cross
+static void fill(MatchingEngine& engine, uint64_t n, std::vector<EnvelopeOut>& events) {
+    for (uint64_t i = 1; i <= n; ++i) {
+        const bool buy = i % 2 == 0;
+        const double px = buy ? 9000 + (i * 7) % 500 : 10000 + (i * 13) % 500;
+        Order o(i, i, i, "AAPL", buy ? Side::Buy : Side::Sell, MsgType::NewOrder, px, kStartQty);
+        o.client_id = 7;
+        engine.process(o, events);
+    }
+    events.clear();
+}
+
+static void report(const char* what, uint64_t n, Clock::time_point t0) {
+    const double ns = std::chrono::duration<double, std::nano>(Clock::now() - t0).count();
+    std::cout << what << ": " << ns / n << " ns/amend (" << n * 1e3 / ns << " M/s)" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    const uint64_t num_orders = argc > 1 ? std::stoull(argv[1]) : 100000;
+    const uint64_t num_amends = argc > 2 ? std::stoull(argv[2]) : 1000000;
+    std::vector<EnvelopeOut> events;
+    events.reserve(16);
+
+    {
+        MatchingEngine engine(num_orders);
+        fill(engine, num_orders, events);
+
+        Order o;
+        o.type = MsgType::Replace;
+        o.client_id = 7;
+        auto t0 = Clock::now();
+        for (uint64_t i = 0; i < num_amends; ++i) {
+            const RestingOrder* r = engine.find(i % num_orders + 1);
+            o.internal_order_id = r->order_id;
+            o.price = static_cast<double>(r->price);
+            o.quantity = static_cast<uint32_t>(r->qty - 1);
+            engine.process(o, events);
+            events.clear();
+        }
+        report("Replace qty down     ", num_amends, t0);
+    }
+
+    {
+        MatchingEngine engine(num_orders);
+        fill(engine, num_orders, events);
+
+        Order o;
+        o.type = MsgType::Replace;
+        o.client_id = 7;
+        auto t0 = Clock::now();
+        for (uint64_t i = 0; i < num_amends; ++i) {
+            const RestingOrder* r = engine.find(i % num_orders + 1);
+            const bool buy = r->side == Side::Buy;
+            o.internal_order_id = r->order_id;
+            o.price = static_cast<double>(buy ? 9000 + (r->price + 1 - 9000) % 500
+                                              : 10000 + (r->price + 1 - 10000) % 500);
+            o.quantity = static_cast<uint32_t>(r->qty);
+            engine.process(o, events);
+            events.clear();
+        }
+        report("Replace price move   ", num_amends, t0);
+    }
+
+    {
+        MatchingEngine engine(num_orders);
+        fill(engine, num_orders, events);
+
+        // The client-side equivalent: cancel, then a new order with a new id
+        std::vector<OrderId> live(num_orders);
+        for (uint64_t i = 0; i < num_orders; ++i) live[i] = i + 1;
+        OrderId next_id = num_orders;
+
+        Order cxl;
+        cxl.type = MsgType::Cancel;
+        cxl.client_id = 7;
+        auto t0 = Clock::now();
+        for (uint64_t i = 0; i < num_amends; ++i) {
+            OrderId& id = live[i % num_orders];
+            const RestingOrder* r = engine.find(id);
+            Order o(0, ++next_id, 0, "AAPL", r->side, MsgType::NewOrder,
+                    static_cast<double>(r->price), static_cast<uint32_t>(r->qty - 1));
+            o.client_id = 7;
+            cxl.internal_order_id = id;
+            engine.process(cxl, events);
+            engine.process(o, events);
+            events.clear();
+            id = next_id;
+        }
+        report("Cancel + new         ", num_amends, t0);
+    }
+
+    return 0;
+}
@@ -0,0 +1,90 @@
+// Cost of replicating the sequenced input to a backup.
+//
+// A primary and a backup in one process over loopback TCP. Round trip: one
+// message at a time, the time from append until the backup's ack covers it,
+// which is what every response waits for when the exchange is quiet. Burst:
+// N messages appended back to back, throughput until the last is acked and
+// how many socket writes the stream took.
+//
+// g++ -O2 -std=c++17 -I./include bench/bench_replication.cpp src/replication.cpp -lpthread -o bench_replication
+// ./bench_replication [messages] [port]
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "replication.hpp"
+
+using namespace ex;
+using Clock = std::chrono::steady_clock;
+
+static std::string order(uint64_t i) {
+    return "{\"header\":{\"version\":1,\"type\":1,\"seq\":" + std::to_string(i) +
+           ",\"client_id\":7},\"body\":{\"client_order_id\":" + std::to_string(i) +
+           ",\"symbol\":\"AAPL\",\"side\":\"B\",\"ord_type\":\"LMT\",\"qty\":10,\"limit_price\":10123}}";
+}
+
+static uint64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+int main(int argc, char** argv) {
+    const uint64_t n = argc > 1 ? std::stoull(argv[1]) : 1000000;
+    const uint16_t port = argc > 2 ? static_cast<uint16_t>(std::stoul(argv[2])) : 15558;
+    const uint64_t round_trips = 10000;
+
+    ReplicationPrimary primary(port);
+    uint64_t applied = 0;
+    std::thread backup_thread([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        ReplicationBackup backup;
+        if (!backup.connect("127.0.0.1", port)) return;
+        std::vector<ReplicationRecord> records;
+        while (backup.receive(records)) {
+            applied += records.size();
+            records.clear();
+        }
+    });
+    if (!primary.waitForBackup()) return 1;
+    primary.start();
+    const std::atomic<uint64_t>* replicated = primary.replicated();
+
+    uint64_t seq = 0;
+    std::vector<uint64_t> rtt;
+    rtt.reserve(round_trips);
+    for (uint64_t i = 0; i < round_trips; ++i) {
+        const uint64_t t0 = nowNs();
+        ++seq;
+        primary.append(seq, t0, order(seq));
+        // Yield rather than spin: the replication and backup threads may share our core
+        while (replicated->load(std::memory_order_acquire) < seq) std::this_thread::yield();
+        rtt.push_back(nowNs() - t0);
+    }
+    std::sort(rtt.begin(), rtt.end());
+    std::cout << "round trip: p50 " << rtt[rtt.size() / 2] << " ns, p99 " << rtt[rtt.size() * 99 / 100]
+              << " ns, p99.9 " << rtt[rtt.size() * 999 / 1000] << " ns over " << round_trips << " messages\n";
+
+    std::vector<std::string> msgs;
+    msgs.reserve(n);
+    for (uint64_t i = 0; i < n; ++i) msgs.push_back(order(i));
+    const ReplicationCounters before = primary.counters();
+    const uint64_t first = seq + 1;
+    const auto t0 = Clock::now();
+    for (std::string& m : msgs) primary.append(++seq, 0, std::move(m));
+    const double append_secs = std::chrono::duration<double>(Clock::now() - t0).count();
+    while (replicated->load(std::memory_order_acquire) < seq) std::this_thread::yield();
+    const double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+    const ReplicationCounters after = primary.counters();
+
+    std::cout << "burst of " << n << " (seq " << first << "-" << seq << "): appended at "
+              << static_cast<uint64_t>(n / append_secs) << " msgs/s, acked at " << static_cast<uint64_t>(n / secs)
+              << " msgs/s, " << (after.writes - before.writes) << " writes ("
+              << static_cast<double>(n) / (after.writes - before.writes) << " msgs/write)" << std::endl;
+
+    primary.stop();
+    backup_thread.join();
+    std::cout << "backup applied " << applied << " messages" << std::endl;
+    return 0;
+}
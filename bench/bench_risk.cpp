@@ -0,0 +1,85 @@
+// Added per-order latency of the pre-trade risk stage.
+//
+// g++ -O2 -std=c++17 -I./include bench/bench_risk.cpp src/order_book.cpp src/matching_engine.cpp src/risk_checker.cpp -o bench_risk
+// ./bench_risk [orders] [clients]
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "matching_engine.hpp"
+#include "risk_checker.hpp"
+
+using namespace ex;
+using Clock = std::chrono::steady_clock;
+
+static std::vector<Order> makeOrders(uint64_t n, uint32_t clients) {
+    static const std::string symbols[] = {"AAPL", "TSLA", "GOOG", "MSFT"};
+    std::vector<Order> orders;
+    orders.reserve(n);
+    for (uint64_t i = 1; i <= n; ++i) {
+        const bool buy = (i * 2654435761u) % 2 == 0;
+        const double px = 10000 + static_cast<double>((i * 40503u) % 21) - 10;
+        Order o(i, i, 0, symbols[i % 4], buy ? Side::Buy : Side::Sell,
+                MsgType::NewOrder, px, 100);
+        o.client_id = static_cast<ClientId>(i % clients);
+        orders.push_back(o);
+    }
+    return orders;
+}
+
+static double runEngineOnly(const std::vector<Order>& orders) {
+    MatchingEngine engine(orders.size());
+    std::vector<EnvelopeOut> events;
+    auto t0 = Clock::now();
+    for (const Order& o : orders) {
+        events.clear();
+        engine.process(o, events);
+    }
+    return std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / orders.size();
+}
+
+static double runWithRisk(const std::vector<Order>& orders, uint64_t& rejects) {
+    RiskLimits limits;
+    limits.max_order_qty = 1000000;
+    limits.max_notional = 1000000000000;
+    limits.price_collar_bps = 1000;
+    limits.max_open_orders = 1000000;
+    limits.max_gross_position = 1000000000;
+    RiskChecker risk(limits);
+    MatchingEngine engine(orders.size());
+    std::vector<EnvelopeOut> events;
+
+    auto t0 = Clock::now();
+    for (const Order& o : orders) {
+        events.clear();
+        const RejectCode code = risk.check(o, engine.book(o.symbol).lastTradePrice());
+        if (code != RejectCode::None) {
+            rejects++;
+            continue;
+        }
+        engine.process(o, events);
+        for (const auto& e : events) {
+            if (const Fill* f = std::get_if<Fill>(&e.body)) {
+                risk.onFill(e.header.client_id, f->side, f->fill_qty, f->complete);
+            }
+        }
+    }
+    return std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / orders.size();
+}
+
+int main(int argc, char** argv) {
+    const uint64_t n = argc > 1 ? std::stoull(argv[1]) : 2000000;
+    const uint32_t clients = argc > 2 ? static_cast<uint32_t>(std::stoul(argv[2])) : 1000;
+    const auto orders = makeOrders(n, clients);
+
+    uint64_t rejects = 0;
+    const double base = runEngineOnly(orders);
+    const double with_risk = runWithRisk(orders, rejects);
+
+    std::cout << "Orders: " << n << " | Clients: " << clients << " | Risk rejects: " << rejects << std::endl;
+    std::cout << "Engine only:   " << base << " ns/order" << std::endl;
+    std::cout << "Risk + engine: " << with_risk << " ns/order" << std::endl;
+    std::cout << "Added by risk: " << with_risk - base << " ns/order" << std::endl;
+    return 0;
+}
@@ -0,0 +1,121 @@
+// Router-mode ingress with N concurrent DEALER clients (default 100), each
+// keeping a window of orders in flight. A stand-in parse worker answers every
+// order by pushing an ack to kRouterResponses, as OrderGenerator and the
+// matching thread do; InputStream routes it back to the sender. Reports acked
+// orders per second, round trips, and acks that reached the wrong client.
+//
+// g++ -O2 -std=c++17 -I./include -I./include/lib/zmq bench/bench_router.cpp src/input_stream.cpp src/shm_gateway.cpp -lzmq -lpthread -o bench_router
+// ./bench_router [clients] [orders_per_client] [window]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <zmq.hpp>
+#include "input_stream.hpp"
+#include "net/transport.hpp"
+
+using namespace ex;
+using Clock = std::chrono::steady_clock;
+
+int main(int argc, char** argv) {
+    const size_t clients = argc > 1 ? std::stoul(argv[1]) : 100;
+    const uint64_t per_client = argc > 2 ? std::stoull(argv[2]) : 20000;
+    const uint64_t window = argc > 3 ? std::stoull(argv[3]) : 8;
+    const std::string endpoint = "tcp://127.0.0.1:15560";
+
+    zmq::context_t context(2);
+    ThreadSafeQueue<InboundMessage> raw_queue(65536, OverflowPolicy::Block);
+    Sequencer sequencer(&raw_queue);
+    InputStream input(&sequencer, context, endpoint, ThrottleConfig(), IngressMode::Router);
+    std::thread(&InputStream::startListening, &input).detach();
+
+    std::thread worker([&] {
+        zmq::socket_t out(context, zmq::socket_type::push);
+        out.connect(kRouterResponses);
+        for (;;) {
+            const std::string raw = raw_queue.pop().payload;
+            if (raw.empty()) return;
+            ClientId client_id = 0;
+            SeqNum seq = 0;
+            scan_client_id(raw.data(), raw.size(), client_id);
+            scan_seq(raw.data(), raw.size(), seq);
+            const std::string ack = "{\"header\":{\"version\":1,\"type\":100,\"seq\":" + std::to_string(seq) +
+                                    ",\"client_id\":" + std::to_string(client_id) +
+                                    "},\"body\":{\"client_order_id\":" + std::to_string(seq) +
+                                    ",\"order_id\":1,\"symbol\":\"AAPL\"}}";
+            out.send(zmq::buffer(ack), zmq::send_flags::none);
+        }
+    });
+
+    struct Client {
+        zmq::socket_t socket;
+        ClientId id = 0;
+        uint64_t sent = 0, acked = 0;
+        std::vector<Clock::time_point> sent_at;
+    };
+    zmq::context_t client_ctx(1);
+    std::vector<Client> cs;
+    cs.reserve(clients);
+    for (size_t i = 0; i < clients; ++i) {
+        Client c;
+        c.socket = zmq::socket_t(client_ctx, zmq::socket_type::dealer);
+        c.id = static_cast<ClientId>(100 + i);
+        c.socket.connect(endpoint);
+        c.sent_at.resize(per_client + 1);
+        cs.push_back(std::move(c));
+    }
+
+    auto sendOne = [&](Client& c) {
+        const uint64_t seq = ++c.sent;
+        const std::string msg = "{\"header\":{\"version\":1,\"type\":1,\"seq\":" + std::to_string(seq) +
+                                ",\"client_id\":" + std::to_string(c.id) +
+                                "},\"body\":{\"client_order_id\":" + std::to_string(seq) +
+                                ",\"symbol\":\"AAPL\",\"side\":\"B\",\"ord_type\":\"LMT\",\"qty\":10,\"limit_price\":10123}}";
+        c.sent_at[seq] = Clock::now();
+        c.socket.send(zmq::buffer(msg), zmq::send_flags::none);
+    };
+
+    std::vector<zmq::pollitem_t> items;
+    for (Client& c : cs) items.push_back({ c.socket.handle(), 0, ZMQ_POLLIN, 0 });
+
+    std::vector<uint64_t> lat;
+    lat.reserve(clients * per_client);
+    uint64_t misrouted = 0, done = 0;
+    const auto t0 = Clock::now();
+    for (Client& c : cs) {
+        for (uint64_t w = 0; w < window && c.sent < per_client; ++w) sendOne(c);
+    }
+    while (done < clients) {
+        zmq::poll(items.data(), items.size(), std::chrono::milliseconds(1000));
+        for (size_t i = 0; i < cs.size(); ++i) {
+            if (!(items[i].revents & ZMQ_POLLIN)) continue;
+            Client& c = cs[i];
+            zmq::message_t ack;
+            while (c.socket.recv(ack, zmq::recv_flags::dontwait)) {
+                ClientId to = 0;
+                SeqNum seq = 0;
+                scan_client_id(static_cast<const char*>(ack.data()), ack.size(), to);
+                scan_seq(static_cast<const char*>(ack.data()), ack.size(), seq);
+                if (to != c.id || seq == 0 || seq > per_client) { ++misrouted; continue; }
+                lat.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - c.sent_at[seq]).count());
+                if (++c.acked == per_client) ++done;
+                if (c.sent < per_client) sendOne(c);
+            }
+        }
+    }
+    const double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+
+    std::sort(lat.begin(), lat.end());
+    std::cout << clients << " clients x " << per_client << " orders, window " << window << ": "
+              << static_cast<uint64_t>(lat.size() / secs) << " acks/s, round trip p50 "
+              << lat[lat.size() / 2] / 1000 << " us, p99 " << lat[lat.size() * 99 / 100] / 1000
+              << " us, misrouted " << misrouted << ", unroutable " << input.unroutable() << std::endl;
+
+    raw_queue.push(InboundMessage());
+    worker.join();
+    std::_Exit(0); // the listener thread owns its sockets until the process ends
+}
@@ -0,0 +1,114 @@
+// Cost of the ingress stage's routing decision per message.
+//
+// A mix of new orders, cancels and mass cancels, formatted as clients send
+// them (json.dumps spacing), through:
+//   client_id only  - scan_client_id, what the throttle reads
+//   separate scans  - type, seq, client_id and symbol with one scan each
+//   scan_header     - the four in one pass
+//   full parse      - parse_inbound_envelope, what the parse workers do
+// Checks scan_header against the full parse on every message first.
+//
+// g++ -O2 -std=c++17 -I./include bench/bench_scan.cpp -o bench_scan
+// ./bench_scan [messages] [rounds]
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "net/codec_json.hpp"
+
+using namespace ex;
+using Clock = std::chrono::steady_clock;
+
+static std::string message(uint64_t i) {
+    const std::string seq = std::to_string(i);
+    const std::string symbol = i % 3 == 0 ? "AAPL" : i % 3 == 1 ? "MSFT" : "GOOG";
+    switch (i % 20) {
+        case 0:  // client-wide mass cancel, no symbol
+            return "{\"header\": {\"version\": 1, \"type\": 3, \"seq\": " + seq + ", \"client_id\": 55}, "
+                   "\"body\": {\"client_order_id\": " + seq + ", \"scope\": \"CLIENT\"}}";
+        case 1:  // type by name
+            return "{\"header\": {\"version\": 1, \"type\": \"NewOrder\", \"seq\": " + seq + ", \"client_id\": 7}, "
+                   "\"body\": {\"client_order_id\": " + seq + ", \"symbol\": \"" + symbol +
+                   "\", \"side\": \"B\", \"ord_type\": \"LMT\", \"qty\": 10, \"limit_price\": 10123}}";
+        case 2: case 3: case 4: case 5:
+            return "{\"header\": {\"version\": 1, \"type\": 2, \"seq\": " + seq + ", \"client_id\": 7}, "
+                   "\"body\": {\"order_id\": " + std::to_string(i / 2) + ", \"client_order_id\": " + seq +
+                   ", \"symbol\": \"" + symbol + "\"}}";
+        default:
+            return "{\"header\": {\"version\": 1, \"type\": 1, \"seq\": " + seq + ", \"client_id\": 7}, "
+                   "\"body\": {\"client_order_id\": " + seq + ", \"symbol\": \"" + symbol +
+                   "\", \"side\": \"B\", \"ord_type\": \"LMT\", \"qty\": 10, \"limit_price\": 10123, \"tif\": \"DAY\"}}";
+    }
+}
+
+static std::string symbolOf(const EnvelopeIn& e) {
+    if (const auto* r = std::get_if<NewOrderRequest>(&e.body)) return r->symbol;
+    if (const auto* r = std::get_if<CancelRequest>(&e.body)) return r->symbol;
+    if (const auto* r = std::get_if<MassCancelRequest>(&e.body)) return r->symbol;
+    return std::string();
+}
+
+template <typename F>
+static double nsPerMsg(const std::vector<std::string>& msgs, int rounds, F&& f) {
+    uint64_t sink = 0;
+    const auto t0 = Clock::now();
+    for (int r = 0; r < rounds; ++r) {
+        for (const std::string& m : msgs) sink += f(m);
+    }
+    const double ns = std::chrono::duration<double, std::nano>(Clock::now() - t0).count();
+    if (sink == 42) std::cout << "";
+    return ns / (static_cast<double>(msgs.size()) * rounds);
+}
+
+int main(int argc, char** argv) {
+    const uint64_t n = argc > 1 ? std::stoull(argv[1]) : 100000;
+    const int rounds = argc > 2 ? std::stoi(argv[2]) : 10;
+
+    std::vector<std::string> msgs;
+    msgs.reserve(n);
+    size_t bytes = 0;
+    for (uint64_t i = 0; i < n; ++i) {
+        msgs.push_back(message(i + 1));
+        bytes += msgs.back().size();
+    }
+
+    for (const std::string& m : msgs) {
+        HeaderFields h;
+        const EnvelopeIn e = parse_inbound_envelope(m);
+        if (!scan_header(m.data(), m.size(), h) || h.type != e.header.type || h.seq != e.header.seq ||
+            h.client_id != e.header.client_id || std::string(h.symbol) != symbolOf(e)) {
+            std::cerr << "scan_header disagrees with the parser on " << m << std::endl;
+            return 1;
+        }
+    }
+
+    std::cout << n << " messages, " << bytes / n << " bytes on average" << std::endl;
+    std::cout << "client_id only: " << nsPerMsg(msgs, rounds, [](const std::string& m) {
+        ClientId c = 0;
+        scan_client_id(m.data(), m.size(), c);
+        return c;
+    }) << " ns/msg" << std::endl;
+    std::cout << "separate scans: " << nsPerMsg(msgs, rounds, [](const std::string& m) {
+        static constexpr char kType[] = "\"type\"";
+        uint64_t type = 0;
+        ClientId c = 0;
+        SeqNum seq = 0;
+        std::string_view symbol;
+        scan_uint_field(m.data(), m.size(), kType, sizeof(kType) - 1, type);
+        scan_seq(m.data(), m.size(), seq);
+        scan_client_id(m.data(), m.size(), c);
+        scan_symbol(m.data(), m.size(), symbol);
+        return type + seq + c + symbol.size();
+    }) << " ns/msg" << std::endl;
+    std::cout << "scan_header:    " << nsPerMsg(msgs, rounds, [](const std::string& m) {
+        HeaderFields h;
+        scan_header(m.data(), m.size(), h);
+        return static_cast<uint64_t>(h.type) + h.seq + h.client_id + h.symbol.size();
+    }) << " ns/msg" << std::endl;
+    std::cout << "full parse:     " << nsPerMsg(msgs, 1, [](const std::string& m) {
+        const EnvelopeIn e = parse_inbound_envelope(m);
+        return static_cast<uint64_t>(e.header.type) + e.header.seq;
+    }) << " ns/msg" << std::endl;
+    return 0;
+}
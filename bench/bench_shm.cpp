@@ -0,0 +1,99 @@
+// Round-trip latency and throughput of a shared-memory session: a client
+// thread on ShmClient, an exchange thread on ShmGateway echoing every message
+// back, the way the ingress thread polls and a responder answers. Compare
+// with the ipc/inproc rows of bench_transport. Both threads spin, so pin them
+// to separate cores; on a single core every trip costs a context switch.
+//
+// g++ -O2 -std=c++17 -I./include bench/bench_shm.cpp src/shm_gateway.cpp -lpthread -o bench_shm
+// ./bench_shm [round_trips] [messages] [msg_bytes]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "shm_gateway.hpp"
+#include "net/shm_client.hpp"
+
+using namespace ex;
+using Clock = std::chrono::steady_clock;
+
+int main(int argc, char** argv) {
+    const uint64_t trips = argc > 1 ? std::stoull(argv[1]) : 200000;
+    const uint64_t n = argc > 2 ? std::stoull(argv[2]) : 2000000;
+    const size_t bytes = argc > 3 ? std::stoul(argv[3]) : 200; // about one NewOrder
+    const ClientId client_id = 4242;
+
+    ShmGateway gateway({client_id});
+    ShmClient client;
+    if (!client.connect(client_id)) return 1;
+
+    // Spin, then give the core away, as InputStream's loop does
+    auto backoff = [](uint32_t& spins) {
+        if (++spins > 1000) std::this_thread::yield();
+    };
+
+    std::atomic<bool> done{false};
+    std::thread exchange([&] {
+        std::string reply;
+        uint32_t spins = 0;
+        while (!done.load(std::memory_order_relaxed)) {
+            const size_t got = gateway.poll([&](ClientId id, const char* data, size_t len) {
+                reply.assign(data, len);
+                gateway.send(id, reply);
+            });
+            if (got) spins = 0; else backoff(spins);
+        }
+    });
+
+    // An envelope for this session's client_id, padded out to msg_bytes; the
+    // gateway rejects anything naming another client
+    std::string payload = "{\"header\":{\"version\":1,\"type\":900,\"seq\":1,\"client_id\":" +
+                          std::to_string(client_id) + "},\"body\":{\"pad\":\"";
+    payload.append(bytes > payload.size() + 4 ? bytes - payload.size() - 4 : 0, 'x');
+    payload += "\"}}";
+    std::string msg;
+    uint32_t spins = 0;
+
+    // Latency: one message in flight
+    std::vector<uint64_t> lat;
+    lat.reserve(trips);
+    for (uint64_t i = 0; i < trips; ++i) {
+        const auto t0 = Clock::now();
+        while (client.send(payload) != ShmWrite::Ok) backoff(spins);
+        for (spins = 0; !client.poll(msg);) backoff(spins);
+        lat.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t0).count());
+    }
+    std::sort(lat.begin(), lat.end());
+
+    // Throughput: keep up to one ring of messages in flight so the echo
+    // never finds the egress ring full, drain replies as they come. A message
+    // over one slot's payload takes several slots.
+    const uint64_t window = 4096 / ((payload.size() + kShmPayload - 1) / kShmPayload);
+    uint64_t sent = 0, received = 0;
+    const auto t0 = Clock::now();
+    while (received < n) {
+        bool busy = false;
+        if (sent < n && sent - received < window && client.send(payload) == ShmWrite::Ok) { ++sent; busy = true; }
+        while (client.poll(msg)) { ++received; busy = true; }
+        if (busy) spins = 0; else backoff(spins);
+    }
+    const double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+
+    done = true;
+    exchange.join();
+
+    std::cout << trips << " round trips, " << bytes << " bytes: p50 " << lat[lat.size() / 2]
+              << " ns, p99 " << lat[lat.size() * 99 / 100] << " ns, p99.9 "
+              << lat[lat.size() * 999 / 1000] << " ns\n";
+    std::cout << n << " echoed messages: " << static_cast<uint64_t>(n / secs) << " msgs/s\n";
+    uint64_t dropped = 0, rejected = 0;
+    gateway.forEachSession([&](const ShmSessionCounters& c) {
+        dropped += c.dropped;
+        rejected += c.rejected;
+    });
+    std::cout << "dropped on egress: " << dropped << ", rejected: " << rejected << "\n";
+    return 0;
+}
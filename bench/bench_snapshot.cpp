@@ -0,0 +1,72 @@
+// Snapshot write / restore timing for large resting books, and the pause a
+// forked SnapshotWriter costs the matching thread instead of the write.
+//
+// g++ -O2 -std=c++17 -I./include bench/bench_snapshot.cpp src/order_book.cpp src/matching_engine.cpp src/snapshot.cpp -o bench_snapshot
+// ./bench_snapshot [resting_orders] [symbols]
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "matching_engine.hpp"
+#include "snapshot.hpp"
+
+using namespace ex;
+using Clock = std::chrono::steady_clock;
+
+static double msSince(Clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+int main(int argc, char** argv) {
+    const uint64_t num_orders = argc > 1 ? std::stoull(argv[1]) : 2000000;
+    const int num_symbols = argc > 2 ? std::stoi(argv[2]) : 100;
+    const std::string path = "bench.snapshot";
+
+    std::vector<std::string> symbols;
+    for (int i = 0; i < num_symbols; ++i) symbols.push_back("SYM" + std::to_string(i));
+
+    // Non-crossing book: bids at 9000..9499, asks at 10000..10499
+    MatchingEngine engine(num_orders);
+    std::vector<EnvelopeOut> events;
+    auto t0 = Clock::now();
+    for (uint64_t i = 1; i <= num_orders; ++i) {
+        const bool buy = i % 2 == 0;
+        const double px = buy ? 9000 + (i * 7) % 500 : 10000 + (i * 13) % 500;
+        Order o(i, i, i, symbols[i % num_symbols], buy ? Side::Buy : Side::Sell,
+                MsgType::NewOrder, px, 100);
+        o.client_id = static_cast<ClientId>(i % 64);
+        engine.process(o, events);
+    }
+    std::cout << "Built " << engine.restingCount() << " resting orders in " << msSince(t0) << " ms" << std::endl;
+
+    t0 = Clock::now();
+    if (!writeSnapshot(path, engine, num_orders, num_orders)) return 1;
+    std::cout << "Snapshot write:   " << msSince(t0) << " ms (on the calling thread)" << std::endl;
+
+    // What the matching thread pays with SnapshotWriter: the fork only
+    {
+        SnapshotWriter writer(path);
+        t0 = Clock::now();
+        if (!writer.start(engine, num_orders, num_orders)) return 1;
+        std::cout << "Snapshot fork:    " << msSince(t0) << " ms (child writes the file)" << std::endl;
+        while (writer.counters().written + writer.counters().failed == 0) std::this_thread::yield();
+        std::cout << "Child finished:   " << msSince(t0) << " ms" << std::endl;
+        if (writer.counters().failed) return 1;
+    }
+
+    MatchingEngine restored;
+    uint64_t last_order_id = 0;
+    uint64_t last_seq = 0;
+    t0 = Clock::now();
+    if (!loadSnapshot(path, restored, last_order_id, last_seq)) return 1;
+    const double restore_ms = msSince(t0);
+    std::cout << "Snapshot restore: " << restore_ms << " ms ("
+              << restored.restingCount() << " orders, last id " << last_order_id << ", "
+              << restore_ms * 1e6 / restored.restingCount() << " ns/order)" << std::endl;
+
+    std::remove(path.c_str());
+    return restored.restingCount() == engine.restingCount() ? 0 : 1;
+}
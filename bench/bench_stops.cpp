@@ -0,0 +1,86 @@
+// Stop trigger cost: one trade that sets off a cascade through a ladder of buy
+// stops, and plain matching with a large number of stops that never fire.
+//
+// g++ -O2 -std=c++17 -I./include bench/bench_stops.cpp src/order_book.cpp src/matching_engine.cpp -o bench_stops
+// ./bench_stops [stops] [stops_per_level]
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "matching_engine.hpp"
+
+using namespace ex;
+using Clock = std::chrono::steady_clock;
+
+static OrderId next_id = 0;
+
+static Order order(Side side, OrdType type, double px, uint32_t qty) {
+    Order o(0, ++next_id, 0, "AAPL", side, MsgType::NewOrder, px, qty);
+    o.ord_type = type;
+    o.client_id = 7;
+    return o;
+}
+
+static double nsSince(Clock::time_point t0) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - t0).count();
+}
+
+int main(int argc, char** argv) {
+    const uint64_t num_stops = argc > 1 ? std::stoull(argv[1]) : 1000000;
+    const uint64_t per_level = argc > 2 ? std::stoull(argv[2]) : 10;
+    const uint64_t levels = (num_stops + per_level - 1) / per_level;
+    std::vector<EnvelopeOut> events;
+
+    {
+        // Asks one lot per stop at every level from 10001, buy stops on the
+        // same ladder: each fired level of stops trades into the next level up
+        MatchingEngine engine(num_stops * 2);
+        for (uint64_t l = 1; l <= levels; ++l) {
+            engine.process(order(Side::Sell, OrdType::Limit, 10000 + l, per_level), events);
+        }
+        for (uint64_t i = 0; i < num_stops; ++i) {
+            Order s = order(Side::Buy, OrdType::Stop, 0, 1);
+            s.stop_price = 10000 + 1 + i / per_level;
+            engine.process(s, events);
+        }
+        events.clear();
+        events.reserve(num_stops * 2 + 16);
+
+        auto t0 = Clock::now();
+        engine.process(order(Side::Buy, OrdType::Limit, 10001, 1), events);
+        const double ns = nsSince(t0);
+
+        uint64_t pending = 0;
+        for (const auto& [px, level] : engine.book("AAPL").stops(Side::Buy)) {
+            (void)px;
+            pending += level.count;
+        }
+        std::cout << "Cascade: " << num_stops - pending << " stops fired over " << levels << " levels, " << events.size() << " fills in "
+                  << ns / 1e6 << " ms (" << ns / num_stops << " ns/stop)" << std::endl;
+    }
+
+    {
+        // Sell stops far below the market: every trade checks them, none fire
+        for (uint64_t pending : {uint64_t(0), num_stops}) {
+            MatchingEngine engine(pending + 1024);
+            for (uint64_t i = 0; i < pending; ++i) {
+                Order s = order(Side::Sell, OrdType::Stop, 0, 1);
+                s.stop_price = 1000 + i % 1000;
+                engine.process(s, events);
+            }
+            events.clear();
+
+            const uint64_t trades = 1000000;
+            auto t0 = Clock::now();
+            for (uint64_t i = 0; i < trades; ++i) {
+                engine.process(order(Side::Sell, OrdType::Limit, 10000, 1), events);
+                engine.process(order(Side::Buy, OrdType::Limit, 10000, 1), events);
+                events.clear();
+            }
+            std::cout << "Cross with " << pending << " pending stops: "
+                      << nsSince(t0) / trades << " ns/trade" << std::endl;
+        }
+    }
+    return 0;
+}
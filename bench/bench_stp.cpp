@@ -0,0 +1,54 @@
+// Matching cost with self-trade prevention off and on. Resting orders come
+// from other clients, so STP never fires and only the per-order client id
+// comparison is measured. A last run has about one contra order in ten
+// self-matching.
+//
+// g++ -O2 -std=c++17 -I./include bench/bench_stp.cpp src/order_book.cpp src/matching_engine.cpp -o bench_stp
+// ./bench_stp [resting_orders]
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "matching_engine.hpp"
+
+using namespace ex;
+using Clock = std::chrono::steady_clock;
+
+static void run(const char* what, uint64_t num_orders, StpMode stp, ClientId taker) {
+    MatchingEngine engine(num_orders);
+    std::vector<EnvelopeOut> events;
+    for (uint64_t i = 1; i <= num_orders; ++i) {
+        Order o(i, i, i, "AAPL", Side::Sell, MsgType::NewOrder, 10000 + (i * 13) % 100, 10);
+        o.client_id = static_cast<ClientId>(1 + (i / 100) % 10);
+        engine.process(o, events);
+    }
+    events.clear();
+    events.reserve(64);
+
+    // Each market buy takes three resting orders
+    OrderId id = num_orders;
+    uint64_t n = 0;
+    auto t0 = Clock::now();
+    while (engine.restingCount() > 0) {
+        Order o(0, ++id, 0, "AAPL", Side::Buy, MsgType::NewOrder, 0, 30);
+        o.ord_type = OrdType::Market;
+        o.client_id = taker ? taker : static_cast<ClientId>(1 + (id * 7) % 10);
+        o.stp = stp;
+        engine.process(o, events);
+        events.clear();
+        n++;
+    }
+    const double ns = std::chrono::duration<double, std::nano>(Clock::now() - t0).count();
+    std::cout << what << ": " << ns / n << " ns/order, " << ns / num_orders << " ns/contra order" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    const uint64_t num_orders = argc > 1 ? std::stoull(argv[1]) : 1000000;
+    for (int rep = 0; rep < 2; ++rep) {
+        run("STP off                  ", num_orders, StpMode::None, 99);
+        run("STP on, no self-match    ", num_orders, StpMode::CancelResting, 99);
+    }
+    run("STP on, mixed clients (CR)", num_orders, StpMode::CancelResting, 0);
+    return 0;
+}
@@ -0,0 +1,59 @@
+// Market / IOC orders sweeping through many price levels.
+//
+// g++ -O2 -std=c++17 -I./include bench/bench_sweep.cpp src/order_book.cpp src/matching_engine.cpp -o bench_sweep
+// ./bench_sweep [levels] [orders_per_level] [rounds]
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "matching_engine.hpp"
+
+using namespace ex;
+using Clock = std::chrono::steady_clock;
+
+int main(int argc, char** argv) {
+    const int levels = argc > 1 ? std::stoi(argv[1]) : 1000;
+    const int per_level = argc > 2 ? std::stoi(argv[2]) : 10;
+    const int rounds = argc > 3 ? std::stoi(argv[3]) : 50;
+    const uint32_t resting_qty = 100;
+
+    MatchingEngine engine(static_cast<size_t>(levels) * per_level);
+    std::vector<EnvelopeOut> events;
+    events.reserve(static_cast<size_t>(levels) * per_level * 2 + 1);
+    OrderId id = 0;
+
+    for (const char* kind : {"Market", "IOC limit"}) {
+        double total_ns = 0;
+        for (int r = 0; r < rounds; ++r) {
+            for (int l = 0; l < levels; ++l) {
+                for (int k = 0; k < per_level; ++k) {
+                    Order o(0, ++id, 0, "AAPL", Side::Sell, MsgType::NewOrder, 10000 + l, resting_qty);
+                    engine.process(o, events);
+                }
+            }
+            events.clear();
+
+            // Asks for one more lot than the book holds, so the remainder is cancelled
+            Order sweep(0, ++id, 0, "AAPL", Side::Buy, MsgType::NewOrder, 10000 + levels,
+                        static_cast<uint32_t>(levels * per_level) * resting_qty + 1);
+            if (kind[0] == 'M') sweep.ord_type = OrdType::Market;
+            else                sweep.tif = TimeInForce::IOC;
+
+            auto t0 = Clock::now();
+            engine.process(sweep, events);
+            total_ns += std::chrono::duration<double, std::nano>(Clock::now() - t0).count();
+
+            if (engine.restingCount() != 0) {
+                std::cerr << "Sweep left orders resting" << std::endl;
+                return 1;
+            }
+        }
+
+        const double per_sweep = total_ns / rounds;
+        std::cout << kind << " sweep of " << levels << " levels x " << per_level << " orders: "
+                  << per_sweep / 1000 << " us/sweep | " << per_sweep / levels << " ns/level | "
+                  << per_sweep / (levels * per_level) << " ns/fill" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,51 @@
+// Per-message cost of the ingress throttle (client_id scan + token bucket).
+//
+// g++ -O2 -std=c++17 -I./include bench/bench_throttle.cpp -o bench_throttle
+// ./bench_throttle [messages] [clients]
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "client_throttle.hpp"
+#include "net/codec_json.hpp"
+
+using namespace ex;
+using Clock = std::chrono::steady_clock;
+
+int main(int argc, char** argv) {
+    const uint64_t n = argc > 1 ? std::stoull(argv[1]) : 10000000;
+    const uint32_t clients = argc > 2 ? static_cast<uint32_t>(std::stoul(argv[2])) : 1000;
+
+    std::vector<std::string> msgs;
+    for (uint32_t c = 0; c < clients; ++c) {
+        msgs.push_back("{\"header\":{\"version\":1,\"type\":1,\"seq\":12,\"client_id\":" + std::to_string(c) +
+                       "},\"body\":{\"client_order_id\":999,\"symbol\":\"AAPL\",\"side\":\"B\","
+                       "\"ord_type\":\"LMT\",\"qty\":10,\"limit_price\":10123}}");
+    }
+
+    ThrottleConfig cfg;
+    cfg.rate_per_sec = 1000;
+    cfg.burst = 100;
+    ClientThrottle throttle(cfg);
+
+    uint64_t passed = 0;
+    auto t0 = Clock::now();
+    for (uint64_t i = 0; i < n; ++i) {
+        const std::string& m = msgs[i % clients];
+        ClientId client_id = 0;
+        scan_client_id(m.data(), m.size(), client_id);
+        const uint64_t now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            Clock::now().time_since_epoch()).count();
+        passed += throttle.allow(client_id, now_ns);
+    }
+    const double ns = std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / n;
+
+    uint64_t dropped = 0;
+    throttle.forEachClient([&](const ThrottleCounters& c) { dropped += c.dropped; });
+
+    std::cout << "Messages: " << n << " | Clients: " << clients << std::endl;
+    std::cout << "Passed: " << passed << " | Dropped: " << dropped << std::endl;
+    std::cout << "Scan + throttle: " << ns << " ns/msg" << std::endl;
+    return 0;
+}
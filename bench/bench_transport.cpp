@@ -0,0 +1,107 @@
+// PUSH/PULL throughput and round-trip latency over tcp, ipc and inproc, with
+// one shared context as the exchange now uses.
+//
+// g++ -O2 -std=c++17 -I./include -I./include/lib/zmq bench/bench_transport.cpp -lzmq -lpthread -o bench_transport
+// ./bench_transport [messages] [round_trips] [msg_bytes]
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <zmq.hpp>
+
+using Clock = std::chrono::steady_clock;
+
+// One-way: a sender thread pushes n messages, this thread pulls them
+static double throughput(zmq::context_t& ctx, const std::string& ep, uint64_t n, size_t bytes) {
+    zmq::socket_t pull(ctx, zmq::socket_type::pull);
+    pull.set(zmq::sockopt::rcvhwm, 10000);
+    pull.bind(ep);
+
+    std::thread sender([&] {
+        zmq::socket_t push(ctx, zmq::socket_type::push);
+        push.set(zmq::sockopt::sndhwm, 10000);
+        push.connect(ep);
+        const std::string payload(bytes, 'x');
+        for (uint64_t i = 0; i < n; ++i) {
+            push.send(zmq::buffer(payload), zmq::send_flags::none);
+        }
+    });
+
+    zmq::message_t msg;
+    (void)pull.recv(msg, zmq::recv_flags::none); // first message starts the clock
+    const auto t0 = Clock::now();
+    for (uint64_t i = 1; i < n; ++i) {
+        (void)pull.recv(msg, zmq::recv_flags::none);
+    }
+    const double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+    sender.join();
+    return (n - 1) / secs;
+}
+
+// Round trip over two PUSH/PULL pairs, the shape of an order and its ack.
+// Returns sorted per-trip latencies in ns.
+static std::vector<uint64_t> roundTrips(zmq::context_t& ctx, const std::string& there, const std::string& back,
+                                        uint64_t n, size_t bytes) {
+    zmq::socket_t in(ctx, zmq::socket_type::pull);
+    in.bind(there);
+    zmq::socket_t ack_in(ctx, zmq::socket_type::pull);
+    ack_in.bind(back);
+
+    std::thread echo([&] {
+        zmq::socket_t ack_out(ctx, zmq::socket_type::push);
+        ack_out.connect(back);
+        zmq::message_t msg;
+        for (uint64_t i = 0; i < n + 1; ++i) {
+            (void)in.recv(msg, zmq::recv_flags::none);
+            ack_out.send(msg, zmq::send_flags::none);
+        }
+    });
+
+    zmq::socket_t out(ctx, zmq::socket_type::push);
+    out.connect(there);
+    const std::string payload(bytes, 'x');
+    zmq::message_t reply;
+
+    // Warm-up trip so connection setup is not timed
+    out.send(zmq::buffer(payload), zmq::send_flags::none);
+    (void)ack_in.recv(reply, zmq::recv_flags::none);
+
+    std::vector<uint64_t> lat;
+    lat.reserve(n);
+    for (uint64_t i = 0; i < n; ++i) {
+        const auto t0 = Clock::now();
+        out.send(zmq::buffer(payload), zmq::send_flags::none);
+        (void)ack_in.recv(reply, zmq::recv_flags::none);
+        lat.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t0).count());
+    }
+    echo.join();
+    std::sort(lat.begin(), lat.end());
+    return lat;
+}
+
+int main(int argc, char** argv) {
+    const uint64_t n = argc > 1 ? std::stoull(argv[1]) : 2000000;
+    const uint64_t trips = argc > 2 ? std::stoull(argv[2]) : 100000;
+    const size_t bytes = argc > 3 ? std::stoul(argv[3]) : 200; // about one NewOrder
+
+    // Each socket gets its own endpoint so no bind waits on an earlier close
+    auto endpoint = [](const std::string& transport, int i) -> std::string {
+        if (transport == "tcp") return "tcp://127.0.0.1:" + std::to_string(15555 + i);
+        if (transport == "ipc") return "ipc:///tmp/bench_transport_" + std::to_string(i);
+        return "inproc://bench_transport_" + std::to_string(i);
+    };
+
+    std::cout << n << " messages, " << trips << " round trips, " << bytes << " bytes\n";
+    for (const std::string transport : {"tcp", "ipc", "inproc"}) {
+        zmq::context_t ctx(1);
+        const double rate = throughput(ctx, endpoint(transport, 0), n, bytes);
+        const std::vector<uint64_t> lat =
+            roundTrips(ctx, endpoint(transport, 1), endpoint(transport, 2), trips, bytes);
+        std::cout << transport << ":\t" << static_cast<uint64_t>(rate) << " msgs/s one-way, round trip p50 "
+                  << lat[lat.size() / 2] << " ns, p99 " << lat[lat.size() * 99 / 100] << " ns\n";
+    }
+    return 0;
+}
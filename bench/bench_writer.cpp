@@ -0,0 +1,136 @@
+// Cost of encoding one response.
+//
+// A mix of outbound envelopes in the proportions a busy book sends them
+// (acks and fills mostly, some cancels and rejects, the odd replace, mass
+// cancel ack and auction print), through:
+//   json tree     - json(e).dump(), the encoder before the writer
+//   dump_envelope - the writer into a scratch buffer, copied out as the
+//                   std::string the egress queue takes
+//   append only   - append_envelope into one reused buffer, no copy
+// Checks the writer against json(e).dump() byte for byte first, on the mix
+// and on strings that need escaping.
+//
+// g++ -O2 -std=c++17 -I./include bench/bench_writer.cpp -o bench_writer
+// ./bench_writer [messages] [rounds]
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "net/codec_json.hpp"
+
+using namespace ex;
+using Clock = std::chrono::steady_clock;
+
+static EnvelopeOut response(uint64_t i) {
+    EnvelopeOut e;
+    e.header.seq = i;
+    e.header.client_id = static_cast<ClientId>(1 + i % 40);
+    const std::string symbol = i % 3 == 0 ? "AAPL" : i % 3 == 1 ? "MSFT" : "GOOG";
+    const OrderId id = 1000000 + i;
+    switch (i % 20) {
+        case 0: case 1: case 2: case 3: case 4: case 5: case 6: {
+            e.header.type = MsgType::Ack;
+            e.body = Ack{ i, id, symbol };
+            break;
+        }
+        case 7: case 8: case 9: case 10: case 11: case 12: case 13: {
+            e.header.type = MsgType::Fill;
+            e.body = Fill{ id, symbol, i % 2 ? Side::Sell : Side::Buy, static_cast<Qty>(1 + i % 500),
+                           static_cast<Price>(10000 + i % 997), i % 4 == 0 };
+            break;
+        }
+        case 14: case 15: {
+            e.header.type = MsgType::Cancelled;
+            e.body = Cancelled{ id, i, symbol, Side::Buy, static_cast<Qty>(1 + i % 300), 0 };
+            break;
+        }
+        case 16: case 17: {
+            e.header.type = MsgType::Reject;
+            Reject r{ i, symbol, {} };
+            r.info.code = to_u(RejectCode::PriceCollar);
+            r.info.reason = reject_reason(RejectCode::PriceCollar);
+            e.body = r;
+            break;
+        }
+        case 18: {
+            e.header.type = MsgType::Replaced;
+            e.body = Replaced{ id, i, symbol, static_cast<Qty>(1 + i % 300), static_cast<Price>(10000 + i % 997) };
+            break;
+        }
+        default: {
+            if (i % 40 == 19) {
+                e.header.type = MsgType::MassCancelAck;
+                e.body = MassCancelAck{ i, i % 17 };
+            } else {
+                e.header.type = MsgType::AuctionInfo;
+                e.header.client_id = 0;
+                e.body = AuctionInfo{ symbol, static_cast<Price>(10000 + i % 997), static_cast<Qty>(i % 900),
+                                      -static_cast<Qty>(i % 50), i % 3 == 0 };
+            }
+        }
+    }
+    return e;
+}
+
+// Parse-error rejects carry the parser's message, which can quote anything
+static EnvelopeOut escaped(const std::string& text) {
+    EnvelopeOut e;
+    e.header.type = MsgType::Reject;
+    Reject r{ 0, "UNKNOWN", {} };
+    r.info.code = to_u(RejectCode::ParseError);
+    r.info.reason = text;
+    e.body = r;
+    return e;
+}
+
+template <typename F>
+static double nsPerMsg(const std::vector<EnvelopeOut>& msgs, int rounds, F&& f) {
+    uint64_t sink = 0;
+    const auto t0 = Clock::now();
+    for (int r = 0; r < rounds; ++r) {
+        for (const EnvelopeOut& e : msgs) sink += f(e);
+    }
+    const double ns = std::chrono::duration<double, std::nano>(Clock::now() - t0).count();
+    if (sink == 42) std::cout << "";
+    return ns / (static_cast<double>(msgs.size()) * rounds);
+}
+
+int main(int argc, char** argv) {
+    const uint64_t n = argc > 1 ? std::stoull(argv[1]) : 100000;
+    const int rounds = argc > 2 ? std::stoi(argv[2]) : 10;
+
+    std::vector<EnvelopeOut> msgs;
+    msgs.reserve(n);
+    size_t bytes = 0;
+    for (uint64_t i = 0; i < n; ++i) msgs.push_back(response(i + 1));
+
+    std::vector<EnvelopeOut> checks = msgs;
+    for (const char* text : { "quote \" backslash \\ slash /", "tab\tnewline\nreturn\r\b\f", "\x01\x1f\x7f",
+                              "caf\xc3\xa9", "" }) {
+        checks.push_back(escaped(text));
+    }
+    for (const EnvelopeOut& e : checks) {
+        const std::string expected = json(e).dump();
+        if (dump_envelope(e) != expected) {
+            std::cerr << "writer disagrees with dump():\n  " << dump_envelope(e) << "\n  " << expected << std::endl;
+            return 1;
+        }
+    }
+    for (const EnvelopeOut& e : msgs) bytes += dump_envelope(e).size();
+
+    std::cout << n << " responses, " << bytes / n << " bytes on average" << std::endl;
+    std::cout << "json tree:     " << nsPerMsg(msgs, rounds, [](const EnvelopeOut& e) {
+        return json(e).dump().size();
+    }) << " ns/msg" << std::endl;
+    std::cout << "dump_envelope: " << nsPerMsg(msgs, rounds, [](const EnvelopeOut& e) {
+        return dump_envelope(e).size();
+    }) << " ns/msg" << std::endl;
+    std::string buffer;
+    std::cout << "append only:   " << nsPerMsg(msgs, rounds, [&](const EnvelopeOut& e) {
+        buffer.clear();
+        append_envelope(buffer, e);
+        return buffer.size();
+    }) << " ns/msg" << std::endl;
+    return 0;
+}
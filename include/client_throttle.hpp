@@ -0,0 +1,107 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include "core/types.hpp"
+
+namespace ex {
+
+struct ThrottleConfig {
+    double rate_per_sec = 0;    // sustained messages per second per client (0 = off)
+    double burst = 0;           // bucket depth
+    uint32_t max_clients = 4096; // table size, rounded up to a power of two
+};
+
+struct ThrottleCounters {
+    ClientId client_id;
+    uint64_t passed;
+    uint64_t dropped;
+};
+
+// Per-client token bucket evaluated by the ingress thread on every message.
+// The table is allocated once up front (open addressing, linear probing), so
+// allow() never locks or allocates. Counters are relaxed atomics so other
+// threads can read them while the ingress thread writes.
+class ClientThrottle {
+public:
+    explicit ClientThrottle(const ThrottleConfig& cfg = ThrottleConfig())
+        : config(cfg), capacity(roundUp(cfg.max_clients)), slots(new Slot[capacity]) {}
+
+    bool enabled() const { return config.rate_per_sec > 0; }
+
+    // Consumes one token for client_id. Returns false if the message should be dropped.
+    bool allow(ClientId client_id, uint64_t now_ns) {
+        Slot& s = slotFor(client_id, now_ns);
+
+        const double elapsed = static_cast<double>(now_ns - s.last_ns) * 1e-9;
+        s.last_ns = now_ns;
+        s.tokens += elapsed * config.rate_per_sec;
+        if (s.tokens > config.burst) s.tokens = config.burst;
+
+        if (s.tokens < 1.0) {
+            s.dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        s.tokens -= 1.0;
+        s.passed.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Calls fn(const ThrottleCounters&) for every client seen so far.
+    template <class Fn>
+    void forEachClient(Fn&& fn) const {
+        for (uint32_t i = 0; i < capacity; ++i) {
+            const Slot& s = slots[i];
+            if (!s.used.load(std::memory_order_acquire)) continue;
+            fn(ThrottleCounters{ s.client_id, s.passed.load(std::memory_order_relaxed),
+                                 s.dropped.load(std::memory_order_relaxed) });
+        }
+    }
+
+    uint64_t dropped(ClientId client_id) const {
+        uint64_t n = 0;
+        forEachClient([&](const ThrottleCounters& c) { if (c.client_id == client_id) n = c.dropped; });
+        return n;
+    }
+
+private:
+    struct Slot {
+        ClientId client_id = 0;
+        std::atomic<bool> used{false};
+        double tokens = 0;
+        uint64_t last_ns = 0;
+        std::atomic<uint64_t> passed{0};
+        std::atomic<uint64_t> dropped{0};
+    };
+
+    static uint32_t roundUp(uint32_t n) {
+        uint32_t c = 1;
+        while (c < n) c <<= 1;
+        return c;
+    }
+
+    // Once the table is full, unseen clients share the slot their probe ends on.
+    Slot& slotFor(ClientId client_id, uint64_t now_ns) {
+        const uint32_t mask = capacity - 1;
+        uint32_t i = (client_id * 2654435761u) & mask;
+        for (uint32_t probes = 0; probes < capacity; ++probes, i = (i + 1) & mask) {
+            Slot& s = slots[i];
+            if (!s.used.load(std::memory_order_relaxed)) {
+                s.client_id = client_id;
+                s.tokens = config.burst;
+                s.last_ns = now_ns;
+                s.used.store(true, std::memory_order_release);
+                return s;
+            }
+            if (s.client_id == client_id) return s;
+        }
+        return slots[i];
+    }
+
+    ThrottleConfig config;
+    uint32_t capacity;
+    std::unique_ptr<Slot[]> slots;
+};
+
+} // namespace ex
@@ -17,4 +17,26 @@ struct RejectInfo {
   int code = 0;
 };
 
+// Default RejectInfo::reason text for each RejectCode
+inline const char* reject_reason(RejectCode code) {
+  switch (code) {
+    case RejectCode::None:             return "";
+    case RejectCode::ParseError:       return "Parse error";
+    case RejectCode::Overloaded:       return "Exchange overloaded";
+    case RejectCode::SequenceGap:      return "Unexpected sequence number";
+    case RejectCode::MaxOrderQty:      return "Order quantity exceeds limit";
+    case RejectCode::MaxNotional:      return "Order notional exceeds limit";
+    case RejectCode::PriceCollar:      return "Price outside collar around last trade";
+    case RejectCode::MaxOpenOrders:    return "Too many open orders";
+    case RejectCode::MaxGrossPosition: return "Gross position limit exceeded";
+    case RejectCode::KillSwitch:       return "Client blocked by kill switch";
+    case RejectCode::InvalidOrder:     return "Invalid quantity or price";
+    case RejectCode::NoReferencePrice: return "No reference price for market order";
+    case RejectCode::UnknownOrder:     return "Unknown order";
+    case RejectCode::NotAuthorized:    return "Not authorized";
+    case RejectCode::InvalidReplace:   return "Invalid replace";
+  }
+  return "Rejected";
+}
+
 } // namespace ex
@@ -17,11 +17,25 @@ struct NewOrderRequest {
   OrdType ord_type = OrdType::Limit;
   Qty qty = 0;
 
-  // For LMT only (ignored for MKT).
+  // For LMT and STPLMT only (ignored for MKT and STP).
   Price limit_price = 0;
 
+  // For STP and STPLMT: the order stays off the book until a trade prints
+  // at or through this price (at or above for buys, at or below for sells),
+  // then enters as a market or limit order.
+  Price stop_price = 0;
+
   // Optional (default Day)
   TimeInForce tif = TimeInForce::Day;
+  // GTD only: last session date the order stays on the book, as YYYYMMDD
+  uint32_t expire_date = 0;
+
+  // Optional iceberg peak: only this much is shown at a time and the rest
+  // is replenished from a hidden reserve (0 = fully displayed)
+  Qty display_qty = 0;
+
+  // Optional self-trade prevention (default none)
+  StpMode stp = StpMode::None;
 };
 
 struct CancelRequest {
@@ -31,6 +45,56 @@ struct CancelRequest {
   std::string symbol;
 };
 
+// Modifies a resting order in place. qty is the new open quantity. Lowering
+// it at an unchanged price keeps queue priority; raising it or moving the
+// price sends the order to the back of its (new) level. client_order_id, if
+// set, replaces the order's id for later cancels.
+struct ReplaceRequest {
+  OrderId order_id = 0;
+  uint64_t client_order_id = 0;
+  std::string symbol;
+  Qty qty = 0;
+  Price limit_price = 0;
+};
+
+// Non-admin senders are always limited to their own orders: Client scope
+// cancels everything they have resting, Symbol scope only that symbol. Admin
+// senders may name any target client, in any scope, to cancel only that
+// client's orders; without one they clear a whole symbol or every book.
+struct MassCancelRequest {
+  uint64_t client_order_id = 0;   // request id, echoed in the MassCancelAck
+  MassCancelScope scope = MassCancelScope::Client;
+  ClientId target_client_id = 0;  // admin only (default: sender in Client scope)
+  std::string symbol;             // Symbol scope
+};
+
+// Admin only. StartCall puts the symbol's book (every book if symbol is
+// empty) into a call auction: limit orders rest without matching and market
+// and IOC orders are cancelled. Uncross executes the call at the single price
+// that maximizes volume and returns the book to continuous matching. Used for
+// both the opening and the closing auction.
+struct AuctionRequest {
+  uint64_t client_order_id = 0;
+  std::string symbol;
+  AuctionAction action = AuctionAction::StartCall;
+};
+
+// Admin only. Closes the session dated session_date (YYYYMMDD): every Day
+// order and every GTD order expiring on or before that date is cancelled with
+// an unsolicited Cancelled. The requester gets a MassCancelAck with the count.
+struct EndOfSessionRequest {
+  uint64_t client_order_id = 0;
+  uint32_t session_date = 0;
+};
+
+// Admin only. Blocks (or unblocks) a client's new orders.
+struct KillSwitchRequest {
+  uint64_t client_order_id = 0;
+  ClientId target_client_id = 0;
+  bool enabled = true;
+  bool cancel_open = true;        // also mass-cancel the client's resting orders
+};
+
 // ===================== OUTBOUND (venue -> client) =====================
 
 struct Ack {
@@ -54,7 +118,43 @@ struct Fill {
   bool complete = false;
 };
 
-using InboundMsg  = std::variant<NewOrderRequest, CancelRequest>;
-using OutboundMsg = std::variant<Ack, Reject, Fill>;
+// Unsolicited or requested removal of a resting order. Self-trade
+// prevention in Decrement mode can cancel part of an order, leaving
+// leaves_qty open; otherwise the order is gone.
+struct Cancelled {
+  OrderId order_id = 0;
+  uint64_t client_order_id = 0;
+  std::string symbol;
+  Side side = Side::Buy;
+  Qty cancelled_qty = 0;
+  Qty leaves_qty = 0;
+};
+
+struct Replaced {
+  OrderId order_id = 0;
+  uint64_t client_order_id = 0;
+  std::string symbol;
+  Qty qty = 0;
+  Price limit_price = 0;
+};
+
+// Public, client_id 0 in the header. During a call it carries the indicative
+// uncross after each order; uncrossed is set on the final print.
+struct AuctionInfo {
+  std::string symbol;
+  Price price = 0;
+  Qty qty = 0;
+  Qty imbalance = 0;   // buy minus sell quantity left at price
+  bool uncrossed = false;
+};
+
+struct MassCancelAck {
+  uint64_t client_order_id = 0;
+  uint64_t cancelled_count = 0;
+};
+
+using InboundMsg  = std::variant<NewOrderRequest, CancelRequest, ReplaceRequest, MassCancelRequest,
+                                 KillSwitchRequest, AuctionRequest, EndOfSessionRequest>;
+using OutboundMsg = std::variant<Ack, Reject, Fill, Cancelled, Replaced, MassCancelAck, AuctionInfo>;
 
 } // namespace ex
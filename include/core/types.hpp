@@ -12,18 +12,55 @@ using Price = int64_t;
 using Qty   = int64_t;
 
 enum class Side : uint8_t { Buy = 1, Sell = 2 };
-enum class OrdType : uint8_t { Market = 1, Limit = 2 };   
-enum class TimeInForce : uint8_t { Day = 1, IOC = 2 };    
+enum class OrdType : uint8_t { Market = 1, Limit = 2, Stop = 3, StopLimit = 4 };   
+enum class TimeInForce : uint8_t { Day = 1, IOC = 2, GTC = 3, GTD = 4 };    
+enum class MassCancelScope : uint8_t { Client = 1, Symbol = 2, All = 3 };
+enum class AuctionAction : uint8_t { StartCall = 1, Uncross = 2 };
+// Self-trade prevention, set on the incoming order and applied when it meets
+// a resting order from the same client_id
+enum class StpMode : uint8_t { None = 0, CancelResting = 1, CancelAggressor = 2, CancelBoth = 3, Decrement = 4 };
 
 enum class MsgType : uint16_t {
   NewOrder = 1,
   Cancel  = 2,
+  MassCancel = 3,
+  KillSwitch = 4,
+  Replace    = 5,
+  Auction    = 6,
+  EndOfSession = 7,
 
   Ack     = 100,
   Reject  = 101,
   Fill    = 102,
+  Cancelled     = 103,
+  MassCancelAck = 104,
+  Replaced      = 105,
+  AuctionInfo   = 106,
 
   Heartbeat = 900
 };
 
+// Carried in RejectInfo::code
+enum class RejectCode : int {
+  None             = 0,
+  ParseError       = 1,
+  Overloaded       = 2,
+  SequenceGap      = 3,
+
+  // Pre-trade risk
+  MaxOrderQty      = 10,
+  MaxNotional      = 11,
+  PriceCollar      = 12,
+  MaxOpenOrders    = 13,
+  MaxGrossPosition = 14,
+  KillSwitch       = 15,
+  InvalidOrder     = 16,  // quantity or price out of range
+  NoReferencePrice = 17,  // market order before the book's first trade
+
+  // Cancels and admin requests
+  UnknownOrder     = 20,
+  NotAuthorized    = 21,
+  InvalidReplace   = 22
+};
+
 }
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <zmq.hpp>
+#include "core/types.hpp"
+#include "session_routes.hpp"
+#include "spsc_queue.hpp"
+
+namespace ex {
+
+struct OutboundMessage {
+    ClientId client_id = 0;
+    std::string payload;
+    uint64_t hold_until = 0;  // sequence number the backup must have first, 0 = none
+};
+
+struct EgressCounters {
+    uint64_t sent;            // responses written to the ZMQ socket
+    uint64_t routed;          // responses handed to a shm or TCP gateway session
+    uint64_t batches;         // multipart messages sent
+    uint64_t producer_waits;  // sends that found their queue full
+    uint64_t discarded;       // dropped in standby (a backup's own responses)
+    uint64_t replayed;        // kept in standby and sent on promotion
+};
+
+// The exchange's one outbound stage. Every responding thread (the parse
+// workers and the matching thread) gets its own Producer, a lock-free SPSC
+// queue, and hands it finished responses; the egress thread drains the
+// queues, routes each response to the client's gateway session if it has
+// one, and sends the rest on the single ZMQ egress socket as multipart
+// messages of up to max_batch responses. It flushes whenever it has caught
+// up with the producers, so batching never holds a response back while the
+// thread would otherwise be idle.
+//
+// A client's responses from one producer leave in the order they were sent.
+// The matching thread is the only producer of acks, fills and cancels; the
+// workers only answer orders that never reached it (parse errors, overload).
+//
+// With a replication watermark (holdFor), a response tagged with a sequence
+// number waits until the backup has that message, so nothing is acked that
+// a failover could lose. The wait only stops that producer's queue; the
+// matching thread itself never waits for the backup. A backup runs its
+// stage in standby, discarding the responses its matching produces until
+// it is promoted; with retainFor it keeps those the primary has not
+// released yet and sends them first once promoted.
+class EgressStage {
+public:
+    class Producer {
+    public:
+        // Owning thread only. Spins, then yields, while the egress thread
+        // catches up with a full queue.
+        void send(ClientId client_id, std::string msg);
+
+        // Responses sent from now on wait for the replication watermark to
+        // reach seq (the message they answer)
+        void holdUntil(uint64_t seq) { hold_until = seq; }
+
+    private:
+        friend class EgressStage;
+        explicit Producer(size_t capacity) : queue(capacity) {}
+
+        SpscQueue<OutboundMessage> queue;
+        uint64_t hold_until = 0;
+        std::atomic<uint64_t> waits{0};
+    };
+
+    EgressStage(zmq::context_t& context, const std::string& endpoint, const SessionRoutes* routes = nullptr,
+                size_t queue_capacity = 16384, size_t max_batch = 256);
+    ~EgressStage();
+
+    EgressStage(const EgressStage&) = delete;
+    EgressStage& operator=(const EgressStage&) = delete;
+
+    // One per responding thread, all added before start()
+    Producer* addProducer();
+
+    // Highest sequence number the backup has confirmed; set before start()
+    void holdFor(const std::atomic<uint64_t>* replicated) { watermark = replicated; }
+
+    // Standby: keep responses to messages past *released (the primary's
+    // release watermark) instead of dropping them; set before start()
+    void retainFor(const std::atomic<uint64_t>* released) { primary_released = released; }
+
+    // Highest sequence number whose responses have been handed to the socket
+    // or a gateway session; what a primary reports to its backup
+    const std::atomic<uint64_t>* released() const { return &released_seq; }
+
+    // Standby drops every response; a promoted backup turns it off
+    void setStandby(bool on) { standby.store(on, std::memory_order_release); }
+
+    void start();
+    // Drains what the producers have queued, then joins the egress thread
+    void stop();
+
+    EgressCounters counters() const;
+
+private:
+    // Idle passes before the egress thread yields, then sleeps between passes
+    static constexpr uint32_t kSpinPasses = 1000;
+    static constexpr uint32_t kYieldPasses = 100000;
+    // Per queue per pass, so one busy producer cannot starve the others
+    static constexpr size_t kDrainPerQueue = 64;
+
+    void run();
+    size_t drain();
+    void flush();
+    void markReleased(uint64_t seq);
+
+    zmq::socket_t socket;
+    const SessionRoutes* routes;
+    const std::atomic<uint64_t>* watermark = nullptr;
+    const std::atomic<uint64_t>* primary_released = nullptr;
+    std::atomic<bool> standby{false};
+    size_t queue_capacity;
+    size_t max_batch;
+
+    std::vector<std::unique_ptr<Producer>> producers;
+    std::vector<std::string> pending;
+    uint64_t pending_seq = 0;               // highest hold_until in pending
+    std::deque<OutboundMessage> retained;   // standby responses to replay
+    std::atomic<uint64_t> released_seq{0};
+    std::thread thread;
+    std::atomic<bool> running{false};
+
+    std::atomic<uint64_t> sent{0};
+    std::atomic<uint64_t> routed{0};
+    std::atomic<uint64_t> batches{0};
+    std::atomic<uint64_t> discarded{0};
+    std::atomic<uint64_t> replayed{0};
+};
+
+} // namespace ex
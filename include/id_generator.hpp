@@ -11,6 +11,11 @@ public:
         return ++current_id;
     }
 
+    // Last id handed out; persisted in snapshots so a restart resumes after it.
+    uint64_t current() const {
+        return current_id.load();
+    }
+
 private:
     // Atomic prevent two threads from getting the same ID.
     std::atomic<uint64_t> current_id;
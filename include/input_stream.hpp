@@ -1,31 +1,99 @@
 #pragma once
 
+#include <atomic>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 #include <zmq.hpp>
 #include "order.hpp"
-#include "thread_safe_queue.hpp"
+#include "sequencer.hpp"
 #include "net/codec_json.hpp"
-#include "id_generator.hpp"
+#include "client_throttle.hpp"
+#include "shm_gateway.hpp"
 
 namespace ex {
 
+// Pull: clients PUSH orders and bind their own PULL for responses.
+// Router: clients use DEALER sockets and responses come back on them (see
+// kRouterResponses in net/transport.hpp).
+enum class IngressMode : uint8_t { Pull, Router };
+
 class InputStream {
 public:
-    // We now take two ports: one for incoming orders, one for outgoing status
-    explicit InputStream(ThreadSafeQueue<std::string>* raw_queue, const std::string& in_port);
+    // Most parts taken from one multipart message; the rest are dropped
+    static constexpr size_t kMaxBatch = 256;
+
+    // Binds a PULL (or ROUTER) on endpoint, see net/transport.hpp. The
+    // context is shared with the responders so the router's inproc response
+    // endpoint can reach them. In Router mode this thread also binds
+    // kRouterResponses and is the single sender of every response on the
+    // ROUTER socket. Accepted messages are numbered by the sequencer on their
+    // way to the raw queue.
+    InputStream(Sequencer* sequencer, zmq::context_t& context,
+                const std::string& endpoint,
+                const ThrottleConfig& throttle_config = ThrottleConfig(),
+                IngressMode mode = IngressMode::Pull);
     
     ~InputStream();
 
+    // Also take orders from the gateway's shared-memory sessions. Must be
+    // called before startListening; the loop then busy-polls both sources.
+    void attachShm(ShmGateway* gateway) { shm = gateway; }
+
     void startListening();
     void stop();
 
+    // Per-client pass/drop counters; safe to read from any thread.
+    const ClientThrottle& throttle() const { return client_throttle; }
+
+    // Router mode: responses dropped because their client_id has never
+    // sent on the ROUTER
+    uint64_t unroutable() const { return unroutable_count.load(std::memory_order_relaxed); }
+    // Router mode: messages rejected at ingress, for lacking a client_id or
+    // naming one bound to another identity
+    uint64_t refused() const { return refused_count.load(std::memory_order_relaxed); }
+    // Parts dropped from multipart messages longer than kMaxBatch
+    uint64_t truncated() const { return truncated_count.load(std::memory_order_relaxed); }
+
 private:
+    // Throttles one raw message into the pending batch; session is the
+    // shm session's client it came in on, 0 for ZMQ
+    void admit(ClientId client_id, const char* data, size_t len, ClientId session = 0);
+    // Queues the pending batch for the parse workers under one lock. In
+    // Router mode it queues only what fits and leaves the rest in batch.
+    void flushBatch();
+    // Reads one ZMQ message; a multipart message is a batch, one order per part
+    bool receiveZmq(zmq::recv_flags flags);
+    // Router mode: a client_id belongs to the first identity it arrives
+    // from. Returns false, with a Reject queued in refusals, for a message
+    // without one or from any other identity.
+    bool claim(const zmq::message_t& identity, const char* data, size_t len, ClientId& client_id);
+    // Router mode: sends waiting responses to their clients' identities
+    bool forwardResponses();
 
     // ZMQ Infrastructure
-    zmq::context_t context;
     zmq::socket_t in_socket;   // For receiving JSON Orders
+    IngressMode mode;
+
+    // Router mode, listen thread only: responders' PUSH sockets connect here,
+    // each client's bound ROUTER identity and the identities holding one
+    zmq::socket_t responses;
+    std::unordered_map<ClientId, std::string> identities;
+    std::unordered_set<std::string> peers;
+    std::vector<std::string> refusals;
+    std::vector<zmq::message_t> response_parts;
+    std::vector<ClientId> response_clients;
+    std::atomic<uint64_t> unroutable_count{0};
+    std::atomic<uint64_t> refused_count{0};
+
+    Sequencer* sequencer;
+    ShmGateway* shm = nullptr;
+    std::vector<InboundMessage> batch;
+    std::atomic<uint64_t> truncated_count{0};
 
-    ThreadSafeQueue<std::string>* raw_queue;
+    // Applied before messages reach the parser pool; owned by the listen thread
+    ClientThrottle client_throttle;
     
     bool running;
 };
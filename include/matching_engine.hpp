@@ -0,0 +1,140 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "order.hpp"
+#include "order_book.hpp"
+#include "net/codec_json.hpp"
+
+namespace ex {
+
+// Owns every book, the shared order pool and the order-id index. Only the
+// matching thread touches it, so nothing here is synchronized.
+class MatchingEngine {
+public:
+    using Books = std::unordered_map<std::string, OrderBook>;
+
+    explicit MatchingEngine(size_t expected_orders = 0);
+
+    MatchingEngine(const MatchingEngine&) = delete;
+    MatchingEngine& operator=(const MatchingEngine&) = delete;
+
+    // Applies a NewOrder, Cancel or Replace from the order queue; resulting
+    // Fills, Cancelled/Replaced confirmations and Rejects are appended to out.
+    // Stops fired by any trades are worked before it returns.
+    void process(const Order& o, std::vector<EnvelopeOut>& out);
+
+    // Removes a resting order by venue id. Returns false if it is not resting.
+    bool cancel(OrderId order_id, std::vector<EnvelopeOut>& out);
+
+    // Mass cancels. Each walks only the orders it removes, via the client's
+    // order list or the book's level FIFOs, and emits one Cancelled per order.
+    // cancelClient can be limited to one book. All return the number cancelled.
+    size_t cancelClient(ClientId client_id, const OrderBook* only, std::vector<EnvelopeOut>& out);
+    size_t cancelBook(OrderBook& book, std::vector<EnvelopeOut>& out);
+    size_t cancelAll(std::vector<EnvelopeOut>& out);
+
+    // Call auction. startAuction stops matching in the book; uncross executes
+    // everything that crosses at one price and resumes continuous matching.
+    // Both emit an AuctionInfo; uncross returns the executed quantity.
+    void startAuction(OrderBook& book, std::vector<EnvelopeOut>& out);
+    Qty uncross(OrderBook& book, std::vector<EnvelopeOut>& out);
+    // Price that maximizes executable volume in the crossed part of the book,
+    // ties broken by smallest imbalance then nearest the last trade. Returns
+    // false if the book does not cross.
+    bool indicative(const OrderBook& book, AuctionInfo& info);
+
+    // End-of-session expiry: cancels Day orders and GTD orders dated on or
+    // before session_date, at most max_orders per call so the caller can
+    // publish in batches. Walks only the expiring orders. Returns the number
+    // cancelled; 0 once nothing is left to expire.
+    size_t expire(uint32_t session_date, size_t max_orders, std::vector<EnvelopeOut>& out);
+
+    OrderBook& book(const std::string& symbol);
+    OrderBook* findBook(const std::string& symbol);
+    const Books& books() const { return symbol_books; }
+    const OrderPool& pool() const { return order_pool; }
+    size_t restingCount() const { return order_index.size(); }
+    const RestingOrder* find(OrderId order_id) const;
+    const OrderBook& bookOf(const RestingOrder& r) const { return *book_table[r.book]; }
+
+    // Snapshot restore: re-inserts a resting order without matching. Orders
+    // must arrive level by level in ascending price and FIFO order per side.
+    void reserve(size_t n);
+    void restore(OrderBook& book, const RestingOrder& r);
+
+private:
+    // Head/tail of an intrusive list of resting orders: a client's orders,
+    // or the orders expiring at one session end
+    struct ClientOrders {
+        uint32_t head = kNullIndex;
+        uint32_t tail = kNullIndex;
+    };
+    using ExpiryList = ClientOrders;
+
+    // The incoming side of a match. seq is the request's, stamped on the
+    // taker's own Cancelled; 0 for a stop or auction order no request is
+    // waiting on.
+    struct Taker {
+        OrderId  order_id;
+        uint64_t client_order_id;
+        ClientId client_id;
+        Side     side;
+        StpMode  stp;
+        SeqNum   seq;
+    };
+    static Taker takerOf(const RestingOrder& r, SeqNum seq = 0) {
+        return Taker{ r.order_id, r.client_order_id, r.client_id, r.side, r.stp, seq };
+    }
+
+    // Trades qty against the contra side of b; returns the unfilled quantity.
+    // Returns 0 if self-trade prevention cancelled the taker's remainder.
+    Qty match(OrderBook& b, const Taker& t, Price limit, bool is_market, Qty qty,
+              std::vector<EnvelopeOut>& out);
+    // Applies t.stp against a resting order from the same client; returns the
+    // taker's new remaining quantity.
+    Qty preventSelfTrade(OrderBook& b, PriceLevel& level, uint32_t idx, const Taker& t,
+                         Qty remaining, std::vector<EnvelopeOut>& out);
+    void submit(const Order& o, std::vector<EnvelopeOut>& out);
+    void place(OrderBook& b, const Order& o, std::vector<EnvelopeOut>& out);
+    void addStop(OrderBook& b, const Order& o);
+    // Works every stop the book's last trade has fired, including cascades.
+    void triggerStops(OrderBook& b, std::vector<EnvelopeOut>& out);
+    void activateStop(OrderBook& b, uint32_t idx, std::vector<EnvelopeOut>& out);
+    void cancelRequest(const Order& o, std::vector<EnvelopeOut>& out);
+    void replace(const Order& o, std::vector<EnvelopeOut>& out);
+
+    void linkClient(uint32_t idx);
+    void unlinkClient(uint32_t idx);
+    // No-ops for orders that never expire (GTC)
+    void linkExpiry(uint32_t idx);
+    void unlinkExpiry(uint32_t idx);
+    // Unlinks from book, client list and index, and frees the slot.
+    void removeResting(uint32_t idx);
+
+    void emitFill(OrderId order_id, ClientId client_id, const std::string& symbol, Side side,
+                  Qty qty, Price px, bool complete, std::vector<EnvelopeOut>& out);
+    void emitCancelled(const RestingOrder& r, const std::string& symbol, std::vector<EnvelopeOut>& out);
+    void emitAuctionInfo(const AuctionInfo& info, std::vector<EnvelopeOut>& out);
+    // Takes one traded-out resting order off the book, or refills an iceberg
+    void retire(OrderBook& b, PriceLevel& level, uint32_t idx);
+
+    OrderPool order_pool;
+    Books symbol_books;
+    std::vector<OrderBook*> book_table; // indexed by OrderBook::id()
+    std::unordered_map<OrderId, uint32_t> order_index;
+    std::unordered_map<ClientId, ClientOrders> client_orders;
+    ExpiryList day_orders;
+    std::map<uint32_t, ExpiryList> gtd_orders;   // by expire_date
+    std::vector<uint32_t> fired_stops;  // scratch for triggerStops
+
+    // Scratch ladder for indicative(): one entry per level price in the
+    // crossed range, bid and ask quantity at that price
+    std::vector<Price> ladder_px;
+    std::vector<Qty> ladder_bid;
+    std::vector<Qty> ladder_ask;
+};
+
+} // namespace ex
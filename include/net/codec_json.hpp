@@ -2,15 +2,20 @@
 
 #include "lib/nlohmann/json.hpp"
 
+#include <array>
 #include <cstdint>
+#include <cstring>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <type_traits>
 #include <variant>
 
 #include "core/types.hpp"
 #include "core/message.hpp"
 #include "core/messages.hpp"
+#include "net/json_scan.hpp"
+#include "net/json_writer.hpp"
 
 namespace ex {
 
@@ -40,8 +45,11 @@ constexpr std::underlying_type_t<E> to_u(E e) noexcept {
 // -----------------------------------------------------------------------------
 // Enum <-> JSON (canonical output uses short codes from the example)
 //   Side:        "B" | "S"
-//   OrdType:     "MKT" | "LMT"
-//   TimeInForce: "DAY" | "IOC"
+//   OrdType:     "MKT" | "LMT" | "STP" | "STPLMT"
+//   TimeInForce: "DAY" | "IOC" | "GTC" | "GTD"
+//   MassCancelScope: "CLIENT" | "SYMBOL" | "ALL"
+//   AuctionAction:   "CALL" | "UNCROSS"
+//   StpMode:         "NONE" | "CR" | "CA" | "CB" | "DC"
 //   MsgType:     numeric (uint16) in header
 // -----------------------------------------------------------------------------
 
@@ -54,16 +62,25 @@ inline std::string side_to_code(Side s) {
   throw std::runtime_error("Invalid Side");
 }
 
+// The _from_code / _from_name pairs do not throw, so has_required can
+// check a field before the get<> that would
+inline bool side_from_code(int64_t v, Side& out) {
+  if (v == 1) { out = Side::Buy; return true; }
+  if (v == 2) { out = Side::Sell; return true; }
+  return false;
+}
+
+inline bool side_from_name(std::string_view s, Side& out) {
+  if (s == "B" || s == "Buy" || s == "BUY" || s == "bid" || s == "Bid") { out = Side::Buy; return true; }
+  if (s == "S" || s == "Sell" || s == "SELL" || s == "ask" || s == "Ask") { out = Side::Sell; return true; }
+  return false;
+}
+
 inline Side side_from_any(const json& j) {
-  if (j.is_number_integer()) {
-    const int v = j.get<int>();
-    if (v == 1) return Side::Buy;
-    if (v == 2) return Side::Sell;
-  }
-  const std::string s = j.get<std::string>();
-  if (s == "B" || s == "Buy" || s == "BUY" || s == "bid" || s == "Bid") return Side::Buy;
-  if (s == "S" || s == "Sell" || s == "SELL" || s == "ask" || s == "Ask") return Side::Sell;
-  throw std::runtime_error("Invalid Side: " + s);
+  Side s;
+  if (j.is_number_integer() && side_from_code(j.get<int64_t>(), s)) return s;
+  if (side_from_name(j.get<std::string>(), s)) return s;
+  throw std::runtime_error("Invalid Side: " + j.get<std::string>());
 }
 
 // ----- OrdType -----
@@ -71,20 +88,33 @@ inline std::string ordtype_to_code(OrdType t) {
   switch (t) {
     case OrdType::Market: return "MKT";
     case OrdType::Limit:  return "LMT";
+    case OrdType::Stop:      return "STP";
+    case OrdType::StopLimit: return "STPLMT";
   }
   throw std::runtime_error("Invalid OrdType");
 }
 
+inline bool ordtype_from_code(int64_t v, OrdType& out) {
+  if (v == 1) { out = OrdType::Market; return true; }
+  if (v == 2) { out = OrdType::Limit; return true; }
+  if (v == 3) { out = OrdType::Stop; return true; }
+  if (v == 4) { out = OrdType::StopLimit; return true; }
+  return false;
+}
+
+inline bool ordtype_from_name(std::string_view s, OrdType& out) {
+  if (s == "MKT" || s == "Market" || s == "MARKET") { out = OrdType::Market; return true; }
+  if (s == "LMT" || s == "Limit" || s == "LIMIT") { out = OrdType::Limit; return true; }
+  if (s == "STP" || s == "Stop" || s == "STOP") { out = OrdType::Stop; return true; }
+  if (s == "STPLMT" || s == "StopLimit" || s == "STOP_LIMIT") { out = OrdType::StopLimit; return true; }
+  return false;
+}
+
 inline OrdType ordtype_from_any(const json& j) {
-  if (j.is_number_integer()) {
-    const int v = j.get<int>();
-    if (v == 1) return OrdType::Market;
-    if (v == 2) return OrdType::Limit;
-  }
-  const std::string s = j.get<std::string>();
-  if (s == "MKT" || s == "Market" || s == "MARKET") return OrdType::Market;
-  if (s == "LMT" || s == "Limit" || s == "LIMIT") return OrdType::Limit;
-  throw std::runtime_error("Invalid OrdType: " + s);
+  OrdType t;
+  if (j.is_number_integer() && ordtype_from_code(j.get<int64_t>(), t)) return t;
+  if (ordtype_from_name(j.get<std::string>(), t)) return t;
+  throw std::runtime_error("Invalid OrdType: " + j.get<std::string>());
 }
 
 // ----- TimeInForce -----
@@ -92,35 +122,165 @@ inline std::string tif_to_code(TimeInForce tif) {
   switch (tif) {
     case TimeInForce::Day: return "DAY";
     case TimeInForce::IOC: return "IOC";
+    case TimeInForce::GTC: return "GTC";
+    case TimeInForce::GTD: return "GTD";
   }
   throw std::runtime_error("Invalid TimeInForce");
 }
 
+inline bool tif_from_code(int64_t v, TimeInForce& out) {
+  if (v == 1) { out = TimeInForce::Day; return true; }
+  if (v == 2) { out = TimeInForce::IOC; return true; }
+  if (v == 3) { out = TimeInForce::GTC; return true; }
+  if (v == 4) { out = TimeInForce::GTD; return true; }
+  return false;
+}
+
+inline bool tif_from_name(std::string_view s, TimeInForce& out) {
+  if (s == "DAY" || s == "Day") { out = TimeInForce::Day; return true; }
+  if (s == "IOC") { out = TimeInForce::IOC; return true; }
+  if (s == "GTC") { out = TimeInForce::GTC; return true; }
+  if (s == "GTD") { out = TimeInForce::GTD; return true; }
+  return false;
+}
+
 inline TimeInForce tif_from_any(const json& j) {
-  if (j.is_number_integer()) {
-    const int v = j.get<int>();
-    if (v == 1) return TimeInForce::Day;
-    if (v == 2) return TimeInForce::IOC;
+  TimeInForce t;
+  if (j.is_number_integer() && tif_from_code(j.get<int64_t>(), t)) return t;
+  if (tif_from_name(j.get<std::string>(), t)) return t;
+  throw std::runtime_error("Invalid TimeInForce: " + j.get<std::string>());
+}
+
+// ----- MassCancelScope -----
+inline std::string scope_to_code(MassCancelScope s) {
+  switch (s) {
+    case MassCancelScope::Client: return "CLIENT";
+    case MassCancelScope::Symbol: return "SYMBOL";
+    case MassCancelScope::All:    return "ALL";
   }
-  const std::string s = j.get<std::string>();
-  if (s == "DAY" || s == "Day") return TimeInForce::Day;
-  if (s == "IOC") return TimeInForce::IOC;
-  throw std::runtime_error("Invalid TimeInForce: " + s);
+  throw std::runtime_error("Invalid MassCancelScope");
+}
+
+inline bool scope_from_code(int64_t v, MassCancelScope& out) {
+  if (v == 1) { out = MassCancelScope::Client; return true; }
+  if (v == 2) { out = MassCancelScope::Symbol; return true; }
+  if (v == 3) { out = MassCancelScope::All; return true; }
+  return false;
+}
+
+inline bool scope_from_name(std::string_view s, MassCancelScope& out) {
+  if (s == "CLIENT" || s == "Client") { out = MassCancelScope::Client; return true; }
+  if (s == "SYMBOL" || s == "Symbol") { out = MassCancelScope::Symbol; return true; }
+  if (s == "ALL" || s == "All") { out = MassCancelScope::All; return true; }
+  return false;
+}
+
+inline MassCancelScope scope_from_any(const json& j) {
+  MassCancelScope s;
+  if (j.is_number_integer() && scope_from_code(j.get<int64_t>(), s)) return s;
+  if (scope_from_name(j.get<std::string>(), s)) return s;
+  throw std::runtime_error("Invalid MassCancelScope: " + j.get<std::string>());
+}
+
+// ----- AuctionAction -----
+inline std::string auction_action_to_code(AuctionAction a) {
+  switch (a) {
+    case AuctionAction::StartCall: return "CALL";
+    case AuctionAction::Uncross:   return "UNCROSS";
+  }
+  throw std::runtime_error("Invalid AuctionAction");
+}
+
+inline bool auction_action_from_code(int64_t v, AuctionAction& out) {
+  if (v == 1) { out = AuctionAction::StartCall; return true; }
+  if (v == 2) { out = AuctionAction::Uncross; return true; }
+  return false;
+}
+
+inline bool auction_action_from_name(std::string_view s, AuctionAction& out) {
+  if (s == "CALL" || s == "StartCall") { out = AuctionAction::StartCall; return true; }
+  if (s == "UNCROSS" || s == "Uncross") { out = AuctionAction::Uncross; return true; }
+  return false;
+}
+
+inline AuctionAction auction_action_from_any(const json& j) {
+  AuctionAction a;
+  if (j.is_number_integer() && auction_action_from_code(j.get<int64_t>(), a)) return a;
+  if (auction_action_from_name(j.get<std::string>(), a)) return a;
+  throw std::runtime_error("Invalid AuctionAction: " + j.get<std::string>());
+}
+
+// ----- StpMode -----
+inline std::string stp_to_code(StpMode m) {
+  switch (m) {
+    case StpMode::None:            return "NONE";
+    case StpMode::CancelResting:   return "CR";
+    case StpMode::CancelAggressor: return "CA";
+    case StpMode::CancelBoth:      return "CB";
+    case StpMode::Decrement:       return "DC";
+  }
+  throw std::runtime_error("Invalid StpMode");
+}
+
+inline bool stp_from_code(int64_t v, StpMode& out) {
+  if (v < 0 || v > 4) return false;
+  out = static_cast<StpMode>(v);
+  return true;
+}
+
+inline bool stp_from_name(std::string_view s, StpMode& out) {
+  if (s == "NONE" || s == "None") { out = StpMode::None; return true; }
+  if (s == "CR" || s == "CancelResting") { out = StpMode::CancelResting; return true; }
+  if (s == "CA" || s == "CancelAggressor") { out = StpMode::CancelAggressor; return true; }
+  if (s == "CB" || s == "CancelBoth") { out = StpMode::CancelBoth; return true; }
+  if (s == "DC" || s == "Decrement") { out = StpMode::Decrement; return true; }
+  return false;
+}
+
+inline StpMode stp_from_any(const json& j) {
+  StpMode m;
+  if (j.is_number_integer() && stp_from_code(j.get<int64_t>(), m)) return m;
+  if (stp_from_name(j.get<std::string>(), m)) return m;
+  throw std::runtime_error("Invalid StpMode: " + j.get<std::string>());
 }
 
 // ----- MsgType -----
+// Also used by scan_header, so it takes a view and does not throw
+inline bool msgtype_from_name(std::string_view s, MsgType& out) {
+  if (s == "NewOrder" || s == "NewOrderRequest" || s == "NEW_ORDER") { out = MsgType::NewOrder; return true; }
+  if (s == "Cancel" || s == "CANCEL") { out = MsgType::Cancel; return true; }
+  if (s == "Replace" || s == "REPLACE") { out = MsgType::Replace; return true; }
+  if (s == "MassCancel" || s == "MASS_CANCEL") { out = MsgType::MassCancel; return true; }
+  if (s == "KillSwitch" || s == "KILL_SWITCH") { out = MsgType::KillSwitch; return true; }
+  if (s == "Auction" || s == "AUCTION") { out = MsgType::Auction; return true; }
+  if (s == "EndOfSession" || s == "END_OF_SESSION") { out = MsgType::EndOfSession; return true; }
+  if (s == "Ack" || s == "ACK") { out = MsgType::Ack; return true; }
+  if (s == "Reject" || s == "REJECT") { out = MsgType::Reject; return true; }
+  if (s == "Fill" || s == "FILL") { out = MsgType::Fill; return true; }
+  if (s == "Cancelled" || s == "CANCELLED") { out = MsgType::Cancelled; return true; }
+  if (s == "Replaced" || s == "REPLACED") { out = MsgType::Replaced; return true; }
+  if (s == "MassCancelAck" || s == "MASS_CANCEL_ACK") { out = MsgType::MassCancelAck; return true; }
+  if (s == "AuctionInfo" || s == "AUCTION_INFO") { out = MsgType::AuctionInfo; return true; }
+  if (s == "Heartbeat" || s == "HEARTBEAT") { out = MsgType::Heartbeat; return true; }
+  return false;
+}
+
+// Numeric types are 16 bits on the wire; anything wider is no type at all
+inline bool msgtype_from_code(int64_t v, MsgType& out) {
+  if (v < 0 || v > 0xFFFF) return false;
+  out = static_cast<MsgType>(v);
+  return true;
+}
+
 inline MsgType msgtype_from_any(const json& j) {
   if (j.is_number_integer()) {
-    const int v = j.get<int>();
-    return static_cast<MsgType>(static_cast<uint16_t>(v));
+    MsgType t;
+    if (msgtype_from_code(j.get<int64_t>(), t)) return t;
+    throw std::runtime_error("Invalid MsgType: " + j.dump());
   }
   const std::string s = j.get<std::string>();
-  if (s == "NewOrder" || s == "NewOrderRequest" || s == "NEW_ORDER") return MsgType::NewOrder;
-  if (s == "Cancel" || s == "CANCEL") return MsgType::Cancel;
-  if (s == "Ack" || s == "ACK") return MsgType::Ack;
-  if (s == "Reject" || s == "REJECT") return MsgType::Reject;
-  if (s == "Fill" || s == "FILL") return MsgType::Fill;
-  if (s == "Heartbeat" || s == "HEARTBEAT") return MsgType::Heartbeat;
+  MsgType t;
+  if (msgtype_from_name(s, t)) return t;
   throw std::runtime_error("Invalid MsgType: " + s);
 }
 
@@ -134,6 +294,15 @@ inline void from_json(const json& j, OrdType& t) { t = ordtype_from_any(j); }
 inline void to_json(json& j, const TimeInForce& t) { j = tif_to_code(t); }
 inline void from_json(const json& j, TimeInForce& t) { t = tif_from_any(j); }
 
+inline void to_json(json& j, const MassCancelScope& s) { j = scope_to_code(s); }
+inline void from_json(const json& j, MassCancelScope& s) { s = scope_from_any(j); }
+
+inline void to_json(json& j, const StpMode& m) { j = stp_to_code(m); }
+inline void from_json(const json& j, StpMode& m) { m = stp_from_any(j); }
+
+inline void to_json(json& j, const AuctionAction& a) { j = auction_action_to_code(a); }
+inline void from_json(const json& j, AuctionAction& a) { a = auction_action_from_any(j); }
+
 // IMPORTANT: header.type is numeric in your example
 inline void to_json(json& j, const MsgType& t) { j = to_u(t); }
 inline void from_json(const json& j, MsgType& t) { t = msgtype_from_any(j); }
@@ -184,6 +353,10 @@ inline void to_json(json& j, const NewOrderRequest& r) {
 
   // only include tif if it isn't the default (keeps JSON minimal)
   if (r.tif != TimeInForce::Day) j["tif"] = r.tif;
+  if (r.expire_date != 0) j["expire_date"] = r.expire_date;
+  if (r.display_qty != 0) j["display_qty"] = r.display_qty;
+  if (r.stop_price != 0) j["stop_price"] = r.stop_price;
+  if (r.stp != StpMode::None) j["stp"] = r.stp;
 }
 
 inline void from_json(const json& j, NewOrderRequest& r) {
@@ -192,12 +365,25 @@ inline void from_json(const json& j, NewOrderRequest& r) {
   j.at("side").get_to(r.side);
   j.at("ord_type").get_to(r.ord_type);
   j.at("qty").get_to(r.qty);
+  if (r.qty <= 0) throw std::runtime_error("qty must be positive");
 
   if (j.contains("limit_price")) j.at("limit_price").get_to(r.limit_price);
   // accept alias "price"
   if (!j.contains("limit_price") && j.contains("price")) j.at("price").get_to(r.limit_price);
 
   if (j.contains("tif")) j.at("tif").get_to(r.tif);
+  if (j.contains("expire_date")) j.at("expire_date").get_to(r.expire_date);
+  if (r.tif == TimeInForce::GTD && r.expire_date == 0) {
+    throw std::runtime_error("GTD orders need an expire_date");
+  }
+  if (j.contains("display_qty")) j.at("display_qty").get_to(r.display_qty);
+  if (r.display_qty < 0) throw std::runtime_error("display_qty must not be negative");
+
+  if (j.contains("stop_price")) j.at("stop_price").get_to(r.stop_price);
+  if ((r.ord_type == OrdType::Stop || r.ord_type == OrdType::StopLimit) && r.stop_price <= 0) {
+    throw std::runtime_error("Stop orders need a positive stop_price");
+  }
+  if (j.contains("stp")) j.at("stp").get_to(r.stp);
 }
 
 // -----------------------------------------------------------------------------
@@ -216,6 +402,93 @@ inline void from_json(const json& j, CancelRequest& r) {
   if (j.contains("symbol")) j.at("symbol").get_to(r.symbol);
 }
 
+// -----------------------------------------------------------------------------
+// ReplaceRequest
+// -----------------------------------------------------------------------------
+inline void to_json(json& j, const ReplaceRequest& r) {
+  j = json{
+    {"order_id", r.order_id},
+    {"qty", r.qty},
+    {"limit_price", r.limit_price}
+  };
+  if (r.client_order_id != 0) j["client_order_id"] = r.client_order_id;
+  if (!r.symbol.empty()) j["symbol"] = r.symbol;
+}
+
+inline void from_json(const json& j, ReplaceRequest& r) {
+  j.at("order_id").get_to(r.order_id);
+  if (j.contains("client_order_id")) j.at("client_order_id").get_to(r.client_order_id);
+  if (j.contains("symbol")) j.at("symbol").get_to(r.symbol);
+  j.at("qty").get_to(r.qty);
+
+  if (j.contains("limit_price")) j.at("limit_price").get_to(r.limit_price);
+  else j.at("price").get_to(r.limit_price);
+}
+
+// -----------------------------------------------------------------------------
+// MassCancelRequest / KillSwitchRequest
+// -----------------------------------------------------------------------------
+inline void to_json(json& j, const MassCancelRequest& r) {
+  j = json{
+    {"client_order_id", r.client_order_id},
+    {"scope", r.scope}
+  };
+  if (r.target_client_id != 0) j["target_client_id"] = r.target_client_id;
+  if (!r.symbol.empty()) j["symbol"] = r.symbol;
+}
+
+inline void from_json(const json& j, MassCancelRequest& r) {
+  if (j.contains("client_order_id")) j.at("client_order_id").get_to(r.client_order_id);
+  j.at("scope").get_to(r.scope);
+  if (j.contains("target_client_id")) j.at("target_client_id").get_to(r.target_client_id);
+  if (j.contains("symbol")) j.at("symbol").get_to(r.symbol);
+  if (r.scope == MassCancelScope::Symbol && r.symbol.empty()) {
+    throw std::runtime_error("MassCancel with SYMBOL scope needs a symbol");
+  }
+}
+
+inline void to_json(json& j, const KillSwitchRequest& r) {
+  j = json{
+    {"client_order_id", r.client_order_id},
+    {"target_client_id", r.target_client_id},
+    {"enabled", r.enabled},
+    {"cancel_open", r.cancel_open}
+  };
+}
+
+inline void from_json(const json& j, KillSwitchRequest& r) {
+  if (j.contains("client_order_id")) j.at("client_order_id").get_to(r.client_order_id);
+  j.at("target_client_id").get_to(r.target_client_id);
+  if (j.contains("enabled")) j.at("enabled").get_to(r.enabled);
+  if (j.contains("cancel_open")) j.at("cancel_open").get_to(r.cancel_open);
+}
+
+inline void to_json(json& j, const AuctionRequest& r) {
+  j = json{
+    {"client_order_id", r.client_order_id},
+    {"action", r.action}
+  };
+  if (!r.symbol.empty()) j["symbol"] = r.symbol;
+}
+
+inline void from_json(const json& j, AuctionRequest& r) {
+  if (j.contains("client_order_id")) j.at("client_order_id").get_to(r.client_order_id);
+  if (j.contains("symbol")) j.at("symbol").get_to(r.symbol);
+  j.at("action").get_to(r.action);
+}
+
+inline void to_json(json& j, const EndOfSessionRequest& r) {
+  j = json{
+    {"client_order_id", r.client_order_id},
+    {"session_date", r.session_date}
+  };
+}
+
+inline void from_json(const json& j, EndOfSessionRequest& r) {
+  if (j.contains("client_order_id")) j.at("client_order_id").get_to(r.client_order_id);
+  j.at("session_date").get_to(r.session_date);
+}
+
 // -----------------------------------------------------------------------------
 // Ack / Reject / Fill (outbound)
 // -----------------------------------------------------------------------------
@@ -267,6 +540,74 @@ inline void from_json(const json& j, Fill& f) {
   if (j.contains("complete")) j.at("complete").get_to(f.complete);
 }
 
+inline void to_json(json& j, const Cancelled& c) {
+  j = json{
+    {"order_id", c.order_id},
+    {"client_order_id", c.client_order_id},
+    {"symbol", c.symbol},
+    {"side", c.side},
+    {"cancelled_qty", c.cancelled_qty},
+    {"leaves_qty", c.leaves_qty}
+  };
+}
+
+inline void from_json(const json& j, Cancelled& c) {
+  if (j.contains("order_id")) j.at("order_id").get_to(c.order_id);
+  if (j.contains("client_order_id")) j.at("client_order_id").get_to(c.client_order_id);
+  if (j.contains("symbol")) j.at("symbol").get_to(c.symbol);
+  if (j.contains("side")) j.at("side").get_to(c.side);
+  if (j.contains("cancelled_qty")) j.at("cancelled_qty").get_to(c.cancelled_qty);
+  if (j.contains("leaves_qty")) j.at("leaves_qty").get_to(c.leaves_qty);
+}
+
+inline void to_json(json& j, const Replaced& r) {
+  j = json{
+    {"order_id", r.order_id},
+    {"client_order_id", r.client_order_id},
+    {"symbol", r.symbol},
+    {"qty", r.qty},
+    {"limit_price", r.limit_price}
+  };
+}
+
+inline void from_json(const json& j, Replaced& r) {
+  if (j.contains("order_id")) j.at("order_id").get_to(r.order_id);
+  if (j.contains("client_order_id")) j.at("client_order_id").get_to(r.client_order_id);
+  if (j.contains("symbol")) j.at("symbol").get_to(r.symbol);
+  if (j.contains("qty")) j.at("qty").get_to(r.qty);
+  if (j.contains("limit_price")) j.at("limit_price").get_to(r.limit_price);
+}
+
+inline void to_json(json& j, const MassCancelAck& a) {
+  j = json{
+    {"client_order_id", a.client_order_id},
+    {"cancelled_count", a.cancelled_count}
+  };
+}
+
+inline void from_json(const json& j, MassCancelAck& a) {
+  if (j.contains("client_order_id")) j.at("client_order_id").get_to(a.client_order_id);
+  if (j.contains("cancelled_count")) j.at("cancelled_count").get_to(a.cancelled_count);
+}
+
+inline void to_json(json& j, const AuctionInfo& a) {
+  j = json{
+    {"symbol", a.symbol},
+    {"price", a.price},
+    {"qty", a.qty},
+    {"imbalance", a.imbalance},
+    {"uncrossed", a.uncrossed}
+  };
+}
+
+inline void from_json(const json& j, AuctionInfo& a) {
+  if (j.contains("symbol")) j.at("symbol").get_to(a.symbol);
+  if (j.contains("price")) j.at("price").get_to(a.price);
+  if (j.contains("qty")) j.at("qty").get_to(a.qty);
+  if (j.contains("imbalance")) j.at("imbalance").get_to(a.imbalance);
+  if (j.contains("uncrossed")) j.at("uncrossed").get_to(a.uncrossed);
+}
+
 // -----------------------------------------------------------------------------
 // Envelope helpers (one-call parse/dump for ZMQ request/reply)
 // -----------------------------------------------------------------------------
@@ -293,6 +634,11 @@ inline void from_json(const json& j, EnvelopeIn& e) {
   switch (e.header.type) {
     case MsgType::NewOrder: e.body = b.get<NewOrderRequest>(); break;
     case MsgType::Cancel:   e.body = b.get<CancelRequest>();   break;
+    case MsgType::Replace:  e.body = b.get<ReplaceRequest>();  break;
+    case MsgType::MassCancel: e.body = b.get<MassCancelRequest>(); break;
+    case MsgType::KillSwitch: e.body = b.get<KillSwitchRequest>(); break;
+    case MsgType::Auction:    e.body = b.get<AuctionRequest>();    break;
+    case MsgType::EndOfSession: e.body = b.get<EndOfSessionRequest>(); break;
     default:
       throw std::runtime_error("Unsupported inbound MsgType: " +
                                std::to_string(to_u(e.header.type)));
@@ -312,22 +658,662 @@ inline void from_json(const json& j, EnvelopeOut& e) {
     case MsgType::Ack:    e.body = b.get<Ack>();    break;
     case MsgType::Reject: e.body = b.get<Reject>(); break;
     case MsgType::Fill:   e.body = b.get<Fill>();   break;
+    case MsgType::Cancelled:     e.body = b.get<Cancelled>();     break;
+    case MsgType::Replaced:      e.body = b.get<Replaced>();      break;
+    case MsgType::MassCancelAck: e.body = b.get<MassCancelAck>(); break;
+    case MsgType::AuctionInfo:   e.body = b.get<AuctionInfo>();   break;
     default:
       throw std::runtime_error("Unsupported outbound MsgType: " +
                                std::to_string(to_u(e.header.type)));
   }
 }
 
+// -----------------------------------------------------------------------------
+// Ingress field scan: pulls one unsigned integer field (e.g. header.client_id)
+// out of the raw bytes without building a DOM, for per-message decisions made
+// before parsing. key includes the quotes. Returns false if the key is missing
+// or its value is not an unsigned integer.
+// -----------------------------------------------------------------------------
+inline bool scan_uint_field(const char* data, size_t len, const char* key, size_t key_len, uint64_t& out) {
+  const char* end = data + len;
+  const char* p = data;
+  while (static_cast<size_t>(end - p) > key_len) {
+    p = static_cast<const char*>(std::memchr(p, '"', static_cast<size_t>(end - p)));
+    if (!p || static_cast<size_t>(end - p) <= key_len) return false;
+    if (std::memcmp(p, key, key_len) != 0) { ++p; continue; }
+
+    p += key_len;
+    while (p < end && (*p == ' ' || *p == ':' || *p == '\t' || *p == '\n' || *p == '\r')) ++p;
+    return json_scan::parse_uint(p, end, out);
+  }
+  return false;
+}
+
+// String counterpart of scan_uint_field: out points into data. Returns false
+// if the key is missing, its value is not a string, or the string has escapes.
+inline bool scan_string_field(const char* data, size_t len, const char* key, size_t key_len, std::string_view& out) {
+  const char* end = data + len;
+  const char* p = data;
+  while (static_cast<size_t>(end - p) > key_len) {
+    p = static_cast<const char*>(std::memchr(p, '"', static_cast<size_t>(end - p)));
+    if (!p || static_cast<size_t>(end - p) <= key_len) return false;
+    if (std::memcmp(p, key, key_len) != 0) { ++p; continue; }
+
+    p += key_len;
+    while (p < end && (*p == ' ' || *p == ':' || *p == '\t' || *p == '\n' || *p == '\r')) ++p;
+    if (p == end || *p != '"') return false;
+
+    const char* begin = ++p;
+    const char* close = static_cast<const char*>(std::memchr(begin, '"', static_cast<size_t>(end - begin)));
+    if (!close || std::memchr(begin, '\\', static_cast<size_t>(close - begin))) return false;
+    out = std::string_view(begin, static_cast<size_t>(close - begin));
+    return true;
+  }
+  return false;
+}
+
+inline bool scan_client_id(const char* data, size_t len, ClientId& out) {
+  static constexpr char kKey[] = "\"client_id\"";
+  uint64_t v = 0;
+  if (!scan_uint_field(data, len, kKey, sizeof(kKey) - 1, v)) return false;
+  out = static_cast<ClientId>(v);
+  return true;
+}
+
+inline bool scan_seq(const char* data, size_t len, SeqNum& out) {
+  static constexpr char kKey[] = "\"seq\"";
+  uint64_t v = 0;
+  if (!scan_uint_field(data, len, kKey, sizeof(kKey) - 1, v)) return false;
+  out = static_cast<SeqNum>(v);
+  return true;
+}
+
+inline bool scan_symbol(const char* data, size_t len, std::string_view& out) {
+  static constexpr char kKey[] = "\"symbol\"";
+  return scan_string_field(data, len, kKey, sizeof(kKey) - 1, out);
+}
+
+// -----------------------------------------------------------------------------
+// Ingress header scan: everything the ingress stages decide on (header.type,
+// header.seq, header.client_id, body.symbol) in one pass over the raw bytes,
+// without building a DOM; the parse worker still parses the whole envelope.
+// Walks the message string by string, so a key inside a string value never
+// matches, and stops once it has all four. The first occurrence of each key
+// counts. A field that is missing, or not of the expected kind, is left unset.
+// -----------------------------------------------------------------------------
+struct HeaderFields {
+  enum : uint8_t { kType = 1, kSeq = 2, kClientId = 4, kSymbol = 8, kAll = 15 };
+
+  MsgType type = MsgType::Heartbeat;
+  SeqNum seq = 0;
+  ClientId client_id = 0;
+  std::string_view symbol;   // points into the scanned bytes
+  uint8_t found = 0;         // kType | kSeq | ...
+
+  bool has(uint8_t field) const { return (found & field) != 0; }
+};
+
+namespace detail {
+
+inline const char* skip_ws(const char* p, const char* end) {
+  while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) ++p;
+  return p;
+}
+
+// Beyond 18 digits a value may not fit; nlohmann decides what it is
+constexpr uint64_t kMaxScanned = 999999999999999999ull;
+
+// An unsigned integer at p as the scanners take one: no more than 18
+// digits, no leading zero, no fraction or exponent, and at most max.
+// Anything else is left to nlohmann. Advances p past the digits.
+inline bool scan_number(const char*& p, const char* end, uint64_t& out, uint64_t max = kMaxScanned) {
+  const char* start = p;
+  uint64_t v = 0;
+  if (!json_scan::parse_uint(p, end, v)) return false;
+  const size_t digits = static_cast<size_t>(p - start);
+  if (digits > 18 || (digits > 1 && *start == '0') || v > max) return false;
+  if (p < end && (*p == '.' || *p == 'e' || *p == 'E')) return false;
+  out = v;
+  return true;
+}
+
+} // namespace detail
+
+// Strings are taken from json_scan::QuoteCursor two quotes at a time (see
+// net/json_scan.hpp), and numbers with detail::scan_number, so a type, seq
+// or client_id is found only where nlohmann would read the same value
+inline bool scan_header(const char* data, size_t len, HeaderFields& out) {
+  const char* end = data + len;
+  json_scan::QuoteCursor quotes(data, len);
+  while (out.found != HeaderFields::kAll) {
+    const char* open = quotes.next();
+    if (!open) break;
+    const char* key = open + 1;
+    const char* close = quotes.close();
+    if (!close) break;
+    const size_t key_len = static_cast<size_t>(close - key);
+    const char* p = detail::skip_ws(close + 1, end);
+    // A string followed by anything but ':' was a value
+    if (p == end || *p != ':') continue;
+    p = detail::skip_ws(p + 1, end);
+
+    // A string value is the cursor's next pair, which the next pass would
+    // otherwise skip as a value
+    const bool string_value = p < end && *p == '"';
+    uint64_t v = 0;
+    if (key_len == 4 && std::memcmp(key, "type", 4) == 0) {
+      if (out.has(HeaderFields::kType)) continue;
+      if (detail::scan_number(p, end, v, 0xFFFF)) {
+        out.type = static_cast<MsgType>(v);
+        out.found |= HeaderFields::kType;
+      } else if (string_value) {
+        // By name, as msgtype_from_any accepts
+        quotes.next();
+        const char* name_end = quotes.close();
+        if (!name_end) break;
+        if (msgtype_from_name(std::string_view(p + 1, static_cast<size_t>(name_end - p - 1)), out.type)) {
+          out.found |= HeaderFields::kType;
+        }
+      }
+    } else if (key_len == 3 && std::memcmp(key, "seq", 3) == 0) {
+      if (!out.has(HeaderFields::kSeq) && detail::scan_number(p, end, v)) {
+        out.seq = static_cast<SeqNum>(v);
+        out.found |= HeaderFields::kSeq;
+      }
+    } else if (key_len == 9 && std::memcmp(key, "client_id", 9) == 0) {
+      if (!out.has(HeaderFields::kClientId) && detail::scan_number(p, end, v, 0xFFFFFFFFull)) {
+        out.client_id = static_cast<ClientId>(v);
+        out.found |= HeaderFields::kClientId;
+      }
+    } else if (key_len == 6 && std::memcmp(key, "symbol", 6) == 0) {
+      if (!out.has(HeaderFields::kSymbol) && string_value) {
+        quotes.next();
+        const char* value_end = quotes.close();
+        if (!value_end) break;
+        const char* value = p + 1;
+        if (!std::memchr(value, '\\', static_cast<size_t>(value_end - value))) {
+          out.symbol = std::string_view(value, static_cast<size_t>(value_end - value));
+          out.found |= HeaderFields::kSymbol;
+        }
+      }
+    }
+  }
+  return out.has(HeaderFields::kType) && out.has(HeaderFields::kClientId);
+}
+
 inline EnvelopeIn parse_inbound_envelope(const std::string& raw) {
   return json::parse(raw).get<EnvelopeIn>();
 }
 
+// -----------------------------------------------------------------------------
+// Exception-free inbound parse, for the parse workers. A malformed message
+// is the common case during a misbehaving client's flood, so the usual ways
+// of being malformed (not JSON, a header without type or seq, a type that is
+// not a request, a body without one of its required fields or with an enum
+// field no code or name matches, e.g. "side":"X") are reported as a
+// ParseFailure without throwing. Only a value that fails the request's own
+// checks (a GTD order without expire_date, a number where a string belongs)
+// still goes through the get<> that throws, and comes back as BadValue.
+// -----------------------------------------------------------------------------
+enum class ParseFailure : uint8_t {
+  None,
+  Syntax,
+  NoHeader,
+  NoType,
+  NoSeq,
+  NotInbound,
+  NoBody,
+  MissingField,
+  BadValue,
+  Count
+};
+
+inline const char* parse_failure_reason(ParseFailure f) {
+  switch (f) {
+    case ParseFailure::None:         return "";
+    case ParseFailure::Syntax:       return "Parse error: not valid JSON";
+    case ParseFailure::NoHeader:     return "Parse error: no header object";
+    case ParseFailure::NoType:       return "Parse error: header.type missing or unknown";
+    case ParseFailure::NoSeq:        return "Parse error: header.seq missing or not a number";
+    case ParseFailure::NotInbound:   return "Parse error: not a request type";
+    case ParseFailure::NoBody:       return "Parse error: no body object";
+    case ParseFailure::MissingField: return "Parse error: required body field missing or mistyped";
+    case ParseFailure::BadValue:     return "Parse error: invalid field value";
+    case ParseFailure::Count:        break;
+  }
+  return "Parse error";
+}
+
+namespace detail {
+
+// Present and convertible to a number by get<>, which takes booleans too
+inline bool has_number(const json& j, const char* key) {
+  auto it = j.find(key);
+  return it != j.end() && (it->is_number() || it->is_boolean());
+}
+
+// A number get<int64_t> makes at least 1 of; an order for nothing would
+// be booked as open and never filled or cancelled
+inline bool has_positive(const json& j, const char* key) {
+  auto it = j.find(key);
+  return it != j.end() && it->is_number() && it->get<int64_t>() > 0;
+}
+
+inline bool has_string(const json& j, const char* key) {
+  auto it = j.find(key);
+  return it != j.end() && it->is_string();
+}
+
+// An enum field holding one of its codes or names, as its _from_any takes.
+// An optional field may be left out.
+template <typename E>
+inline bool has_code(const json& j, const char* key, bool (*from_code)(int64_t, E&),
+                     bool (*from_name)(std::string_view, E&), bool optional = false) {
+  auto it = j.find(key);
+  if (it == j.end()) return optional;
+  E e;
+  if (it->is_number_integer()) return from_code(it->get<int64_t>(), e);
+  return it->is_string() && from_name(it->get_ref<const std::string&>(), e);
+}
+
+// The fields each request's from_json reads with at(), and every enum
+// field that is there
+inline bool has_required(MsgType type, const json& b) {
+  switch (type) {
+    case MsgType::NewOrder:
+      return has_string(b, "symbol") && has_code(b, "side", side_from_code, side_from_name) &&
+             has_code(b, "ord_type", ordtype_from_code, ordtype_from_name) && has_positive(b, "qty") &&
+             has_code(b, "tif", tif_from_code, tif_from_name, true) &&
+             has_code(b, "stp", stp_from_code, stp_from_name, true);
+    case MsgType::Cancel:
+      return true;
+    case MsgType::Replace:
+      return has_number(b, "order_id") && has_number(b, "qty") &&
+             (b.contains("limit_price") ? has_number(b, "limit_price") : has_number(b, "price"));
+    case MsgType::MassCancel:   return has_code(b, "scope", scope_from_code, scope_from_name);
+    case MsgType::KillSwitch:   return has_number(b, "target_client_id");
+    case MsgType::Auction:      return has_code(b, "action", auction_action_from_code, auction_action_from_name);
+    case MsgType::EndOfSession: return has_number(b, "session_date");
+    default:                    return false;
+  }
+}
+
+} // namespace detail
+
+// -----------------------------------------------------------------------------
+// NewOrder fast path: the envelope of src/jsonExample.txt read straight off
+// the bytes, without building a DOM. Strings come from json_scan::QuoteCursor
+// two quotes at a time and numbers from json_scan::parse_uint. It only takes
+// the plain form: a header and a body object and nothing else, the known
+// keys each at most once, unsigned integers without leading zeros, and
+// strings without escapes or non-ASCII bytes. Anything else returns false and
+// goes through nlohmann, which gives the same result for whatever this takes.
+// -----------------------------------------------------------------------------
+namespace detail {
+
+class NewOrderScan {
+public:
+  explicit NewOrderScan(std::string_view raw)
+      : p(raw.data()), end(raw.data() + raw.size()), quotes(raw.data(), raw.size()) {}
+
+  bool parse(EnvelopeIn& out) {
+    MessageHeader h;
+    NewOrderRequest r;
+    if (!expect('{')) return false;
+    for (int member = 0; member < 2; ++member) {
+      std::string_view key;
+      if ((member && !expect(',')) || !string(key) || !expect(':') || !expect('{')) return false;
+      const bool header = key == "header";
+      if ((!header && key != "body") || !once(header ? kHeader : kBody)) return false;
+      if (!at('}')) {
+        do {
+          if (!string(key) || !expect(':')) return false;
+          if (!(header ? headerField(key, h) : bodyField(key, r))) return false;
+        } while (expect(','));
+      }
+      if (!expect('}')) return false;
+    }
+    if (!expect('}') || skip_ws(p, end) != end) return false;
+
+    // What try_parse_inbound_envelope and from_json would refuse, they refuse
+    if (!has(kType | kSeq | kSymbol | kSide | kOrdType | kQty) || h.type != MsgType::NewOrder) return false;
+    if (r.qty == 0) return false;
+    if (r.tif == TimeInForce::GTD && r.expire_date == 0) return false;
+    if ((r.ord_type == OrdType::Stop || r.ord_type == OrdType::StopLimit) && r.stop_price <= 0) return false;
+    if (!has(kLimitPrice) && has(kPrice)) r.limit_price = price_alias;
+
+    out.header = h;
+    out.body = std::move(r);
+    return true;
+  }
+
+private:
+  enum : uint32_t {
+    kHeader = 1u << 0, kBody = 1u << 1,
+    kVersion = 1u << 2, kType = 1u << 3, kSeq = 1u << 4, kClientId = 1u << 5,
+    kClientOrderId = 1u << 6, kSymbol = 1u << 7, kSide = 1u << 8, kOrdType = 1u << 9, kQty = 1u << 10,
+    kLimitPrice = 1u << 11, kPrice = 1u << 12, kStopPrice = 1u << 13, kTif = 1u << 14,
+    kExpireDate = 1u << 15, kDisplayQty = 1u << 16, kStp = 1u << 17
+  };
+
+  bool has(uint32_t bits) const { return (seen & bits) == bits; }
+
+  bool once(uint32_t bit) {
+    if (seen & bit) return false;
+    seen |= bit;
+    return true;
+  }
+
+  bool at(char c) {
+    p = skip_ws(p, end);
+    return p < end && *p == c;
+  }
+
+  bool expect(char c) {
+    if (!at(c)) return false;
+    ++p;
+    return true;
+  }
+
+  bool string(std::string_view& out) {
+    if (!at('"') || quotes.next() != p) return false;
+    const char* close = quotes.next();
+    if (!close) return false;
+    for (const char* c = p + 1; c < close; ++c) {
+      const unsigned char u = static_cast<unsigned char>(*c);
+      if (u < 0x20 || u >= 0x80 || u == '\\') return false;
+    }
+    out = std::string_view(p + 1, static_cast<size_t>(close - p - 1));
+    p = close + 1;
+    return true;
+  }
+
+  template <typename T>
+  bool number(T& out, uint64_t max = kMaxScanned) {
+    p = skip_ws(p, end);
+    uint64_t v = 0;
+    if (!scan_number(p, end, v, max)) return false;
+    out = static_cast<T>(v);
+    return true;
+  }
+
+  // A code or a name, as the enum's _from_any takes
+  template <typename E>
+  bool code(E& out, bool (*from_code)(int64_t, E&), bool (*from_name)(std::string_view, E&)) {
+    if (at('"')) {
+      std::string_view name;
+      return string(name) && from_name(name, out);
+    }
+    int64_t v = 0;
+    return number(v) && from_code(v, out);
+  }
+
+  bool headerField(std::string_view key, MessageHeader& h) {
+    if (key == "version") return once(kVersion) && number(h.version, 0xFFFF);
+    if (key == "seq") return once(kSeq) && number(h.seq);
+    if (key == "client_id") return once(kClientId) && number(h.client_id, 0xFFFFFFFFull);
+    if (key == "type") {
+      if (!once(kType)) return false;
+      if (!at('"')) return number(h.type, 0xFFFF);
+      std::string_view name;
+      return string(name) && msgtype_from_name(name, h.type);
+    }
+    return false;
+  }
+
+  bool bodyField(std::string_view key, NewOrderRequest& r) {
+    if (key == "client_order_id") return once(kClientOrderId) && number(r.client_order_id);
+    if (key == "symbol") {
+      std::string_view symbol;
+      if (!once(kSymbol) || !string(symbol)) return false;
+      r.symbol.assign(symbol.data(), symbol.size());
+      return true;
+    }
+    if (key == "side") return once(kSide) && code(r.side, side_from_code, side_from_name);
+    if (key == "ord_type") return once(kOrdType) && code(r.ord_type, ordtype_from_code, ordtype_from_name);
+    if (key == "qty") return once(kQty) && number(r.qty);
+    if (key == "limit_price") return once(kLimitPrice) && number(r.limit_price);
+    if (key == "price") return once(kPrice) && number(price_alias);
+    if (key == "stop_price") return once(kStopPrice) && number(r.stop_price);
+    if (key == "tif") return once(kTif) && code(r.tif, tif_from_code, tif_from_name);
+    if (key == "expire_date") return once(kExpireDate) && number(r.expire_date, 0xFFFFFFFFull);
+    if (key == "display_qty") return once(kDisplayQty) && number(r.display_qty);
+    if (key == "stp") return once(kStp) && code(r.stp, stp_from_code, stp_from_name);
+    return false;
+  }
+
+  const char* p;
+  const char* end;
+  json_scan::QuoteCursor quotes;
+  uint32_t seen = 0;
+  Price price_alias = 0;
+};
+
+} // namespace detail
+
+inline ParseFailure try_parse_inbound_envelope(std::string_view raw, EnvelopeIn& out) {
+  // Most traffic is plain new orders
+  if (detail::NewOrderScan(raw).parse(out)) return ParseFailure::None;
+
+  const json j = json::parse(raw.begin(), raw.end(), nullptr, false);
+  if (j.is_discarded() || !j.is_object()) return ParseFailure::Syntax;
+
+  auto header = j.find("header");
+  if (header == j.end() || !header->is_object()) return ParseFailure::NoHeader;
+  auto type_it = header->find("type");
+  if (type_it == header->end()) return ParseFailure::NoType;
+  MsgType type;
+  if (type_it->is_number_integer()) {
+    if (!msgtype_from_code(type_it->get<int64_t>(), type)) return ParseFailure::NoType;
+  } else if (!type_it->is_string() || !msgtype_from_name(type_it->get_ref<const std::string&>(), type)) {
+    return ParseFailure::NoType;
+  }
+  if (!detail::has_number(*header, "seq")) return ParseFailure::NoSeq;
+  if ((header->contains("version") && !detail::has_number(*header, "version")) ||
+      (header->contains("client_id") && !detail::has_number(*header, "client_id"))) {
+    return ParseFailure::BadValue;
+  }
+  if (to_u(type) < to_u(MsgType::NewOrder) || to_u(type) > to_u(MsgType::EndOfSession)) {
+    return ParseFailure::NotInbound;
+  }
+
+  auto body = j.find("body");
+  if (body == j.end() || !body->is_object()) return ParseFailure::NoBody;
+  if (!detail::has_required(type, *body)) return ParseFailure::MissingField;
+
+  try {
+    j.get_to(out);
+  } catch (const std::exception&) {
+    return ParseFailure::BadValue;
+  }
+  return ParseFailure::None;
+}
+
+// -----------------------------------------------------------------------------
+// Parse-error rejects from pre-serialized templates: the bytes dump_envelope
+// gives for a Reject with code ParseError, symbol "UNKNOWN" and the
+// failure's reason, with only the ids patched in. The constant stretch
+// between client_order_id and header.client_id is written once per failure.
+// -----------------------------------------------------------------------------
+inline const std::string& parse_reject_template(ParseFailure f) {
+  static const auto templates = [] {
+    std::array<std::string, static_cast<size_t>(ParseFailure::Count)> t;
+    for (size_t i = 0; i < t.size(); ++i) {
+      std::string& s = t[i];
+      json_write::raw(s, ",\"info\":{\"code\":");
+      json_write::i64(s, to_u(RejectCode::ParseError));
+      json_write::raw(s, ",\"reason\":");
+      json_write::str(s, parse_failure_reason(static_cast<ParseFailure>(i)));
+      json_write::raw(s, "},\"symbol\":\"UNKNOWN\"},\"header\":{\"client_id\":");
+    }
+    return t;
+  }();
+  return templates[static_cast<size_t>(f) < templates.size() ? static_cast<size_t>(f) : 0];
+}
+
+inline void append_parse_reject(std::string& out, ParseFailure f, uint64_t client_order_id, ClientId client_id,
+                                SeqNum seq) {
+  json_write::raw(out, "{\"body\":{\"client_order_id\":");
+  json_write::u64(out, client_order_id);
+  out += parse_reject_template(f);
+  json_write::u64(out, client_id);
+  json_write::raw(out, ",\"seq\":");
+  json_write::u64(out, seq);
+  json_write::raw(out, ",\"type\":");
+  json_write::u64(out, to_u(MsgType::Reject));
+  json_write::raw(out, ",\"version\":1}}");
+}
+
 inline std::string dump_envelope(const EnvelopeIn& e) {
   return json(e).dump();
 }
 
+// -----------------------------------------------------------------------------
+// Outbound writer: the response layouts written straight into a buffer, in
+// the order dump() gives (keys sorted, as nlohmann's object map keeps them),
+// so clients see the same bytes without a json tree being built per response.
+// Appends to out; a buffer reused across calls stops allocating once it has
+// grown to the largest response.
+// -----------------------------------------------------------------------------
+namespace detail {
+
+inline void append_side(std::string& out, Side s) {
+  if (s == Side::Sell) json_write::raw(out, "\"S\"");
+  else json_write::raw(out, "\"B\"");
+}
+
+inline void append_body(std::string& out, const Ack& a) {
+  json_write::raw(out, "{\"client_order_id\":");
+  json_write::u64(out, a.client_order_id);
+  json_write::raw(out, ",\"order_id\":");
+  json_write::u64(out, a.order_id);
+  json_write::raw(out, ",\"symbol\":");
+  json_write::str(out, a.symbol);
+  out.push_back('}');
+}
+
+inline void append_body(std::string& out, const Reject& r) {
+  json_write::raw(out, "{\"client_order_id\":");
+  json_write::u64(out, r.client_order_id);
+  json_write::raw(out, ",\"info\":{\"code\":");
+  json_write::i64(out, r.info.code);
+  json_write::raw(out, ",\"reason\":");
+  json_write::str(out, r.info.reason);
+  json_write::raw(out, "},\"symbol\":");
+  json_write::str(out, r.symbol);
+  out.push_back('}');
+}
+
+inline void append_body(std::string& out, const Fill& f) {
+  json_write::raw(out, "{\"complete\":");
+  json_write::boolean(out, f.complete);
+  json_write::raw(out, ",\"fill_price\":");
+  json_write::i64(out, f.fill_price);
+  json_write::raw(out, ",\"fill_qty\":");
+  json_write::i64(out, f.fill_qty);
+  json_write::raw(out, ",\"order_id\":");
+  json_write::u64(out, f.order_id);
+  json_write::raw(out, ",\"side\":");
+  append_side(out, f.side);
+  json_write::raw(out, ",\"symbol\":");
+  json_write::str(out, f.symbol);
+  out.push_back('}');
+}
+
+inline void append_body(std::string& out, const Cancelled& c) {
+  json_write::raw(out, "{\"cancelled_qty\":");
+  json_write::i64(out, c.cancelled_qty);
+  json_write::raw(out, ",\"client_order_id\":");
+  json_write::u64(out, c.client_order_id);
+  json_write::raw(out, ",\"leaves_qty\":");
+  json_write::i64(out, c.leaves_qty);
+  json_write::raw(out, ",\"order_id\":");
+  json_write::u64(out, c.order_id);
+  json_write::raw(out, ",\"side\":");
+  append_side(out, c.side);
+  json_write::raw(out, ",\"symbol\":");
+  json_write::str(out, c.symbol);
+  out.push_back('}');
+}
+
+inline void append_body(std::string& out, const Replaced& r) {
+  json_write::raw(out, "{\"client_order_id\":");
+  json_write::u64(out, r.client_order_id);
+  json_write::raw(out, ",\"limit_price\":");
+  json_write::i64(out, r.limit_price);
+  json_write::raw(out, ",\"order_id\":");
+  json_write::u64(out, r.order_id);
+  json_write::raw(out, ",\"qty\":");
+  json_write::i64(out, r.qty);
+  json_write::raw(out, ",\"symbol\":");
+  json_write::str(out, r.symbol);
+  out.push_back('}');
+}
+
+inline void append_body(std::string& out, const MassCancelAck& a) {
+  json_write::raw(out, "{\"cancelled_count\":");
+  json_write::u64(out, a.cancelled_count);
+  json_write::raw(out, ",\"client_order_id\":");
+  json_write::u64(out, a.client_order_id);
+  out.push_back('}');
+}
+
+inline void append_body(std::string& out, const AuctionInfo& a) {
+  json_write::raw(out, "{\"imbalance\":");
+  json_write::i64(out, a.imbalance);
+  json_write::raw(out, ",\"price\":");
+  json_write::i64(out, a.price);
+  json_write::raw(out, ",\"qty\":");
+  json_write::i64(out, a.qty);
+  json_write::raw(out, ",\"symbol\":");
+  json_write::str(out, a.symbol);
+  json_write::raw(out, ",\"uncrossed\":");
+  json_write::boolean(out, a.uncrossed);
+  out.push_back('}');
+}
+
+} // namespace detail
+
+inline void append_envelope(std::string& out, const EnvelopeOut& e) {
+  json_write::raw(out, "{\"body\":");
+  std::visit([&](const auto& msg) { detail::append_body(out, msg); }, e.body);
+  json_write::raw(out, ",\"header\":{\"client_id\":");
+  json_write::u64(out, e.header.client_id);
+  json_write::raw(out, ",\"seq\":");
+  json_write::u64(out, e.header.seq);
+  json_write::raw(out, ",\"type\":");
+  json_write::u64(out, to_u(e.header.type));
+  json_write::raw(out, ",\"version\":");
+  json_write::u64(out, e.header.version);
+  json_write::raw(out, "}}");
+}
+
+// Written in this thread's scratch buffer, then copied out at its exact size:
+// one allocation per response, for the string the egress queue takes over
 inline std::string dump_envelope(const EnvelopeOut& e) {
-  return json(e).dump();
+  thread_local std::string scratch;
+  scratch.clear();
+  append_envelope(scratch, e);
+  return scratch;
+}
+
+// Reject for a frame turned away before parsing (wrong client, bad sequence):
+// the client_order_id is scanned from the raw bytes, the symbol is unknown
+inline std::string dump_frame_reject(RejectCode code, ClientId client_id, SeqNum seq,
+                                     const char* data, size_t len) {
+  static constexpr char kClientOrderId[] = "\"client_order_id\"";
+  Reject rej_msg;
+  scan_uint_field(data, len, kClientOrderId, sizeof(kClientOrderId) - 1, rej_msg.client_order_id);
+  rej_msg.symbol = "UNKNOWN";
+  rej_msg.info.code = to_u(code);
+  rej_msg.info.reason = reject_reason(code);
+
+  EnvelopeOut response;
+  response.header.type = MsgType::Reject;
+  response.header.seq = seq;
+  response.header.client_id = client_id;
+  response.body = rej_msg;
+  return dump_envelope(response);
 }
 
 } // namespace ex
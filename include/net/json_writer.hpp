@@ -0,0 +1,83 @@
+#pragma once
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace ex {
+
+// =============================================================================
+// Building blocks for the outbound writer (append_envelope in codec_json.hpp)
+//
+// Each one appends to a caller-owned buffer, which keeps its capacity from
+// one message to the next, so a response is written with no allocation once
+// the buffer has grown to the largest one seen. The output is byte for byte
+// what nlohmann's dump() gives for the same values: integers in decimal,
+// true/false, and strings with '"', '\\' and control characters escaped
+// (the short forms where JSON has one, \u00XX otherwise). Bytes from 0x7F
+// up are copied as they are; dump() would throw on invalid UTF-8 instead.
+// =============================================================================
+
+namespace json_write {
+
+// A constant fragment of the layout: punctuation and quoted keys together
+template <size_t N>
+inline void raw(std::string& out, const char (&s)[N]) {
+  out.append(s, N - 1);
+}
+
+inline void u64(std::string& out, uint64_t v) {
+  char buf[20];
+  const auto r = std::to_chars(buf, buf + sizeof(buf), v);
+  out.append(buf, static_cast<size_t>(r.ptr - buf));
+}
+
+inline void i64(std::string& out, int64_t v) {
+  char buf[20];
+  const auto r = std::to_chars(buf, buf + sizeof(buf), v);
+  out.append(buf, static_cast<size_t>(r.ptr - buf));
+}
+
+inline void boolean(std::string& out, bool v) {
+  if (v) out.append("true", 4);
+  else out.append("false", 5);
+}
+
+inline bool needs_escape(unsigned char c) {
+  return c < 0x20 || c == '"' || c == '\\';
+}
+
+// Quoted, escaped as dump() escapes. Runs that need no escaping (every
+// symbol and reject reason the exchange writes itself) go in one append.
+inline void str(std::string& out, std::string_view s) {
+  static constexpr char kHex[] = "0123456789abcdef";
+  out.push_back('"');
+  size_t run = 0;
+  for (size_t i = 0; i < s.size(); ++i) {
+    const unsigned char c = static_cast<unsigned char>(s[i]);
+    if (!needs_escape(c)) continue;
+    out.append(s.data() + run, i - run);
+    run = i + 1;
+    switch (c) {
+      case '"':  out.append("\\\"", 2); break;
+      case '\\': out.append("\\\\", 2); break;
+      case '\b': out.append("\\b", 2); break;
+      case '\f': out.append("\\f", 2); break;
+      case '\n': out.append("\\n", 2); break;
+      case '\r': out.append("\\r", 2); break;
+      case '\t': out.append("\\t", 2); break;
+      default: {
+        const char u[] = { '\\', 'u', '0', '0', kHex[c >> 4], kHex[c & 0xF] };
+        out.append(u, sizeof(u));
+      }
+    }
+  }
+  out.append(s.data() + run, s.size() - run);
+  out.push_back('"');
+}
+
+} // namespace json_write
+
+} // namespace ex
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <string>
+
+#include "core/types.hpp"
+#include "net/shm_ring.hpp"
+
+namespace ex {
+
+// Ring names for one client session; the exchange creates both
+inline std::string shm_ingress_name(ClientId client_id) {
+  return "/market_exchange_" + std::to_string(client_id) + "_in";
+}
+inline std::string shm_egress_name(ClientId client_id) {
+  return "/market_exchange_" + std::to_string(client_id) + "_out";
+}
+
+// =============================================================================
+// Client library for co-located strategies. Sends and receives the same JSON
+// envelopes as the ZMQ sockets over the session's two rings. Single-threaded:
+// one thread sends and polls.
+//
+//   ShmClient c;
+//   if (!c.connect(7)) ...            // exchange must list 7 in its shm clients
+//   c.send(dump_envelope(order));     // Full = retry later, Closed = connect again
+//   std::string msg;
+//   while (c.poll(msg)) { auto e = json::parse(msg).get<EnvelopeOut>(); ... }
+//   c.heartbeat();                    // from the idle loop
+//
+// Every envelope sent must carry this session's client_id; the exchange
+// rejects any other with NotAuthorized. When the exchange restarts, it
+// retires the session's rings. send() then returns Closed and closed() is
+// true, and connect() again picks up the new rings.
+// =============================================================================
+
+class ShmClient {
+public:
+  bool connect(ClientId client_id) {
+    out = ShmRing();
+    in = ShmRing();
+    return out.open(shm_ingress_name(client_id), ShmRole::Producer) &&
+           in.open(shm_egress_name(client_id), ShmRole::Consumer);
+  }
+
+  ShmWrite send(const std::string& msg) { return send(msg.data(), msg.size()); }
+  ShmWrite send(const char* data, size_t len) {
+    if (!out.current()) return ShmWrite::Closed;
+    const ShmWrite r = out.write(data, len);
+    if (r == ShmWrite::Ok) out.producerHeartbeat(shm_now_ns());
+    return r;
+  }
+
+  // Next response, if one is waiting. Responses the exchange wrote before
+  // retiring the ring can still be read.
+  bool poll(std::string& msg) {
+    size_t len = 0;
+    const char* data = in.peek(len, msg);
+    if (!data) return false;
+    if (data != msg.data()) msg.assign(data, len);
+    in.release();
+    return true;
+  }
+
+  // The exchange has retired this session's rings
+  bool closed() const { return !out.current() || !in.current(); }
+
+  void heartbeat() {
+    const uint64_t now = shm_now_ns();
+    out.producerHeartbeat(now);
+    in.consumerHeartbeat(now);
+  }
+
+  // True while the exchange has stamped the session within timeout_ns
+  bool exchangeAlive(uint64_t timeout_ns) const {
+    return shm_now_ns() - in.producerHeartbeatNs() < timeout_ns;
+  }
+
+private:
+  ShmRing out;  // orders to the exchange
+  ShmRing in;   // acks, rejects and fills back
+};
+
+} // namespace ex
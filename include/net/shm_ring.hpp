@@ -0,0 +1,308 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ex {
+
+// =============================================================================
+// Shared-memory SPSC ring
+//
+// One ring carries one direction of one client session, mapped from
+// /dev/shm by both processes. Messages are the same JSON envelopes as on the
+// ZMQ sockets in fixed-size slots, one slot each up to 496 bytes; a longer
+// message takes consecutive slots, all but the last flagged kShmMore:
+//
+//   [header: 5 cache lines][slot 0][slot 1]...[slot N-1]     N = power of two
+//   slot: seq (8) | len (4) | flags (4) | payload (496)
+//
+// The producer fills slot n % N, then publishes it by storing seq = n + 1
+// (release). The consumer waits for seq == its next expected number, so the
+// payload is visible without touching the producer's cache line and a stale
+// slot from the previous lap is never mistaken for a new one. The consumer
+// hands the slot back by advancing tail, which the producer only re-reads
+// when the ring looks full.
+//
+// Each side stamps its heartbeat (CLOCK_MONOTONIC ns, shared by every process
+// on the host) on activity and from its idle loop; the peer treats a stale
+// heartbeat as a dead session.
+//
+// The exchange never resets a ring in place, since a client may still have it
+// mapped. It zeroes the old ring's epoch, unlinks it and creates a new one
+// numbered one higher. A client notices the epoch change and reconnects.
+// =============================================================================
+
+constexpr uint64_t kShmRingMagic = 0x4D58524E47303032ull; // "MXRNG002"
+constexpr uint32_t kShmSlotSize = 512;
+constexpr uint32_t kShmPayload = kShmSlotSize - 16;
+constexpr uint32_t kShmMore = 1;   // slot flag: the message continues in the next slot
+
+struct ShmSlot {
+  std::atomic<uint64_t> seq;
+  uint32_t len;
+  uint32_t flags;
+  char data[kShmPayload];
+};
+static_assert(sizeof(ShmSlot) == kShmSlotSize, "slot layout is part of the wire format");
+
+struct ShmRingHeader {
+  uint64_t magic;
+  uint32_t slots;
+  uint32_t slot_size;
+  std::atomic<uint64_t> epoch;             // 1 for a name's first ring, +1 per restart, 0 once retired
+  alignas(64) std::atomic<uint64_t> head;  // messages published (monitoring, producer restart)
+  alignas(64) std::atomic<uint64_t> tail;  // messages consumed
+  alignas(64) std::atomic<uint64_t> producer_heartbeat_ns;
+  alignas(64) std::atomic<uint64_t> consumer_heartbeat_ns;
+};
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "ring counters are shared across processes");
+
+inline uint64_t shm_now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Which end of the ring this process holds
+enum class ShmRole : uint8_t { Producer, Consumer };
+
+// Outcome of ShmRing::write and ShmClient::send
+enum class ShmWrite : uint8_t {
+  Ok,
+  Full,       // the consumer is behind; retry or drop
+  TooLarge,   // more slots than the whole ring, never fits
+  Closed      // client only: the exchange retired the session, reconnect
+};
+
+class ShmRing {
+public:
+  ShmRing() = default;
+  ShmRing(const ShmRing&) = delete;
+  ShmRing& operator=(const ShmRing&) = delete;
+  ShmRing(ShmRing&& o) noexcept { *this = std::move(o); }
+  ShmRing& operator=(ShmRing&& o) noexcept {
+    if (this != &o) {
+      unmap();
+      hdr = o.hdr; ring = o.ring; mask = o.mask; bytes = o.bytes;
+      pos = o.pos; tail_cache = o.tail_cache; peeked = o.peeked; ring_epoch = o.ring_epoch;
+      owner = o.owner; name = std::move(o.name);
+      o.hdr = nullptr; o.ring = nullptr; o.owner = false;
+    }
+    return *this;
+  }
+  ~ShmRing() { unmap(); }
+
+  // Exchange side: creates the named ring with slots rounded up to a power
+  // of two, retiring any ring an earlier exchange left under that name. The
+  // object is retired and removed again on destruction.
+  bool create(const std::string& shm_name, uint32_t slots, ShmRole role) {
+    uint32_t n = 1;
+    while (n < slots) n <<= 1;
+    const size_t size = sizeof(ShmRingHeader) + size_t(n) * sizeof(ShmSlot);
+
+    const uint64_t epoch = retire(shm_name) + 1;
+    const int fd = ::shm_open(shm_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0 || ::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+      std::cerr << "[SHM] Cannot create " << shm_name << ": " << std::strerror(errno) << std::endl;
+      if (fd >= 0) ::close(fd);
+      return false;
+    }
+    if (!map(fd, size)) return false;
+
+    // A new object reads as zeros, so only the header needs filling in
+    hdr->slots = n;
+    hdr->slot_size = kShmSlotSize;
+    hdr->epoch.store(epoch, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    hdr->magic = kShmRingMagic;   // last, so a client never maps a half-built ring
+
+    name = shm_name;
+    owner = true;
+    ring_epoch = epoch;
+    init(n, role);
+    return true;
+  }
+
+  // Client side: maps a ring the exchange created, resuming where it stands.
+  bool open(const std::string& shm_name, ShmRole role) {
+    const int fd = ::shm_open(shm_name.c_str(), O_RDWR, 0600);
+    struct stat st {};
+    if (fd < 0 || ::fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(ShmRingHeader)) {
+      std::cerr << "[SHM] Cannot open " << shm_name << ": " << std::strerror(errno) << std::endl;
+      if (fd >= 0) ::close(fd);
+      return false;
+    }
+    if (!map(fd, size_t(st.st_size))) return false;
+    if (hdr->magic != kShmRingMagic || hdr->slot_size != kShmSlotSize ||
+        sizeof(ShmRingHeader) + size_t(hdr->slots) * sizeof(ShmSlot) > bytes) {
+      std::cerr << "[SHM] " << shm_name << " is not a ring of this version" << std::endl;
+      unmap();
+      return false;
+    }
+    ring_epoch = hdr->epoch.load(std::memory_order_acquire);
+    if (ring_epoch == 0) {
+      std::cerr << "[SHM] " << shm_name << " has been retired" << std::endl;
+      unmap();
+      return false;
+    }
+    name = shm_name;
+    init(hdr->slots, role);
+    return true;
+  }
+
+  bool valid() const { return hdr != nullptr; }
+
+  // False once the exchange has retired this ring (restart or shutdown)
+  bool current() const { return hdr->epoch.load(std::memory_order_relaxed) == ring_epoch; }
+
+  // ---- producer ----
+
+  // Copies one message in, across as many slots as it needs. Full if the
+  // consumer has not freed that many yet, and the caller decides whether to
+  // drop or retry; TooLarge if the ring could never hold it.
+  ShmWrite write(const char* data, size_t len) {
+    const uint64_t n = len == 0 ? 1 : (len + kShmPayload - 1) / kShmPayload;
+    if (n > mask + 1) return ShmWrite::TooLarge;
+    if (pos + n - tail_cache > mask + 1) {
+      tail_cache = hdr->tail.load(std::memory_order_acquire);
+      if (pos + n - tail_cache > mask + 1) return ShmWrite::Full;
+    }
+    for (uint64_t i = 0; i < n; ++i) {
+      ShmSlot& s = ring[pos & mask];
+      const size_t part = std::min<size_t>(len, kShmPayload);
+      s.len = static_cast<uint32_t>(part);
+      s.flags = i + 1 < n ? kShmMore : 0;
+      std::memcpy(s.data, data, part);
+      data += part;
+      len -= part;
+      s.seq.store(++pos, std::memory_order_release);
+    }
+    hdr->head.store(pos, std::memory_order_release);
+    return ShmWrite::Ok;
+  }
+
+  void producerHeartbeat(uint64_t now_ns) {
+    hdr->producer_heartbeat_ns.store(now_ns, std::memory_order_relaxed);
+  }
+
+  // ---- consumer ----
+
+  // Returns the next whole message, or nullptr if none is ready. A message in
+  // one slot is returned in place; a longer one is copied together into
+  // scratch once all its slots are published. The pointer stays valid until
+  // release().
+  const char* peek(size_t& len, std::string& scratch) {
+    ShmSlot& s = ring[pos & mask];
+    if (s.seq.load(std::memory_order_acquire) != pos + 1) return nullptr;
+    if (!(s.flags & kShmMore)) {
+      len = s.len;
+      peeked = 1;
+      return s.data;
+    }
+    uint64_t n = 1;
+    for (;; ++n) {
+      const ShmSlot& next = ring[(pos + n) & mask];
+      if (next.seq.load(std::memory_order_acquire) != pos + n + 1) return nullptr;
+      if (!(next.flags & kShmMore)) break;
+    }
+    scratch.clear();
+    for (uint64_t i = 0; i <= n; ++i) {
+      const ShmSlot& part = ring[(pos + i) & mask];
+      scratch.append(part.data, part.len);
+    }
+    len = scratch.size();
+    peeked = n + 1;
+    return scratch.data();
+  }
+  void release() {
+    pos += peeked;
+    peeked = 0;
+    hdr->tail.store(pos, std::memory_order_release);
+  }
+
+  void consumerHeartbeat(uint64_t now_ns) {
+    hdr->consumer_heartbeat_ns.store(now_ns, std::memory_order_relaxed);
+  }
+
+  // ---- either side ----
+
+  uint64_t producerHeartbeatNs() const { return hdr->producer_heartbeat_ns.load(std::memory_order_relaxed); }
+  uint64_t consumerHeartbeatNs() const { return hdr->consumer_heartbeat_ns.load(std::memory_order_relaxed); }
+  const std::string& shmName() const { return name; }
+
+private:
+  // Marks a ring left under shm_name as retired for any client still mapping
+  // it and unlinks it. Returns its epoch, 0 if there was none.
+  static uint64_t retire(const std::string& shm_name) {
+    const int fd = ::shm_open(shm_name.c_str(), O_RDWR, 0600);
+    if (fd < 0) return 0;
+    uint64_t epoch = 0;
+    struct stat st {};
+    if (::fstat(fd, &st) == 0 && size_t(st.st_size) >= sizeof(ShmRingHeader)) {
+      void* p = ::mmap(nullptr, sizeof(ShmRingHeader), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      if (p != MAP_FAILED) {
+        auto* old = static_cast<ShmRingHeader*>(p);
+        if (old->magic == kShmRingMagic) epoch = old->epoch.exchange(0, std::memory_order_acq_rel);
+        ::munmap(p, sizeof(ShmRingHeader));
+      }
+    }
+    ::close(fd);
+    ::shm_unlink(shm_name.c_str());
+    return epoch;
+  }
+
+  bool map(int fd, size_t size) {
+    void* p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) {
+      std::cerr << "[SHM] mmap failed: " << std::strerror(errno) << std::endl;
+      return false;
+    }
+    hdr = static_cast<ShmRingHeader*>(p);
+    bytes = size;
+    return true;
+  }
+
+  // The producer resumes at head and the consumer at tail, so either side
+  // can reattach to a live ring
+  void init(uint32_t n, ShmRole role) {
+    ring = reinterpret_cast<ShmSlot*>(reinterpret_cast<char*>(hdr) + sizeof(ShmRingHeader));
+    mask = n - 1;
+    tail_cache = hdr->tail.load(std::memory_order_acquire);
+    pos = role == ShmRole::Producer ? hdr->head.load(std::memory_order_acquire) : tail_cache;
+  }
+
+  void unmap() {
+    if (!hdr) return;
+    if (owner) hdr->epoch.store(0, std::memory_order_release);
+    ::munmap(static_cast<void*>(hdr), bytes);
+    if (owner) ::shm_unlink(name.c_str());
+    hdr = nullptr;
+    ring = nullptr;
+    owner = false;
+  }
+
+  ShmRingHeader* hdr = nullptr;
+  ShmSlot* ring = nullptr;
+  uint64_t mask = 0;
+  size_t bytes = 0;
+  uint64_t pos = 0;         // producer: published count; consumer: consumed count
+  uint64_t tail_cache = 0;  // producer's last view of tail
+  uint64_t peeked = 0;      // consumer: slots the last peek() covered
+  uint64_t ring_epoch = 0;
+  bool owner = false;
+  std::string name;
+};
+
+} // namespace ex
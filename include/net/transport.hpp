@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace ex {
+
+// =============================================================================
+// ZMQ endpoints for the exchange's two sockets
+//
+// ingress: PULL bound by InputStream, clients PUSH orders to it
+// egress:  PUSH connected by every responder (parse workers and the matching
+//          thread), clients bind a PULL on it to receive acks and fills
+//
+// tcp - remote clients, the default
+// ipc - clients on the same host, unix domain sockets under /tmp
+//
+// There is no inproc client transport: nothing in the exchange process
+// would be on the other end. inproc is only used between the exchange's
+// own threads (kRouterResponses).
+// =============================================================================
+
+enum class Transport : uint8_t { Tcp, Ipc };
+
+// Router mode: clients connect DEALER sockets to a ROUTER on the ingress
+// endpoint and get their own responses back on the same socket. Responders
+// push to this internal endpoint instead of egress; the ROUTER's thread
+// drains it and addresses each response by its header.client_id.
+constexpr const char* kRouterResponses = "inproc://market_exchange_responses";
+
+struct Endpoints {
+    std::string ingress;
+    std::string egress;
+};
+
+inline bool transport_from_string(std::string_view s, Transport& out) {
+    if (s == "tcp") { out = Transport::Tcp; return true; }
+    if (s == "ipc") { out = Transport::Ipc; return true; }
+    return false;
+}
+
+inline const char* transport_name(Transport t) {
+    switch (t) {
+        case Transport::Tcp: return "tcp";
+        case Transport::Ipc: return "ipc";
+    }
+    return "tcp";
+}
+
+// The ports also name the ipc endpoints so two exchanges on one host do not
+// collide
+inline Endpoints make_endpoints(Transport t, const std::string& in_port, const std::string& out_port,
+                                bool router = false) {
+    if (router) {
+        Endpoints e = make_endpoints(t, in_port, out_port);
+        e.egress = kRouterResponses;
+        return e;
+    }
+    switch (t) {
+        case Transport::Ipc:
+            return {"ipc:///tmp/market_exchange_" + in_port, "ipc:///tmp/market_exchange_" + out_port};
+        case Transport::Tcp:
+            break;
+    }
+    return {"tcp://*:" + in_port, "tcp://localhost:" + out_port};
+}
+
+} // namespace ex
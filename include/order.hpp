@@ -4,18 +4,37 @@
 
 class Order {
     public:
-        uint64_t client_order_id;
-        uint64_t internal_order_id;
-        uint64_t timestamp;
+        uint64_t client_order_id = 0;
+        uint64_t internal_order_id = 0; // for Cancel: the order being cancelled
+        uint64_t timestamp = 0;         // receive time, steady clock ns
+        uint64_t global_seq = 0;        // Sequencer number of the message it came from
+        std::string raw;                // that message, only when replicating to a backup
         std::string symbol;
-        ex::Side side;
-        ex::MsgType type;
-        double price;
-        uint32_t quantity;
+        ex::Side side = ex::Side::Buy;
+        ex::MsgType type = ex::MsgType::Heartbeat; // Heartbeat = nothing to process
+        double price = 0;
+        ex::Qty quantity = 0;           // as sent; RiskChecker refuses what the books cannot hold
+        ex::ClientId client_id = 0;
+        ex::SeqNum seq = 0;
+        ex::OrdType ord_type = ex::OrdType::Limit;
+        ex::TimeInForce tif = ex::TimeInForce::Day;
+        uint32_t expire_date = 0; // GTD: YYYYMMDD; EndOfSession: session date
+        ex::Qty display_qty = 0;  // iceberg peak size, 0 = fully displayed
+        double stop_price = 0;    // Stop / StopLimit trigger
+        ex::StpMode stp = ex::StpMode::None;
+
+        // MassCancel / KillSwitch
+        ex::MassCancelScope cancel_scope = ex::MassCancelScope::Client;
+        ex::ClientId target_client_id = 0;  // MassCancel: 0 when the request named none
+        bool kill_enabled = false;
+        bool cancel_open = false;
+
+        // Auction
+        ex::AuctionAction auction_action = ex::AuctionAction::StartCall;
 
         // Main Constructor
         Order(uint64_t c_id, uint64_t i_id, uint64_t timestamp, const std::string symbol, 
-            ex::Side side, ex::MsgType type, double price, uint32_t quantity)
+            ex::Side side, ex::MsgType type, double price, ex::Qty quantity)
 
             : client_order_id(c_id), internal_order_id(i_id), timestamp(timestamp), symbol(symbol), 
             side(side), type(type), price(price), quantity(quantity) 
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+#include "core/types.hpp"
+
+namespace ex {
+
+// Pool slots are addressed by index, never by pointer, so the whole pool can be
+// copied or mapped at a different address without fixing anything up.
+constexpr uint32_t kNullIndex = UINT32_MAX;
+
+struct RestingOrder {
+    OrderId  order_id = 0;
+    uint64_t client_order_id = 0;
+    uint64_t timestamp = 0;
+    Price    price = 0;
+    Qty      qty = 0;          // open displayed quantity
+    Qty      reserve = 0;      // iceberg: hidden quantity behind qty
+    Qty      display = 0;      // iceberg: peak size, 0 = fully displayed
+    ClientId client_id = 0;
+    Side     side = Side::Buy;
+    OrdType  ord_type = OrdType::Limit; // Stop/StopLimit until triggered
+    StpMode  stp = StpMode::None;       // applies when this order takes liquidity
+    TimeInForce tif = TimeInForce::Day;
+    uint32_t expire_date = 0;           // GTD, YYYYMMDD
+    Price    stop_price = 0;
+    uint32_t book = kNullIndex; // OrderBook::id() of the owning book
+
+    // FIFO links inside the order's price level
+    uint32_t prev = kNullIndex;
+    uint32_t next = kNullIndex;
+
+    // Links in the owning client's list of resting orders (see MatchingEngine)
+    uint32_t client_prev = kNullIndex;
+    uint32_t client_next = kNullIndex;
+
+    // Links in the session's expiry list for this order (Day and GTD only)
+    uint32_t expiry_prev = kNullIndex;
+    uint32_t expiry_next = kNullIndex;
+};
+
+// A stop that has not triggered sits in its book's stop levels, keyed by
+// stop_price, instead of the price levels.
+inline bool isPendingStop(const RestingOrder& o) {
+    return o.ord_type == OrdType::Stop || o.ord_type == OrdType::StopLimit;
+}
+
+// Fixed-slot storage for every resting order across all books.
+class OrderPool {
+public:
+    void reserve(size_t n) { slots.reserve(n); }
+
+    uint32_t allocate() {
+        if (!free_slots.empty()) {
+            uint32_t idx = free_slots.back();
+            free_slots.pop_back();
+            slots[idx] = RestingOrder();
+            return idx;
+        }
+        slots.emplace_back();
+        return static_cast<uint32_t>(slots.size() - 1);
+    }
+
+    void release(uint32_t idx) { free_slots.push_back(idx); }
+
+    RestingOrder& operator[](uint32_t idx) { return slots[idx]; }
+    const RestingOrder& operator[](uint32_t idx) const { return slots[idx]; }
+
+    size_t live() const { return slots.size() - free_slots.size(); }
+
+private:
+    std::vector<RestingOrder> slots;
+    std::vector<uint32_t> free_slots;
+};
+
+struct PriceLevel {
+    uint32_t head = kNullIndex;
+    uint32_t tail = kNullIndex;
+    Qty      total_qty = 0;
+    Qty      reserve_qty = 0;  // iceberg quantity hidden behind total_qty
+    uint32_t count = 0;
+};
+
+// Price-time priority book for a single symbol. Levels are keyed by price in
+// ascending order on both sides; the best bid is the last bid level. Pending
+// stops use the same level FIFOs in a second pair of maps keyed by stop price,
+// so the ones a trade fires are always at one end of their map.
+class OrderBook {
+public:
+    using Levels = std::map<Price, PriceLevel>;
+
+    OrderBook(OrderPool* pool, uint32_t id, const std::string& symbol)
+        : pool(pool), book_id(id), book_symbol(symbol) {}
+
+    uint32_t id() const { return book_id; }
+    const std::string& symbol() const { return book_symbol; }
+
+    // Appends the pooled order to the tail of its price level (its stop level
+    // for a pending stop; likewise for appendSorted, remove and reduce).
+    void append(uint32_t idx);
+    // Same as append, but hints that the level sorts at or after every existing
+    // level on that side (used when rebuilding a book from a snapshot).
+    void appendSorted(uint32_t idx);
+    // Unlinks the pooled order from its level, dropping the level if it empties.
+    void remove(uint32_t idx);
+    // Lowers a resting order's quantity in place, keeping its queue position.
+    void reduce(uint32_t idx, Qty by);
+    // Same for an iceberg's hidden quantity.
+    void reduceReserve(uint32_t idx, Qty by);
+    // Iceberg whose displayed qty has traded to zero: refills it from the
+    // reserve and moves it to the tail of the same level.
+    void replenish(PriceLevel& level, uint32_t idx);
+    // Unlinks every stop that last_trade fires and appends them to fired:
+    // buy stops (stop <= last) in ascending stop price, then sell stops
+    // (stop >= last) in descending stop price, FIFO within each level. Only
+    // the fired stops are visited.
+    void takeTriggered(Price last_trade, std::vector<uint32_t>& fired);
+    // Drops every level at once. The caller is responsible for the pooled orders.
+    void clear() { bids.clear(); asks.clear(); buy_stops.clear(); sell_stops.clear(); }
+
+    Levels& levels(Side side) { return side == Side::Buy ? bids : asks; }
+    const Levels& levels(Side side) const { return side == Side::Buy ? bids : asks; }
+    Levels& stops(Side side) { return side == Side::Buy ? buy_stops : sell_stops; }
+    const Levels& stops(Side side) const { return side == Side::Buy ? buy_stops : sell_stops; }
+
+    bool empty() const { return bids.empty() && asks.empty() && buy_stops.empty() && sell_stops.empty(); }
+
+    Price lastTradePrice() const { return last_trade; }
+    void setLastTrade(Price px) { last_trade = px; }
+
+    // During a call auction orders rest without matching, so the book may be
+    // crossed until MatchingEngine::uncross runs.
+    bool inAuction() const { return auction; }
+    void setAuction(bool on) { auction = on; }
+
+private:
+    void link(PriceLevel& level, uint32_t idx);
+    Levels& home(const RestingOrder& o) { return isPendingStop(o) ? stops(o.side) : levels(o.side); }
+    static Price homeKey(const RestingOrder& o) { return isPendingStop(o) ? o.stop_price : o.price; }
+
+    OrderPool* pool;
+    uint32_t book_id;
+    std::string book_symbol;
+    Levels bids;
+    Levels asks;
+    Levels buy_stops;
+    Levels sell_stops;
+    Price last_trade = 0;
+    bool auction = false;
+};
+
+} // namespace ex
@@ -4,36 +4,50 @@
 #include <atomic>
 #include "order.hpp"
 #include "thread_safe_queue.hpp"
-#include "id_generator.hpp"
-#include <zmq.hpp>
+#include "sequencer.hpp"
+#include "egress_stage.hpp"
+#include "net/codec_json.hpp"
 
 namespace ex {
 
+// The Order a parsed envelope describes, without an internal id (assigned by
+// the matching thread) or sequencing. A backup rebuilds its orders from the
+// replicated stream with the same function.
+Order order_from_envelope(const EnvelopeIn& envelope);
+
 class OrderGenerator {
 public:
-    OrderGenerator(ThreadSafeQueue<std::string>* raw_queue,
+    OrderGenerator(ThreadSafeQueue<InboundMessage>* raw_queue,
                    ThreadSafeQueue<Order>* order_queue,
-                   IdGenerator* id_gen,
-                   const std::string& out_port);
+                   EgressStage::Producer* egress, bool keep_raw = false);
 
     ~OrderGenerator();
     // This is the loop that each worker thread will run
     void run();
     void stop();
 
+    // Messages this worker rejected because they did not parse
+    uint64_t parseErrors() const { return parse_errors.load(std::memory_order_relaxed); }
+
 private:
     // Internal logic moved from InputStream
-    Order convertToOrder(const std::string& json_raw);
-    void sendResponse(const std::string& message);
+    Order convertToOrder(const std::string& json_raw, ClientId session);
+    // Hands the response to the egress thread
+    void sendResponse(ClientId client_id, std::string message);
+    void sendOverloadReject(const Order& o);
+    // Answers a message that did not parse from a pre-serialized template,
+    // over the session it came in on if it came through a gateway
+    void sendParseReject(const std::string& json_raw, ParseFailure failure, ClientId session);
 
-    zmq::context_t context;
-    ThreadSafeQueue<std::string>* raw_queue;
+    ThreadSafeQueue<InboundMessage>* raw_queue;
     ThreadSafeQueue<Order>* order_queue;
-    IdGenerator* id_generator;
-    
-    // Each worker needs its own socket to send Acks/Rejects
-    zmq::socket_t out_socket;
+
+    // This worker's queue to the egress thread, which owns the socket
+    EgressStage::Producer* egress;
+    // Pass each message's raw bytes on in Order::raw, for replication
+    bool keep_raw;
     std::atomic<bool> running;
+    std::atomic<uint64_t> parse_errors{0};
 };
 
 } // namespace ex
\ No newline at end of file
@@ -0,0 +1,207 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <zmq.hpp>
+#include "core/types.hpp"
+
+namespace ex {
+
+// =============================================================================
+// Symbol partitions across exchange processes
+//
+// Each core process (market_exchange --partition PORT --partition-index I/N)
+// owns some symbols' books and binds its ingress on its own port. A front end
+// (market_exchange --front MAP) binds the clients' ingress in their place,
+// reads just the symbol out of each message and forwards it to the process
+// that owns it. Responses do not come back through the front end: every
+// partition's egress connects to the clients' response endpoint directly.
+//
+// Partition map, one partition per line:
+//
+//   # endpoint              symbols
+//   tcp://localhost:6001    AAPL MSFT
+//   tcp://localhost:6002    GOOG TSLA
+//   tcp://localhost:6003    *
+//
+// "*" takes every symbol not listed; with no "*" line they are spread by an
+// FNV-1a hash of the symbol over all the partitions. Where unlisted symbols go is
+// recorded next to the map (MAP.placement) and a map that would send them
+// elsewhere is refused, at startup too, since their books would not follow.
+//
+// Messages that apply to every book when they name no symbol (heartbeats,
+// client- or venue-wide mass cancels, auctions, end of session, the kill
+// switch) go to every partition. Mass cancels, the kill switch and end of
+// session get one answer per partition, sent back to the front end, which
+// sums them into the one answer the client sees; only partition 0 answers a
+// refused auction. A cancel or replace without a symbol goes to the
+// partition its order_id came from (see kPartitionIdBits). Anything else
+// without a symbol, a cancel by client_order_id alone included, goes to the
+// first partition, which rejects it unless the order is its own.
+//
+// Risk state is not shared: each partition checks a client's orders against
+// its own open orders and positions, with the open-order and gross-position
+// limits divided by the number of partitions.
+// =============================================================================
+
+// Order ids carry the partition index in their top bits, so partitions
+// never hand out the same id: partition i counts up from i << 40
+constexpr unsigned kPartitionIdBits = 40;
+
+inline OrderId partitionIdBase(size_t index) {
+    return static_cast<OrderId>(index) << kPartitionIdBits;
+}
+
+// Broadcasts each partition answers with one MassCancelAck or Reject
+inline bool mergedAnswer(MsgType type) {
+    return type == MsgType::MassCancel || type == MsgType::KillSwitch || type == MsgType::EndOfSession;
+}
+
+// FNV-1a over the symbol's bytes: cheap for short symbols, and the same in
+// every build, so where unlisted symbols go does not depend on the library
+struct SymbolHash {
+    size_t operator()(std::string_view symbol) const {
+        uint64_t h = 14695981039346656037ull;
+        for (const unsigned char c : symbol) {
+            h ^= c;
+            h *= 1099511628211ull;
+        }
+        return static_cast<size_t>(h);
+    }
+};
+
+struct PartitionMap {
+    static constexpr size_t kNone = static_cast<size_t>(-1);
+
+    PartitionMap() = default;
+    PartitionMap(PartitionMap&&) = default;
+    PartitionMap& operator=(PartitionMap&&) = default;
+    // owners would still point into the original's symbols
+    PartitionMap(const PartitionMap&) = delete;
+    PartitionMap& operator=(const PartitionMap&) = delete;
+
+    std::vector<std::string> endpoints;
+    // symbol -> index into endpoints. Looked up by string_view for every
+    // message, so the keys are views of the names in symbols, which a deque
+    // never moves, rather than strings to be built for each lookup.
+    std::deque<std::string> symbols;
+    std::unordered_map<std::string_view, size_t, SymbolHash> owners;
+    size_t fallback = kNone;
+
+    // Replaces out only if the whole file parses; error says why not
+    static bool load(const std::string& path, PartitionMap& out, std::string& error);
+
+    // Where symbols the map does not list end up: the "*" endpoint, or the
+    // whole endpoint list when they are hashed
+    std::string placement() const;
+
+    size_t partitionOf(std::string_view symbol) const {
+        auto it = owners.find(symbol);
+        if (it != owners.end()) return it->second;
+        if (fallback != kNone) return fallback;
+        return SymbolHash()(symbol) % endpoints.size();
+    }
+
+    // The partition that handed out id; ids from before partitioning, or
+    // past the end of the map, go to the first partition
+    size_t partitionOfOrder(OrderId id) const {
+        const uint64_t index = id >> kPartitionIdBits;
+        return index < endpoints.size() ? static_cast<size_t>(index) : 0;
+    }
+};
+
+struct PartitionRouterCounters {
+    uint64_t forwarded;   // messages sent to one partition
+    uint64_t broadcast;   // messages without a symbol, sent to all
+    uint64_t reloads;
+    size_t partitions;
+    uint64_t merged;      // broadcast answers sent to clients
+    uint64_t incomplete;  // of those, sent before every partition answered
+};
+
+class PartitionRouter {
+public:
+    // Binds a PULL on ingress for the clients. Nothing is forwarded until
+    // load() has read the map. With an answers endpoint it binds a PULL there
+    // for the partitions' answers to broadcasts and sends each merged answer
+    // to the clients on egress; without one, every partition's answer goes
+    // to the client as it is.
+    PartitionRouter(zmq::context_t& context, const std::string& ingress, const std::string& map_path,
+                    const std::string& answers = std::string(), const std::string& egress = std::string());
+
+    // Reads the map and connects to any partition not connected yet. On a
+    // bad file, or one that moves unlisted symbols, the current map stays in
+    // force.
+    bool load();
+
+    // Forwards until stop(). Re-reads the map whenever its file changes, so
+    // symbols can be added or moved without a restart. Moving a symbol
+    // does not move its book: only move symbols that have nothing resting.
+    void run();
+    void stop() { running = false; }
+
+    PartitionRouterCounters counters() const;
+
+private:
+    // Forwards one client message (a multipart message is a batch); each
+    // partition gets its share as one multipart message
+    bool forward(zmq::recv_flags flags);
+    void reloadIfChanged();
+    // Compares the map's placement with the one recorded beside it, and
+    // records it if there is none yet
+    bool checkPlacement(const std::string& placement, std::string& error) const;
+
+    // Broadcast answers being summed, by the request's client id and seq.
+    // An answer is sent once every partition the request went to has
+    // answered, or kMergeTimeout after it went out with what has arrived.
+    struct Merge {
+        size_t waiting = 0;
+        size_t answered = 0;
+        uint64_t client_order_id = 0;
+        uint64_t cancelled = 0;
+        std::string reject;   // the first partition's Reject, sent as it is
+        std::chrono::steady_clock::time_point deadline;
+    };
+    static constexpr std::chrono::milliseconds kMergeTimeout{1000};
+
+    void expect(ClientId client_id, SeqNum seq, size_t partitions);
+    // Takes in whatever answers have arrived
+    bool collect();
+    void expireMerges(std::chrono::steady_clock::time_point now);
+    void reply(ClientId client_id, SeqNum seq, const Merge& m);
+
+    zmq::context_t& context;
+    zmq::socket_t in_socket;
+    zmq::socket_t answers_socket;
+    zmq::socket_t out_socket;
+    bool merging = false;
+    std::string map_path;
+    time_t map_mtime = 0;
+
+    PartitionMap map;
+    // One PUSH per endpoint, kept across reloads; outputs[i] serves map.endpoints[i]
+    std::unordered_map<std::string, std::unique_ptr<zmq::socket_t>> sockets;
+    std::vector<zmq::socket_t*> outputs;
+    std::vector<std::vector<zmq::message_t>> pending; // per partition, one batch
+    std::map<std::pair<ClientId, SeqNum>, Merge> merges;
+
+    std::atomic<bool> running{false};
+    std::atomic<uint64_t> forwarded{0};
+    std::atomic<uint64_t> broadcast{0};
+    std::atomic<uint64_t> reloads{0};
+    std::atomic<size_t> partitions{0};
+    std::atomic<uint64_t> merged{0};
+    std::atomic<uint64_t> incomplete{0};
+};
+
+} // namespace ex
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace ex {
+
+struct ReorderCounters {
+    uint64_t skipped;   // numbers given up on: not arrived within the window or timeout
+    uint64_t late;      // arrived after being given up on, delivered out of order
+    size_t max_held;    // deepest the buffer has been
+};
+
+// Puts items numbered by the Sequencer back into order after the parse
+// workers have raced each other. push() delivers an item as soon as every
+// number before it has been delivered and holds it otherwise, in a ring of
+// `window` slots indexed by number.
+//
+// The workers forward every number, so a gap only means a worker has not
+// finished yet. As a safety valve against a stalled worker, a missing number
+// is given up on when the items behind it would overflow the window, or once
+// the matching thread has waited gap_timeout_ns for it (expire(), which gives
+// up on the whole run of missing numbers at once). Anything
+// that turns up after that is delivered straight away and counted as late.
+// Single-threaded: the matching thread owns it.
+template <typename T>
+class ReorderBuffer {
+public:
+    explicit ReorderBuffer(uint64_t first_seq = 1, size_t window = 16384, uint64_t gap_timeout_ns = 50000000)
+        : slots(roundUp(window)), mask(slots.size() - 1), next(first_seq), gap_timeout_ns(gap_timeout_ns) {}
+
+    // Calls fn(T&) for item and then for whatever it unblocks, in order
+    template <class Fn>
+    void push(uint64_t seq, T item, uint64_t now_ns, Fn&& fn) {
+        if (seq < next) {
+            ++late;
+            fn(item);
+            return;
+        }
+        if (seq - next > mask) {
+            if (held == 0) {
+                // Nothing buffered: jump straight to seq rather than leave a
+                // window's worth of gaps behind it
+                skipped += seq - next;
+                next = seq;
+            }
+            while (seq - next > mask) skip(now_ns, fn);
+        }
+        slots[seq & mask] = std::move(item);
+        if (++held > max_held) max_held = held;
+        if (seq == next) {
+            release(now_ns, fn);
+        } else if (held == 1) {
+            gap_since_ns = now_ns;
+        }
+    }
+
+    // Gives up on the gap being waited for if it is gap_timeout_ns overdue,
+    // however many numbers it spans, delivering what it was holding back
+    template <class Fn>
+    void expire(uint64_t now_ns, Fn&& fn) {
+        if (held == 0 || now_ns - gap_since_ns < gap_timeout_ns) return;
+        // Something is held within the window, so this stops at it
+        while (!slots[next & mask]) {
+            ++skipped;
+            ++next;
+        }
+        release(now_ns, fn);
+    }
+
+    // Starts over at first_seq; only while nothing is held
+    void restart(uint64_t first_seq) {
+        next = first_seq;
+        gap_since_ns = 0;
+    }
+
+    // True while items are held behind a missing number
+    bool waiting() const { return held > 0; }
+
+    // How long until expire() would give up on the current gap
+    uint64_t untilExpiryNs(uint64_t now_ns) const {
+        const uint64_t waited = now_ns - gap_since_ns;
+        return waited >= gap_timeout_ns ? 0 : gap_timeout_ns - waited;
+    }
+
+    uint64_t nextSeq() const { return next; }
+
+    ReorderCounters counters() const { return ReorderCounters{ skipped, late, max_held }; }
+
+private:
+    static size_t roundUp(size_t n) {
+        size_t c = 2;
+        while (c < n) c <<= 1;
+        return c;
+    }
+
+    template <class Fn>
+    void skip(uint64_t now_ns, Fn&& fn) {
+        ++skipped;
+        ++next;
+        release(now_ns, fn);
+    }
+
+    // Delivers the run starting at next; a gap left behind starts its clock now
+    template <class Fn>
+    void release(uint64_t now_ns, Fn&& fn) {
+        while (held > 0 && slots[next & mask]) {
+            T item = std::move(*slots[next & mask]);
+            slots[next & mask].reset();
+            --held;
+            ++next;
+            fn(item);
+        }
+        gap_since_ns = now_ns;
+    }
+
+    std::vector<std::optional<T>> slots;
+    size_t mask;
+    uint64_t next;
+    uint64_t gap_timeout_ns;
+    uint64_t gap_since_ns = 0;
+    size_t held = 0;
+
+    uint64_t skipped = 0;
+    uint64_t late = 0;
+    size_t max_held = 0;
+};
+
+} // namespace ex
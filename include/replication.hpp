@@ -0,0 +1,172 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+#include "spsc_queue.hpp"
+
+namespace ex {
+
+// =============================================================================
+// Primary/backup replication of the sequenced input
+//
+// The primary's matching thread appends every message it processes, in
+// sequence order, as it processes it; a replication thread streams them to
+// one backup over TCP. The backup feeds the same messages through the same
+// matching code, so its books, ids and risk state track the primary's.
+//
+// primary -> backup, one frame per message:
+//   len (u32) | seq (u64) | recv_ns (u64) | payload (len bytes), big-endian
+//   seq 0 with no payload is a heartbeat, sent when the stream is idle and
+//   whenever the primary's egress releases more; its recv_ns field carries
+//   the highest seq whose responses the primary has released
+// backup -> primary:
+//   seq (u64, big-endian): every message up to seq has been received, sent
+//   for every read that brought in a frame, heartbeats included
+//
+// Frames are batched into as few writes as the socket takes and acks cover
+// whatever arrived in one read, so neither side waits per message. The
+// primary's egress holds each response until the backup's ack covers the
+// message it answers (EgressStage::holdFor), so a client is never acked for
+// an order a failover would lose.
+//
+// Only one of the two serves at a time. A primary that has had no ack for
+// kAckTimeoutMs, or loses the connection, fences itself: it releases nothing
+// more and runs its fence action, which stops the process. A backup takes
+// over only once it has heard nothing for kTakeoverMs, however the
+// connection ended, which leaves the primary time to fence first. It then
+// sends the responses it computed in standby that the primary had not
+// released (EgressStage::retainFor); one the primary sent just before it
+// went can go out twice, but none is lost.
+// =============================================================================
+
+constexpr int kAckTimeoutMs = 500;
+constexpr int kTakeoverMs = 1000;
+
+struct ReplicationRecord {
+    uint64_t seq = 0;
+    uint64_t recv_ns = 0;
+    std::string payload;
+};
+
+struct ReplicationCounters {
+    bool connected;
+    uint64_t appended;      // messages handed over by the matching thread
+    uint64_t sent;          // messages written to the backup
+    uint64_t writes;        // socket writes they took
+    uint64_t replicated;    // highest seq the backup has acked
+};
+
+class ReplicationPrimary {
+public:
+    explicit ReplicationPrimary(uint16_t port, size_t queue_capacity = 65536);
+    ~ReplicationPrimary();
+
+    ReplicationPrimary(const ReplicationPrimary&) = delete;
+    ReplicationPrimary& operator=(const ReplicationPrimary&) = delete;
+
+    // Runs on the replication thread when the primary fences itself; must
+    // stop this process serving. Without one the primary just holds every
+    // response from then on. Set before start().
+    void fenceWith(void (*action)()) { fence_action = action; }
+
+    // Highest seq whose responses the egress has released, streamed to the
+    // backup so it knows what it need not replay. Set before start().
+    void reportReleased(const std::atomic<uint64_t>* released) { released_seq = released; }
+
+    // Listens on port and blocks until a backup connects. The backup has to
+    // start from the same snapshot and join before the first message.
+    bool waitForBackup();
+
+    void start();
+    void stop();
+
+    // Matching thread only. Spins, then yields, while the queue is full.
+    void append(uint64_t seq, uint64_t recv_ns, std::string payload);
+
+    // What the egress holds responses against. Stops moving once the
+    // primary has fenced itself.
+    const std::atomic<uint64_t>* replicated() const { return &acked; }
+    bool fenced() const { return is_fenced.load(std::memory_order_acquire); }
+
+    ReplicationCounters counters() const;
+
+private:
+    static constexpr size_t kMaxWrite = 256 * 1024;
+    static constexpr uint64_t kHeartbeatNs = 100000000;
+    static constexpr uint64_t kAckTimeoutNs = kAckTimeoutMs * 1000000ull;
+    static constexpr uint32_t kSpinPasses = 1000;
+    static constexpr uint32_t kYieldPasses = 100000;
+
+    void run();
+    // Sends what it can of out; false if the backup is gone
+    bool writeOut();
+    // Reads any acks; false if the backup is gone
+    bool readAcks();
+    // Fences the primary: closes the connection, freezes the watermark
+    void lost(const char* why);
+
+    uint16_t port;
+    int listen_fd = -1;
+    int fd = -1;
+    SpscQueue<ReplicationRecord> queue;
+
+    std::string out;        // encoded frames not yet written
+    size_t out_pos = 0;
+    char ack_buf[64];
+    size_t ack_len = 0;
+    uint64_t last_ack_ns = 0;
+    const std::atomic<uint64_t>* released_seq = nullptr;
+    uint64_t reported = 0;  // last release watermark sent
+    void (*fence_action)() = nullptr;
+
+    std::thread thread;
+    std::atomic<bool> running{false};
+    std::atomic<bool> connected{false};
+    std::atomic<bool> is_fenced{false};
+    std::atomic<uint64_t> acked{0};
+    std::atomic<uint64_t> appended{0};
+    std::atomic<uint64_t> sent{0};
+    std::atomic<uint64_t> writes{0};
+};
+
+class ReplicationBackup {
+public:
+    ReplicationBackup() = default;
+    ~ReplicationBackup();
+
+    ReplicationBackup(const ReplicationBackup&) = delete;
+    ReplicationBackup& operator=(const ReplicationBackup&) = delete;
+
+    // Connects to the primary's replication port
+    bool connect(const std::string& host, uint16_t port);
+
+    // Blocks for the next messages, acks them and appends them to out in
+    // sequence order. Returns false once the primary is gone: the connection
+    // closed, or nothing (not even a heartbeat) for silence_timeout_ms; out
+    // still gets whatever complete messages arrived before that.
+    bool receive(std::vector<ReplicationRecord>& out, int silence_timeout_ms = kTakeoverMs);
+
+    // After receive() has returned false: waits until nothing has been heard
+    // from the primary for kTakeoverMs, so it has fenced itself, and drops
+    // the connection. Only then may this side serve.
+    void awaitFence();
+
+    // Last sequence number received
+    uint64_t lastSeq() const { return last_seq; }
+
+    // Highest seq whose responses the primary reported released; updated on
+    // the receiving thread, read by the egress (EgressStage::retainFor)
+    const std::atomic<uint64_t>* released() const { return &released_seq; }
+
+private:
+    int fd = -1;
+    std::string in;
+    uint64_t last_seq = 0;
+    uint64_t last_heard_ns = 0;
+    std::atomic<uint64_t> released_seq{0};
+};
+
+} // namespace ex
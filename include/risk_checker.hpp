@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include "order.hpp"
+#include "core/types.hpp"
+
+namespace ex {
+
+// Largest quantity an order may carry, whatever its client's limits
+constexpr Qty kMaxQty = UINT32_MAX;
+
+// Per-client pre-trade limits. A zero limit disables that check.
+struct RiskLimits {
+    Qty      max_order_qty = 0;
+    int64_t  max_notional = 0;       // price * qty
+    int64_t  price_collar_bps = 0;   // max distance from last trade, in basis points
+    uint32_t max_open_orders = 0;
+    Qty      max_gross_position = 0; // |position| + open buy qty + open sell qty
+};
+
+struct ClientRiskState {
+    RiskLimits limits;
+    uint32_t open_orders = 0;
+    Qty open_buy_qty = 0;
+    Qty open_sell_qty = 0;
+    Qty position = 0;                // net filled quantity, buys positive
+    bool blocked = false;            // kill switch
+};
+
+// Pre-trade checks run on the matching thread before an order reaches the
+// engine. The matching thread owns all client state, so there is no locking;
+// each check is one hash lookup plus a handful of comparisons.
+class RiskChecker {
+public:
+    explicit RiskChecker(const RiskLimits& defaults = RiskLimits()) : default_limits(defaults) {}
+
+    void setLimits(ClientId client_id, const RiskLimits& limits);
+
+    // Admin clients may send KillSwitch and venue-wide MassCancel requests.
+    void addAdmin(ClientId client_id) { admins.insert(client_id); }
+    bool isAdmin(ClientId client_id) const { return admins.count(client_id) != 0; }
+
+    // Kill switch: while blocked, every new order from the client is rejected.
+    void setBlocked(ClientId client_id, bool blocked) { stateFor(client_id).blocked = blocked; }
+
+    // Returns RejectCode::None and books the order as open if it passes.
+    // A quantity outside 1..kMaxQty or a non-positive limit or stop price
+    // is InvalidOrder; a market order with no last trade to size it at is
+    // NoReferencePrice while a notional limit applies.
+    RejectCode check(const Order& o, Price last_trade);
+    // Same limits for a Replace of a resting order with open_qty left; only
+    // the change in open quantity is booked if it passes. The new quantity
+    // and price are range-checked as above, refused with InvalidReplace.
+    RejectCode checkReplace(const Order& o, Side side, Qty open_qty, Price last_trade);
+
+    // Keep open-order and position state in step with the engine.
+    void onFill(ClientId client_id, Side side, Qty qty, bool complete);
+    // complete is false when only part of the order was cancelled.
+    void onCancel(ClientId client_id, Side side, Qty qty, bool complete);
+    // Counts an order that is already resting (e.g. restored from a snapshot).
+    void onResting(ClientId client_id, Side side, Qty open_qty);
+
+    const ClientRiskState* state(ClientId client_id) const;
+
+private:
+    ClientRiskState& stateFor(ClientId client_id);
+
+    RiskLimits default_limits;
+    std::unordered_map<ClientId, ClientRiskState> clients;
+    std::unordered_set<ClientId> admins;
+};
+
+} // namespace ex
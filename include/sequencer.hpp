@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "core/types.hpp"
+#include "thread_safe_queue.hpp"
+
+namespace ex {
+
+// One raw inbound message as the parse workers see it: stamped with its
+// place in the exchange-wide order of arrival and the time it was received
+struct InboundMessage {
+    uint64_t seq = 0;       // global, gapless from first_seq
+    uint64_t recv_ns = 0;   // steady clock
+    std::string payload;
+    ClientId session = 0;   // client of the shm or TCP session it came in on; 0 for ZMQ
+};
+
+// Stands between every receiver (InputStream's ZMQ socket and shm rings,
+// the TCP gateway's io threads) and the raw queue. Numbers each message as
+// it is queued, so the matching thread can put the parse workers' output
+// back into arrival order (see ReorderBuffer).
+//
+// Numbers are handed out with one atomic add per call and never skipped:
+// every stamped message is queued, which holds as long as the raw queue
+// blocks rather than sheds when full. Two receivers can queue their messages
+// in the opposite order to their numbers; the reorder stage absorbs that
+// along with the workers' own reordering.
+class Sequencer {
+public:
+    explicit Sequencer(ThreadSafeQueue<InboundMessage>* raw_queue, uint64_t first_seq = 1)
+        : raw_queue(raw_queue), next_seq(first_seq) {}
+
+    void push(std::string payload, ClientId session = 0) {
+        InboundMessage m{ next_seq.fetch_add(1, std::memory_order_relaxed), nowNs(), std::move(payload), session };
+        raw_queue->push(std::move(m));
+    }
+
+    // Stamps a batch with consecutive numbers and one receive time, then
+    // queues it under one lock
+    void pushAll(std::vector<InboundMessage>& batch) {
+        uint64_t seq = next_seq.fetch_add(batch.size(), std::memory_order_relaxed);
+        const uint64_t now = nowNs();
+        for (InboundMessage& m : batch) {
+            m.seq = seq++;
+            m.recv_ns = now;
+        }
+        raw_queue->pushAll(batch);
+    }
+
+    // pushAll that queues only what fits without blocking and numbers only
+    // that, so no number is left unqueued. Returns how many were queued from
+    // the front of batch.
+    size_t tryPushAll(std::vector<InboundMessage>& batch) {
+        return raw_queue->tryPushAll(batch, [this](InboundMessage* first, size_t n) {
+            uint64_t seq = next_seq.fetch_add(n, std::memory_order_relaxed);
+            const uint64_t now = nowNs();
+            for (size_t i = 0; i < n; ++i) {
+                first[i].seq = seq++;
+                first[i].recv_ns = now;
+            }
+        });
+    }
+
+    // True when a push would block
+    bool full() { return raw_queue->full(); }
+
+    // Continues numbering from first_seq, e.g. a backup taking over where
+    // its primary stopped. Only before any receiver is running.
+    void restart(uint64_t first_seq) { next_seq.store(first_seq, std::memory_order_relaxed); }
+
+    // The number the next message will get
+    uint64_t next() const { return next_seq.load(std::memory_order_relaxed); }
+
+    static uint64_t nowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+private:
+    ThreadSafeQueue<InboundMessage>* raw_queue;
+    std::atomic<uint64_t> next_seq;
+};
+
+} // namespace ex
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <string>
+#include "core/types.hpp"
+#include "shm_gateway.hpp"
+#include "tcp_gateway.hpp"
+
+namespace ex {
+
+// Responses go back over the session the client is connected on: its
+// shared-memory rings or its gateway TCP connection. send() returns false
+// for clients with neither, which the caller answers over the ZMQ egress
+// socket. Safe to call from any responder thread.
+struct SessionRoutes {
+    ShmGateway* shm = nullptr;
+    TcpGateway* tcp = nullptr;
+
+    bool send(ClientId client_id, const std::string& msg) const {
+        if (shm && shm->send(client_id, msg)) return true;
+        if (tcp && tcp->send(client_id, msg)) return true;
+        return false;
+    }
+};
+
+} // namespace ex
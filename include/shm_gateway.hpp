@@ -0,0 +1,106 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include "core/types.hpp"
+#include "net/shm_ring.hpp"
+
+namespace ex {
+
+struct ShmSessionCounters {
+    ClientId client_id;
+    bool alive;         // client heartbeat seen within the timeout
+    uint64_t received;
+    uint64_t rejected;  // messages naming another client_id, or none
+    uint64_t dropped;   // responses lost to a full egress ring, or too large for it
+};
+
+// Exchange end of the shared-memory sessions (see net/shm_ring.hpp and the
+// client library in net/shm_client.hpp). Creates an ingress and an egress
+// ring per configured client at startup.
+//
+// poll() belongs to the ingress thread, which spins over the ingress rings
+// next to its ZMQ socket. send() may be called from any responder thread:
+// the parse workers and the matching thread share each egress ring's
+// producer end under a spin lock, the client end stays lock-free.
+class ShmGateway {
+public:
+    ShmGateway(const std::vector<ClientId>& clients, uint32_t slots_per_ring = 4096,
+               uint64_t heartbeat_timeout_ns = 1000000000);
+
+    ShmGateway(const ShmGateway&) = delete;
+    ShmGateway& operator=(const ShmGateway&) = delete;
+
+    bool empty() const { return sessions.empty(); }
+
+    // Calls fn(client_id, data, len) for up to max_per_session waiting
+    // messages of every session; returns how many it took off the rings. A
+    // message whose header.client_id is not the session's is answered with a
+    // Reject instead. The data pointer is only valid during the call.
+    template <class Fn>
+    size_t poll(Fn&& fn, size_t max_per_session = 64) {
+        size_t delivered = 0;
+        for (auto& s : sessions) {
+            size_t len = 0;
+            size_t n = 0;
+            for (; n < max_per_session; ++n) {
+                const char* data = s->in.peek(len, s->scratch);
+                if (!data) break;
+                if (admits(*s, data, len)) fn(s->client_id, data, len);
+                s->in.release();
+            }
+            if (n > 0) s->received.fetch_add(n, std::memory_order_relaxed);
+            delivered += n;
+        }
+        if (++polls % kHousekeepingPolls == 0) housekeeping();
+        return delivered;
+    }
+
+    // Writes one response to client_id's egress ring, across several slots
+    // if it is long. Returns false if the client has no shm session and the
+    // caller should use ZMQ instead. A full ring drops the message rather than
+    // stall the sender.
+    bool send(ClientId client_id, const std::string& msg);
+
+    // Safe to call from any thread
+    template <class Fn>
+    void forEachSession(Fn&& fn) const {
+        for (const auto& s : sessions) {
+            fn(ShmSessionCounters{ s->client_id, s->alive.load(std::memory_order_relaxed),
+                                   s->received.load(std::memory_order_relaxed),
+                                   s->rejected.load(std::memory_order_relaxed),
+                                   s->dropped.load(std::memory_order_relaxed) });
+        }
+    }
+
+private:
+    static constexpr uint64_t kHousekeepingPolls = 1024;
+
+    struct Session {
+        ClientId client_id = 0;
+        ShmRing in;     // client -> exchange, consumed by the ingress thread
+        ShmRing out;    // exchange -> client
+        std::string scratch;    // reassembles multi-slot ingress messages
+        std::atomic_flag out_lock = ATOMIC_FLAG_INIT;
+        std::atomic<bool> alive{false};
+        std::atomic<uint64_t> received{0};
+        std::atomic<uint64_t> rejected{0};
+        std::atomic<uint64_t> dropped{0};
+    };
+
+    // Checks the message names the session's client_id, and rejects it on
+    // the session's ring if not
+    bool admits(Session& s, const char* data, size_t len);
+    void write(Session& s, const std::string& msg);
+
+    // Stamps the exchange's heartbeats and notices sessions coming and going
+    void housekeeping();
+
+    std::vector<std::unique_ptr<Session>> sessions;
+    uint64_t heartbeat_timeout_ns;
+    uint64_t polls = 0;
+};
+
+} // namespace ex
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <sys/types.h>
+#include "matching_engine.hpp"
+
+namespace ex {
+
+// =============================================================================
+// Point-in-time book snapshot, written to and read from a memory-mapped file.
+//
+// There is no journal: a crash loses what happened since the last snapshot
+// that reached the disk, acked orders included (see SnapshotWriter). The
+// header says which input the image covers (last_seq), and each book keeps
+// its call-auction state, so a book restored mid-auction stays in the call.
+//
+// Layout (all offsets are from the start of the file, so the image can be
+// mapped at any address):
+//
+//   SnapshotHeader
+//   SnapshotBook[book_count]
+//   SnapshotOrder[order_count]      grouped per book: bids, asks, buy stops, sell
+//                                   stops, each in ascending (stop) price and
+//                                   FIFO order
+//   char symbols[]                  symbol bytes referenced by SnapshotBook
+// =============================================================================
+
+constexpr char     kSnapshotMagic[8] = {'E','X','S','N','A','P','0','1'};
+constexpr uint32_t kSnapshotVersion  = 5;
+
+struct SnapshotHeader {
+    char     magic[8];
+    uint32_t version;
+    uint32_t book_count;
+    uint64_t order_count;
+    uint64_t last_order_id;     // IdGenerator counter at snapshot time
+    uint64_t last_seq;          // sequencer number of the last message applied
+    uint64_t books_offset;
+    uint64_t orders_offset;
+    uint64_t symbols_offset;
+    uint64_t file_size;
+};
+
+struct SnapshotBook {
+    uint64_t symbol_offset;
+    uint32_t symbol_len;
+    uint32_t flags;             // kSnapshotBookAuction
+    uint64_t first_order;       // index into the order array
+    uint64_t order_count;
+    Price    last_trade;        // stops and the price collar key off it
+};
+
+constexpr uint32_t kSnapshotBookAuction = 1;  // book was in a call auction
+
+struct SnapshotOrder {
+    OrderId  order_id;
+    uint64_t client_order_id;
+    uint64_t timestamp;
+    Price    price;
+    Qty      qty;
+    Qty      reserve;
+    Qty      display;
+    ClientId client_id;
+    Price    stop_price;
+    uint8_t  side;
+    uint8_t  ord_type;
+    uint8_t  stp;
+    uint8_t  tif;
+    uint32_t expire_date;
+    uint32_t reserved;
+};
+
+// Writes every resting order plus the id counter and the sequencer position
+// to path. The image is built in
+// path + ".tmp" and renamed over path, so a crash never leaves a torn snapshot.
+bool writeSnapshot(const std::string& path, const MatchingEngine& engine, uint64_t last_order_id,
+                   uint64_t last_seq);
+
+struct SnapshotWriterCounters {
+    uint64_t written;
+    uint64_t failed;
+    uint64_t skipped;   // due while the previous one was still being written
+};
+
+// Writes snapshots off the matching thread. start() forks: the child sees
+// the books exactly as they are at that instant (copy-on-write), writes
+// them with writeSnapshot and exits, while the matching thread carries on
+// after only the fork itself. One child at a time; a snapshot that falls
+// due while the last one is still writing is skipped. The child only
+// touches the engine's memory, the file and stderr, never a socket.
+class SnapshotWriter {
+public:
+    explicit SnapshotWriter(std::string path) : path(std::move(path)) {}
+    // Waits for a snapshot in progress to finish
+    ~SnapshotWriter();
+
+    SnapshotWriter(const SnapshotWriter&) = delete;
+    SnapshotWriter& operator=(const SnapshotWriter&) = delete;
+
+    // False if no snapshot was started (one still writing, or fork failed)
+    bool start(const MatchingEngine& engine, uint64_t last_order_id, uint64_t last_seq);
+
+    // Collects a finished child's result first
+    SnapshotWriterCounters counters();
+
+private:
+    // Blocking waits for the child; otherwise only collects it if done
+    void reap(bool wait);
+
+    const std::string path;
+    pid_t child = -1;
+    uint64_t written = 0;
+    uint64_t failed = 0;
+    uint64_t skipped = 0;
+};
+
+// Rebuilds an empty engine from the snapshot at path. Returns false, without
+// touching the engine, if the file is missing or fails validation (offsets,
+// sizes and every order's enum fields).
+bool loadSnapshot(const std::string& path, MatchingEngine& engine, uint64_t& last_order_id, uint64_t& last_seq);
+
+} // namespace ex
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Bounded lock-free queue for exactly one producer thread and one consumer
+// thread. Capacity is rounded up to a power of two. Each side keeps a cached
+// copy of the other's index and only re-reads the shared one when the queue
+// looks full (producer) or empty (consumer), so in steady state a push or pop
+// touches no cache line the other thread is writing.
+template <typename T>
+class SpscQueue {
+    private:
+        std::vector<T> slots;
+        size_t mask;
+
+        alignas(64) std::atomic<size_t> head{0};    // next slot to write, owned by the producer
+        size_t cached_tail = 0;
+        alignas(64) std::atomic<size_t> tail{0};    // next slot to read, owned by the consumer
+        size_t cached_head = 0;
+
+        static size_t roundUp(size_t n) {
+            size_t c = 1;
+            while (c < n) c <<= 1;
+            return c;
+        }
+
+    public:
+        explicit SpscQueue(size_t capacity)
+            : slots(roundUp(capacity < 2 ? 2 : capacity)), mask(slots.size() - 1) {}
+
+        SpscQueue(const SpscQueue&) = delete;
+        SpscQueue& operator=(const SpscQueue&) = delete;
+
+        // Producer only. Returns false, leaving item untouched, when full.
+        bool tryPush(T& item) {
+            const size_t h = head.load(std::memory_order_relaxed);
+            if (h - cached_tail > mask) {
+                cached_tail = tail.load(std::memory_order_acquire);
+                if (h - cached_tail > mask) return false;
+            }
+            slots[h & mask] = std::move(item);
+            head.store(h + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Consumer only. Returns false when empty.
+        bool tryPop(T& out) {
+            const size_t t = tail.load(std::memory_order_relaxed);
+            if (t == cached_head) {
+                cached_head = head.load(std::memory_order_acquire);
+                if (t == cached_head) return false;
+            }
+            out = std::move(slots[t & mask]);
+            tail.store(t + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Consumer only. The oldest item, left in place, or nullptr when empty.
+        T* front() {
+            const size_t t = tail.load(std::memory_order_relaxed);
+            if (t == cached_head) {
+                cached_head = head.load(std::memory_order_acquire);
+                if (t == cached_head) return nullptr;
+            }
+            return &slots[t & mask];
+        }
+
+        // Consumer only, after front() returned an item
+        void popFront() {
+            tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        // Approximate from any thread other than the two ends
+        size_t size() const {
+            return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+        }
+
+        size_t capacity() const { return slots.size(); }
+};
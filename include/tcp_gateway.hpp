@@ -0,0 +1,119 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "core/types.hpp"
+#include "sequencer.hpp"
+
+namespace ex {
+
+struct TcpGatewayConfig {
+    uint16_t port = 5557;
+    uint32_t io_threads = 2;
+    uint32_t max_sessions_per_thread = 8192;
+    uint32_t max_frame = 64 * 1024;          // larger frames close the session
+    size_t max_pending_out = 4 * 1024 * 1024; // unsent response bytes before a slow reader is dropped
+};
+
+struct TcpGatewayCounters {
+    uint64_t sessions;      // currently connected
+    uint64_t accepted;
+    uint64_t frames_in;
+    uint64_t seq_rejects;
+    uint64_t dropped_sessions; // framing errors, duplicate logons, slow readers
+};
+
+// Native TCP order gateway. Each frame is a 4-byte big-endian length followed
+// by one JSON envelope, in both directions:
+//
+//   [len:u32 BE][{"header":{...,"seq":N,"client_id":C},"body":{...}}]
+//
+// The first frame binds the connection to its header.client_id; one client
+// has at most one connection. Inbound seq must run 1, 2, 3... per client, and
+// survives reconnects: anything else is answered with a SequenceGap reject
+// and not processed. Accepted frames are sequenced onto the raw queue for
+// the parse workers like ZMQ messages; responses come back through send().
+//
+// An acceptor thread hands connections to io_threads epoll loops
+// (edge-triggered), each holding up to max_sessions_per_thread.
+class TcpGateway {
+public:
+    TcpGateway(Sequencer* sequencer, const TcpGatewayConfig& config = TcpGatewayConfig());
+    ~TcpGateway();
+
+    TcpGateway(const TcpGateway&) = delete;
+    TcpGateway& operator=(const TcpGateway&) = delete;
+
+    // Binds and starts the acceptor and io threads. Returns false if the
+    // port cannot be bound.
+    bool start();
+    void stop();
+
+    // Frames msg to client_id's connection. Returns false if the client has
+    // no connection here. Writes directly when the socket has room and
+    // queues the rest for the owning io thread; safe from any thread.
+    bool send(ClientId client_id, const std::string& msg);
+
+    TcpGatewayCounters counters() const;
+
+private:
+    struct Session : std::enable_shared_from_this<Session> {
+        int fd = -1;
+        // io thread only
+        ClientId client_id = 0;
+        bool bound = false;
+        SeqNum next_seq = 1;
+        std::string in;             // partial frames
+
+        std::mutex out_mtx;         // guards out and closed, taken by senders
+        std::string out;            // framed bytes waiting for EPOLLOUT
+        bool closed = false;
+    };
+
+    struct IoThread {
+        int epfd = -1;
+        std::thread thread;
+        std::mutex sessions_mtx;    // acceptor inserts, io thread erases
+        std::unordered_map<int, std::shared_ptr<Session>> sessions;
+    };
+
+    void acceptLoop();
+    void ioLoop(IoThread& io);
+    // Returns false if the session was closed (and may be gone)
+    bool onReadable(IoThread& io, Session& s);
+    // Validates one inbound frame; false closes the session
+    bool onFrame(Session& s, const char* data, size_t len);
+    void flush(Session& s);
+    void close(IoThread& io, Session& s);
+    void reject(Session& s, RejectCode code, SeqNum seq, const char* data, size_t len);
+    // Appends a framed message and writes what the socket takes; caller
+    // holds out_mtx
+    void write(Session& s, const char* data, size_t len);
+
+    Sequencer* sequencer;
+    TcpGatewayConfig config;
+    int listen_fd = -1;
+    std::atomic<bool> running{false};
+    std::thread acceptor;
+    std::vector<std::unique_ptr<IoThread>> io_threads;
+
+    // client_id -> connected session; the next seq of disconnected clients
+    // is kept for their reconnect
+    mutable std::shared_mutex routes_mtx;
+    std::unordered_map<ClientId, std::shared_ptr<Session>> routes;
+    std::unordered_map<ClientId, SeqNum> resume_seq;
+
+    std::atomic<uint64_t> active{0};
+    std::atomic<uint64_t> accepted{0};
+    std::atomic<uint64_t> frames_in{0};
+    std::atomic<uint64_t> seq_rejects{0};
+    std::atomic<uint64_t> dropped_sessions{0};
+};
+
+} // namespace ex
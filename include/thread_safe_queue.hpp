@@ -1,9 +1,20 @@
 #pragma once
 
+#include <algorithm>
+#include <chrono>
 #include <condition_variable>
+#include <cstdint>
 #include <iostream>
 #include <mutex>
 #include <queue>
+#include <vector>
+
+// What push() does when a bounded queue is full
+enum class OverflowPolicy {
+    Block,      // wait for space, pushing back on the producer
+    Reject,     // refuse the item; push() returns false so the caller can shed it
+    DropOldest  // evict the head to make room for the new item
+};
 
 template <typename T>
 class ThreadSafeQueue {
@@ -11,31 +22,169 @@ class ThreadSafeQueue {
         std::queue<T> queue;
         std::mutex mtx;
         std::condition_variable c_var;
+        std::condition_variable not_full;
+
+        size_t capacity;        // 0 = unbounded
+        OverflowPolicy policy;
+        size_t high_water = 0;
+        uint64_t overflows = 0; // items rejected or dropped
 
 
     public:
-        void push(T item){
+        explicit ThreadSafeQueue(size_t capacity = 0, OverflowPolicy policy = OverflowPolicy::Block)
+            : capacity(capacity), policy(policy) {}
+
+        // Returns false only when the item was refused under OverflowPolicy::Reject.
+        bool push(T item){
+            std::unique_lock<std::mutex> lock(mtx);
+
+            if (capacity != 0 && queue.size() >= capacity) {
+                switch (policy) {
+                    case OverflowPolicy::Block:
+                        not_full.wait(lock, [this]{ return queue.size() < capacity; });
+                        break;
+                    case OverflowPolicy::Reject:
+                        overflows++;
+                        return false;
+                    case OverflowPolicy::DropOldest:
+                        queue.pop();
+                        overflows++;
+                        break;
+                }
+            }
+
+            queue.push(std::move(item));
+            if (queue.size() > high_water) high_water = queue.size();
+
+            c_var.notify_one();
+            return true;
+        }
+
+        // Queues item if there is room, moving from it. Otherwise leaves it
+        // as it was, counts an overflow and returns false, whatever the policy.
+        bool tryPush(T& item){
             std::unique_lock<std::mutex> lock(mtx);
+            if (capacity != 0 && queue.size() >= capacity) {
+                overflows++;
+                return false;
+            }
+            queue.push(std::move(item));
+            if (queue.size() > high_water) high_water = queue.size();
+            c_var.notify_one();
+            return true;
+        }
+
+        // Queues a batch under one lock with one wakeup, by the same overflow
+        // rules as push(). Returns how many items were queued; items are
+        // moved from.
+        size_t pushAll(std::vector<T>& items){
+            std::unique_lock<std::mutex> lock(mtx);
+            size_t pushed = 0;
+
+            for (T& item : items) {
+                if (capacity != 0 && queue.size() >= capacity) {
+                    switch (policy) {
+                        case OverflowPolicy::Block:
+                            // Wake consumers for what is already queued before waiting on them
+                            c_var.notify_all();
+                            not_full.wait(lock, [this]{ return queue.size() < capacity; });
+                            break;
+                        case OverflowPolicy::Reject:
+                            overflows++;
+                            continue;
+                        case OverflowPolicy::DropOldest:
+                            queue.pop();
+                            overflows++;
+                            break;
+                    }
+                }
+                queue.push(std::move(item));
+                pushed++;
+                if (queue.size() > high_water) high_water = queue.size();
+            }
+
+            if (pushed == 1) c_var.notify_one();
+            else if (pushed > 1) c_var.notify_all();
+            return pushed;
+        }
+
+        // Queues as many items as fit, from the front, without waiting or
+        // dropping whatever the policy. stamp(first, count) runs under the
+        // lock on exactly the items about to be queued. Returns the count;
+        // those items are moved from.
+        template <typename Stamp>
+        size_t tryPushAll(std::vector<T>& items, Stamp&& stamp){
+            std::unique_lock<std::mutex> lock(mtx);
+            size_t n = items.size();
+            if (capacity != 0) n = queue.size() >= capacity ? 0 : std::min(n, capacity - queue.size());
+            if (n == 0) return 0;
+
+            stamp(items.data(), n);
+            for (size_t i = 0; i < n; ++i) queue.push(std::move(items[i]));
+            if (queue.size() > high_water) high_water = queue.size();
 
-            queue.push(item);
+            if (n == 1) c_var.notify_one();
+            else c_var.notify_all();
+            return n;
+        }
 
+        // Queues past capacity whatever the policy: for small markers that
+        // must not be lost. Callers bound how many they send.
+        void forcePush(T item){
+            std::unique_lock<std::mutex> lock(mtx);
+            queue.push(std::move(item));
+            if (queue.size() > high_water) high_water = queue.size();
             c_var.notify_one();
         }
 
         T pop(){
             std::unique_lock<std::mutex> lock(mtx);
-            
+
             c_var.wait(lock, [this]{ return !queue.empty(); });
 
-            T item = queue.front();
+            T item = std::move(queue.front());
             queue.pop();
 
+            if (capacity != 0) not_full.notify_one();
+
             return item;
         }
 
+        // pop() that gives up after timeout; false if nothing arrived
+        template <class Rep, class Period>
+        bool popFor(T& out, std::chrono::duration<Rep, Period> timeout){
+            std::unique_lock<std::mutex> lock(mtx);
+
+            if (!c_var.wait_for(lock, timeout, [this]{ return !queue.empty(); })) return false;
+
+            out = std::move(queue.front());
+            queue.pop();
+
+            if (capacity != 0) not_full.notify_one();
+
+            return true;
+        }
+
         size_t size() {
             std::unique_lock<std::mutex> lock(mtx);
             return queue.size();
         }
 
+        // True when a push would block or be refused
+        bool full() {
+            std::unique_lock<std::mutex> lock(mtx);
+            return capacity != 0 && queue.size() >= capacity;
+        }
+
+        // Deepest the queue has been since construction
+        size_t highWater() {
+            std::unique_lock<std::mutex> lock(mtx);
+            return high_water;
+        }
+
+        uint64_t overflowCount() {
+            std::unique_lock<std::mutex> lock(mtx);
+            return overflows;
+        }
+
 };
@@ -0,0 +1,151 @@
+#include "egress_stage.hpp"
+#include <chrono>
+#include <iostream>
+
+namespace ex {
+
+void EgressStage::Producer::send(ClientId client_id, std::string msg) {
+    OutboundMessage m{ client_id, std::move(msg), hold_until };
+    if (queue.tryPush(m)) return;
+
+    waits.fetch_add(1, std::memory_order_relaxed);
+    for (uint32_t spins = 0; !queue.tryPush(m); ++spins) {
+        if (spins >= kSpinPasses) std::this_thread::yield();
+    }
+}
+
+EgressStage::EgressStage(zmq::context_t& context, const std::string& endpoint, const SessionRoutes* routes,
+                         size_t queue_capacity, size_t max_batch)
+    : socket(context, zmq::socket_type::push),
+      routes(routes),
+      queue_capacity(queue_capacity),
+      max_batch(max_batch)
+{
+    try {
+        socket.connect(endpoint);
+        std::cout << "Egress socket connected. Out:" << endpoint << std::endl;
+    } catch (const zmq::error_t& e) {
+        std::cerr << "[EGRESS] Connect error: " << e.what() << std::endl;
+    }
+    pending.reserve(max_batch);
+}
+
+EgressStage::~EgressStage() {
+    stop();
+}
+
+EgressStage::Producer* EgressStage::addProducer() {
+    producers.push_back(std::unique_ptr<Producer>(new Producer(queue_capacity)));
+    return producers.back().get();
+}
+
+void EgressStage::start() {
+    running = true;
+    thread = std::thread(&EgressStage::run, this);
+}
+
+void EgressStage::stop() {
+    if (!running.exchange(false)) return;
+    thread.join();
+    while (drain() > 0) {}
+    flush();
+}
+
+void EgressStage::run() {
+    uint32_t idle = 0;
+    while (running.load(std::memory_order_relaxed)) {
+        if (drain() > 0) {
+            idle = 0;
+            continue;
+        }
+        // Caught up: whatever is batched goes out now
+        flush();
+        if (++idle < kSpinPasses) continue;
+        if (idle < kYieldPasses) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+}
+
+size_t EgressStage::drain() {
+    size_t taken = 0;
+    const bool drop = standby.load(std::memory_order_acquire);
+    const uint64_t replicated = watermark ? watermark->load(std::memory_order_acquire) : 0;
+
+    if (drop && primary_released) {
+        // Whatever the primary has released, its clients already have
+        const uint64_t done = primary_released->load(std::memory_order_acquire);
+        while (!retained.empty() && retained.front().hold_until <= done) {
+            retained.pop_front();
+            discarded.fetch_add(1, std::memory_order_relaxed);
+        }
+    } else if (!drop && !retained.empty()) {
+        // Promoted: what the primary never sent goes out before anything new
+        for (OutboundMessage& m : retained) {
+            if (routes && routes->send(m.client_id, m.payload)) {
+                routed.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                pending.push_back(std::move(m.payload));
+                if (pending.size() >= max_batch) flush();
+            }
+        }
+        replayed.fetch_add(retained.size(), std::memory_order_relaxed);
+        taken += retained.size();
+        retained.clear();
+    }
+
+    for (auto& p : producers) {
+        for (size_t n = 0; n < kDrainPerQueue; ++n) {
+            OutboundMessage* m = p->queue.front();
+            // Held back until the backup has the message it answers
+            if (!m || (watermark && !drop && m->hold_until > replicated)) break;
+            ++taken;
+            if (drop && primary_released && m->hold_until > primary_released->load(std::memory_order_acquire)) {
+                retained.push_back(std::move(*m));
+            } else if (drop) {
+                discarded.fetch_add(1, std::memory_order_relaxed);
+            } else if (routes && routes->send(m->client_id, m->payload)) {
+                routed.fetch_add(1, std::memory_order_relaxed);
+                markReleased(m->hold_until);
+            } else {
+                pending.push_back(std::move(m->payload));
+                if (m->hold_until > pending_seq) pending_seq = m->hold_until;
+            }
+            p->queue.popFront();
+            if (pending.size() >= max_batch) flush();
+        }
+    }
+    return taken;
+}
+
+void EgressStage::flush() {
+    if (pending.empty()) return;
+    for (size_t i = 0; i < pending.size(); ++i) {
+        socket.send(zmq::buffer(pending[i]),
+                    i + 1 < pending.size() ? zmq::send_flags::sndmore : zmq::send_flags::none);
+    }
+    sent.fetch_add(pending.size(), std::memory_order_relaxed);
+    batches.fetch_add(1, std::memory_order_relaxed);
+    pending.clear();
+    markReleased(pending_seq);
+}
+
+void EgressStage::markReleased(uint64_t seq) {
+    // Only this thread stores it
+    if (seq > released_seq.load(std::memory_order_relaxed)) released_seq.store(seq, std::memory_order_release);
+}
+
+EgressCounters EgressStage::counters() const {
+    uint64_t waits = 0;
+    for (const auto& p : producers) waits += p->waits.load(std::memory_order_relaxed);
+    return EgressCounters{ sent.load(std::memory_order_relaxed),
+                           routed.load(std::memory_order_relaxed),
+                           batches.load(std::memory_order_relaxed),
+                           waits,
+                           discarded.load(std::memory_order_relaxed),
+                           replayed.load(std::memory_order_relaxed) };
+}
+
+} // namespace ex
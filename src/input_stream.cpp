@@ -1,22 +1,39 @@
 #include "input_stream.hpp"
+#include <chrono>
+#include <cstring>
 #include <iostream>
+#include <thread>
 #include "core/message.hpp"
+#include "net/transport.hpp"
 
 namespace ex {
 
-// Constructor: Initializes ZMQ context and binds sockets
-InputStream::InputStream(ThreadSafeQueue<std::string>* raw_queue, const std::string& in_port)
-    : context(1), 
-      in_socket(context, zmq::socket_type::pull), 
-      raw_queue(raw_queue),
+// Constructor: binds the inbound socket on the shared context
+InputStream::InputStream(Sequencer* sequencer, zmq::context_t& context,
+                         const std::string& endpoint, const ThrottleConfig& throttle_config,
+                         IngressMode mode)
+    : in_socket(context, mode == IngressMode::Router ? zmq::socket_type::router : zmq::socket_type::pull),
+      mode(mode),
+      sequencer(sequencer),
+      client_throttle(throttle_config),
       running(false)
 {
     try {
         // High-water mark limits internal buffering to prevent memory overflow
         in_socket.set(zmq::sockopt::rcvhwm, 10000);
-        in_socket.bind("tcp://*:" + in_port);
-                
-        std::cout << "InputStream initialized. In:" << in_port << std::endl;
+        in_socket.bind(endpoint);
+
+        if (mode == IngressMode::Router) {
+            // A client reconnecting under its routing id takes it over from
+            // the dead connection instead of being refused
+            in_socket.set(zmq::sockopt::router_handover, true);
+            responses = zmq::socket_t(context, zmq::socket_type::pull);
+            responses.set(zmq::sockopt::rcvhwm, 10000);
+            responses.bind(kRouterResponses);
+        }
+
+        std::cout << "InputStream initialized. In:" << endpoint
+                  << (mode == IngressMode::Router ? " (router)" : "") << std::endl;
     } catch (const zmq::error_t& e) {
         std::cerr << "ZMQ Bind Error: " << e.what() << std::endl;
     }
@@ -30,20 +47,197 @@ InputStream::~InputStream() {
 void InputStream::stop() {
     running = false;
     in_socket.close();
+    responses.close();
+}
+
+void InputStream::admit(ClientId client_id, const char* data, size_t len, ClientId session) {
+    if (client_throttle.enabled()) {
+        const uint64_t now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+        if (!client_throttle.allow(client_id, now_ns)) return;
+    }
+    batch.push_back(InboundMessage{ 0, 0, std::string(data, len), session });
+}
+
+void InputStream::flushBatch() {
+    if (mode == IngressMode::Router) {
+        // Never blocks: the parse workers may be waiting on this thread to
+        // forward their responses before they can drain the raw queue. What
+        // does not fit stays for the next pass, and intake waits for it.
+        batch.erase(batch.begin(), batch.begin() + sequencer->tryPushAll(batch));
+        return;
+    }
+    if (batch.size() == 1) {
+        sequencer->push(std::move(batch.front().payload), batch.front().session);
+    } else if (!batch.empty()) {
+        sequencer->pushAll(batch);
+    }
+    batch.clear();
+}
+
+bool InputStream::receiveZmq(zmq::recv_flags flags) {
+    zmq::message_t identity;
+    zmq::message_t part;
+    const bool router = mode == IngressMode::Router;
+    if (!in_socket.recv(router ? identity : part, flags)) return false;
+    if (router) (void)in_socket.recv(part, zmq::recv_flags::none);
+
+    for (size_t parts = 0;;) {
+        // A REQ client puts an empty delimiter after the identity
+        if (part.size() > 0 && ++parts > kMaxBatch) {
+            // Read off the socket and dropped
+            truncated_count.fetch_add(1, std::memory_order_relaxed);
+        } else if (part.size() > 0) {
+            const char* data = static_cast<const char*>(part.data());
+            // Messages without a readable client_id share client 0's bucket
+            ClientId client_id = 0;
+            if (router) {
+                if (claim(identity, data, part.size(), client_id)) admit(client_id, data, part.size());
+            } else {
+                if (client_throttle.enabled()) scan_client_id(data, part.size(), client_id);
+                admit(client_id, data, part.size());
+            }
+        }
+        if (!part.more()) break;
+        (void)in_socket.recv(part, zmq::recv_flags::none);
+    }
+    flushBatch();
+
+    // Refused parts are answered once the whole message has been read
+    if (!refusals.empty()) {
+        in_socket.send(zmq::buffer(identity.data(), identity.size()),
+                       zmq::send_flags::sndmore | zmq::send_flags::dontwait);
+        for (size_t i = 0; i < refusals.size(); ++i) {
+            in_socket.send(zmq::buffer(refusals[i]), i + 1 < refusals.size()
+                                                         ? zmq::send_flags::sndmore | zmq::send_flags::dontwait
+                                                         : zmq::send_flags::dontwait);
+        }
+        refusals.clear();
+    }
+    return true;
+}
+
+bool InputStream::claim(const zmq::message_t& identity, const char* data, size_t len, ClientId& client_id) {
+    RejectCode code = RejectCode::ParseError;
+    if (scan_client_id(data, len, client_id) && client_id != 0) {
+        auto it = identities.find(client_id);
+        if (it == identities.end()) {
+            it = identities.emplace(client_id, std::string(static_cast<const char*>(identity.data()),
+                                                           identity.size())).first;
+            peers.insert(it->second);
+        }
+        if (it->second.size() == identity.size() &&
+            std::memcmp(it->second.data(), identity.data(), identity.size()) == 0) {
+            return true;
+        }
+        code = RejectCode::NotAuthorized;
+    }
+    SeqNum seq = 0;
+    scan_seq(data, len, seq);
+    refusals.push_back(dump_frame_reject(code, client_id, seq, data, len));
+    refused_count.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+bool InputStream::forwardResponses() {
+    bool any = false;
+    zmq::message_t msg;
+    for (int i = 0; i < 256 && responses.recv(msg, zmq::recv_flags::dontwait); ++i) {
+        any = true;
+        // The matching thread sends coalesced responses as one multipart message
+        response_parts.clear();
+        response_clients.clear();
+        bool more = true;
+        while (more) {
+            more = msg.more();
+            ClientId client_id = 0;
+            scan_client_id(static_cast<const char*>(msg.data()), msg.size(), client_id);
+            response_clients.push_back(client_id);
+            response_parts.push_back(std::move(msg));
+            if (more) (void)responses.recv(msg, zmq::recv_flags::none);
+        }
+
+        // Each run of parts for one client goes out as one multipart message.
+        // ROUTER drops messages for peers that are gone or over their HWM.
+        for (size_t j = 0; j < response_parts.size();) {
+            size_t k = j + 1;
+            while (k < response_parts.size() && response_clients[k] == response_clients[j]) ++k;
+
+            // Unaddressed responses (AuctionInfo) go to every client, copied
+            if (response_clients[j] == 0) {
+                if (peers.empty()) unroutable_count.fetch_add(k - j, std::memory_order_relaxed);
+                for (const std::string& peer : peers) {
+                    in_socket.send(zmq::buffer(peer), zmq::send_flags::sndmore | zmq::send_flags::dontwait);
+                    for (size_t p = j; p < k; ++p) {
+                        in_socket.send(zmq::buffer(response_parts[p].data(), response_parts[p].size()),
+                                       p + 1 < k ? zmq::send_flags::sndmore | zmq::send_flags::dontwait
+                                                 : zmq::send_flags::dontwait);
+                    }
+                }
+                j = k;
+                continue;
+            }
+
+            auto it = identities.find(response_clients[j]);
+            if (it == identities.end()) {
+                unroutable_count.fetch_add(k - j, std::memory_order_relaxed);
+            } else {
+                in_socket.send(zmq::buffer(it->second), zmq::send_flags::sndmore | zmq::send_flags::dontwait);
+                for (size_t p = j; p < k; ++p) {
+                    in_socket.send(response_parts[p], p + 1 < k ? zmq::send_flags::sndmore | zmq::send_flags::dontwait
+                                                                : zmq::send_flags::dontwait);
+                }
+            }
+            j = k;
+        }
+    }
+    return any;
 }
 
 void InputStream::startListening() {
     running = true;
     std::cout << "InputStream: Start listening for orders..." << std::endl;
 
+    const bool router = mode == IngressMode::Router;
+    const bool spin = shm && !shm->empty();
+    uint32_t idle_spins = 0;
     while(running){
         try {
-            zmq::message_t request;
+            if (!router && !spin) {
+                receiveZmq(zmq::recv_flags::none);
+                continue;
+            }
 
-            auto result = in_socket.recv(request, zmq::recv_flags::none);
+            // In router mode responses go out from here too. A full raw queue
+            // stops intake but never egress: the parse workers may be waiting
+            // on their response sockets before they can drain it. Intake also
+            // waits for the rest of a batch that did not fit.
+            bool busy = router && forwardResponses();
+            if (router && !batch.empty()) flushBatch();
+            const bool intake = !router || (batch.empty() && !sequencer->full());
+            if (intake) busy |= receiveZmq(zmq::recv_flags::dontwait);
+            if (spin && intake) {
+                busy |= shm->poll([this](ClientId client_id, const char* data, size_t len) {
+                    admit(client_id, data, len, client_id);
+                }) > 0;
+                flushBatch();
+            }
+            if (busy) {
+                idle_spins = 0;
+                continue;
+            }
 
-            if (result) {
-                raw_queue->push(std::string(static_cast<char*>(request.data()), request.size()));
+            if (!spin) {
+                // Nothing to spin for: sleep until either socket has work
+                zmq::pollitem_t items[] = {
+                    { in_socket.handle(), 0, static_cast<short>(intake ? ZMQ_POLLIN : 0), 0 },
+                    { responses.handle(), 0, ZMQ_POLLIN, 0 },
+                };
+                zmq::poll(items, 2, std::chrono::milliseconds(intake ? 100 : 1));
+            } else if (++idle_spins > 10000) {
+                // Shared-memory clients are only as fast as this loop, so it
+                // spins over every source and yields after a stretch of idling
+                std::this_thread::yield();
             }
         }
         catch (const zmq::error_t& e) {
@@ -66,4 +260,4 @@ void InputStream::startListening() {
     }
 }
 
-} // namespace ex
\ No newline at end of file
+} // namespace ex
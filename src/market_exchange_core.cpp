@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
 #include <iostream>
 #include <thread>
 #include <iomanip> // For pretty printing
@@ -6,6 +9,16 @@
 #include "thread_safe_queue.hpp"
 #include "id_generator.hpp"
 #include "order_generator.hpp"
+#include "matching_engine.hpp"
+#include "snapshot.hpp"
+#include "risk_checker.hpp"
+#include "net/transport.hpp"
+#include "session_routes.hpp"
+#include "egress_stage.hpp"
+#include "sequencer.hpp"
+#include "reorder_buffer.hpp"
+#include "replication.hpp"
+#include "partition_router.hpp"
 
 using namespace ex;
 
@@ -22,44 +35,573 @@ void printOrder(const Order& o) {
               << std::endl;
 }
 
-int main() {
+/**
+ * @brief Builds the Ack or Reject for an order that has been through risk checks
+ */
+EnvelopeOut makeResponse(const Order& o, RejectCode code) {
+    EnvelopeOut e;
+    e.header.seq = o.seq;
+    e.header.client_id = o.client_id;
+
+    if (code == RejectCode::None) {
+        e.header.type = MsgType::Ack;
+        e.body = Ack{ o.client_order_id, o.internal_order_id, o.symbol };
+    } else {
+        e.header.type = MsgType::Reject;
+        e.body = Reject{ o.client_order_id, o.symbol, RejectInfo{ reject_reason(code), to_u(code) } };
+    }
+    return e;
+}
+
+EnvelopeOut makeMassCancelAck(const Order& o, size_t cancelled) {
+    EnvelopeOut e;
+    e.header.type = MsgType::MassCancelAck;
+    e.header.seq = o.seq;
+    e.header.client_id = o.client_id;
+    e.body = MassCancelAck{ o.client_order_id, cancelled };
+    return e;
+}
+
+// Session-end expiries are published this many at a time
+constexpr size_t kExpiryBatch = 4096;
+
+/**
+ * @brief Feeds fills and cancels back into risk, sends every event and clears the batch
+ */
+void publish(std::vector<EnvelopeOut>& events, RiskChecker& risk, EgressStage::Producer& egress) {
+    for (const auto& e : events) {
+        if (const Fill* f = std::get_if<Fill>(&e.body)) {
+            risk.onFill(e.header.client_id, f->side, f->fill_qty, f->complete);
+        } else if (const Cancelled* c = std::get_if<Cancelled>(&e.body)) {
+            risk.onCancel(e.header.client_id, c->side, c->cancelled_qty, c->leaves_qty == 0);
+        }
+        egress.send(e.header.client_id, dump_envelope(e));
+    }
+    events.clear();
+}
+
+/**
+ * @brief Runs one message from the order queue through risk and the engine
+ */
+void handle(const Order& o, MatchingEngine& engine, RiskChecker& risk, std::vector<EnvelopeOut>& events,
+            EgressStage::Producer& egress) {
+    switch (o.type) {
+        case MsgType::NewOrder: {
+            // Looked up without creating a book, so rejected orders leave none behind
+            const OrderBook* b = engine.findBook(o.symbol);
+            const RejectCode code = risk.check(o, b ? b->lastTradePrice() : 0);
+            events.push_back(makeResponse(o, code));
+            if (code == RejectCode::None) {
+                engine.process(o, events);
+            }
+            break;
+        }
+
+        case MsgType::Cancel:
+            engine.process(o, events);
+            break;
+
+        case MsgType::Replace: {
+            // Unknown or foreign orders fall through to the engine's reject
+            const RestingOrder* r = engine.find(o.internal_order_id);
+            if (r && r->client_id == o.client_id && o.quantity > 0) {
+                // A pending stop-market order is sized at its stop price
+                Order amend = o;
+                if (r->ord_type == OrdType::Stop) amend.price = static_cast<double>(r->stop_price);
+                const Price last = engine.bookOf(*r).lastTradePrice();
+                const RejectCode code = risk.checkReplace(amend, r->side, r->qty + r->reserve, last);
+                if (code != RejectCode::None) {
+                    events.push_back(makeResponse(o, code));
+                    break;
+                }
+            }
+            engine.process(o, events);
+            break;
+        }
+
+        case MsgType::MassCancel: {
+            // Non-admins only ever reach their own orders. An admin that names
+            // a target reaches only that client's orders, in every scope.
+            const bool admin = risk.isAdmin(o.client_id);
+            const ClientId target = o.target_client_id ? o.target_client_id : o.client_id;
+            if (!admin && target != o.client_id) {
+                events.push_back(makeResponse(o, RejectCode::NotAuthorized));
+                break;
+            }
+            const bool whole_books = admin && o.target_client_id == 0;
+
+            size_t cancelled = 0;
+            OrderBook* book = o.symbol.empty() ? nullptr : engine.findBook(o.symbol);
+            switch (o.cancel_scope) {
+                case MassCancelScope::Client:
+                    cancelled = engine.cancelClient(target, nullptr, events);
+                    break;
+                case MassCancelScope::Symbol:
+                    if (book) {
+                        cancelled = whole_books ? engine.cancelBook(*book, events)
+                                                : engine.cancelClient(target, book, events);
+                    }
+                    break;
+                case MassCancelScope::All:
+                    cancelled = whole_books ? engine.cancelAll(events)
+                                            : engine.cancelClient(target, nullptr, events);
+                    break;
+            }
+            events.push_back(makeMassCancelAck(o, cancelled));
+            break;
+        }
+
+        case MsgType::KillSwitch: {
+            if (!risk.isAdmin(o.client_id)) {
+                events.push_back(makeResponse(o, RejectCode::NotAuthorized));
+                break;
+            }
+            risk.setBlocked(o.target_client_id, o.kill_enabled);
+            std::cout << "[CORE] Kill switch " << (o.kill_enabled ? "ON" : "OFF")
+                      << " for client " << o.target_client_id << std::endl;
+
+            size_t cancelled = 0;
+            if (o.kill_enabled && o.cancel_open) {
+                cancelled = engine.cancelClient(o.target_client_id, nullptr, events);
+            }
+            events.push_back(makeMassCancelAck(o, cancelled));
+            break;
+        }
+
+        case MsgType::Auction: {
+            if (!risk.isAdmin(o.client_id)) {
+                events.push_back(makeResponse(o, RejectCode::NotAuthorized));
+                break;
+            }
+            std::vector<OrderBook*> books;
+            if (o.symbol.empty()) {
+                for (const auto& [symbol, b] : engine.books()) books.push_back(engine.findBook(symbol));
+            } else {
+                books.push_back(&engine.book(o.symbol));
+            }
+            for (OrderBook* b : books) {
+                if (o.auction_action == AuctionAction::StartCall) {
+                    engine.startAuction(*b, events);
+                } else if (b->inAuction()) {
+                    const Qty qty = engine.uncross(*b, events);
+                    std::cout << "[CORE] Uncrossed " << b->symbol() << ": " << qty
+                              << " @ " << b->lastTradePrice() << std::endl;
+                }
+            }
+            break;
+        }
+
+        case MsgType::EndOfSession: {
+            if (!risk.isAdmin(o.client_id)) {
+                events.push_back(makeResponse(o, RejectCode::NotAuthorized));
+                break;
+            }
+            // Published batch by batch so a large expiry never builds one huge event list
+            size_t expired = 0;
+            while (size_t n = engine.expire(o.expire_date, kExpiryBatch, events)) {
+                expired += n;
+                publish(events, risk, egress);
+            }
+            std::cout << "[CORE] Session " << o.expire_date << " closed: "
+                      << expired << " orders expired" << std::endl;
+            events.push_back(makeMassCancelAck(o, expired));
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+int main(int argc, char* argv[]) {
     std::cout << "--- Initializing Market Exchange Core ---" << std::endl;
 
-    ThreadSafeQueue<std::string> rawQueue;
-    ThreadSafeQueue<Order> orderQueue;
-    IdGenerator id_generator;
-    const std::string inbound_port = "5555";
-    const std::string outbound_port = "5556";
+    // Usage: market_exchange [tcp|ipc] [router]
+    //                        [--replicate PORT | --backup HOST:PORT] [--port-offset N]
+    //                        [--partition PORT --partition-index I/N | --front PARTITION_MAP]
+    Transport transport = Transport::Tcp;
+    bool router = false;
+    uint16_t replicate_port = 0;  // primary: stream the sequenced input to a backup connecting here
+    std::string primary_host;     // backup: follow this primary, take over when it goes
+    uint16_t primary_port = 0;
+    int port_offset = 0;          // shifts every client port, for a backup on the primary's host
+    std::string partition_port;   // serve one symbol partition, fed by a front end on this port
+    size_t partition_index = 0;   // its line in the front end's map, from 0
+    size_t partition_count = 0;   // lines in the map
+    std::string partition_map;    // run as the front end for the partitions in this file
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "router") {
+            router = true;
+        } else if (arg == "--replicate" && i + 1 < argc) {
+            replicate_port = static_cast<uint16_t>(std::stoi(argv[++i]));
+        } else if (arg == "--backup" && i + 1 < argc) {
+            const std::string target = argv[++i];
+            const size_t colon = target.rfind(':');
+            if (colon == std::string::npos) {
+                std::cerr << "[CORE] --backup expects HOST:PORT" << std::endl;
+                return 1;
+            }
+            primary_host = target.substr(0, colon);
+            primary_port = static_cast<uint16_t>(std::stoi(target.substr(colon + 1)));
+        } else if (arg == "--port-offset" && i + 1 < argc) {
+            port_offset = std::stoi(argv[++i]);
+        } else if (arg == "--partition" && i + 1 < argc) {
+            partition_port = argv[++i];
+        } else if (arg == "--partition-index" && i + 1 < argc) {
+            const std::string spec = argv[++i];
+            const size_t slash = spec.find('/');
+            if (slash == std::string::npos) {
+                std::cerr << "[CORE] --partition-index expects I/N" << std::endl;
+                return 1;
+            }
+            partition_index = std::stoul(spec.substr(0, slash));
+            partition_count = std::stoul(spec.substr(slash + 1));
+        } else if (arg == "--front" && i + 1 < argc) {
+            partition_map = argv[++i];
+        } else if (!transport_from_string(arg, transport)) {
+            std::cerr << "[CORE] Unknown argument '" << arg << "', expected tcp or ipc" << std::endl;
+            return 1;
+        }
+    }
+    const bool following = primary_port != 0;
+    const bool partitioned = !partition_port.empty();
+    if (router && (partitioned || !partition_map.empty())) {
+        std::cerr << "[CORE] Symbol partitions take orders on a PULL ingress, not router" << std::endl;
+        return 1;
+    }
+    if (partitioned && partition_index >= partition_count) {
+        std::cerr << "[CORE] --partition needs --partition-index I/N, its line in the map out of N" << std::endl;
+        return 1;
+    }
+    // Partitions send their answers to broadcasts to the front end on this
+    // port: bound as the ingress, connected as the egress
+    const Endpoints answer_endpoints = make_endpoints(transport, std::to_string(5559 + port_offset),
+                                                      std::to_string(5559 + port_offset));
+
+    if (!partition_map.empty()) {
+        // Front end only: no books, just forwarding by symbol
+        zmq::context_t context(2);
+        const Endpoints endpoints = make_endpoints(transport, std::to_string(5555 + port_offset),
+                                                   std::to_string(5556 + port_offset));
+        PartitionRouter front(context, endpoints.ingress, partition_map, answer_endpoints.ingress, endpoints.egress);
+        if (!front.load()) return 1;
+        std::cout << "[CORE] Front end is LIVE. Forwarding orders by symbol..." << std::endl;
+        front.run();
+        return 0;
+    }
+
+    // Bounded so a slow stage pushes back instead of growing memory: a full raw
+    // queue blocks the receiver (ZMQ's rcvhwm then throttles senders), a full
+    // order queue makes the parse workers shed orders with a Reject.
+    ThreadSafeQueue<InboundMessage> rawQueue(65536, OverflowPolicy::Block);
+    ThreadSafeQueue<Order> orderQueue(65536, OverflowPolicy::Reject);
+    // A partition takes its orders from the front end; responses still go
+    // straight to the clients
+    const std::string inbound_port = partitioned ? partition_port : std::to_string(5555 + port_offset);
+    const std::string outbound_port = std::to_string(5556 + port_offset);
+    const Endpoints endpoints = make_endpoints(transport, inbound_port, outbound_port, router);
     const int num_json_parsing_threads = 8;
+    // Each partition keeps its own books. A backup starts from its
+    // primary's snapshot but writes its own.
+    const std::string snapshot_stem = partitioned ? "exchange." + partition_port : "exchange";
+    const std::string restore_path = snapshot_stem + ".snapshot";
+    const std::string snapshot_path = following ? snapshot_stem + ".backup.snapshot" : restore_path;
+    const uint64_t snapshot_interval = 100000; // orders between snapshots
+    const ClientId admin_client_id = 1;        // may send KillSwitch / venue-wide MassCancel
+    const std::vector<ClientId> shm_clients = {}; // co-located clients given shared-memory sessions
 
-    InputStream inputProcessor(&rawQueue, inbound_port);
+    // Restore books and the id counter from the last snapshot before the
+    // matching thread hands out ids; sequence numbers carry on after the
+    // last message it covers
+    MatchingEngine engine;
+    uint64_t last_order_id = 0;
+    uint64_t last_seq = 0;
+    if (loadSnapshot(restore_path, engine, last_order_id, last_seq)) {
+        std::cout << "[CORE] Restored " << engine.restingCount() << " resting orders from "
+                  << restore_path << " (last order id " << last_order_id << ", input through seq "
+                  << last_seq << ")" << std::endl;
+    }
+    if (partitioned) {
+        // Ids below 1 << 40 predate the per-partition ranges and cannot collide with new ones
+        const OrderId owner = last_order_id >> kPartitionIdBits;
+        if (owner != 0 && owner != partition_index) {
+            std::cerr << "[CORE] " << restore_path << " holds ids of partition " << owner
+                      << ", not " << partition_index << std::endl;
+            return 1;
+        }
+        last_order_id = std::max(last_order_id, partitionIdBase(partition_index));
+    }
+    IdGenerator id_generator(last_order_id);
+    SnapshotWriter snapshot_writer(snapshot_path);
+
+    RiskLimits default_limits;
+    default_limits.max_order_qty = 1000000;
+    default_limits.max_notional = 1000000000000;
+    default_limits.price_collar_bps = 1000;
+    default_limits.max_open_orders = 100000;
+    default_limits.max_gross_position = 100000000;
+    if (partitioned) {
+        // A static 1/N split, not a shared limit: partitions never exchange
+        // positions, so each enforces its own share. A client's total across
+        // the venue stays within the limit, but one trading in a single
+        // partition is stopped at 1/N of it.
+        default_limits.max_open_orders = (default_limits.max_open_orders + partition_count - 1) / partition_count;
+        default_limits.max_gross_position = (default_limits.max_gross_position + partition_count - 1) / partition_count;
+    }
+    RiskChecker risk(default_limits);
+    risk.addAdmin(admin_client_id);
+    for (const auto& [symbol, book] : engine.books()) {
+        (void)symbol;
+        for (Side side : {Side::Buy, Side::Sell}) {
+            for (const OrderBook::Levels* levels : {&book.levels(side), &book.stops(side)}) {
+                for (const auto& [px, level] : *levels) {
+                    (void)px;
+                    for (uint32_t idx = level.head; idx != kNullIndex; idx = engine.pool()[idx].next) {
+                        const RestingOrder& r = engine.pool()[idx];
+                        risk.onResting(r.client_id, r.side, r.qty + r.reserve);
+                    }
+                }
+            }
+        }
+    }
+
+    ThrottleConfig throttle_config;
+    throttle_config.rate_per_sec = 100000;
+    throttle_config.burst = 10000;
+
+    // One context for every socket in the process: the router's inproc
+    // response endpoint only connects within a context, and 10 sockets don't
+    // need 9 sets of I/O threads
+    zmq::context_t context(2);
+
+    // Every receiver numbers its messages through the sequencer on the way to
+    // the parse workers
+    Sequencer sequencer(&rawQueue, last_seq + 1);
+
+    InputStream inputProcessor(&sequencer, context, endpoints.ingress, throttle_config,
+                               router ? IngressMode::Router : IngressMode::Pull);
+    ShmGateway shm_gateway(shm_clients);
+    inputProcessor.attachShm(&shm_gateway);
 
-    // create and detach thread
-    std::thread inputThread(&InputStream::startListening, &inputProcessor);
-    inputThread.detach();
+    // Framed TCP sessions feed the same parser pool
+    TcpGatewayConfig gateway_config;
+    gateway_config.port = static_cast<uint16_t>(5557 + port_offset);
+    gateway_config.io_threads = 2;
+    TcpGateway tcp_gateway(&sequencer, gateway_config);
+
+    const SessionRoutes routes{&shm_gateway, &tcp_gateway};
+
+    // Every response leaves through one thread and one socket; each
+    // responding thread hands it over on its own lock-free queue
+    EgressStage egress(context, endpoints.egress, &routes);
 
     // parellelize json parsing
     std::vector<std::unique_ptr<OrderGenerator>> workers;
     for (int i = 0; i < num_json_parsing_threads; ++i) {
-        // Each worker handles JSON parsing and ID generation
+        // Each worker handles JSON parsing; raw bytes ride along only for replication
         workers.push_back(std::make_unique<OrderGenerator>(
-            &rawQueue, &orderQueue, &id_generator, outbound_port
+            &rawQueue, &orderQueue, egress.addProducer(), replicate_port != 0
         ));
-        
-        // Launch worker in its own thread
-        std::thread([&worker = workers.back()]() {
-            worker->run();
-        }).detach();
     }
 
-    std::cout << "[CORE] Exchange is LIVE. Waiting for orders..." << std::endl;
+    // Acks, risk rejects and fills from the matching thread
+    EgressStage::Producer& matching_out = *egress.addProducer();
+
+    // A partition's answers to broadcasts go to the front end, which merges
+    // them into one per request
+    std::unique_ptr<EgressStage> answer_egress;
+    EgressStage::Producer* answer_out = nullptr;
+    if (partitioned) {
+        answer_egress = std::make_unique<EgressStage>(context, answer_endpoints.egress);
+        answer_out = answer_egress->addProducer();
+    }
+
+    // A primary holds every response until its backup has the message it
+    // answers, and waits for the backup before taking any traffic. Once it
+    // loses the backup it stops, since the backup may be taking over.
+    std::unique_ptr<ReplicationPrimary> replication;
+    if (replicate_port != 0) {
+        replication = std::make_unique<ReplicationPrimary>(replicate_port);
+        if (!replication->waitForBackup()) return 1;
+        egress.holdFor(replication->replicated());
+        if (answer_egress) answer_egress->holdFor(replication->replicated());
+        replication->reportReleased(egress.released());
+        replication->fenceWith([] {
+            std::cerr << "[CORE] Fenced: stopping so the backup can take over" << std::endl;
+            std::_Exit(3);
+        });
+        replication->start();
+    }
+    // A backup computes the same responses and keeps those the primary has
+    // not released yet, to send them if it takes over
+    ReplicationBackup backup;
+    if (following) {
+        if (!backup.connect(primary_host, primary_port)) return 1;
+        egress.retainFor(backup.released());
+        if (answer_egress) answer_egress->retainFor(backup.released());
+    }
+    egress.setStandby(following);
+    egress.start();
+    if (answer_egress) {
+        answer_egress->setStandby(following);
+        answer_egress->start();
+    }
+
+    // Clients and parse workers; a backup only starts them when it takes over
+    auto goLive = [&]() {
+        // Gateway sessions would bypass the front end's partition map
+        if (!partitioned) tcp_gateway.start();
+
+        std::thread inputThread(&InputStream::startListening, &inputProcessor);
+        inputThread.detach();
+
+        // Launch each worker in its own thread. Capture the worker itself,
+        // not the vector slot, which moves when the vector grows.
+        for (auto& w : workers) {
+            std::thread([worker = w.get()]() {
+                worker->run();
+            }).detach();
+        }
+        std::cout << "[CORE] Exchange is LIVE. Waiting for orders..." << std::endl;
+    };
 
     // main processing loop
-    while (true) {
-        Order o = orderQueue.pop();
+    std::vector<EnvelopeOut> events;
+    uint64_t since_snapshot = 0;
+
+    // Workers finish in any order; the reorder stage puts their output back
+    // into sequencer order before anything touches the books, and internal
+    // ids are handed out in that order. The window matches the order queue,
+    // so one worker descheduled mid-message does not overflow it.
+    ReorderBuffer<Order> reorder(sequencer.next(), 65536);
+    auto process = [&](Order& o) {
+        last_seq = o.global_seq;
+        // Placeholder for a heartbeat or a message the worker rejected
+        if (o.type == MsgType::Heartbeat) return;
+        if (o.type == MsgType::NewOrder) o.internal_order_id = id_generator.next();
+
+        // On its way to the backup before any response to it can leave
+        if (replication) replication->append(o.global_seq, o.timestamp, std::move(o.raw));
+        matching_out.holdUntil(o.global_seq);
+        if (answer_out) answer_out->holdUntil(o.global_seq);
+
         std::cout << "[DEBUG] Raw Queue Size: " << rawQueue.size() << " | Orders Parsed: " << o.internal_order_id << std::endl;
-        printOrder(o); // placeholder for now, matching engine and order books will be used here
+        printOrder(o);
+
+        handle(o, engine, risk, events, matching_out);
+
+        // A broadcast's own answer comes last: every partition's goes to the
+        // front end to be merged, and only partition 0 refuses an auction
+        EnvelopeOut answer;
+        bool merge = false;
+        if (partitioned && o.symbol.empty() && !events.empty()) {
+            if (mergedAnswer(o.type)) {
+                answer = std::move(events.back());
+                events.pop_back();
+                merge = true;
+            } else if (o.type == MsgType::Auction && partition_index != 0 &&
+                       events.back().header.type == MsgType::Reject) {
+                events.pop_back();
+            }
+        }
+        publish(events, risk, matching_out);
+        if (merge) answer_out->send(answer.header.client_id, dump_envelope(answer));
 
+        // Snapshots are taken between orders on this thread, so they are
+        // always a consistent point in time; a forked child writes them
+        if (++since_snapshot >= snapshot_interval) {
+            since_snapshot = 0;
+            snapshot_writer.start(engine, id_generator.current(), last_seq);
+            const SnapshotWriterCounters sw = snapshot_writer.counters();
+            std::cout << "[CORE] Snapshots: " << sw.written << " written, " << sw.failed << " failed, "
+                      << sw.skipped << " skipped" << std::endl;
+
+            std::cout << "[CORE] Queue high water: raw " << rawQueue.highWater()
+                      << " | order " << orderQueue.highWater()
+                      << " (" << orderQueue.overflowCount() << " shed)" << std::endl;
+
+            uint64_t parse_errors = 0;
+            for (const auto& w : workers) parse_errors += w->parseErrors();
+            if (parse_errors > 0) std::cout << "[CORE] Parse errors: " << parse_errors << " rejected" << std::endl;
+
+            const ReorderCounters r = reorder.counters();
+            std::cout << "[CORE] Sequencer: next " << sequencer.next() << " | reorder held up to "
+                      << r.max_held << ", " << r.skipped << " skipped, " << r.late << " late" << std::endl;
+
+            if (inputProcessor.truncated() > 0) {
+                std::cout << "[CORE] Batches over " << InputStream::kMaxBatch << " parts: "
+                          << inputProcessor.truncated() << " parts dropped" << std::endl;
+            }
+            inputProcessor.throttle().forEachClient([](const ThrottleCounters& c) {
+                if (c.dropped > 0) {
+                    std::cout << "[CORE] Throttled client " << c.client_id << ": "
+                              << c.dropped << " dropped / " << c.passed << " passed" << std::endl;
+                }
+            });
+            shm_gateway.forEachSession([](const ShmSessionCounters& c) {
+                std::cout << "[CORE] shm client " << c.client_id << (c.alive ? " up" : " down") << ": "
+                          << c.received << " received, " << c.rejected << " rejected, " << c.dropped
+                          << " responses dropped" << std::endl;
+            });
+            if (router) {
+                std::cout << "[CORE] Router: " << inputProcessor.unroutable() << " unroutable responses, "
+                          << inputProcessor.refused() << " messages refused" << std::endl;
+            }
+            if (replication) {
+                const ReplicationCounters c = replication->counters();
+                std::cout << "[CORE] Replication: backup " << (c.connected ? "up" : "DOWN") << ", "
+                          << c.sent << "/" << c.appended << " sent in " << c.writes << " writes, acked to "
+                          << c.replicated << std::endl;
+            }
+            const EgressCounters e = egress.counters();
+            std::cout << "[CORE] Egress: " << e.sent << " sent in " << e.batches << " batches, "
+                      << e.routed << " to gateway sessions, " << e.producer_waits << " producer waits";
+            if (following) std::cout << ", " << e.replayed << " replayed on takeover";
+            std::cout << std::endl;
+            const TcpGatewayCounters g = tcp_gateway.counters();
+            std::cout << "[CORE] Gateway: " << g.sessions << " sessions (" << g.accepted << " accepted, "
+                      << g.dropped_sessions << " dropped) | " << g.frames_in << " frames, "
+                      << g.seq_rejects << " sequence rejects" << std::endl;
+        }
+    };
+
+    if (following) {
+        // Hot standby: apply the primary's stream through the same matching
+        // code until the primary goes, then take over from the next number
+        std::vector<ReplicationRecord> records;
+        bool primary_up = true;
+        while (primary_up) {
+            primary_up = backup.receive(records);
+            for (ReplicationRecord& r : records) {
+                Order o = order_from_envelope(parse_inbound_envelope(r.payload));
+                o.global_seq = r.seq;
+                o.timestamp = r.recv_ns;
+                process(o);
+            }
+            records.clear();
+        }
+        backup.awaitFence();
+        std::cout << "[CORE] Primary lost after seq " << backup.lastSeq() << ", taking over on ports "
+                  << inbound_port << "/" << outbound_port << "/" << gateway_config.port << std::endl;
+        sequencer.restart(last_seq + 1);
+        reorder.restart(sequencer.next());
+        egress.setStandby(false);
+        if (answer_egress) answer_egress->setStandby(false);
+    }
+    goLive();
+
+    while (true) {
+        Order o;
+        if (!reorder.waiting()) {
+            o = orderQueue.pop();
+        } else if (!orderQueue.popFor(o, std::chrono::nanoseconds(reorder.untilExpiryNs(Sequencer::nowNs())))) {
+            // Still missing: a shed order, most likely
+            reorder.expire(Sequencer::nowNs(), process);
+            continue;
+        }
+        const uint64_t seq = o.global_seq;
+        reorder.push(seq, std::move(o), Sequencer::nowNs(), process);
     }
 
     return 0;
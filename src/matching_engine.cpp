@@ -0,0 +1,703 @@
+#include "matching_engine.hpp"
+#include <algorithm>
+#include <cstdlib>
+
+namespace ex {
+
+// Never a real client: taker ids compare against it when STP is off, so the
+// match loop always does the same single comparison
+constexpr ClientId kNoStpClient = UINT32_MAX;
+
+// Splits an order's open quantity into its displayed slice and the reserve
+static void setOpen(RestingOrder& r, Qty open) {
+    r.qty = r.display > 0 && r.display < open ? r.display : open;
+    r.reserve = open - r.qty;
+}
+
+MatchingEngine::MatchingEngine(size_t expected_orders) {
+    reserve(expected_orders);
+}
+
+void MatchingEngine::reserve(size_t n) {
+    order_pool.reserve(n);
+    order_index.reserve(n);
+}
+
+OrderBook& MatchingEngine::book(const std::string& symbol) {
+    auto it = symbol_books.find(symbol);
+    if (it == symbol_books.end()) {
+        const uint32_t id = static_cast<uint32_t>(book_table.size());
+        it = symbol_books.emplace(symbol, OrderBook(&order_pool, id, symbol)).first;
+        book_table.push_back(&it->second);
+    }
+    return it->second;
+}
+
+OrderBook* MatchingEngine::findBook(const std::string& symbol) {
+    auto it = symbol_books.find(symbol);
+    return it == symbol_books.end() ? nullptr : &it->second;
+}
+
+const RestingOrder* MatchingEngine::find(OrderId order_id) const {
+    auto it = order_index.find(order_id);
+    return it == order_index.end() ? nullptr : &order_pool[it->second];
+}
+
+void MatchingEngine::process(const Order& o, std::vector<EnvelopeOut>& out) {
+    switch (o.type) {
+        case MsgType::NewOrder: submit(o, out); break;
+        case MsgType::Cancel:   cancelRequest(o, out); break;
+        case MsgType::Replace:  replace(o, out); break;
+        default: break;
+    }
+}
+
+Qty MatchingEngine::match(OrderBook& b, const Taker& t, Price limit, bool is_market, Qty qty,
+                          std::vector<EnvelopeOut>& out) {
+    if (b.inAuction()) return qty;
+
+    const bool is_buy = t.side == Side::Buy;
+    OrderBook::Levels& contra = b.levels(is_buy ? Side::Sell : Side::Buy);
+    const ClientId stp_client = t.stp == StpMode::None ? kNoStpClient : t.client_id;
+    Qty remaining = qty;
+
+    // Take liquidity one resting order at a time from the best contra level
+    while (remaining > 0 && !contra.empty()) {
+        auto best = is_buy ? contra.begin() : std::prev(contra.end());
+        if (!is_market && (is_buy ? best->first > limit : best->first < limit)) break;
+
+        PriceLevel& level = best->second;
+        const uint32_t idx = level.head;
+        RestingOrder& resting = order_pool[idx];
+        if (resting.client_id == stp_client) {
+            remaining = preventSelfTrade(b, level, idx, t, remaining, out);
+            continue;
+        }
+
+        const Qty traded = std::min(remaining, resting.qty);
+        remaining -= traded;
+        resting.qty -= traded;
+        level.total_qty -= traded;
+
+        emitFill(resting.order_id, resting.client_id, b.symbol(), resting.side,
+                 traded, best->first, resting.qty == 0 && resting.reserve == 0, out);
+        emitFill(t.order_id, t.client_id, b.symbol(), t.side,
+                 traded, best->first, remaining == 0, out);
+
+        b.setLastTrade(best->first);
+
+        if (resting.qty == 0) retire(b, level, idx);
+    }
+    return remaining;
+}
+
+Qty MatchingEngine::preventSelfTrade(OrderBook& b, PriceLevel& level, uint32_t idx,
+                                     const Taker& t, Qty remaining, std::vector<EnvelopeOut>& out) {
+    RestingOrder& resting = order_pool[idx];
+    const Qty open = resting.qty + resting.reserve;
+    Qty taker_cut = 0;
+
+    switch (t.stp) {
+        case StpMode::CancelResting:
+            emitCancelled(resting, b.symbol(), out);
+            removeResting(idx);
+            return remaining;
+        case StpMode::CancelBoth:
+            emitCancelled(resting, b.symbol(), out);
+            removeResting(idx);
+            taker_cut = remaining;
+            break;
+        case StpMode::Decrement: {
+            // Both sides lose the smaller quantity; neither trades
+            taker_cut = std::min(remaining, open);
+            if (taker_cut == open) {
+                emitCancelled(resting, b.symbol(), out);
+                removeResting(idx);
+            } else {
+                const Qty from_reserve = std::min(taker_cut, resting.reserve);
+                resting.reserve -= from_reserve;
+                resting.qty -= taker_cut - from_reserve;
+                level.reserve_qty -= from_reserve;
+                level.total_qty -= taker_cut - from_reserve;
+
+                EnvelopeOut e;
+                e.header.type = MsgType::Cancelled;
+                e.header.client_id = resting.client_id;
+                e.body = Cancelled{ resting.order_id, resting.client_order_id, b.symbol(),
+                                    resting.side, taker_cut, open - taker_cut };
+                out.push_back(std::move(e));
+            }
+            break;
+        }
+        default: // CancelAggressor
+            taker_cut = remaining;
+            break;
+    }
+
+    EnvelopeOut e;
+    e.header.type = MsgType::Cancelled;
+    e.header.seq = t.seq;
+    e.header.client_id = t.client_id;
+    e.body = Cancelled{ t.order_id, t.client_order_id, b.symbol(), t.side,
+                        taker_cut, remaining - taker_cut };
+    out.push_back(std::move(e));
+    return remaining - taker_cut;
+}
+
+void MatchingEngine::retire(OrderBook& b, PriceLevel& level, uint32_t idx) {
+    if (order_pool[idx].reserve > 0) b.replenish(level, idx);
+    else                             removeResting(idx);
+}
+
+void MatchingEngine::submit(const Order& o, std::vector<EnvelopeOut>& out) {
+    OrderBook& b = book(o.symbol);
+    if (o.ord_type == OrdType::Stop || o.ord_type == OrdType::StopLimit) {
+        addStop(b, o);
+    } else {
+        place(b, o, out);
+    }
+    // Also fires a new stop whose price the last trade has already crossed
+    triggerStops(b, out);
+
+    if (b.inAuction()) {
+        AuctionInfo info;
+        info.symbol = b.symbol();
+        indicative(b, info);
+        emitAuctionInfo(info, out);
+    }
+}
+
+void MatchingEngine::place(OrderBook& b, const Order& o, std::vector<EnvelopeOut>& out) {
+    const bool is_market = o.ord_type == OrdType::Market;
+    const Price limit = static_cast<Price>(o.price);
+    const Taker t{ o.internal_order_id, o.client_order_id, o.client_id, o.side, o.stp, o.seq };
+    const Qty remaining = match(b, t, limit, is_market, o.quantity, out);
+
+    if (remaining == 0) return;
+
+    // Market and IOC remainders are cancelled here and never touch a level
+    if (is_market || o.tif == TimeInForce::IOC) {
+        EnvelopeOut e;
+        e.header.type = MsgType::Cancelled;
+        e.header.seq = o.seq;
+        e.header.client_id = o.client_id;
+        e.body = Cancelled{ o.internal_order_id, o.client_order_id, o.symbol, o.side, remaining };
+        out.push_back(std::move(e));
+        return;
+    }
+
+    const uint32_t idx = order_pool.allocate();
+    RestingOrder& r = order_pool[idx];
+    r.order_id = o.internal_order_id;
+    r.client_order_id = o.client_order_id;
+    r.timestamp = o.timestamp;
+    r.price = limit;
+    r.display = o.display_qty;
+    setOpen(r, remaining);
+    r.client_id = o.client_id;
+    r.side = o.side;
+    r.stp = o.stp;
+    r.tif = o.tif;
+    r.expire_date = o.expire_date;
+    r.book = b.id();
+
+    b.append(idx);
+    linkClient(idx);
+    linkExpiry(idx);
+    order_index.emplace(r.order_id, idx);
+}
+
+void MatchingEngine::addStop(OrderBook& b, const Order& o) {
+    const uint32_t idx = order_pool.allocate();
+    RestingOrder& r = order_pool[idx];
+    r.order_id = o.internal_order_id;
+    r.client_order_id = o.client_order_id;
+    r.timestamp = o.timestamp;
+    r.price = o.ord_type == OrdType::StopLimit ? static_cast<Price>(o.price) : 0;
+    r.stop_price = static_cast<Price>(o.stop_price);
+    r.ord_type = o.ord_type;
+    r.display = o.display_qty;
+    r.qty = o.quantity;
+    r.client_id = o.client_id;
+    r.side = o.side;
+    r.stp = o.stp;
+    r.tif = o.tif;
+    r.expire_date = o.expire_date;
+    r.book = b.id();
+
+    b.append(idx);
+    linkClient(idx);
+    linkExpiry(idx);
+    order_index.emplace(r.order_id, idx);
+}
+
+void MatchingEngine::triggerStops(OrderBook& b, std::vector<EnvelopeOut>& out) {
+    // A call auction holds stops, even ones already crossed, until the
+    // uncross prints a price and calls back in here
+    if (b.inAuction()) return;
+
+    // Fired stops run strictly in the order they were taken; trades they make
+    // can fire more, which queue up behind them
+    fired_stops.clear();
+    b.takeTriggered(b.lastTradePrice(), fired_stops);
+    for (size_t i = 0; i < fired_stops.size(); ++i) {
+        const Price last = b.lastTradePrice();
+        activateStop(b, fired_stops[i], out);
+        if (b.lastTradePrice() != last) b.takeTriggered(b.lastTradePrice(), fired_stops);
+    }
+}
+
+void MatchingEngine::activateStop(OrderBook& b, uint32_t idx, std::vector<EnvelopeOut>& out) {
+    RestingOrder& r = order_pool[idx];
+    const bool is_market = r.ord_type == OrdType::Stop;
+    r.ord_type = is_market ? OrdType::Market : OrdType::Limit;
+
+    const Qty remaining = match(b, takerOf(r), r.price, is_market, r.qty, out);
+    // A stop-limit rests what it could not fill, unless it is IOC
+    if (remaining > 0 && !is_market && r.tif != TimeInForce::IOC) {
+        setOpen(r, remaining);
+        b.append(idx);
+        return;
+    }
+    if (remaining > 0) {
+        r.qty = remaining;
+        emitCancelled(r, b.symbol(), out);
+    }
+    unlinkClient(idx);
+    unlinkExpiry(idx);
+    order_index.erase(r.order_id);
+    order_pool.release(idx);
+}
+
+void MatchingEngine::cancelRequest(const Order& o, std::vector<EnvelopeOut>& out) {
+    uint32_t idx = kNullIndex;
+
+    if (o.internal_order_id != 0) {
+        auto it = order_index.find(o.internal_order_id);
+        if (it != order_index.end()) idx = it->second;
+    } else {
+        // By client_order_id: only this client's own resting orders can match
+        auto c = client_orders.find(o.client_id);
+        for (uint32_t i = c == client_orders.end() ? kNullIndex : c->second.head;
+             i != kNullIndex; i = order_pool[i].client_next) {
+            if (order_pool[i].client_order_id == o.client_order_id) {
+                idx = i;
+                break;
+            }
+        }
+    }
+
+    // Other clients' orders look exactly like unknown ones
+    if (idx == kNullIndex || order_pool[idx].client_id != o.client_id) {
+        EnvelopeOut e;
+        e.header.type = MsgType::Reject;
+        e.header.seq = o.seq;
+        e.header.client_id = o.client_id;
+        e.body = Reject{ o.client_order_id, o.symbol,
+                         RejectInfo{ reject_reason(RejectCode::UnknownOrder), to_u(RejectCode::UnknownOrder) } };
+        out.push_back(std::move(e));
+        return;
+    }
+
+    emitCancelled(order_pool[idx], book_table[order_pool[idx].book]->symbol(), out);
+    removeResting(idx);
+}
+
+void MatchingEngine::replace(const Order& o, std::vector<EnvelopeOut>& out) {
+    auto it = order_index.find(o.internal_order_id);
+    RejectCode code = RejectCode::None;
+    if (it == order_index.end() || order_pool[it->second].client_id != o.client_id) {
+        code = RejectCode::UnknownOrder;
+    } else if (o.quantity <= 0) {
+        code = RejectCode::InvalidReplace;
+    }
+    if (code != RejectCode::None) {
+        EnvelopeOut e;
+        e.header.type = MsgType::Reject;
+        e.header.seq = o.seq;
+        e.header.client_id = o.client_id;
+        e.body = Reject{ o.client_order_id, o.symbol, RejectInfo{ reject_reason(code), to_u(code) } };
+        out.push_back(std::move(e));
+        return;
+    }
+
+    const uint32_t idx = it->second;
+    RestingOrder& r = order_pool[idx];
+    OrderBook& b = *book_table[r.book];
+    const Price new_price = static_cast<Price>(o.price);
+    const Qty new_qty = o.quantity;
+    if (o.client_order_id != 0) r.client_order_id = o.client_order_id;
+
+    EnvelopeOut ack;
+    ack.header.type = MsgType::Replaced;
+    ack.header.seq = o.seq;
+    ack.header.client_id = o.client_id;
+    ack.body = Replaced{ r.order_id, r.client_order_id, b.symbol(), new_qty, new_price };
+    out.push_back(std::move(ack));
+
+    // A pending stop only changes its quantity and limit; its stop price
+    // stays, and so does its place in the stop level's queue unless the
+    // quantity goes up
+    if (isPendingStop(r)) {
+        if (r.ord_type == OrdType::StopLimit) r.price = new_price;
+        if (new_qty <= r.qty) {
+            b.reduce(idx, r.qty - new_qty);
+        } else {
+            b.remove(idx);
+            r.qty = new_qty;
+            b.append(idx);
+        }
+        return;
+    }
+
+    if (new_price == r.price) {
+        const Qty open = r.qty + r.reserve;
+        if (new_qty <= open) {
+            // Quantity down at the same price keeps queue priority; an
+            // iceberg gives up hidden quantity before displayed
+            const Qty cut = open - new_qty;
+            const Qty from_reserve = std::min(cut, r.reserve);
+            b.reduceReserve(idx, from_reserve);
+            b.reduce(idx, cut - from_reserve);
+        } else {
+            // Quantity up loses priority: back of the same level
+            b.remove(idx);
+            setOpen(r, new_qty);
+            b.append(idx);
+        }
+        return;
+    }
+
+    // New price: the order keeps its pool slot and index entry, leaves its old
+    // level and may trade before joining the tail of the new one
+    b.remove(idx);
+    r.price = new_price;
+    setOpen(r, match(b, takerOf(r, o.seq), new_price, false, new_qty, out));
+
+    if (r.qty == 0) {
+        unlinkClient(idx);
+        unlinkExpiry(idx);
+        order_index.erase(it);
+        order_pool.release(idx);
+    } else {
+        b.append(idx);
+    }
+    triggerStops(b, out);
+}
+
+void MatchingEngine::startAuction(OrderBook& b, std::vector<EnvelopeOut>& out) {
+    b.setAuction(true);
+    AuctionInfo info;
+    info.symbol = b.symbol();
+    indicative(b, info);
+    emitAuctionInfo(info, out);
+}
+
+bool MatchingEngine::indicative(const OrderBook& b, AuctionInfo& info) {
+    const OrderBook::Levels& bids = b.levels(Side::Buy);
+    const OrderBook::Levels& asks = b.levels(Side::Sell);
+    info.price = info.qty = info.imbalance = 0;
+    if (bids.empty() || asks.empty()) return false;
+
+    // Only [lowest ask, highest bid] can trade, and executable volume only
+    // changes at a level price, so the ladder is the union of level prices
+    // in that range rather than every tick
+    const Price lo = asks.begin()->first;
+    const Price hi = std::prev(bids.end())->first;
+    if (hi < lo) return false;
+
+    ladder_px.clear();
+    ladder_bid.clear();
+    ladder_ask.clear();
+    auto bi = bids.lower_bound(lo);
+    auto ai = asks.begin();
+    const auto ae = asks.upper_bound(hi);
+    while (bi != bids.end() || ai != ae) {
+        const Price bp = bi != bids.end() ? bi->first : hi + 1;
+        const Price ap = ai != ae ? ai->first : hi + 1;
+        const Price px = std::min(bp, ap);
+        ladder_px.push_back(px);
+        // Hidden iceberg quantity executes in the uncross, so it counts here
+        if (bp == px) {
+            ladder_bid.push_back(bi->second.total_qty + bi->second.reserve_qty);
+            ++bi;
+        } else {
+            ladder_bid.push_back(0);
+        }
+        if (ap == px) {
+            ladder_ask.push_back(ai->second.total_qty + ai->second.reserve_qty);
+            ++ai;
+        } else {
+            ladder_ask.push_back(0);
+        }
+    }
+
+    // Cumulative demand at or above each price, supply at or below it
+    const size_t n = ladder_px.size();
+    for (size_t i = n - 1; i > 0; --i) ladder_bid[i - 1] += ladder_bid[i];
+    for (size_t i = 1; i < n; ++i) ladder_ask[i] += ladder_ask[i - 1];
+
+    const Price ref = b.lastTradePrice();
+    size_t best = 0;
+    Qty best_vol = -1, best_imb = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const Qty vol = std::min(ladder_bid[i], ladder_ask[i]);
+        const Qty imb = std::llabs(ladder_bid[i] - ladder_ask[i]);
+        if (vol > best_vol || (vol == best_vol && (imb < best_imb ||
+            (imb == best_imb && ref > 0 &&
+             std::llabs(ladder_px[i] - ref) < std::llabs(ladder_px[best] - ref))))) {
+            best = i;
+            best_vol = vol;
+            best_imb = imb;
+        }
+    }
+
+    info.price = ladder_px[best];
+    info.qty = best_vol;
+    info.imbalance = ladder_bid[best] - ladder_ask[best];
+    return true;
+}
+
+Qty MatchingEngine::uncross(OrderBook& b, std::vector<EnvelopeOut>& out) {
+    AuctionInfo info;
+    info.symbol = b.symbol();
+    info.uncrossed = true;
+
+    Qty executed = 0;
+    if (indicative(b, info)) {
+        const Price px = info.price;
+        OrderBook::Levels& bids = b.levels(Side::Buy);
+        OrderBook::Levels& asks = b.levels(Side::Sell);
+
+        // Best bid against best ask in price-time priority, all at one price
+        while (!bids.empty() && !asks.empty() &&
+               std::prev(bids.end())->first >= px && asks.begin()->first <= px) {
+            PriceLevel& bid_level = std::prev(bids.end())->second;
+            PriceLevel& ask_level = asks.begin()->second;
+            const uint32_t bid_idx = bid_level.head;
+            const uint32_t ask_idx = ask_level.head;
+            RestingOrder& bid = order_pool[bid_idx];
+            RestingOrder& ask = order_pool[ask_idx];
+
+            // Same client on both sides: the later order is the aggressor, as
+            // it would have been in continuous trading, and its STP mode applies
+            if (bid.client_id == ask.client_id) {
+                const bool bid_later = bid.order_id > ask.order_id;
+                const uint32_t taker_idx = bid_later ? bid_idx : ask_idx;
+                RestingOrder& taker = order_pool[taker_idx];
+                if (taker.stp != StpMode::None) {
+                    const Qty open = taker.qty + taker.reserve;
+                    const Qty left = preventSelfTrade(b, bid_later ? ask_level : bid_level,
+                                                      bid_later ? ask_idx : bid_idx, takerOf(taker), open, out);
+                    if (left == 0) {
+                        removeResting(taker_idx);
+                    } else if (left < open) {
+                        const Qty from_reserve = std::min(open - left, taker.reserve);
+                        b.reduceReserve(taker_idx, from_reserve);
+                        b.reduce(taker_idx, open - left - from_reserve);
+                    }
+                    continue;
+                }
+            }
+
+            const Qty traded = std::min(bid.qty, ask.qty);
+            bid.qty -= traded;
+            ask.qty -= traded;
+            bid_level.total_qty -= traded;
+            ask_level.total_qty -= traded;
+            executed += traded;
+
+            emitFill(bid.order_id, bid.client_id, b.symbol(), Side::Buy, traded, px,
+                     bid.qty == 0 && bid.reserve == 0, out);
+            emitFill(ask.order_id, ask.client_id, b.symbol(), Side::Sell, traded, px,
+                     ask.qty == 0 && ask.reserve == 0, out);
+
+            if (bid.qty == 0) retire(b, bid_level, bid_idx);
+            if (ask.qty == 0) retire(b, ask_level, ask_idx);
+        }
+        if (executed > 0) b.setLastTrade(px);
+    }
+
+    info.qty = executed;
+    b.setAuction(false);
+    emitAuctionInfo(info, out);
+    triggerStops(b, out);
+    return executed;
+}
+
+bool MatchingEngine::cancel(OrderId order_id, std::vector<EnvelopeOut>& out) {
+    auto it = order_index.find(order_id);
+    if (it == order_index.end()) return false;
+
+    const uint32_t idx = it->second;
+    emitCancelled(order_pool[idx], book_table[order_pool[idx].book]->symbol(), out);
+    removeResting(idx);
+    return true;
+}
+
+size_t MatchingEngine::cancelClient(ClientId client_id, const OrderBook* only,
+                                    std::vector<EnvelopeOut>& out) {
+    auto c = client_orders.find(client_id);
+    if (c == client_orders.end()) return 0;
+
+    size_t n = 0;
+    uint32_t idx = c->second.head;
+    while (idx != kNullIndex) {
+        const uint32_t next = order_pool[idx].client_next;
+        const RestingOrder& r = order_pool[idx];
+        if (!only || r.book == only->id()) {
+            emitCancelled(r, book_table[r.book]->symbol(), out);
+            removeResting(idx);
+            n++;
+        }
+        idx = next;
+    }
+    return n;
+}
+
+size_t MatchingEngine::cancelBook(OrderBook& b, std::vector<EnvelopeOut>& out) {
+    // Every order in the book goes, so skip per-order level maintenance and
+    // drop the levels in one go afterwards
+    size_t n = 0;
+    for (OrderBook::Levels* side : {&b.levels(Side::Buy), &b.levels(Side::Sell),
+                                    &b.stops(Side::Buy), &b.stops(Side::Sell)}) {
+        for (auto& [px, level] : *side) {
+            (void)px;
+            uint32_t idx = level.head;
+            while (idx != kNullIndex) {
+                const uint32_t next = order_pool[idx].next;
+                emitCancelled(order_pool[idx], b.symbol(), out);
+                unlinkClient(idx);
+                unlinkExpiry(idx);
+                order_index.erase(order_pool[idx].order_id);
+                order_pool.release(idx);
+                n++;
+                idx = next;
+            }
+        }
+    }
+    b.clear();
+    return n;
+}
+
+size_t MatchingEngine::cancelAll(std::vector<EnvelopeOut>& out) {
+    size_t n = 0;
+    for (OrderBook* b : book_table) n += cancelBook(*b, out);
+    return n;
+}
+
+void MatchingEngine::linkClient(uint32_t idx) {
+    RestingOrder& r = order_pool[idx];
+    ClientOrders& c = client_orders[r.client_id];
+    r.client_prev = c.tail;
+    r.client_next = kNullIndex;
+    if (c.tail != kNullIndex) order_pool[c.tail].client_next = idx;
+    else                      c.head = idx;
+    c.tail = idx;
+}
+
+void MatchingEngine::unlinkClient(uint32_t idx) {
+    RestingOrder& r = order_pool[idx];
+    ClientOrders& c = client_orders[r.client_id];
+    if (r.client_prev != kNullIndex) order_pool[r.client_prev].client_next = r.client_next;
+    else                             c.head = r.client_next;
+    if (r.client_next != kNullIndex) order_pool[r.client_next].client_prev = r.client_prev;
+    else                             c.tail = r.client_prev;
+    r.client_prev = r.client_next = kNullIndex;
+}
+
+void MatchingEngine::linkExpiry(uint32_t idx) {
+    RestingOrder& r = order_pool[idx];
+    ExpiryList* list = nullptr;
+    if (r.tif == TimeInForce::Day)      list = &day_orders;
+    else if (r.tif == TimeInForce::GTD) list = &gtd_orders[r.expire_date];
+    if (!list) return;
+
+    r.expiry_prev = list->tail;
+    r.expiry_next = kNullIndex;
+    if (list->tail != kNullIndex) order_pool[list->tail].expiry_next = idx;
+    else                          list->head = idx;
+    list->tail = idx;
+}
+
+void MatchingEngine::unlinkExpiry(uint32_t idx) {
+    RestingOrder& r = order_pool[idx];
+    ExpiryList* list = nullptr;
+    auto gtd = gtd_orders.end();
+    if (r.tif == TimeInForce::Day) {
+        list = &day_orders;
+    } else if (r.tif == TimeInForce::GTD) {
+        gtd = gtd_orders.find(r.expire_date);
+        if (gtd != gtd_orders.end()) list = &gtd->second;
+    }
+    if (!list) return;
+
+    if (r.expiry_prev != kNullIndex) order_pool[r.expiry_prev].expiry_next = r.expiry_next;
+    else                             list->head = r.expiry_next;
+    if (r.expiry_next != kNullIndex) order_pool[r.expiry_next].expiry_prev = r.expiry_prev;
+    else                             list->tail = r.expiry_prev;
+    r.expiry_prev = r.expiry_next = kNullIndex;
+
+    if (gtd != gtd_orders.end() && list->head == kNullIndex) gtd_orders.erase(gtd);
+}
+
+size_t MatchingEngine::expire(uint32_t session_date, size_t max_orders, std::vector<EnvelopeOut>& out) {
+    size_t n = 0;
+    while (n < max_orders) {
+        uint32_t idx = day_orders.head;
+        if (idx == kNullIndex) {
+            if (gtd_orders.empty() || gtd_orders.begin()->first > session_date) break;
+            idx = gtd_orders.begin()->second.head;
+        }
+        emitCancelled(order_pool[idx], book_table[order_pool[idx].book]->symbol(), out);
+        removeResting(idx);
+        n++;
+    }
+    return n;
+}
+
+void MatchingEngine::removeResting(uint32_t idx) {
+    book_table[order_pool[idx].book]->remove(idx);
+    unlinkClient(idx);
+    unlinkExpiry(idx);
+    order_index.erase(order_pool[idx].order_id);
+    order_pool.release(idx);
+}
+
+void MatchingEngine::restore(OrderBook& b, const RestingOrder& r) {
+    const uint32_t idx = order_pool.allocate();
+    order_pool[idx] = r;
+    order_pool[idx].book = b.id();
+    b.appendSorted(idx);
+    linkClient(idx);
+    linkExpiry(idx);
+    order_index.emplace(r.order_id, idx);
+}
+
+void MatchingEngine::emitFill(OrderId order_id, ClientId client_id, const std::string& symbol,
+                              Side side, Qty qty, Price px, bool complete,
+                              std::vector<EnvelopeOut>& out) {
+    EnvelopeOut e;
+    e.header.type = MsgType::Fill;
+    e.header.client_id = client_id;
+    e.body = Fill{ order_id, symbol, side, qty, px, complete };
+    out.push_back(std::move(e));
+}
+
+void MatchingEngine::emitAuctionInfo(const AuctionInfo& info, std::vector<EnvelopeOut>& out) {
+    EnvelopeOut e;
+    e.header.type = MsgType::AuctionInfo;
+    e.body = info;
+    out.push_back(std::move(e));
+}
+
+void MatchingEngine::emitCancelled(const RestingOrder& r, const std::string& symbol,
+                                   std::vector<EnvelopeOut>& out) {
+    EnvelopeOut e;
+    e.header.type = MsgType::Cancelled;
+    e.header.client_id = r.client_id;
+    e.body = Cancelled{ r.order_id, r.client_order_id, symbol, r.side, r.qty + r.reserve };
+    out.push_back(std::move(e));
+}
+
+} // namespace ex
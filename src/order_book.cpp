@@ -0,0 +1,115 @@
+#include "order_book.hpp"
+#include <algorithm>
+
+namespace ex {
+
+void OrderBook::link(PriceLevel& level, uint32_t idx) {
+    RestingOrder& o = (*pool)[idx];
+    o.prev = level.tail;
+    o.next = kNullIndex;
+
+    if (level.tail != kNullIndex) {
+        (*pool)[level.tail].next = idx;
+    } else {
+        level.head = idx;
+    }
+    level.tail = idx;
+    level.total_qty += o.qty;
+    level.reserve_qty += o.reserve;
+    level.count++;
+}
+
+void OrderBook::append(uint32_t idx) {
+    const RestingOrder& o = (*pool)[idx];
+    link(home(o)[homeKey(o)], idx);
+}
+
+void OrderBook::appendSorted(uint32_t idx) {
+    const RestingOrder& o = (*pool)[idx];
+    Levels& side = home(o);
+    const Price key = homeKey(o);
+
+    auto it = side.empty() ? side.end() : std::prev(side.end());
+    if (it == side.end() || it->first != key) {
+        it = side.emplace_hint(side.end(), key, PriceLevel());
+    }
+    link(it->second, idx);
+}
+
+void OrderBook::remove(uint32_t idx) {
+    RestingOrder& o = (*pool)[idx];
+    Levels& side = home(o);
+
+    auto it = side.find(homeKey(o));
+    if (it == side.end()) return;
+    PriceLevel& level = it->second;
+
+    if (o.prev != kNullIndex) (*pool)[o.prev].next = o.next;
+    else                      level.head = o.next;
+
+    if (o.next != kNullIndex) (*pool)[o.next].prev = o.prev;
+    else                      level.tail = o.prev;
+
+    level.total_qty -= o.qty;
+    level.reserve_qty -= o.reserve;
+    level.count--;
+    o.prev = o.next = kNullIndex;
+
+    if (level.count == 0) side.erase(it);
+}
+
+void OrderBook::reduce(uint32_t idx, Qty by) {
+    RestingOrder& o = (*pool)[idx];
+    o.qty -= by;
+    home(o)[homeKey(o)].total_qty -= by;
+}
+
+void OrderBook::reduceReserve(uint32_t idx, Qty by) {
+    RestingOrder& o = (*pool)[idx];
+    o.reserve -= by;
+    home(o)[homeKey(o)].reserve_qty -= by;
+}
+
+void OrderBook::replenish(PriceLevel& level, uint32_t idx) {
+    RestingOrder& o = (*pool)[idx];
+    const Qty slice = std::min(o.display, o.reserve);
+    o.reserve -= slice;
+    o.qty = slice;
+    level.total_qty += slice;
+    level.reserve_qty -= slice;
+    if (o.next == kNullIndex) return;
+
+    // Relink at the tail without touching the map; the level keeps its count
+    if (o.prev != kNullIndex) (*pool)[o.prev].next = o.next;
+    else                      level.head = o.next;
+    (*pool)[o.next].prev = o.prev;
+
+    o.prev = level.tail;
+    o.next = kNullIndex;
+    (*pool)[level.tail].next = idx;
+    level.tail = idx;
+}
+
+void OrderBook::takeTriggered(Price last, std::vector<uint32_t>& fired) {
+    if (last <= 0) return; // no trade yet
+    auto take = [&](PriceLevel& level) {
+        for (uint32_t idx = level.head; idx != kNullIndex;) {
+            RestingOrder& o = (*pool)[idx];
+            const uint32_t next = o.next;
+            o.prev = o.next = kNullIndex;
+            fired.push_back(idx);
+            idx = next;
+        }
+    };
+
+    while (!buy_stops.empty() && buy_stops.begin()->first <= last) {
+        take(buy_stops.begin()->second);
+        buy_stops.erase(buy_stops.begin());
+    }
+    while (!sell_stops.empty() && std::prev(sell_stops.end())->first >= last) {
+        take(std::prev(sell_stops.end())->second);
+        sell_stops.erase(std::prev(sell_stops.end()));
+    }
+}
+
+} // namespace ex
@@ -4,24 +4,15 @@
 
 namespace ex {
 
-OrderGenerator::OrderGenerator(ThreadSafeQueue<std::string>* raw_queue,
+OrderGenerator::OrderGenerator(ThreadSafeQueue<InboundMessage>* raw_queue,
                                ThreadSafeQueue<Order>* order_queue,
-                               IdGenerator* id_gen,
-                               const std::string& out_port)
-    : context(1), 
-      raw_queue(raw_queue),
+                               EgressStage::Producer* egress, bool keep_raw)
+    : raw_queue(raw_queue),
       order_queue(order_queue),
-      id_generator(id_gen),
-      out_socket(context, zmq::socket_type::push),
+      egress(egress),
+      keep_raw(keep_raw),
       running(false) 
 {
-    // Connect to the internal "Out" port to send Acks
-    try{
-        out_socket.connect("tcp://localhost:" + out_port);
-        std::cout << "Output socket connected. Out:" << out_port << std::endl;
-    } catch (const zmq::error_t& e) {
-        std::cerr << "ZMQ Connect Error: " << e.what() << std::endl;
-    }
 }
 
 OrderGenerator::~OrderGenerator() {
@@ -30,7 +21,6 @@ OrderGenerator::~OrderGenerator() {
 
 void OrderGenerator::stop(){
     running = false;
-    out_socket.close();
 }
 
 void OrderGenerator::run() {
@@ -39,13 +29,24 @@ void OrderGenerator::run() {
 
     while (running) {
         try{
-            // Pop blocks until a raw JSON string is available from the InputStream
-            std::string raw_json = raw_queue->pop();
-            
-            Order o = convertToOrder(raw_json);
+            // Pop blocks until a sequenced message is available from a receiver
+            InboundMessage raw = raw_queue->pop();
             
-            if (o.quantity > 0) {
-                order_queue->push(std::move(o));
+            Order o = convertToOrder(raw.payload, raw.session);
+            o.global_seq = raw.seq;
+            o.timestamp = raw.recv_ns;
+
+            // Every number reaches the matching thread's reorder stage:
+            // heartbeats and unparseable messages go through as empty orders,
+            // and an order the full queue sheds is rejected to the client and
+            // replaced by one, at most one per worker past capacity.
+            // A refused order is left intact to answer.
+            if (keep_raw && o.type != MsgType::Heartbeat) o.raw = std::move(raw.payload);
+            if (!order_queue->tryPush(o)) {
+                if (o.type != MsgType::Heartbeat) sendOverloadReject(o);
+                Order placeholder;
+                placeholder.global_seq = o.global_seq;
+                order_queue->forcePush(std::move(placeholder));
             }
         } catch (const std::exception& e) {
             // Log the error but DO NOT let the thread exit
@@ -56,53 +57,113 @@ void OrderGenerator::run() {
     }
 }
 
-Order OrderGenerator::convertToOrder(const std::string& json_raw) {
-    try {
-        EnvelopeIn envelope = parse_inbound_envelope(json_raw);
-
-        if (std::holds_alternative<NewOrderRequest>(envelope.body)) {
-            const auto& req = std::get<NewOrderRequest>(envelope.body);
-
-            uint64_t internal_id = id_generator->next();
-            
-            // In a real HFT system, you'd pass a high-res timestamp from the receiver here
-            uint64_t ts = 0; 
+Order order_from_envelope(const EnvelopeIn& envelope) {
+    if (std::holds_alternative<NewOrderRequest>(envelope.body)) {
+        const auto& req = std::get<NewOrderRequest>(envelope.body);
+
+        // The matching thread assigns the internal id in sequence order,
+        // so ids do not depend on which worker finished first
+        Order o(req.client_order_id, 0, 0, req.symbol, 
+                req.side, envelope.header.type, req.limit_price, req.qty);
+        o.client_id = envelope.header.client_id;
+        o.seq = envelope.header.seq;
+        o.ord_type = req.ord_type;
+        o.tif = req.tif;
+        o.expire_date = req.expire_date;
+        o.display_qty = req.display_qty;
+        o.stop_price = static_cast<double>(req.stop_price);
+        o.stp = req.stp;
+
+        // Acked (or rejected) by the matching thread once risk checks pass
+        return o;
+    }
 
-            Order o(req.client_order_id, internal_id, ts, req.symbol, 
-                    req.side, envelope.header.type, req.limit_price, req.qty);
+    // Cancels, replaces and admin requests are answered by the matching thread
+    Order o;
+    o.type = envelope.header.type;
+    o.client_id = envelope.header.client_id;
+    o.seq = envelope.header.seq;
+
+    if (const auto* req = std::get_if<CancelRequest>(&envelope.body)) {
+        o.internal_order_id = req->order_id;
+        o.client_order_id = req->client_order_id;
+        o.symbol = req->symbol;
+    } else if (const auto* req = std::get_if<ReplaceRequest>(&envelope.body)) {
+        o.internal_order_id = req->order_id;
+        o.client_order_id = req->client_order_id;
+        o.symbol = req->symbol;
+        o.quantity = req->qty;
+        o.price = static_cast<double>(req->limit_price);
+    } else if (const auto* req = std::get_if<MassCancelRequest>(&envelope.body)) {
+        o.client_order_id = req->client_order_id;
+        o.cancel_scope = req->scope;
+        o.target_client_id = req->target_client_id;  // 0 = not named
+        o.symbol = req->symbol;
+    } else if (const auto* req = std::get_if<KillSwitchRequest>(&envelope.body)) {
+        o.client_order_id = req->client_order_id;
+        o.target_client_id = req->target_client_id;
+        o.kill_enabled = req->enabled;
+        o.cancel_open = req->cancel_open;
+    } else if (const auto* req = std::get_if<AuctionRequest>(&envelope.body)) {
+        o.client_order_id = req->client_order_id;
+        o.symbol = req->symbol;
+        o.auction_action = req->action;
+    } else if (const auto* req = std::get_if<EndOfSessionRequest>(&envelope.body)) {
+        o.client_order_id = req->client_order_id;
+        o.expire_date = req->session_date;
+    }
+    return o;
+}
 
-            // Prepare Ack
-            Ack ack_msg { req.client_order_id, internal_id, req.symbol };
-            EnvelopeOut response;
-            response.header = envelope.header;
-            response.header.type = MsgType::Ack;
-            response.body = ack_msg;
+Order OrderGenerator::convertToOrder(const std::string& json_raw, ClientId session) {
+    EnvelopeIn envelope;
+    const ParseFailure failure = try_parse_inbound_envelope(json_raw, envelope);
+    if (failure == ParseFailure::None) return order_from_envelope(envelope);
 
-            sendResponse(dump_envelope(response));
-            return o;
-        }
-        // Handle other alternatives (CancelRequest, etc.) here
-    } 
-    catch (const std::exception& e) {
-        std::cerr << "[WORKER] Parse Error: " << e.what() << std::endl;
-        
-        Reject rej_msg;
-        rej_msg.symbol = "UNKNOWN";
-        rej_msg.info.reason = e.what();
-
-        EnvelopeOut response;
-        response.header.type = MsgType::Reject;
-        response.body = rej_msg;
-
-        sendResponse(dump_envelope(response));
+    // A flood of these is logged once per worker and counted after that
+    if (parse_errors.fetch_add(1, std::memory_order_relaxed) == 0) {
+        std::cerr << "[WORKER] " << parse_failure_reason(failure)
+                  << " (further parse errors are counted, not logged)" << std::endl;
     }
+    sendParseReject(json_raw, failure, session);
     return Order();
 }
 
-void OrderGenerator::sendResponse(const std::string& message) {
-    zmq::message_t response(message.size());
-    memcpy(response.data(), message.data(), message.size());
-    out_socket.send(response, zmq::send_flags::none);
+void OrderGenerator::sendParseReject(const std::string& json_raw, ParseFailure failure, ClientId session) {
+    // Whatever ids the message carries, without a full parse; 0 where it has none
+    static constexpr char kClientOrderId[] = "\"client_order_id\"";
+    HeaderFields h;
+    scan_header(json_raw.data(), json_raw.size(), h);
+    uint64_t client_order_id = 0;
+    scan_uint_field(json_raw.data(), json_raw.size(), kClientOrderId, sizeof(kClientOrderId) - 1, client_order_id);
+    // A gateway session already knows its client, whatever the message says
+    const ClientId client_id = session ? session : h.has(HeaderFields::kClientId) ? h.client_id : 0;
+    const SeqNum seq = h.has(HeaderFields::kSeq) ? h.seq : 0;
+
+    std::string msg;
+    msg.reserve(parse_reject_template(failure).size() + 96);
+    append_parse_reject(msg, failure, client_order_id, client_id, seq);
+    sendResponse(client_id, std::move(msg));
+}
+
+void OrderGenerator::sendOverloadReject(const Order& o) {
+    Reject rej_msg;
+    rej_msg.client_order_id = o.client_order_id;
+    rej_msg.symbol = o.symbol;
+    rej_msg.info.reason = "Exchange overloaded";
+    rej_msg.info.code = to_u(RejectCode::Overloaded);
+
+    EnvelopeOut response;
+    response.header.type = MsgType::Reject;
+    response.header.seq = o.seq;
+    response.header.client_id = o.client_id;
+    response.body = rej_msg;
+
+    sendResponse(o.client_id, dump_envelope(response));
+}
+
+void OrderGenerator::sendResponse(ClientId client_id, std::string message) {
+    egress->send(client_id, std::move(message));
 }
 
 } // namespace ex
\ No newline at end of file
@@ -0,0 +1,323 @@
+#include "partition_router.hpp"
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <sys/stat.h>
+#include "net/codec_json.hpp"
+
+namespace ex {
+
+namespace {
+
+// Messages that may leave out the symbol and then apply to every book
+bool venueWide(MsgType type) {
+    switch (type) {
+        case MsgType::MassCancel:
+        case MsgType::KillSwitch:
+        case MsgType::Auction:
+        case MsgType::EndOfSession:
+        case MsgType::Heartbeat:
+            return true;
+        default:
+            return false;
+    }
+}
+
+} // namespace
+
+bool PartitionMap::load(const std::string& path, PartitionMap& out, std::string& error) {
+    std::ifstream in(path);
+    if (!in) {
+        error = "cannot open " + path;
+        return false;
+    }
+
+    PartitionMap m;
+    std::string line;
+    for (int line_no = 1; std::getline(in, line); ++line_no) {
+        const size_t hash = line.find('#');
+        if (hash != std::string::npos) line.resize(hash);
+        std::istringstream fields(line);
+        std::string endpoint;
+        if (!(fields >> endpoint)) continue;
+
+        const size_t index = m.endpoints.size();
+        m.endpoints.push_back(endpoint);
+        for (std::string symbol; fields >> symbol;) {
+            if (symbol == "*") {
+                if (m.fallback != kNone) {
+                    error = path + ":" + std::to_string(line_no) + ": second '*' partition";
+                    return false;
+                }
+                m.fallback = index;
+            } else if (m.owners.count(symbol)) {
+                error = path + ":" + std::to_string(line_no) + ": " + symbol + " is listed twice";
+                return false;
+            } else {
+                m.symbols.push_back(symbol);
+                m.owners.emplace(m.symbols.back(), index);
+            }
+        }
+    }
+    if (m.endpoints.empty()) {
+        error = path + ": no partitions";
+        return false;
+    }
+    out = std::move(m);
+    return true;
+}
+
+std::string PartitionMap::placement() const {
+    if (fallback != kNone) return "* " + endpoints[fallback];
+    // Named after the hash, so a record made with another one is refused
+    std::string out = "fnv1a";
+    for (const std::string& endpoint : endpoints) out += " " + endpoint;
+    return out;
+}
+
+PartitionRouter::PartitionRouter(zmq::context_t& context, const std::string& ingress, const std::string& map_path,
+                                 const std::string& answers, const std::string& egress)
+    : context(context),
+      in_socket(context, zmq::socket_type::pull),
+      answers_socket(context, zmq::socket_type::pull),
+      out_socket(context, zmq::socket_type::push),
+      merging(!answers.empty()),
+      map_path(map_path)
+{
+    try {
+        in_socket.set(zmq::sockopt::rcvhwm, 10000);
+        in_socket.bind(ingress);
+        if (merging) {
+            answers_socket.bind(answers);
+            out_socket.connect(egress);
+        }
+        std::cout << "[ROUTER] Front end bound. In:" << ingress
+                  << (merging ? " Answers:" + answers + " Out:" + egress : std::string()) << std::endl;
+    } catch (const zmq::error_t& e) {
+        std::cerr << "[ROUTER] Bind error: " << e.what() << std::endl;
+    }
+}
+
+bool PartitionRouter::checkPlacement(const std::string& placement, std::string& error) const {
+    const std::string path = map_path + ".placement";
+    std::ifstream in(path);
+    std::string recorded;
+    if (in && std::getline(in, recorded)) {
+        if (recorded == placement) return true;
+        error = "unlisted symbols would move from \"" + recorded + "\" to \"" + placement +
+                "\"; move their books, then delete " + path;
+        return false;
+    }
+    std::ofstream out(path);
+    if (!(out << placement << "\n")) {
+        error = "cannot write " + path;
+        return false;
+    }
+    return true;
+}
+
+bool PartitionRouter::load() {
+    struct stat st {};
+    if (::stat(map_path.c_str(), &st) == 0) map_mtime = st.st_mtime;
+
+    PartitionMap next;
+    std::string error;
+    if (!PartitionMap::load(map_path, next, error)) {
+        std::cerr << "[ROUTER] Partition map not loaded: " << error << std::endl;
+        return false;
+    }
+    // Listed symbols are moved one at a time, on purpose; a new hash or "*"
+    // partition would move every unlisted one and leave its book behind
+    if (!checkPlacement(next.placement(), error)) {
+        std::cerr << "[ROUTER] Partition map not loaded: " << error << std::endl;
+        return false;
+    }
+
+    std::vector<zmq::socket_t*> next_outputs;
+    for (const std::string& endpoint : next.endpoints) {
+        std::unique_ptr<zmq::socket_t>& socket = sockets[endpoint];
+        if (!socket) {
+            socket = std::make_unique<zmq::socket_t>(context, zmq::socket_type::push);
+            socket->connect(endpoint);
+        }
+        next_outputs.push_back(socket.get());
+    }
+    // Partitions dropped from the map keep their socket, and so whatever
+    // is still queued for them, until the process exits
+
+    map = std::move(next);
+    outputs = std::move(next_outputs);
+    pending.clear();
+    pending.resize(outputs.size());
+    partitions = outputs.size();
+    reloads.fetch_add(1, std::memory_order_relaxed);
+    std::cout << "[ROUTER] Partition map " << map_path << ": " << map.endpoints.size() << " partitions, "
+              << map.owners.size() << " symbols"
+              << (map.fallback != PartitionMap::kNone ? ", default " + map.endpoints[map.fallback] : std::string())
+              << std::endl;
+    return true;
+}
+
+void PartitionRouter::reloadIfChanged() {
+    struct stat st {};
+    if (::stat(map_path.c_str(), &st) != 0 || st.st_mtime == map_mtime) return;
+    load();
+}
+
+bool PartitionRouter::forward(zmq::recv_flags flags) {
+    zmq::message_t part;
+    if (!in_socket.recv(part, flags)) return false;
+
+    uint64_t to_one = 0, to_all = 0;
+    for (;;) {
+        const bool more = part.more();
+        if (part.size() > 0) {
+            HeaderFields h;
+            scan_header(static_cast<const char*>(part.data()), part.size(), h);
+            uint64_t order_id = 0;
+            if (h.has(HeaderFields::kSymbol) && !h.symbol.empty()) {
+                pending[map.partitionOf(h.symbol)].push_back(std::move(part));
+                ++to_one;
+            } else if (h.has(HeaderFields::kType) && (h.type == MsgType::Cancel || h.type == MsgType::Replace) &&
+                       scan_uint_field(static_cast<const char*>(part.data()), part.size(),
+                                       "\"order_id\"", 10, order_id)) {
+                // The order's id says which partition holds it
+                pending[map.partitionOfOrder(order_id)].push_back(std::move(part));
+                ++to_one;
+            } else if (!h.has(HeaderFields::kType) || !venueWide(h.type)) {
+                // Needs a symbol and has none: one partition rejects it
+                pending.front().push_back(std::move(part));
+                ++to_one;
+            } else {
+                for (auto& p : pending) p.emplace_back(part.data(), part.size());
+                if (merging && mergedAnswer(h.type)) expect(h.client_id, h.seq, pending.size());
+                ++to_all;
+            }
+        }
+        if (!more) break;
+        (void)in_socket.recv(part, zmq::recv_flags::none);
+    }
+
+    // Blocks while a partition is at its HWM, which pushes back on the clients
+    for (size_t i = 0; i < pending.size(); ++i) {
+        std::vector<zmq::message_t>& parts = pending[i];
+        for (size_t j = 0; j < parts.size(); ++j) {
+            outputs[i]->send(parts[j], j + 1 < parts.size() ? zmq::send_flags::sndmore : zmq::send_flags::none);
+        }
+        parts.clear();
+    }
+    forwarded.fetch_add(to_one, std::memory_order_relaxed);
+    broadcast.fetch_add(to_all, std::memory_order_relaxed);
+    return true;
+}
+
+void PartitionRouter::expect(ClientId client_id, SeqNum seq, size_t partitions) {
+    // A client reusing a seq before the first answer is out waits for both
+    Merge& m = merges[{client_id, seq}];
+    m.waiting += partitions;
+    m.deadline = std::chrono::steady_clock::now() + kMergeTimeout;
+}
+
+bool PartitionRouter::collect() {
+    zmq::message_t answer;
+    if (!answers_socket.recv(answer, zmq::recv_flags::dontwait)) return false;
+
+    const char* data = static_cast<const char*>(answer.data());
+    HeaderFields h;
+    scan_header(data, answer.size(), h);
+    auto it = merges.find({h.client_id, h.seq});
+    if (it == merges.end()) {
+        // Its request timed out already: late, but still the client's
+        out_socket.send(answer, zmq::send_flags::none);
+        return true;
+    }
+
+    Merge& m = it->second;
+    if (h.type == MsgType::Reject) {
+        if (m.reject.empty()) m.reject.assign(data, answer.size());
+    } else {
+        uint64_t v = 0;
+        if (scan_uint_field(data, answer.size(), "\"cancelled_count\"", 17, v)) m.cancelled += v;
+        if (scan_uint_field(data, answer.size(), "\"client_order_id\"", 17, v)) m.client_order_id = v;
+    }
+    ++m.answered;
+    if (--m.waiting == 0) {
+        reply(h.client_id, h.seq, m);
+        merges.erase(it);
+    }
+    return true;
+}
+
+void PartitionRouter::expireMerges(std::chrono::steady_clock::time_point now) {
+    for (auto it = merges.begin(); it != merges.end();) {
+        if (it->second.deadline > now) {
+            ++it;
+            continue;
+        }
+        std::cerr << "[ROUTER] Client " << it->first.first << " seq " << it->first.second << ": "
+                  << it->second.waiting << " partitions did not answer" << std::endl;
+        incomplete.fetch_add(1, std::memory_order_relaxed);
+        if (it->second.answered > 0) reply(it->first.first, it->first.second, it->second);
+        it = merges.erase(it);
+    }
+}
+
+void PartitionRouter::reply(ClientId client_id, SeqNum seq, const Merge& m) {
+    // Partitions share one admin list, so a Reject from one is everyone's
+    std::string out = m.reject;
+    if (out.empty()) {
+        EnvelopeOut e;
+        e.header.type = MsgType::MassCancelAck;
+        e.header.seq = seq;
+        e.header.client_id = client_id;
+        e.body = MassCancelAck{ m.client_order_id, m.cancelled };
+        out = dump_envelope(e);
+    }
+    out_socket.send(zmq::buffer(out), zmq::send_flags::none);
+    merged.fetch_add(1, std::memory_order_relaxed);
+}
+
+void PartitionRouter::run() {
+    running = true;
+    auto next_check = std::chrono::steady_clock::now();
+    while (running) {
+        try {
+            const auto now = std::chrono::steady_clock::now();
+            if (now >= next_check) {
+                reloadIfChanged();
+                expireMerges(now);
+                next_check = now + std::chrono::seconds(1);
+            }
+            if (outputs.empty()) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                continue;
+            }
+            // Drain what is there, then wait at most until the next map check
+            bool busy = merging && collect();
+            if (forward(zmq::recv_flags::dontwait)) busy = true;
+            if (busy) continue;
+            zmq::pollitem_t items[] = { { in_socket.handle(), 0, ZMQ_POLLIN, 0 },
+                                        { answers_socket.handle(), 0, ZMQ_POLLIN, 0 } };
+            zmq::poll(items, merging ? 2 : 1, std::chrono::milliseconds(100));
+        } catch (const zmq::error_t& e) {
+            if (e.num() == ETERM) {
+                running = false;
+            } else {
+                std::cerr << "[ROUTER] ZMQ error: " << e.what() << std::endl;
+            }
+        }
+    }
+}
+
+PartitionRouterCounters PartitionRouter::counters() const {
+    return PartitionRouterCounters{ forwarded.load(std::memory_order_relaxed),
+                                    broadcast.load(std::memory_order_relaxed),
+                                    reloads.load(std::memory_order_relaxed),
+                                    partitions.load(std::memory_order_relaxed),
+                                    merged.load(std::memory_order_relaxed),
+                                    incomplete.load(std::memory_order_relaxed) };
+}
+
+} // namespace ex
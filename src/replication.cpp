@@ -0,0 +1,335 @@
+#include "replication.hpp"
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <arpa/inet.h>
+#include <endian.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace ex {
+
+namespace {
+
+constexpr size_t kFrameHeader = 4 + 8 + 8;
+
+uint64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void putFrame(std::string& out, uint64_t seq, uint64_t recv_ns, const std::string& payload) {
+    char h[kFrameHeader];
+    const uint32_t len = htonl(static_cast<uint32_t>(payload.size()));
+    const uint64_t s = htobe64(seq);
+    const uint64_t t = htobe64(recv_ns);
+    std::memcpy(h, &len, 4);
+    std::memcpy(h + 4, &s, 8);
+    std::memcpy(h + 12, &t, 8);
+    out.append(h, kFrameHeader);
+    out.append(payload);
+}
+
+void setNoDelay(int fd) {
+    const int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// Primary
+// ---------------------------------------------------------------------------
+
+ReplicationPrimary::ReplicationPrimary(uint16_t port, size_t queue_capacity)
+    : port(port), queue(queue_capacity) {}
+
+ReplicationPrimary::~ReplicationPrimary() {
+    stop();
+    if (fd >= 0) ::close(fd);
+    if (listen_fd >= 0) ::close(listen_fd);
+}
+
+bool ReplicationPrimary::waitForBackup() {
+    listen_fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    const int one = 1;
+    ::setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if (::bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        ::listen(listen_fd, 1) != 0) {
+        std::cerr << "[REPL] Cannot listen on " << port << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    std::cout << "[REPL] Waiting for a backup on " << port << std::endl;
+    do {
+        fd = ::accept(listen_fd, nullptr, nullptr);
+    } while (fd < 0 && errno == EINTR);
+    if (fd < 0) {
+        std::cerr << "[REPL] Accept failed: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    setNoDelay(fd);
+    connected = true;
+    last_ack_ns = nowNs();
+    std::cout << "[REPL] Backup connected" << std::endl;
+    return true;
+}
+
+void ReplicationPrimary::start() {
+    running = true;
+    thread = std::thread(&ReplicationPrimary::run, this);
+}
+
+void ReplicationPrimary::stop() {
+    if (!running.exchange(false)) return;
+    thread.join();
+}
+
+void ReplicationPrimary::append(uint64_t seq, uint64_t recv_ns, std::string payload) {
+    ReplicationRecord r{ seq, recv_ns, std::move(payload) };
+    for (uint32_t spins = 0; !queue.tryPush(r); ++spins) {
+        if (spins >= kSpinPasses) std::this_thread::yield();
+    }
+    appended.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ReplicationPrimary::run() {
+    uint32_t idle = 0;
+    uint64_t last_write_ns = nowNs();
+    ReplicationRecord r;
+    while (running.load(std::memory_order_relaxed)) {
+        bool progress = false;
+
+        // Encode whatever the matching thread has appended, up to one write's worth
+        uint64_t framed = 0;
+        while (out.size() - out_pos < kMaxWrite && queue.tryPop(r)) {
+            if (connected.load(std::memory_order_relaxed)) putFrame(out, r.seq, r.recv_ns, r.payload);
+            ++framed;
+        }
+        if (framed) {
+            sent.fetch_add(framed, std::memory_order_relaxed);
+            progress = true;
+        }
+
+        if (connected.load(std::memory_order_relaxed)) {
+            const uint64_t now = nowNs();
+            if (now - last_ack_ns >= kAckTimeoutNs) {
+                lost("no ack within the timeout");
+                continue;
+            }
+            const uint64_t released = released_seq ? released_seq->load(std::memory_order_acquire) : 0;
+            if (released != reported || (out_pos == out.size() && now - last_write_ns >= kHeartbeatNs)) {
+                putFrame(out, 0, released, std::string());
+                reported = released;
+            }
+            if (out_pos < out.size()) {
+                last_write_ns = now;
+                if (!writeOut()) continue;
+            }
+            if (!readAcks()) continue;
+        } else {
+            out.clear();
+            out_pos = 0;
+        }
+
+        if (progress) {
+            idle = 0;
+        } else if (++idle >= kYieldPasses) {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        } else if (idle >= kSpinPasses) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+bool ReplicationPrimary::writeOut() {
+    while (out_pos < out.size()) {
+        const ssize_t n = ::send(fd, out.data() + out_pos, out.size() - out_pos, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n > 0) {
+            out_pos += static_cast<size_t>(n);
+            writes.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        lost("write failed");
+        return false;
+    }
+    if (out_pos == out.size()) {
+        out.clear();
+        out_pos = 0;
+    }
+    return true;
+}
+
+bool ReplicationPrimary::readAcks() {
+    for (;;) {
+        const ssize_t n = ::recv(fd, ack_buf + ack_len, sizeof(ack_buf) - ack_len, MSG_DONTWAIT);
+        if (n > 0) {
+            ack_len += static_cast<size_t>(n);
+            // Only the newest complete ack matters
+            const size_t complete = ack_len / 8 * 8;
+            if (complete > 0) {
+                last_ack_ns = nowNs();
+                uint64_t be;
+                std::memcpy(&be, ack_buf + complete - 8, 8);
+                acked.store(be64toh(be), std::memory_order_release);
+                std::memmove(ack_buf, ack_buf + complete, ack_len - complete);
+                ack_len -= complete;
+            }
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return true;
+        lost(n == 0 ? "connection closed" : "read failed");
+        return false;
+    }
+}
+
+void ReplicationPrimary::lost(const char* why) {
+    // The backup may be taking over, so nothing it has not seen may leave
+    std::cerr << "[REPL] Backup lost (" << why << "), fencing this primary" << std::endl;
+    is_fenced.store(true, std::memory_order_release);
+    connected = false;
+    ::close(fd);
+    fd = -1;
+    out.clear();
+    out_pos = 0;
+    if (fence_action) fence_action();
+}
+
+ReplicationCounters ReplicationPrimary::counters() const {
+    return ReplicationCounters{ connected.load(std::memory_order_relaxed),
+                                appended.load(std::memory_order_relaxed),
+                                sent.load(std::memory_order_relaxed),
+                                writes.load(std::memory_order_relaxed),
+                                acked.load(std::memory_order_relaxed) };
+}
+
+// ---------------------------------------------------------------------------
+// Backup
+// ---------------------------------------------------------------------------
+
+ReplicationBackup::~ReplicationBackup() {
+    if (fd >= 0) ::close(fd);
+}
+
+bool ReplicationBackup::connect(const std::string& host, uint16_t port) {
+    addrinfo hints{};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* res = nullptr;
+    if (::getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &res) != 0 || !res) {
+        std::cerr << "[REPL] Cannot resolve " << host << std::endl;
+        return false;
+    }
+    fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    const int rc = ::connect(fd, res->ai_addr, res->ai_addrlen);
+    ::freeaddrinfo(res);
+    if (rc != 0) {
+        std::cerr << "[REPL] Cannot reach primary at " << host << ":" << port << ": "
+                  << std::strerror(errno) << std::endl;
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+    setNoDelay(fd);
+    last_heard_ns = nowNs();
+    std::cout << "[REPL] Following primary at " << host << ":" << port << std::endl;
+    return true;
+}
+
+bool ReplicationBackup::receive(std::vector<ReplicationRecord>& out, int silence_timeout_ms) {
+    if (fd < 0) return false;
+
+    pollfd p{ fd, POLLIN, 0 };
+    int rc;
+    do {
+        rc = ::poll(&p, 1, silence_timeout_ms);
+    } while (rc < 0 && errno == EINTR);
+    if (rc == 0) {
+        std::cerr << "[REPL] Primary silent for " << silence_timeout_ms << " ms" << std::endl;
+        return false;
+    }
+
+    // What arrived before the primary went still counts
+    bool gone = false;
+    char buf[64 * 1024];
+    for (;;) {
+        const ssize_t n = ::recv(fd, buf, sizeof(buf), MSG_DONTWAIT);
+        if (n > 0) {
+            in.append(buf, static_cast<size_t>(n));
+            last_heard_ns = nowNs();
+            if (static_cast<size_t>(n) < sizeof(buf)) break;
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        std::cerr << "[REPL] Primary " << (n == 0 ? "closed the connection" : "connection failed") << std::endl;
+        gone = true;
+        break;
+    }
+
+    size_t pos = 0;
+    while (in.size() - pos >= kFrameHeader) {
+        uint32_t len;
+        uint64_t seq, recv_ns;
+        std::memcpy(&len, in.data() + pos, 4);
+        std::memcpy(&seq, in.data() + pos + 4, 8);
+        std::memcpy(&recv_ns, in.data() + pos + 12, 8);
+        len = ntohl(len);
+        if (in.size() - pos - kFrameHeader < len) break;
+        seq = be64toh(seq);
+        if (seq != 0) {
+            out.push_back(ReplicationRecord{ seq, be64toh(recv_ns), in.substr(pos + kFrameHeader, len) });
+            last_seq = seq;
+        } else if (be64toh(recv_ns) > released_seq.load(std::memory_order_relaxed)) {
+            released_seq.store(be64toh(recv_ns), std::memory_order_release);
+        }
+        pos += kFrameHeader + len;
+    }
+    in.erase(0, pos);
+
+    if (gone) {
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+
+    // One ack for everything this read brought in; heartbeats too, which
+    // is how an idle primary knows its backup is alive
+    if (pos > 0) {
+        const uint64_t be = htobe64(last_seq);
+        if (::send(fd, &be, sizeof(be), MSG_NOSIGNAL) != static_cast<ssize_t>(sizeof(be))) {
+            std::cerr << "[REPL] Cannot ack the primary" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+void ReplicationBackup::awaitFence() {
+    const uint64_t quiet_ns = kTakeoverMs * 1000000ull;
+    const uint64_t waited = nowNs() - last_heard_ns;
+    if (waited < quiet_ns) {
+        std::cout << "[REPL] Waiting " << (quiet_ns - waited) / 1000000 << " ms for the primary to fence itself"
+                  << std::endl;
+        std::this_thread::sleep_for(std::chrono::nanoseconds(quiet_ns - waited));
+    }
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+} // namespace ex
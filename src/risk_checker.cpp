@@ -0,0 +1,127 @@
+#include "risk_checker.hpp"
+#include <cstdlib>
+
+namespace ex {
+
+namespace {
+
+// price * qty > limit, without overflowing for any price or quantity
+bool exceedsNotional(Price px, Qty qty, int64_t limit) {
+    return static_cast<__int128>(px) * qty > limit;
+}
+
+// Limit price on an order type that has one, stop price on one that has one
+bool validPrices(const Order& o) {
+    const bool has_limit = o.ord_type == OrdType::Limit || o.ord_type == OrdType::StopLimit;
+    const bool has_stop = o.ord_type == OrdType::Stop || o.ord_type == OrdType::StopLimit;
+    return (!has_limit || o.price > 0) && (!has_stop || o.stop_price > 0);
+}
+
+// |px - last| more than bps basis points away from last, in 128 bits for the
+// same reason
+bool outsideCollar(Price px, Price last, int64_t bps) {
+    const __int128 distance = static_cast<__int128>(px) - last;
+    return (distance < 0 ? -distance : distance) * 10000 > static_cast<__int128>(bps) * last;
+}
+
+} // namespace
+
+ClientRiskState& RiskChecker::stateFor(ClientId client_id) {
+    auto it = clients.find(client_id);
+    if (it == clients.end()) {
+        it = clients.emplace(client_id, ClientRiskState()).first;
+        it->second.limits = default_limits;
+    }
+    return it->second;
+}
+
+void RiskChecker::setLimits(ClientId client_id, const RiskLimits& limits) {
+    stateFor(client_id).limits = limits;
+}
+
+const ClientRiskState* RiskChecker::state(ClientId client_id) const {
+    auto it = clients.find(client_id);
+    return it == clients.end() ? nullptr : &it->second;
+}
+
+RejectCode RiskChecker::check(const Order& o, Price last_trade) {
+    ClientRiskState& s = stateFor(o.client_id);
+    const RiskLimits& l = s.limits;
+    const Qty qty = o.quantity;
+    // Market orders have no price of their own; size them at the last trade,
+    // or at the stop price for a stop that becomes a market order
+    const bool is_market = o.ord_type == OrdType::Market || o.ord_type == OrdType::Stop;
+    const Price px = o.ord_type == OrdType::Stop ? static_cast<Price>(o.stop_price)
+                   : is_market ? last_trade : static_cast<Price>(o.price);
+
+    if (s.blocked) return RejectCode::KillSwitch;
+    if (qty <= 0 || qty > kMaxQty || o.display_qty < 0 || o.display_qty > kMaxQty || !validPrices(o)) {
+        return RejectCode::InvalidOrder;
+    }
+    if (l.max_order_qty && qty > l.max_order_qty) return RejectCode::MaxOrderQty;
+    if (l.max_notional && px <= 0) return RejectCode::NoReferencePrice;
+    if (l.max_notional && exceedsNotional(px, qty, l.max_notional)) return RejectCode::MaxNotional;
+    if (l.price_collar_bps && last_trade > 0 && !is_market &&
+        outsideCollar(px, last_trade, l.price_collar_bps)) {
+        return RejectCode::PriceCollar;
+    }
+    if (l.max_open_orders && s.open_orders >= l.max_open_orders) return RejectCode::MaxOpenOrders;
+    if (l.max_gross_position &&
+        std::llabs(s.position) + s.open_buy_qty + s.open_sell_qty + qty > l.max_gross_position) {
+        return RejectCode::MaxGrossPosition;
+    }
+
+    s.open_orders++;
+    (o.side == Side::Buy ? s.open_buy_qty : s.open_sell_qty) += qty;
+    return RejectCode::None;
+}
+
+RejectCode RiskChecker::checkReplace(const Order& o, Side side, Qty open_qty, Price last_trade) {
+    ClientRiskState& s = stateFor(o.client_id);
+    const RiskLimits& l = s.limits;
+    const Qty qty = o.quantity;
+    const Price px = static_cast<Price>(o.price);
+    const Qty delta = qty - open_qty;
+
+    if (s.blocked) return RejectCode::KillSwitch;
+    if (qty <= 0 || qty > kMaxQty || px <= 0) return RejectCode::InvalidReplace;
+    if (l.max_order_qty && qty > l.max_order_qty) return RejectCode::MaxOrderQty;
+    if (l.max_notional && exceedsNotional(px, qty, l.max_notional)) return RejectCode::MaxNotional;
+    if (l.price_collar_bps && last_trade > 0 &&
+        outsideCollar(px, last_trade, l.price_collar_bps)) {
+        return RejectCode::PriceCollar;
+    }
+    if (l.max_gross_position && delta > 0 &&
+        std::llabs(s.position) + s.open_buy_qty + s.open_sell_qty + delta > l.max_gross_position) {
+        return RejectCode::MaxGrossPosition;
+    }
+
+    (side == Side::Buy ? s.open_buy_qty : s.open_sell_qty) += delta;
+    return RejectCode::None;
+}
+
+void RiskChecker::onFill(ClientId client_id, Side side, Qty qty, bool complete) {
+    ClientRiskState& s = stateFor(client_id);
+    if (side == Side::Buy) {
+        s.open_buy_qty -= qty;
+        s.position += qty;
+    } else {
+        s.open_sell_qty -= qty;
+        s.position -= qty;
+    }
+    if (complete && s.open_orders > 0) s.open_orders--;
+}
+
+void RiskChecker::onCancel(ClientId client_id, Side side, Qty qty, bool complete) {
+    ClientRiskState& s = stateFor(client_id);
+    (side == Side::Buy ? s.open_buy_qty : s.open_sell_qty) -= qty;
+    if (complete && s.open_orders > 0) s.open_orders--;
+}
+
+void RiskChecker::onResting(ClientId client_id, Side side, Qty open_qty) {
+    ClientRiskState& s = stateFor(client_id);
+    (side == Side::Buy ? s.open_buy_qty : s.open_sell_qty) += open_qty;
+    s.open_orders++;
+}
+
+} // namespace ex
@@ -0,0 +1,78 @@
+#include "shm_gateway.hpp"
+#include <iostream>
+#include "core/message.hpp"
+#include "net/codec_json.hpp"
+#include "net/shm_client.hpp"
+
+namespace ex {
+
+ShmGateway::ShmGateway(const std::vector<ClientId>& clients, uint32_t slots_per_ring,
+                       uint64_t heartbeat_timeout_ns)
+    : heartbeat_timeout_ns(heartbeat_timeout_ns)
+{
+    for (ClientId client_id : clients) {
+        auto s = std::make_unique<Session>();
+        s->client_id = client_id;
+        if (!s->in.create(shm_ingress_name(client_id), slots_per_ring, ShmRole::Consumer) ||
+            !s->out.create(shm_egress_name(client_id), slots_per_ring, ShmRole::Producer)) {
+            std::cerr << "[SHM] Session for client " << client_id << " not available" << std::endl;
+            continue;
+        }
+        std::cout << "[SHM] Session ready for client " << client_id << ": "
+                  << s->in.shmName() << ", " << s->out.shmName() << std::endl;
+        sessions.push_back(std::move(s));
+    }
+    housekeeping();
+}
+
+bool ShmGateway::send(ClientId client_id, const std::string& msg) {
+    for (auto& s : sessions) {
+        if (s->client_id != client_id) continue;
+        write(*s, msg);
+        return true;
+    }
+    return false;
+}
+
+void ShmGateway::write(Session& s, const std::string& msg) {
+    while (s.out_lock.test_and_set(std::memory_order_acquire)) {}
+    const ShmWrite written = s.out.write(msg.data(), msg.size());
+    s.out_lock.clear(std::memory_order_release);
+
+    if (written == ShmWrite::Ok) return;
+    s.dropped.fetch_add(1, std::memory_order_relaxed);
+    if (written == ShmWrite::TooLarge) {
+        std::cerr << "[SHM] Response of " << msg.size() << " bytes is larger than client "
+                  << s.client_id << "'s ring, dropped" << std::endl;
+    }
+}
+
+bool ShmGateway::admits(Session& s, const char* data, size_t len) {
+    HeaderFields h;
+    scan_header(data, len, h);
+    if (h.has(HeaderFields::kClientId) && h.client_id == s.client_id) return true;
+
+    // Same answer as the TCP gateway gives a frame for another client
+    const RejectCode code = h.has(HeaderFields::kClientId) ? RejectCode::NotAuthorized : RejectCode::ParseError;
+    write(s, dump_frame_reject(code, s.client_id, h.has(HeaderFields::kSeq) ? h.seq : 0, data, len));
+    s.rejected.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+void ShmGateway::housekeeping() {
+    const uint64_t now = shm_now_ns();
+    for (auto& s : sessions) {
+        s->in.consumerHeartbeat(now);
+        // The producer heartbeat field is a single store; no lock needed
+        s->out.producerHeartbeat(now);
+
+        const bool alive = now - s->in.producerHeartbeatNs() < heartbeat_timeout_ns;
+        if (alive != s->alive.load(std::memory_order_relaxed)) {
+            s->alive.store(alive, std::memory_order_relaxed);
+            std::cout << "[SHM] Client " << s->client_id << (alive ? " connected" : " heartbeat lost")
+                      << std::endl;
+        }
+    }
+}
+
+} // namespace ex
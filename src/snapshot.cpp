@@ -0,0 +1,279 @@
+#include "snapshot.hpp"
+#include <array>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace ex {
+
+namespace {
+
+// Owns a mapping for the lifetime of a snapshot read or write.
+struct MappedFile {
+    int fd = -1;
+    void* addr = MAP_FAILED;
+    size_t size = 0;
+
+    ~MappedFile() {
+        if (addr != MAP_FAILED) munmap(addr, size);
+        if (fd >= 0) close(fd);
+    }
+
+    char* data() const { return static_cast<char*>(addr); }
+};
+
+// Snapshot order of a book's level maps
+std::array<const OrderBook::Levels*, 4> levelMaps(const OrderBook& b) {
+    return {&b.levels(Side::Buy), &b.levels(Side::Sell), &b.stops(Side::Buy), &b.stops(Side::Sell)};
+}
+
+uint64_t countOrders(const OrderBook& b) {
+    uint64_t n = 0;
+    for (const OrderBook::Levels* side : levelMaps(b)) {
+        for (const auto& [px, level] : *side) {
+            (void)px;
+            n += level.count;
+        }
+    }
+    return n;
+}
+
+// Enum fields within their ranges, so a corrupt file cannot put an
+// out-of-range side or order type on a book
+bool validOrder(const SnapshotOrder& so) {
+    return (so.side == to_u(Side::Buy) || so.side == to_u(Side::Sell)) &&
+           so.ord_type >= to_u(OrdType::Market) && so.ord_type <= to_u(OrdType::StopLimit) &&
+           so.tif >= to_u(TimeInForce::Day) && so.tif <= to_u(TimeInForce::GTD) &&
+           so.stp <= to_u(StpMode::Decrement) && so.qty >= 0 && so.reserve >= 0;
+}
+
+} // namespace
+
+bool writeSnapshot(const std::string& path, const MatchingEngine& engine, uint64_t last_order_id,
+                   uint64_t last_seq) {
+    const auto& books = engine.books();
+    const OrderPool& pool = engine.pool();
+
+    uint64_t order_count = 0;
+    uint64_t symbol_bytes = 0;
+    for (const auto& [symbol, b] : books) {
+        order_count += countOrders(b);
+        symbol_bytes += symbol.size();
+    }
+
+    SnapshotHeader hdr{};
+    std::memcpy(hdr.magic, kSnapshotMagic, sizeof(hdr.magic));
+    hdr.version = kSnapshotVersion;
+    hdr.book_count = static_cast<uint32_t>(books.size());
+    hdr.order_count = order_count;
+    hdr.last_order_id = last_order_id;
+    hdr.last_seq = last_seq;
+    hdr.books_offset = sizeof(SnapshotHeader);
+    hdr.orders_offset = hdr.books_offset + books.size() * sizeof(SnapshotBook);
+    hdr.symbols_offset = hdr.orders_offset + order_count * sizeof(SnapshotOrder);
+    hdr.file_size = hdr.symbols_offset + symbol_bytes;
+
+    const std::string tmp_path = path + ".tmp";
+    MappedFile f;
+    f.fd = open(tmp_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (f.fd < 0 || ftruncate(f.fd, static_cast<off_t>(hdr.file_size)) != 0) {
+        std::cerr << "[SNAPSHOT] Cannot create " << tmp_path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    f.size = hdr.file_size;
+    f.addr = mmap(nullptr, f.size, PROT_READ | PROT_WRITE, MAP_SHARED, f.fd, 0);
+    if (f.addr == MAP_FAILED) {
+        std::cerr << "[SNAPSHOT] mmap failed: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    char* base = f.data();
+    auto* out_books = reinterpret_cast<SnapshotBook*>(base + hdr.books_offset);
+    auto* out_orders = reinterpret_cast<SnapshotOrder*>(base + hdr.orders_offset);
+    char* out_symbols = base + hdr.symbols_offset;
+
+    uint64_t next_order = 0;
+    uint64_t next_symbol = 0;
+    for (const auto& [symbol, b] : books) {
+        SnapshotBook& sb = *out_books++;
+        sb.symbol_offset = hdr.symbols_offset + next_symbol;
+        sb.symbol_len = static_cast<uint32_t>(symbol.size());
+        sb.flags = b.inAuction() ? kSnapshotBookAuction : 0;
+        sb.first_order = next_order;
+        std::memcpy(out_symbols + next_symbol, symbol.data(), symbol.size());
+        next_symbol += symbol.size();
+
+        sb.last_trade = b.lastTradePrice();
+        for (const OrderBook::Levels* side : levelMaps(b)) {
+            for (const auto& [px, level] : *side) {
+                (void)px;
+                for (uint32_t idx = level.head; idx != kNullIndex; idx = pool[idx].next) {
+                    const RestingOrder& r = pool[idx];
+                    SnapshotOrder& so = out_orders[next_order++];
+                    so = SnapshotOrder{};
+                    so.order_id = r.order_id;
+                    so.client_order_id = r.client_order_id;
+                    so.timestamp = r.timestamp;
+                    so.price = r.price;
+                    so.qty = r.qty;
+                    so.reserve = r.reserve;
+                    so.display = r.display;
+                    so.client_id = r.client_id;
+                    so.stop_price = r.stop_price;
+                    so.side = to_u(r.side);
+                    so.ord_type = to_u(r.ord_type);
+                    so.stp = to_u(r.stp);
+                    so.tif = to_u(r.tif);
+                    so.expire_date = r.expire_date;
+                }
+            }
+        }
+        sb.order_count = next_order - sb.first_order;
+    }
+
+    // Header last, so a partially written image never carries valid magic
+    std::memcpy(base, &hdr, sizeof(hdr));
+
+    if (msync(f.addr, f.size, MS_SYNC) != 0 || std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        std::cerr << "[SNAPSHOT] Failed to commit " << path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+SnapshotWriter::~SnapshotWriter() {
+    reap(true);
+}
+
+bool SnapshotWriter::start(const MatchingEngine& engine, uint64_t last_order_id, uint64_t last_seq) {
+    reap(false);
+    if (child > 0) {
+        ++skipped;
+        return false;
+    }
+    const pid_t pid = fork();
+    if (pid == 0) {
+        _exit(writeSnapshot(path, engine, last_order_id, last_seq) ? 0 : 1);
+    }
+    if (pid < 0) {
+        std::cerr << "[SNAPSHOT] fork failed: " << std::strerror(errno) << std::endl;
+        ++failed;
+        return false;
+    }
+    child = pid;
+    return true;
+}
+
+SnapshotWriterCounters SnapshotWriter::counters() {
+    reap(false);
+    return {written, failed, skipped};
+}
+
+void SnapshotWriter::reap(bool wait) {
+    if (child <= 0) return;
+    int status = 0;
+    pid_t r;
+    do {
+        r = waitpid(child, &status, wait ? 0 : WNOHANG);
+    } while (r < 0 && errno == EINTR);
+    if (r == 0) return;  // still writing
+    child = -1;
+    if (r > 0 && WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+        ++written;
+    } else {
+        ++failed;
+    }
+}
+
+bool loadSnapshot(const std::string& path, MatchingEngine& engine, uint64_t& last_order_id, uint64_t& last_seq) {
+    MappedFile f;
+    f.fd = open(path.c_str(), O_RDONLY);
+    if (f.fd < 0) return false;
+
+    struct stat st;
+    if (fstat(f.fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(SnapshotHeader)) {
+        std::cerr << "[SNAPSHOT] " << path << " is truncated" << std::endl;
+        return false;
+    }
+    f.size = static_cast<size_t>(st.st_size);
+    f.addr = mmap(nullptr, f.size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, f.fd, 0);
+    if (f.addr == MAP_FAILED) {
+        std::cerr << "[SNAPSHOT] mmap failed: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    madvise(f.addr, f.size, MADV_SEQUENTIAL);
+
+    const char* base = f.data();
+    SnapshotHeader hdr;
+    std::memcpy(&hdr, base, sizeof(hdr));
+    // Each region is checked by dividing the space it has, never by
+    // multiplying a count from the file, which could wrap past the check
+    if (std::memcmp(hdr.magic, kSnapshotMagic, sizeof(hdr.magic)) != 0 ||
+        hdr.version != kSnapshotVersion || hdr.file_size != f.size ||
+        hdr.books_offset < sizeof(SnapshotHeader) || hdr.books_offset > hdr.orders_offset ||
+        hdr.orders_offset > hdr.symbols_offset || hdr.symbols_offset > f.size ||
+        hdr.book_count > (hdr.orders_offset - hdr.books_offset) / sizeof(SnapshotBook) ||
+        hdr.order_count > (hdr.symbols_offset - hdr.orders_offset) / sizeof(SnapshotOrder)) {
+        std::cerr << "[SNAPSHOT] " << path << " has an invalid header" << std::endl;
+        return false;
+    }
+
+    const auto* in_books = reinterpret_cast<const SnapshotBook*>(base + hdr.books_offset);
+    const auto* in_orders = reinterpret_cast<const SnapshotOrder*>(base + hdr.orders_offset);
+
+    for (uint32_t i = 0; i < hdr.book_count; ++i) {
+        const SnapshotBook& sb = in_books[i];
+        if (sb.symbol_offset < hdr.symbols_offset || sb.symbol_offset > f.size ||
+            sb.symbol_len > f.size - sb.symbol_offset || sb.first_order > hdr.order_count ||
+            sb.order_count > hdr.order_count - sb.first_order || (sb.flags & ~kSnapshotBookAuction) != 0) {
+            std::cerr << "[SNAPSHOT] " << path << " has a corrupt book entry" << std::endl;
+            return false;
+        }
+    }
+    for (uint64_t k = 0; k < hdr.order_count; ++k) {
+        if (!validOrder(in_orders[k])) {
+            std::cerr << "[SNAPSHOT] " << path << " has a corrupt order entry at " << k << std::endl;
+            return false;
+        }
+    }
+
+    engine.reserve(hdr.order_count);
+    for (uint32_t i = 0; i < hdr.book_count; ++i) {
+        const SnapshotBook& sb = in_books[i];
+        OrderBook& b = engine.book(std::string(base + sb.symbol_offset, sb.symbol_len));
+        b.setLastTrade(sb.last_trade);
+        b.setAuction((sb.flags & kSnapshotBookAuction) != 0);
+
+        for (uint64_t k = sb.first_order; k < sb.first_order + sb.order_count; ++k) {
+            const SnapshotOrder& so = in_orders[k];
+            RestingOrder r;
+            r.order_id = so.order_id;
+            r.client_order_id = so.client_order_id;
+            r.timestamp = so.timestamp;
+            r.price = so.price;
+            r.qty = so.qty;
+            r.reserve = so.reserve;
+            r.display = so.display;
+            r.client_id = so.client_id;
+            r.stop_price = so.stop_price;
+            r.side = static_cast<Side>(so.side);
+            r.ord_type = static_cast<OrdType>(so.ord_type);
+            r.stp = static_cast<StpMode>(so.stp);
+            r.tif = static_cast<TimeInForce>(so.tif);
+            r.expire_date = so.expire_date;
+            engine.restore(b, r);
+        }
+    }
+
+    last_order_id = hdr.last_order_id;
+    last_seq = hdr.last_seq;
+    return true;
+}
+
+} // namespace ex
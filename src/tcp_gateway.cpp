@@ -0,0 +1,322 @@
+#include "tcp_gateway.hpp"
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include "core/message.hpp"
+#include "net/codec_json.hpp"
+
+namespace ex {
+
+TcpGateway::TcpGateway(Sequencer* sequencer, const TcpGatewayConfig& config)
+    : sequencer(sequencer), config(config) {}
+
+TcpGateway::~TcpGateway() {
+    stop();
+}
+
+bool TcpGateway::start() {
+    listen_fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    const int one = 1;
+    ::setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(config.port);
+    if (::bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        ::listen(listen_fd, SOMAXCONN) != 0) {
+        std::cerr << "[GATEWAY] Cannot listen on " << config.port << ": " << std::strerror(errno) << std::endl;
+        ::close(listen_fd);
+        listen_fd = -1;
+        return false;
+    }
+
+    running = true;
+    for (uint32_t i = 0; i < config.io_threads; ++i) {
+        auto io = std::make_unique<IoThread>();
+        io->epfd = ::epoll_create1(0);
+        io->thread = std::thread(&TcpGateway::ioLoop, this, std::ref(*io));
+        io_threads.push_back(std::move(io));
+    }
+    acceptor = std::thread(&TcpGateway::acceptLoop, this);
+
+    std::cout << "[GATEWAY] Listening on " << config.port << " (" << config.io_threads << " io threads)" << std::endl;
+    return true;
+}
+
+void TcpGateway::stop() {
+    if (!running.exchange(false)) return;
+
+    ::shutdown(listen_fd, SHUT_RDWR);   // wakes accept()
+    ::close(listen_fd);
+    acceptor.join();
+
+    for (auto& io : io_threads) {
+        io->thread.join();
+        for (auto& [fd, s] : io->sessions) {
+            (void)fd;
+            std::lock_guard<std::mutex> lock(s->out_mtx);
+            s->closed = true;
+            ::close(s->fd);
+        }
+        io->sessions.clear();
+        ::close(io->epfd);
+    }
+    io_threads.clear();
+
+    std::unique_lock<std::shared_mutex> lock(routes_mtx);
+    routes.clear();
+}
+
+void TcpGateway::acceptLoop() {
+    while (running) {
+        const int fd = ::accept(listen_fd, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            if (errno == EMFILE || errno == ENFILE) {
+                std::cerr << "[GATEWAY] Out of file descriptors" << std::endl;
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                continue;
+            }
+            break; // listen socket closed by stop()
+        }
+
+        // Least loaded io thread; refuse once all are full
+        IoThread* target = nullptr;
+        size_t least = config.max_sessions_per_thread;
+        for (auto& io : io_threads) {
+            std::lock_guard<std::mutex> lock(io->sessions_mtx);
+            if (io->sessions.size() < least) {
+                least = io->sessions.size();
+                target = io.get();
+            }
+        }
+        if (!target) {
+            ::close(fd);
+            dropped_sessions.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+        const int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        auto s = std::make_shared<Session>();
+        s->fd = fd;
+        bool inserted;
+        {
+            std::lock_guard<std::mutex> lock(target->sessions_mtx);
+            inserted = target->sessions.emplace(fd, s).second;
+        }
+        if (!inserted) {
+            // An fd still in the map was closed without leaving it; epoll
+            // would point at two sessions for one number
+            std::cerr << "[GATEWAY] fd " << fd << " is already in use by a session" << std::endl;
+            ::close(fd);
+            dropped_sessions.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        ev.data.ptr = s.get();
+        ::epoll_ctl(target->epfd, EPOLL_CTL_ADD, fd, &ev);
+
+        active.fetch_add(1, std::memory_order_relaxed);
+        accepted.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void TcpGateway::ioLoop(IoThread& io) {
+    epoll_event events[256];
+    while (running) {
+        const int n = ::epoll_wait(io.epfd, events, 256, 100);
+        for (int i = 0; i < n; ++i) {
+            Session& s = *static_cast<Session*>(events[i].data.ptr);
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                close(io, s);
+                continue;
+            }
+            if ((events[i].events & (EPOLLIN | EPOLLRDHUP)) && !onReadable(io, s)) continue;
+            if (events[i].events & EPOLLOUT) flush(s);
+        }
+    }
+}
+
+bool TcpGateway::onReadable(IoThread& io, Session& s) {
+    // Edge-triggered: drain the socket before going back to epoll
+    char buf[64 * 1024];
+    for (;;) {
+        const ssize_t n = ::recv(s.fd, buf, sizeof(buf), 0);
+        if (n > 0) {
+            s.in.append(buf, static_cast<size_t>(n));
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        close(io, s); // EOF or error
+        return false;
+    }
+
+    size_t pos = 0;
+    while (s.in.size() - pos >= 4) {
+        uint32_t be;
+        std::memcpy(&be, s.in.data() + pos, 4);
+        const uint32_t len = ntohl(be);
+        if (len == 0 || len > config.max_frame) {
+            std::cerr << "[GATEWAY] Bad frame length " << len << " from client " << s.client_id << std::endl;
+            dropped_sessions.fetch_add(1, std::memory_order_relaxed);
+            close(io, s);
+            return false;
+        }
+        if (s.in.size() - pos - 4 < len) break;
+        if (!onFrame(s, s.in.data() + pos + 4, len)) {
+            dropped_sessions.fetch_add(1, std::memory_order_relaxed);
+            close(io, s);
+            return false;
+        }
+        pos += 4 + len;
+    }
+    s.in.erase(0, pos);
+    return true;
+}
+
+bool TcpGateway::onFrame(Session& s, const char* data, size_t len) {
+    HeaderFields h;
+    scan_header(data, len, h);
+    if (!h.has(HeaderFields::kClientId) || !h.has(HeaderFields::kSeq)) {
+        reject(s, RejectCode::ParseError, h.seq, data, len);
+        return true;
+    }
+    const ClientId client_id = h.client_id;
+    const SeqNum seq = h.seq;
+
+    if (!s.bound) {
+        // Logon: the first frame claims the client id for this connection
+        std::unique_lock<std::shared_mutex> lock(routes_mtx);
+        auto [it, inserted] = routes.emplace(client_id, s.shared_from_this());
+        if (!inserted) {
+            std::cerr << "[GATEWAY] Client " << client_id << " is already connected" << std::endl;
+            return false;
+        }
+        auto resume = resume_seq.find(client_id);
+        s.next_seq = resume != resume_seq.end() ? resume->second : 1;
+        s.client_id = client_id;
+        s.bound = true;
+    } else if (client_id != s.client_id) {
+        reject(s, RejectCode::NotAuthorized, seq, data, len);
+        return true;
+    }
+
+    if (seq != s.next_seq) {
+        seq_rejects.fetch_add(1, std::memory_order_relaxed);
+        reject(s, RejectCode::SequenceGap, seq, data, len);
+        return true;
+    }
+    ++s.next_seq;
+    frames_in.fetch_add(1, std::memory_order_relaxed);
+    sequencer->push(std::string(data, len), s.client_id);
+    return true;
+}
+
+void TcpGateway::reject(Session& s, RejectCode code, SeqNum seq, const char* data, size_t len) {
+    const std::string msg = dump_frame_reject(code, s.client_id, seq, data, len);
+    std::lock_guard<std::mutex> lock(s.out_mtx);
+    if (!s.closed) write(s, msg.data(), msg.size());
+}
+
+bool TcpGateway::send(ClientId client_id, const std::string& msg) {
+    std::shared_ptr<Session> s;
+    {
+        std::shared_lock<std::shared_mutex> lock(routes_mtx);
+        auto it = routes.find(client_id);
+        if (it == routes.end()) return false;
+        s = it->second;
+    }
+    std::lock_guard<std::mutex> lock(s->out_mtx);
+    if (!s->closed) write(*s, msg.data(), msg.size());
+    return true;
+}
+
+void TcpGateway::write(Session& s, const char* data, size_t len) {
+    const uint32_t be = htonl(static_cast<uint32_t>(len));
+    size_t sent = 0;
+    if (s.out.empty()) {
+        iovec iov[2] = { { const_cast<uint32_t*>(&be), 4 }, { const_cast<char*>(data), len } };
+        msghdr mh{};
+        mh.msg_iov = iov;
+        mh.msg_iovlen = 2;
+        const ssize_t n = ::sendmsg(s.fd, &mh, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n > 0) sent = static_cast<size_t>(n);
+        if (sent == 4 + len) return;
+    }
+
+    // Whatever the socket did not take waits for EPOLLOUT
+    if (sent < 4) s.out.append(reinterpret_cast<const char*>(&be) + sent, 4 - sent);
+    const size_t body_sent = sent > 4 ? sent - 4 : 0;
+    s.out.append(data + body_sent, len - body_sent);
+
+    if (s.out.size() > config.max_pending_out) {
+        // Slow reader: the hangup makes its io thread close the session
+        std::cerr << "[GATEWAY] Client " << s.client_id << " is not reading, disconnecting" << std::endl;
+        dropped_sessions.fetch_add(1, std::memory_order_relaxed);
+        s.closed = true;
+        s.out.clear();
+        ::shutdown(s.fd, SHUT_RDWR);
+    }
+}
+
+void TcpGateway::flush(Session& s) {
+    std::lock_guard<std::mutex> lock(s.out_mtx);
+    size_t pos = 0;
+    while (!s.closed && pos < s.out.size()) {
+        const ssize_t n = ::send(s.fd, s.out.data() + pos, s.out.size() - pos, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n > 0) { pos += static_cast<size_t>(n); continue; }
+        if (n < 0 && errno == EINTR) continue;
+        break; // EAGAIN waits for the next EPOLLOUT; errors arrive as a hangup
+    }
+    s.out.erase(0, pos);
+}
+
+void TcpGateway::close(IoThread& io, Session& s) {
+    std::shared_ptr<Session> keep = s.shared_from_this();
+    const int fd = s.fd;
+    // Out of the map before the fd is closed: accept() can hand the same
+    // number to a new connection as soon as it is
+    {
+        std::lock_guard<std::mutex> lock(io.sessions_mtx);
+        io.sessions.erase(fd);
+    }
+    {
+        std::lock_guard<std::mutex> lock(s.out_mtx);
+        s.closed = true;
+        ::epoll_ctl(io.epfd, EPOLL_CTL_DEL, fd, nullptr);
+        ::close(fd);
+        s.fd = -1;
+    }
+    if (s.bound) {
+        std::unique_lock<std::shared_mutex> lock(routes_mtx);
+        auto it = routes.find(s.client_id);
+        if (it != routes.end() && it->second == keep) routes.erase(it);
+        resume_seq[s.client_id] = s.next_seq;
+    }
+    active.fetch_sub(1, std::memory_order_relaxed);
+}
+
+TcpGatewayCounters TcpGateway::counters() const {
+    return TcpGatewayCounters{ active.load(std::memory_order_relaxed),
+                               accepted.load(std::memory_order_relaxed),
+                               frames_in.load(std::memory_order_relaxed),
+                               seq_rejects.load(std::memory_order_relaxed),
+                               dropped_sessions.load(std::memory_order_relaxed) };
+}
+
+} // namespace ex
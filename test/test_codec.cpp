@@ -0,0 +1,308 @@
+// Unit tests for the exception-free inbound parse: one case per ParseFailure,
+// plus the enum and header.type range checks it relies on, and the NewOrder
+// fast path against nlohmann; and the outbound writer against nlohmann's
+// dump().
+//
+// g++ -std=c++17 -I./include test/test_codec.cpp -o test_codec
+
+#include <climits>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "net/codec_json.hpp"
+
+using namespace ex;
+
+static int failures = 0;
+
+#define CHECK(cond)                                                                   \
+    do {                                                                              \
+        if (!(cond)) {                                                                \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #cond << std::endl; \
+            failures++;                                                               \
+        }                                                                             \
+    } while (0)
+
+static std::string envelope(const std::string& header, const std::string& body) {
+    return "{\"header\":{" + header + "},\"body\":{" + body + "}}";
+}
+
+static const std::string kHeader = "\"version\":1,\"type\":1,\"seq\":12,\"client_id\":7";
+static const std::string kOrder =
+    "\"client_order_id\":999,\"symbol\":\"AAPL\",\"side\":\"B\",\"ord_type\":\"LMT\",\"qty\":10,\"limit_price\":10123";
+
+static ParseFailure parse(const std::string& raw) {
+    EnvelopeIn e;
+    return try_parse_inbound_envelope(raw, e);
+}
+
+static void testNone() {
+    EnvelopeIn e;
+    CHECK(try_parse_inbound_envelope(envelope(kHeader, kOrder), e) == ParseFailure::None);
+    CHECK(e.header.type == MsgType::NewOrder);
+    CHECK(e.header.seq == 12);
+    CHECK(e.header.client_id == 7);
+    const NewOrderRequest* r = std::get_if<NewOrderRequest>(&e.body);
+    CHECK(r && r->symbol == "AAPL" && r->side == Side::Buy && r->qty == 10 && r->limit_price == 10123);
+
+    // Enum fields by code, and the optional ones by name
+    CHECK(try_parse_inbound_envelope(envelope(kHeader, "\"symbol\":\"AAPL\",\"side\":2,\"ord_type\":1,\"qty\":5,"
+                                                       "\"tif\":\"IOC\",\"stp\":\"CB\""), e) == ParseFailure::None);
+    r = std::get_if<NewOrderRequest>(&e.body);
+    CHECK(r && r->side == Side::Sell && r->ord_type == OrdType::Market && r->tif == TimeInForce::IOC &&
+          r->stp == StpMode::CancelBoth);
+
+    CHECK(parse(envelope("\"type\":\"MassCancel\",\"seq\":1,\"client_id\":7", "\"scope\":\"ALL\"")) ==
+          ParseFailure::None);
+    CHECK(parse(envelope("\"type\":6,\"seq\":1,\"client_id\":1", "\"action\":2")) == ParseFailure::None);
+}
+
+static void testSyntax() {
+    CHECK(parse("{\"header\":{\"type\":1,\"seq\":1},\"body\":{\"sym") == ParseFailure::Syntax);
+    CHECK(parse("[1,2,3]") == ParseFailure::Syntax);
+    CHECK(parse("") == ParseFailure::Syntax);
+}
+
+static void testNoHeader() {
+    CHECK(parse("{\"body\":{" + kOrder + "}}") == ParseFailure::NoHeader);
+    CHECK(parse("{\"header\":1,\"body\":{" + kOrder + "}}") == ParseFailure::NoHeader);
+}
+
+static void testNoType() {
+    CHECK(parse(envelope("\"seq\":1,\"client_id\":7", kOrder)) == ParseFailure::NoType);
+    CHECK(parse(envelope("\"type\":\"Bogus\",\"seq\":1", kOrder)) == ParseFailure::NoType);
+    CHECK(parse(envelope("\"type\":1.5,\"seq\":1", kOrder)) == ParseFailure::NoType);
+    // Past 16 bits: 65537 must not wrap round to NewOrder
+    CHECK(parse(envelope("\"type\":65537,\"seq\":1,\"client_id\":7", kOrder)) == ParseFailure::NoType);
+    CHECK(parse(envelope("\"type\":-1,\"seq\":1,\"client_id\":7", kOrder)) == ParseFailure::NoType);
+
+    HeaderFields h;
+    const std::string wide = envelope("\"type\":65537,\"seq\":1,\"client_id\":7", kOrder);
+    scan_header(wide.data(), wide.size(), h);
+    CHECK(!h.has(HeaderFields::kType));
+
+    MsgType t;
+    CHECK(msgtype_from_code(900, t) && t == MsgType::Heartbeat);
+    CHECK(msgtype_from_code(0xFFFF, t));
+    CHECK(!msgtype_from_code(0x10000, t));
+}
+
+static void testNoSeq() {
+    CHECK(parse(envelope("\"type\":1,\"client_id\":7", kOrder)) == ParseFailure::NoSeq);
+    CHECK(parse(envelope("\"type\":1,\"seq\":\"12\",\"client_id\":7", kOrder)) == ParseFailure::NoSeq);
+}
+
+static void testNotInbound() {
+    CHECK(parse(envelope("\"type\":900,\"seq\":1,\"client_id\":7", "")) == ParseFailure::NotInbound);
+    CHECK(parse(envelope("\"type\":\"Ack\",\"seq\":1,\"client_id\":7", "")) == ParseFailure::NotInbound);
+}
+
+static void testNoBody() {
+    CHECK(parse("{\"header\":{" + kHeader + "}}") == ParseFailure::NoBody);
+    CHECK(parse("{\"header\":{" + kHeader + "},\"body\":[]}") == ParseFailure::NoBody);
+}
+
+static void testMissingField() {
+    CHECK(parse(envelope(kHeader, "\"symbol\":\"AAPL\",\"side\":\"B\",\"ord_type\":\"LMT\"")) ==
+          ParseFailure::MissingField);
+    // Enum fields that name nothing are caught before the throwing get<>
+    CHECK(parse(envelope(kHeader, "\"symbol\":\"AAPL\",\"side\":\"X\",\"ord_type\":\"LMT\",\"qty\":10")) ==
+          ParseFailure::MissingField);
+    CHECK(parse(envelope(kHeader, "\"symbol\":\"AAPL\",\"side\":3,\"ord_type\":\"LMT\",\"qty\":10")) ==
+          ParseFailure::MissingField);
+    CHECK(parse(envelope(kHeader, "\"symbol\":\"AAPL\",\"side\":\"B\",\"ord_type\":9,\"qty\":10")) ==
+          ParseFailure::MissingField);
+    // An order for nothing, or for less than nothing
+    for (const char* qty : {"0", "-3", "0.5", "false"}) {
+        CHECK(parse(envelope(kHeader, std::string("\"symbol\":\"AAPL\",\"side\":\"B\",\"ord_type\":\"LMT\",\"qty\":") +
+                                          qty)) == ParseFailure::MissingField);
+    }
+    CHECK(parse(envelope(kHeader, kOrder + ",\"tif\":\"FOK\"")) == ParseFailure::MissingField);
+    CHECK(parse(envelope(kHeader, kOrder + ",\"stp\":7")) == ParseFailure::MissingField);
+    CHECK(parse(envelope("\"type\":3,\"seq\":1,\"client_id\":7", "\"scope\":\"BOOK\"")) ==
+          ParseFailure::MissingField);
+    CHECK(parse(envelope("\"type\":6,\"seq\":1,\"client_id\":1", "\"action\":true")) ==
+          ParseFailure::MissingField);
+
+    Side side;
+    CHECK(side_from_name("ask", side) && side == Side::Sell);
+    CHECK(!side_from_name("", side));
+    MassCancelScope scope;
+    CHECK(scope_from_code(3, scope) && scope == MassCancelScope::All);
+    CHECK(!scope_from_code(0, scope));
+}
+
+static void testBadValue() {
+    CHECK(parse(envelope(kHeader, kOrder + ",\"tif\":\"GTD\"")) == ParseFailure::BadValue);
+    CHECK(parse(envelope("\"type\":1,\"seq\":1,\"client_id\":\"7\"", kOrder)) == ParseFailure::BadValue);
+    CHECK(parse(envelope(kHeader, kOrder + ",\"display_qty\":-1")) == ParseFailure::BadValue);
+}
+
+static bool sameOrder(const EnvelopeIn& a, const EnvelopeIn& b) {
+    const NewOrderRequest* x = std::get_if<NewOrderRequest>(&a.body);
+    const NewOrderRequest* y = std::get_if<NewOrderRequest>(&b.body);
+    return x && y && a.header.version == b.header.version && a.header.type == b.header.type &&
+           a.header.seq == b.header.seq && a.header.client_id == b.header.client_id &&
+           x->client_order_id == y->client_order_id && x->symbol == y->symbol && x->side == y->side &&
+           x->ord_type == y->ord_type && x->qty == y->qty && x->limit_price == y->limit_price &&
+           x->stop_price == y->stop_price && x->tif == y->tif && x->expire_date == y->expire_date &&
+           x->display_qty == y->display_qty && x->stp == y->stp;
+}
+
+static void testFastPath() {
+    // Taken without a DOM, with what nlohmann makes of the same bytes
+    for (const std::string& raw : {
+             envelope(kHeader, kOrder),
+             std::string("{ \"body\" : { \"symbol\": \"MSFT\", \"side\": 2, \"ord_type\": \"STPLMT\", \"qty\": 7,"
+                         " \"price\": 101, \"stop_price\": 99, \"tif\": \"GTD\", \"expire_date\": 20261231,"
+                         " \"display_qty\": 3, \"stp\": 4 },\n  \"header\": {\"type\": \"NEW_ORDER\", \"seq\": 0} }\n"),
+             envelope("\"type\":1,\"seq\":999999999999999999,\"client_id\":4294967295", kOrder + ",\"price\":1"),
+         }) {
+        EnvelopeIn fast, slow;
+        CHECK(detail::NewOrderScan(raw).parse(fast));
+        slow = json::parse(raw).get<EnvelopeIn>();
+        CHECK(sameOrder(fast, slow));
+    }
+
+    // Left to nlohmann, which still parses the valid ones
+    for (const std::string& raw : {
+             envelope(kHeader, "\"symbol\":\"AA\\u0050L\",\"side\":\"B\",\"ord_type\":\"LMT\",\"qty\":10"),
+             envelope(kHeader, kOrder + ",\"text\":\"hi\""),
+             envelope(kHeader, "\"symbol\":\"AAPL\",\"side\":\"B\",\"ord_type\":\"LMT\",\"qty\":10.0"),
+             envelope(kHeader, "\"symbol\":\"AAPL\",\"side\":\"B\",\"ord_type\":\"LMT\",\"qty\":1e1"),
+             envelope("\"type\":1,\"seq\":1234567890123456789", kOrder),
+             "{\"header\":{" + kHeader + "},\"body\":{" + kOrder + "},\"trace\":1}",
+         }) {
+        EnvelopeIn fast, slow;
+        CHECK(!detail::NewOrderScan(raw).parse(fast));
+        CHECK(try_parse_inbound_envelope(raw, fast) == ParseFailure::None);
+        slow = json::parse(raw).get<EnvelopeIn>();
+        CHECK(sameOrder(fast, slow));
+    }
+
+    // Left to nlohmann: malformed, a duplicate key, a stop without its
+    // price, no quantity, or not a new order
+    EnvelopeIn e;
+    for (const std::string& raw : {
+             envelope(kHeader, "\"symbol\":\"AAPL\",\"side\":\"B\",\"ord_type\":\"LMT\",\"qty\":0"),
+             envelope(kHeader, "\"symbol\":\"AAPL\",\"side\":\"B\",\"ord_type\":\"LMT\",\"qty\":010"),
+             envelope(kHeader, kOrder + ",\"qty\":11"),
+             envelope(kHeader, kOrder) + "x",
+             envelope(kHeader, "\"symbol\":\"AAPL\",\"side\":\"B\",\"ord_type\":\"STP\",\"qty\":10"),
+             envelope("\"type\":2,\"seq\":1", "\"order_id\":5"),
+         }) {
+        CHECK(!detail::NewOrderScan(raw).parse(e));
+    }
+    CHECK(parse(envelope(kHeader, kOrder) + "x") == ParseFailure::Syntax);
+    CHECK(parse(envelope(kHeader, "\"symbol\":\"AAPL\",\"side\":\"B\",\"ord_type\":\"LMT\",\"qty\":0")) ==
+          ParseFailure::MissingField);
+}
+
+// What the nlohmann path makes of raw, or false where it refuses it
+static bool slowParse(const std::string& raw, EnvelopeIn& out) {
+    const json j = json::parse(raw, nullptr, false);
+    if (j.is_discarded() || !j.is_object() || !j.contains("body") || !j.at("body").is_object()) return false;
+    if (!detail::has_required(MsgType::NewOrder, j.at("body"))) return false;
+    try {
+        out = j.get<EnvelopeIn>();
+    } catch (const std::exception&) {
+        return false;
+    }
+    return std::holds_alternative<NewOrderRequest>(out.body);
+}
+
+static void testFastPathMalformed() {
+    // Whatever the fast path takes, nlohmann takes as the same order: every
+    // truncation, deletion and single-byte change of a few orders
+    const std::vector<std::string> orders = {
+        envelope(kHeader, kOrder),
+        std::string("{ \"header\" : { \"type\" : \"NEW_ORDER\", \"seq\" : 5 },\n \"body\" : { \"symbol\" : \"MSFT\","
+                    " \"side\" : 2, \"ord_type\" : \"STPLMT\", \"qty\" : 70, \"price\" : 101, \"stop_price\" : 99,"
+                    " \"tif\" : \"GTD\", \"expire_date\" : 20261231, \"display_qty\" : 30, \"stp\" : 4 } }"),
+    };
+    const std::string bytes = " \"\\{}[],:01239.-eE+xBS\t";
+    size_t accepted = 0;
+    auto check = [&](const std::string& raw) {
+        EnvelopeIn fast, slow;
+        if (!detail::NewOrderScan(raw).parse(fast)) return;
+        ++accepted;
+        const bool same = slowParse(raw, slow) && sameOrder(fast, slow);
+        if (!same) std::cerr << "fast path differs on " << raw << std::endl;
+        CHECK(same);
+    };
+    for (const std::string& order : orders) {
+        for (size_t i = 0; i <= order.size(); ++i) {
+            check(order.substr(0, i));
+            if (i == order.size()) break;
+            check(order.substr(0, i) + order.substr(i + 1));
+            for (const char c : bytes) {
+                std::string raw = order;
+                raw[i] = c;
+                check(raw);
+            }
+        }
+    }
+    // The unchanged orders and the harmless changes (a digit, a space, a
+    // shorter symbol) are taken, hundreds of them
+    CHECK(accepted > 100);
+}
+
+static EnvelopeOut outbound(MsgType type, ClientId client_id, SeqNum seq, OutboundMsg body) {
+    EnvelopeOut e;
+    e.header.type = type;
+    e.header.client_id = client_id;
+    e.header.seq = seq;
+    e.body = std::move(body);
+    return e;
+}
+
+static void testDumpEnvelope() {
+    // Every ASCII byte, the ones JSON escapes among them, and some UTF-8
+    std::string all;
+    for (int c = 0; c < 0x80; ++c) all.push_back(static_cast<char>(c));
+    const std::string utf8 = "caf\xc3\xa9 \xe2\x82\xac";
+    const uint64_t u64_max = UINT64_MAX;
+
+    std::vector<EnvelopeOut> responses = {
+        outbound(MsgType::Ack, 7, 12, Ack{999, 42, "AAPL"}),
+        outbound(MsgType::Ack, UINT32_MAX, u64_max, Ack{u64_max, u64_max, ""}),
+        outbound(MsgType::Reject, 7, 13, Reject{1, "UNKNOWN", RejectInfo{"Parse error: \"qty\" \\ bad\n", 1}}),
+        outbound(MsgType::Reject, 7, 14, Reject{0, all, RejectInfo{utf8, INT32_MIN}}),
+        outbound(MsgType::Fill, 7, 15, Fill{42, "MSFT", Side::Sell, 10, -10123, true}),
+        outbound(MsgType::Fill, 7, 16, Fill{0, utf8, Side::Buy, INT64_MAX, INT64_MIN, false}),
+        outbound(MsgType::Cancelled, 7, 17, Cancelled{42, 999, "GOOG", Side::Sell, 5, 0}),
+        outbound(MsgType::Replaced, 7, 18, Replaced{42, 999, "GOOG", 20, 10100}),
+        outbound(MsgType::MassCancelAck, 7, 19, MassCancelAck{999, 3}),
+        outbound(MsgType::AuctionInfo, 0, 20, AuctionInfo{"AAPL", 10100, 500, -200, true}),
+    };
+    responses.back().header.version = 65535;
+
+    // Byte for byte what a json tree would dump
+    std::string reused;
+    for (const EnvelopeOut& e : responses) {
+        const std::string want = json(e).dump();
+        CHECK(dump_envelope(e) == want);
+        const size_t before = reused.size();
+        append_envelope(reused, e);
+        CHECK(reused.compare(before, std::string::npos, want) == 0);
+    }
+}
+
+int main() {
+    testNone();
+    testSyntax();
+    testNoHeader();
+    testNoType();
+    testNoSeq();
+    testNotInbound();
+    testNoBody();
+    testMissingField();
+    testBadValue();
+    testFastPath();
+    testFastPathMalformed();
+    testDumpEnvelope();
+
+    std::cout << (failures == 0 ? "PASS" : "FAIL") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
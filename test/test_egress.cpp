@@ -0,0 +1,173 @@
+// Unit tests for EgressStage over an inproc PULL socket: per-producer order,
+// routing to a gateway session, holding responses for the replication
+// watermark, and a standby's discard, retain and replay on promotion.
+//
+// g++ -std=c++17 -I./include -I./include/lib/zmq test/test_egress.cpp src/egress_stage.cpp src/shm_gateway.cpp src/tcp_gateway.cpp -lzmq -lpthread -o test_egress
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include <zmq.hpp>
+#include "egress_stage.hpp"
+#include "net/shm_client.hpp"
+
+using namespace ex;
+
+static int failures = 0;
+
+#define CHECK(cond)                                                                   \
+    do {                                                                              \
+        if (!(cond)) {                                                                \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #cond << std::endl; \
+            failures++;                                                               \
+        }                                                                             \
+    } while (0)
+
+// The clients' end of the egress socket, on an endpoint of its own
+struct Receiver {
+    Receiver(zmq::context_t& context, const std::string& name)
+        : endpoint("inproc://test_egress_" + name), socket(context, zmq::socket_type::pull) {
+        socket.set(zmq::sockopt::rcvtimeo, 2000);
+        socket.bind(endpoint);
+    }
+
+    // Next response, or "" after the timeout
+    std::string next() {
+        zmq::message_t m;
+        if (!socket.recv(m, zmq::recv_flags::none)) return "";
+        return m.to_string();
+    }
+
+    // True if nothing arrives within ms
+    bool quiet(int ms) {
+        socket.set(zmq::sockopt::rcvtimeo, ms);
+        zmq::message_t m;
+        const bool none = !socket.recv(m, zmq::recv_flags::none);
+        socket.set(zmq::sockopt::rcvtimeo, 2000);
+        return none;
+    }
+
+    const std::string endpoint;
+    zmq::socket_t socket;
+};
+
+template <class Cond>
+static bool waitFor(Cond&& cond) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (!cond()) {
+        if (std::chrono::steady_clock::now() > deadline) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+static void testOrderPerProducer(zmq::context_t& context) {
+    Receiver rx(context, "order");
+    EgressStage egress(context, rx.endpoint, nullptr, 8, 4);
+    EgressStage::Producer* a = egress.addProducer();
+    EgressStage::Producer* b = egress.addProducer();
+    egress.start();
+
+    // More than a queue holds, so the producers wait on the egress thread
+    std::thread ta([&] { for (int i = 0; i < 100; ++i) a->send(1, "a" + std::to_string(i)); });
+    std::thread tb([&] { for (int i = 0; i < 100; ++i) b->send(2, "b" + std::to_string(i)); });
+    ta.join();
+    tb.join();
+
+    int next_a = 0, next_b = 0;
+    for (int n = 0; n < 200; ++n) {
+        const std::string m = rx.next();
+        if (m.empty()) break;
+        if (m[0] == 'a') CHECK(m == "a" + std::to_string(next_a++));
+        else CHECK(m == "b" + std::to_string(next_b++));
+    }
+    CHECK(next_a == 100 && next_b == 100);
+    egress.stop();
+    CHECK(egress.counters().sent == 200 && egress.counters().batches >= 50);
+}
+
+static void testRoutes(zmq::context_t& context) {
+    const ClientId shm_client = 2000000 + static_cast<ClientId>(::getpid());
+    Receiver rx(context, "routes");
+    ShmGateway shm({shm_client}, 16);
+    SessionRoutes routes;
+    routes.shm = &shm;
+    EgressStage egress(context, rx.endpoint, &routes);
+    EgressStage::Producer* p = egress.addProducer();
+    egress.start();
+
+    ShmClient client;
+    CHECK(client.connect(shm_client));
+    p->send(shm_client, "to shm");
+    p->send(5, "to zmq");
+    CHECK(rx.next() == "to zmq");
+    std::string msg;
+    CHECK(waitFor([&] { return client.poll(msg); }) && msg == "to shm");
+    egress.stop();
+    CHECK(egress.counters().routed == 1 && egress.counters().sent == 1);
+}
+
+static void testReplicationHold(zmq::context_t& context) {
+    Receiver rx(context, "hold");
+    std::atomic<uint64_t> replicated{0};
+    EgressStage egress(context, rx.endpoint);
+    egress.holdFor(&replicated);
+    EgressStage::Producer* p = egress.addProducer();
+    egress.start();
+
+    // Nothing answering seq 5 leaves before the backup has seq 5
+    p->holdUntil(5);
+    p->send(1, "ack 5");
+    CHECK(rx.quiet(50));
+    replicated.store(4);
+    CHECK(rx.quiet(50));
+    replicated.store(5);
+    CHECK(rx.next() == "ack 5");
+    CHECK(waitFor([&] { return egress.released()->load() == 5; }));
+    egress.stop();
+}
+
+static void testStandby(zmq::context_t& context) {
+    Receiver rx(context, "standby");
+    std::atomic<uint64_t> primary_released{2};
+    EgressStage egress(context, rx.endpoint);
+    egress.retainFor(&primary_released);
+    egress.setStandby(true);
+    EgressStage::Producer* p = egress.addProducer();
+    egress.start();
+
+    // The primary has already sent the answers to 1 and 2, not to 3 and 4
+    for (uint64_t seq = 1; seq <= 4; ++seq) {
+        p->holdUntil(seq);
+        p->send(1, "ack " + std::to_string(seq));
+    }
+    CHECK(waitFor([&] { return egress.counters().discarded == 2; }));
+    CHECK(rx.quiet(50));
+
+    // The primary releases 3 before it goes; only 4 is replayed, ahead of new responses
+    primary_released.store(3);
+    CHECK(waitFor([&] { return egress.counters().discarded == 3; }));
+    egress.setStandby(false);
+    p->holdUntil(5);
+    p->send(1, "ack 5");
+    CHECK(rx.next() == "ack 4");
+    CHECK(rx.next() == "ack 5");
+    egress.stop();
+    CHECK(egress.counters().replayed == 1 && egress.counters().sent == 2);
+}
+
+int main() {
+    zmq::context_t context(1);
+    testOrderPerProducer(context);
+    testRoutes(context);
+    testReplicationHold(context);
+    testStandby(context);
+
+    std::cout << (failures == 0 ? "PASS" : "FAIL") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,134 @@
+// Unit tests for router-mode ingress: a client_id belongs to the first
+// DEALER identity it arrives from, anything else is refused with a Reject on
+// the sender's socket, responses go back to the identity that owns their
+// client_id, and unaddressed ones go to every client.
+//
+// g++ -std=c++17 -I./include -I./include/lib/zmq test/test_input_stream.cpp src/input_stream.cpp src/shm_gateway.cpp -lzmq -lpthread -o test_input_stream
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <zmq.hpp>
+#include "input_stream.hpp"
+#include "net/transport.hpp"
+
+using namespace ex;
+
+static int failures = 0;
+
+#define CHECK(cond)                                                                   \
+    do {                                                                              \
+        if (!(cond)) {                                                                \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #cond << std::endl; \
+            failures++;                                                               \
+        }                                                                             \
+    } while (0)
+
+static const char* kEndpoint = "inproc://test_input_stream";
+
+static std::string order(ClientId client_id, SeqNum seq) {
+    return "{\"header\":{\"version\":1,\"type\":1,\"seq\":" + std::to_string(seq) +
+           ",\"client_id\":" + std::to_string(client_id) +
+           "},\"body\":{\"symbol\":\"AAPL\",\"side\":\"B\",\"ord_type\":\"LMT\",\"qty\":10,\"limit_price\":100}}";
+}
+
+static std::string ack(ClientId client_id, SeqNum seq) {
+    return "{\"header\":{\"version\":1,\"type\":100,\"seq\":" + std::to_string(seq) +
+           ",\"client_id\":" + std::to_string(client_id) + "},\"body\":{}}";
+}
+
+// A DEALER client with a receive timeout, so a missing response fails the
+// test instead of hanging it
+struct Dealer {
+    explicit Dealer(zmq::context_t& context) : socket(context, zmq::socket_type::dealer) {
+        socket.set(zmq::sockopt::rcvtimeo, 2000);
+        socket.connect(kEndpoint);
+    }
+
+    // Next response, or "" after the timeout
+    std::string next() {
+        zmq::message_t m;
+        if (!socket.recv(m, zmq::recv_flags::none)) return "";
+        return m.to_string();
+    }
+
+    bool quiet(int ms) {
+        socket.set(zmq::sockopt::rcvtimeo, ms);
+        zmq::message_t m;
+        const bool none = !socket.recv(m, zmq::recv_flags::none);
+        socket.set(zmq::sockopt::rcvtimeo, 2000);
+        return none;
+    }
+
+    zmq::socket_t socket;
+};
+
+static bool nextMessage(ThreadSafeQueue<InboundMessage>& q, InboundMessage& m) {
+    return q.popFor(m, std::chrono::seconds(2));
+}
+
+static int rejectCode(const std::string& msg) {
+    const EnvelopeOut e = json::parse(msg).get<EnvelopeOut>();
+    const Reject* r = std::get_if<Reject>(&e.body);
+    return r ? r->info.code : -1;
+}
+
+static void testRouting(zmq::context_t& context, InputStream& input, ThreadSafeQueue<InboundMessage>& q) {
+    Dealer a(context), b(context);
+    zmq::socket_t responder(context, zmq::socket_type::push);
+    responder.connect(kRouterResponses);
+
+    // Each client claims its id with its first order
+    a.socket.send(zmq::buffer(order(7, 1)), zmq::send_flags::none);
+    InboundMessage m;
+    CHECK(nextMessage(q, m) && m.payload == order(7, 1) && m.seq == 1);
+    b.socket.send(zmq::buffer(order(8, 1)), zmq::send_flags::none);
+    CHECK(nextMessage(q, m) && m.payload == order(8, 1) && m.seq == 2);
+
+    // Responses reach the owner of their client_id only
+    responder.send(zmq::buffer(ack(7, 1)), zmq::send_flags::none);
+    responder.send(zmq::buffer(ack(8, 1)), zmq::send_flags::none);
+    CHECK(a.next() == ack(7, 1));
+    CHECK(b.next() == ack(8, 1));
+    CHECK(a.quiet(50) && b.quiet(0));
+
+    // b cannot send as 7, nor without a client_id
+    b.socket.send(zmq::buffer(order(7, 2)), zmq::send_flags::none);
+    CHECK(rejectCode(b.next()) == to_u(RejectCode::NotAuthorized));
+    b.socket.send(zmq::buffer(std::string("{\"header\":{\"type\":1,\"seq\":3},\"body\":{}}")),
+                  zmq::send_flags::none);
+    CHECK(rejectCode(b.next()) == to_u(RejectCode::ParseError));
+    CHECK(input.refused() == 2);
+    CHECK(!q.popFor(m, std::chrono::milliseconds(50)));
+
+    // A multipart message is a batch, numbered in order
+    a.socket.send(zmq::buffer(order(7, 2)), zmq::send_flags::sndmore);
+    a.socket.send(zmq::buffer(order(7, 3)), zmq::send_flags::none);
+    CHECK(nextMessage(q, m) && m.payload == order(7, 2) && m.seq == 3);
+    CHECK(nextMessage(q, m) && m.payload == order(7, 3) && m.seq == 4);
+
+    // Unaddressed responses go to everyone; a client never seen goes nowhere
+    responder.send(zmq::buffer(ack(0, 0)), zmq::send_flags::none);
+    CHECK(a.next() == ack(0, 0));
+    CHECK(b.next() == ack(0, 0));
+    responder.send(zmq::buffer(ack(99, 1)), zmq::send_flags::none);
+    responder.send(zmq::buffer(ack(7, 4)), zmq::send_flags::none);
+    CHECK(a.next() == ack(7, 4));
+    CHECK(input.unroutable() == 1);
+}
+
+int main() {
+    zmq::context_t context(1);
+    ThreadSafeQueue<InboundMessage> q(1024, OverflowPolicy::Block);
+    Sequencer sequencer(&q);
+    InputStream input(&sequencer, context, kEndpoint, ThrottleConfig(), IngressMode::Router);
+    std::thread(&InputStream::startListening, &input).detach();
+
+    testRouting(context, input, q);
+
+    std::cout << (failures == 0 ? "PASS" : "FAIL") << std::endl;
+    std::_Exit(failures == 0 ? 0 : 1); // the listener thread owns its sockets until the process ends
+}
@@ -0,0 +1,654 @@
+// Unit tests for MatchingEngine / OrderBook and book snapshots.
+//
+// g++ -std=c++17 -I./include test/test_matching_engine.cpp src/order_book.cpp src/matching_engine.cpp src/snapshot.cpp -o test_matching_engine
+
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "matching_engine.hpp"
+#include "snapshot.hpp"
+
+using namespace ex;
+
+static int failures = 0;
+
+#define CHECK(cond)                                                                   \
+    do {                                                                              \
+        if (!(cond)) {                                                                \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #cond << std::endl; \
+            failures++;                                                               \
+        }                                                                             \
+    } while (0)
+
+static OrderId next_id = 0;
+
+static Order limit(Side side, double px, uint32_t qty, ClientId client = 7,
+                   TimeInForce tif = TimeInForce::Day) {
+    Order o(0, ++next_id, 0, "AAPL", side, MsgType::NewOrder, px, qty);
+    o.client_id = client;
+    o.tif = tif;
+    return o;
+}
+
+static Order market(Side side, uint32_t qty, ClientId client = 7) {
+    Order o = limit(side, 0, qty, client);
+    o.ord_type = OrdType::Market;
+    return o;
+}
+
+template <class T>
+static std::vector<T> bodies(const std::vector<EnvelopeOut>& events) {
+    std::vector<T> v;
+    for (const auto& e : events) {
+        if (const T* m = std::get_if<T>(&e.body)) v.push_back(*m);
+    }
+    return v;
+}
+
+static Qty levelQty(MatchingEngine& engine, Side side, Price px) {
+    const auto& levels = engine.book("AAPL").levels(side);
+    auto it = levels.find(px);
+    return it == levels.end() ? 0 : it->second.total_qty;
+}
+
+static void testLimitCrossAndRest() {
+    MatchingEngine engine;
+    std::vector<EnvelopeOut> ev;
+
+    const Order ask = limit(Side::Sell, 100, 10);
+    engine.process(ask, ev);
+    CHECK(ev.empty());
+    CHECK(engine.restingCount() == 1);
+
+    // Buy 15 @ 101 takes the 10 @ 100 and rests the other 5 @ 101
+    engine.process(limit(Side::Buy, 101, 15), ev);
+    auto fills = bodies<Fill>(ev);
+    CHECK(fills.size() == 2);
+    CHECK(fills[0].order_id == ask.internal_order_id && fills[0].complete);
+    CHECK(fills[1].fill_qty == 10 && fills[1].fill_price == 100 && !fills[1].complete);
+    CHECK(engine.restingCount() == 1);
+    CHECK(levelQty(engine, Side::Buy, 101) == 5);
+    CHECK(engine.book("AAPL").lastTradePrice() == 100);
+}
+
+static void testPriceTimePriority() {
+    MatchingEngine engine;
+    std::vector<EnvelopeOut> ev;
+
+    const Order first = limit(Side::Sell, 100, 5);
+    const Order second = limit(Side::Sell, 100, 5);
+    const Order better = limit(Side::Sell, 99, 5);
+    engine.process(first, ev);
+    engine.process(second, ev);
+    engine.process(better, ev);
+
+    engine.process(limit(Side::Buy, 100, 10), ev);
+    auto fills = bodies<Fill>(ev);
+    CHECK(fills.size() == 4);
+    CHECK(fills[0].order_id == better.internal_order_id);
+    CHECK(fills[2].order_id == first.internal_order_id);
+    CHECK(engine.find(second.internal_order_id) != nullptr);
+    CHECK(engine.find(first.internal_order_id) == nullptr);
+}
+
+static void testIocRemainderNeverRests() {
+    MatchingEngine engine;
+    std::vector<EnvelopeOut> ev;
+
+    engine.process(limit(Side::Sell, 100, 4), ev);
+    const Order ioc = limit(Side::Buy, 100, 10, 7, TimeInForce::IOC);
+    engine.process(ioc, ev);
+
+    auto fills = bodies<Fill>(ev);
+    auto cancels = bodies<Cancelled>(ev);
+    CHECK(fills.size() == 2 && fills[1].fill_qty == 4);
+    CHECK(cancels.size() == 1);
+    CHECK(cancels[0].order_id == ioc.internal_order_id && cancels[0].cancelled_qty == 6);
+    CHECK(engine.restingCount() == 0);
+    CHECK(engine.book("AAPL").levels(Side::Buy).empty());
+
+    // An IOC that does not cross is cancelled in full
+    ev.clear();
+    engine.process(limit(Side::Sell, 105, 3, 7, TimeInForce::IOC), ev);
+    cancels = bodies<Cancelled>(ev);
+    CHECK(bodies<Fill>(ev).empty());
+    CHECK(cancels.size() == 1 && cancels[0].cancelled_qty == 3);
+    CHECK(engine.restingCount() == 0);
+}
+
+static void testMarketSweepsLevels() {
+    MatchingEngine engine;
+    std::vector<EnvelopeOut> ev;
+
+    for (int px = 100; px < 105; ++px) engine.process(limit(Side::Sell, px, 10), ev);
+
+    engine.process(market(Side::Buy, 35), ev);
+    auto fills = bodies<Fill>(ev);
+    CHECK(fills.size() == 8);
+    CHECK(fills.back().fill_price == 103 && fills.back().fill_qty == 5 && fills.back().complete);
+    CHECK(levelQty(engine, Side::Sell, 103) == 5);
+    CHECK(engine.book("AAPL").levels(Side::Sell).size() == 2);
+
+    // More than the book holds: everything trades, the rest is cancelled
+    ev.clear();
+    const Order big = market(Side::Buy, 100);
+    engine.process(big, ev);
+    auto cancels = bodies<Cancelled>(ev);
+    CHECK(bodies<Fill>(ev).size() == 4);
+    CHECK(cancels.size() == 1 && cancels[0].order_id == big.internal_order_id && cancels[0].cancelled_qty == 85);
+    CHECK(engine.restingCount() == 0);
+    CHECK(engine.book("AAPL").levels(Side::Buy).empty());
+}
+
+static void testCancelAndMassCancel() {
+    MatchingEngine engine;
+    std::vector<EnvelopeOut> ev;
+
+    const Order mine = limit(Side::Buy, 90, 10, 1);
+    engine.process(mine, ev);
+    engine.process(limit(Side::Buy, 91, 10, 2), ev);
+    engine.process(limit(Side::Sell, 110, 10, 1), ev);
+
+    // Another client's cancel is rejected as unknown
+    Order cxl;
+    cxl.type = MsgType::Cancel;
+    cxl.client_id = 2;
+    cxl.internal_order_id = mine.internal_order_id;
+    engine.process(cxl, ev);
+    auto rejects = bodies<Reject>(ev);
+    CHECK(rejects.size() == 1 && rejects[0].info.code == to_u(RejectCode::UnknownOrder));
+    CHECK(engine.restingCount() == 3);
+
+    ev.clear();
+    CHECK(engine.cancelClient(1, nullptr, ev) == 2);
+    CHECK(bodies<Cancelled>(ev).size() == 2);
+    CHECK(engine.restingCount() == 1);
+
+    ev.clear();
+    CHECK(engine.cancelBook(engine.book("AAPL"), ev) == 1);
+    CHECK(engine.restingCount() == 0);
+    CHECK(engine.book("AAPL").empty());
+}
+
+static Order replace(const Order& target, double px, uint32_t qty, ClientId client = 7) {
+    Order o;
+    o.type = MsgType::Replace;
+    o.client_id = client;
+    o.internal_order_id = target.internal_order_id;
+    o.price = px;
+    o.quantity = qty;
+    return o;
+}
+
+static void testReplace() {
+    MatchingEngine engine;
+    std::vector<EnvelopeOut> ev;
+
+    const Order first = limit(Side::Buy, 100, 10);
+    const Order second = limit(Side::Buy, 100, 10);
+    engine.process(first, ev);
+    engine.process(second, ev);
+
+    // Qty down at the same price keeps first at the head of the level
+    engine.process(replace(first, 100, 4), ev);
+    CHECK(bodies<Replaced>(ev).size() == 1);
+    CHECK(levelQty(engine, Side::Buy, 100) == 14);
+    ev.clear();
+    engine.process(limit(Side::Sell, 100, 4), ev);
+    auto fills = bodies<Fill>(ev);
+    CHECK(fills.size() == 2 && fills[0].order_id == first.internal_order_id && fills[0].complete);
+
+    // Qty up loses priority to orders already at the level
+    const Order third = limit(Side::Buy, 100, 5);
+    engine.process(third, ev);
+    engine.process(replace(second, 100, 20), ev);
+    ev.clear();
+    engine.process(limit(Side::Sell, 100, 5), ev);
+    fills = bodies<Fill>(ev);
+    CHECK(fills.size() == 2 && fills[0].order_id == third.internal_order_id);
+    CHECK(levelQty(engine, Side::Buy, 100) == 20);
+
+    // A new price that crosses trades first and rests the remainder
+    engine.process(limit(Side::Sell, 105, 8), ev);
+    ev.clear();
+    engine.process(replace(second, 106, 20), ev);
+    fills = bodies<Fill>(ev);
+    CHECK(fills.size() == 2 && fills[1].order_id == second.internal_order_id && fills[1].fill_qty == 8);
+    CHECK(levelQty(engine, Side::Buy, 100) == 0);
+    CHECK(levelQty(engine, Side::Buy, 106) == 12);
+    CHECK(engine.find(second.internal_order_id)->price == 106);
+    CHECK(engine.restingCount() == 1);
+
+    // Fully filled on the move: gone from the index
+    engine.process(limit(Side::Sell, 110, 12), ev);
+    ev.clear();
+    engine.process(replace(second, 110, 12), ev);
+    CHECK(engine.find(second.internal_order_id) == nullptr);
+    CHECK(engine.restingCount() == 0);
+
+    // Unknown, foreign and zero-qty replaces are rejected
+    const Order mine = limit(Side::Sell, 120, 10);
+    engine.process(mine, ev);
+    ev.clear();
+    engine.process(replace(mine, 120, 5, 8), ev);
+    engine.process(replace(mine, 120, 0), ev);
+    auto rejects = bodies<Reject>(ev);
+    CHECK(rejects.size() == 2);
+    CHECK(rejects[0].info.code == to_u(RejectCode::UnknownOrder));
+    CHECK(rejects[1].info.code == to_u(RejectCode::InvalidReplace));
+    CHECK(levelQty(engine, Side::Sell, 120) == 10);
+}
+
+static void testIceberg() {
+    MatchingEngine engine;
+    std::vector<EnvelopeOut> ev;
+
+    Order berg = limit(Side::Sell, 100, 25);
+    berg.display_qty = 10;
+    const Order plain = limit(Side::Sell, 100, 5);
+    engine.process(berg, ev);
+    engine.process(plain, ev);
+
+    // Only the displayed slice counts towards the level
+    CHECK(levelQty(engine, Side::Sell, 100) == 15);
+    CHECK(engine.find(berg.internal_order_id)->reserve == 15);
+
+    // Taking the visible 10 refills the iceberg behind the plain order
+    engine.process(limit(Side::Buy, 100, 12), ev);
+    auto fills = bodies<Fill>(ev);
+    CHECK(fills.size() == 4);
+    CHECK(fills[0].order_id == berg.internal_order_id && fills[0].fill_qty == 10 && !fills[0].complete);
+    CHECK(fills[2].order_id == plain.internal_order_id && fills[2].fill_qty == 2);
+    CHECK(levelQty(engine, Side::Sell, 100) == 13);
+    CHECK(engine.find(berg.internal_order_id)->qty == 10);
+    CHECK(engine.find(berg.internal_order_id)->reserve == 5);
+
+    // The last slice is smaller than the peak and completes the order
+    ev.clear();
+    engine.process(limit(Side::Buy, 100, 18), ev);
+    fills = bodies<Fill>(ev);
+    CHECK(fills.size() == 6);
+    CHECK(fills[4].order_id == berg.internal_order_id && fills[4].fill_qty == 5 && fills[4].complete);
+    CHECK(engine.restingCount() == 0);
+
+    // Cancelling reports displayed plus hidden quantity
+    Order berg2 = limit(Side::Buy, 90, 30);
+    berg2.display_qty = 4;
+    engine.process(berg2, ev);
+    ev.clear();
+    CHECK(engine.cancel(berg2.internal_order_id, ev));
+    auto cancels = bodies<Cancelled>(ev);
+    CHECK(cancels.size() == 1 && cancels[0].cancelled_qty == 30);
+}
+
+static Order stop(Side side, double stop_px, uint32_t qty, double limit_px = 0, ClientId client = 7) {
+    Order o = limit(side, limit_px, qty, client);
+    o.ord_type = limit_px > 0 ? OrdType::StopLimit : OrdType::Stop;
+    o.stop_price = stop_px;
+    return o;
+}
+
+static void testStops() {
+    MatchingEngine engine;
+    std::vector<EnvelopeOut> ev;
+
+    // Asks at 100..104; clearing the 100 level sets the last price
+    for (int px = 100; px < 105; ++px) engine.process(limit(Side::Sell, px, 10), ev);
+    engine.process(limit(Side::Buy, 100, 10), ev);
+
+    // Buy stops at 101 and 102 stay off the book until the price gets there
+    const Order s102 = stop(Side::Buy, 102, 10);
+    const Order s101 = stop(Side::Buy, 101, 10);
+    engine.process(s102, ev);
+    engine.process(s101, ev);
+    CHECK(engine.book("AAPL").levels(Side::Buy).empty());
+    CHECK(engine.book("AAPL").stops(Side::Buy).size() == 2);
+
+    // A trade at 101 fires s101, whose fills print 101 then 102 and fire s102
+    ev.clear();
+    engine.process(limit(Side::Buy, 101, 1), ev);
+    auto fills = bodies<Fill>(ev);
+    CHECK(engine.book("AAPL").stops(Side::Buy).empty());
+    CHECK(fills.size() == 2 + 4 + 4);
+    CHECK(fills[3].order_id == s101.internal_order_id && fills[3].fill_price == 101 && fills[3].fill_qty == 9);
+    CHECK(fills[5].order_id == s101.internal_order_id && fills[5].fill_price == 102 && fills[5].complete);
+    CHECK(fills[7].order_id == s102.internal_order_id && fills[7].fill_price == 102 && fills[7].fill_qty == 9);
+    CHECK(fills[9].order_id == s102.internal_order_id && fills[9].fill_price == 103 && fills[9].complete);
+    CHECK(engine.book("AAPL").lastTradePrice() == 103);
+    CHECK(engine.find(s101.internal_order_id) == nullptr);
+
+    // A sell stop-limit rests at its limit once fired; a pending stop can be cancelled
+    const Order sl = stop(Side::Sell, 103, 5, 120);
+    const Order far = stop(Side::Sell, 50, 5);
+    engine.process(far, ev);
+    engine.process(sl, ev);
+    CHECK(levelQty(engine, Side::Sell, 120) == 5);
+    CHECK(engine.find(sl.internal_order_id)->ord_type == OrdType::Limit);
+    ev.clear();
+    CHECK(engine.cancel(far.internal_order_id, ev));
+    CHECK(bodies<Cancelled>(ev).size() == 1 && bodies<Cancelled>(ev)[0].cancelled_qty == 5);
+    CHECK(engine.book("AAPL").stops(Side::Sell).empty());
+
+    // A fired IOC stop-limit cancels its unfilled part instead of resting
+    Order ioc = stop(Side::Buy, 104, 15, 104);
+    ioc.tif = TimeInForce::IOC;
+    ev.clear();
+    engine.process(ioc, ev);
+    engine.process(limit(Side::Buy, 104, 10), ev);
+    fills = bodies<Fill>(ev);
+    auto cancels = bodies<Cancelled>(ev);
+    CHECK(fills.size() == 6 && fills[5].order_id == ioc.internal_order_id && fills[5].fill_qty == 9);
+    CHECK(cancels.size() == 1 && cancels[0].order_id == ioc.internal_order_id && cancels[0].cancelled_qty == 6);
+    CHECK(engine.find(ioc.internal_order_id) == nullptr);
+    CHECK(engine.book("AAPL").levels(Side::Buy).empty());
+}
+
+static void testReplacePendingStop() {
+    MatchingEngine engine;
+    std::vector<EnvelopeOut> ev;
+    engine.process(limit(Side::Sell, 100, 10), ev);
+    engine.process(limit(Side::Buy, 100, 10), ev);
+
+    const Order first = stop(Side::Sell, 95, 10, 94);
+    const Order second = stop(Side::Sell, 95, 10, 94);
+    engine.process(first, ev);
+    engine.process(second, ev);
+    const auto& level = engine.book("AAPL").stops(Side::Sell).at(95);
+    auto headId = [&]() { return engine.pool()[level.head].order_id; };
+
+    // Qty down keeps first at the head of the stop level; the limit moves
+    engine.process(replace(first, 93, 6), ev);
+    CHECK(headId() == first.internal_order_id && level.total_qty == 16);
+    CHECK(engine.find(first.internal_order_id)->price == 93);
+
+    // Qty up sends it behind second
+    engine.process(replace(first, 93, 12), ev);
+    CHECK(headId() == second.internal_order_id && level.total_qty == 22);
+    CHECK(engine.find(first.internal_order_id)->stop_price == 95);
+    CHECK(engine.book("AAPL").levels(Side::Sell).empty());
+}
+
+static void testStopsHeldInAuction() {
+    MatchingEngine engine;
+    std::vector<EnvelopeOut> ev;
+    OrderBook& b = engine.book("AAPL");
+    engine.process(limit(Side::Sell, 100, 10), ev);
+    engine.process(limit(Side::Buy, 100, 5), ev);
+    CHECK(b.lastTradePrice() == 100);
+
+    // Already crossed by the last trade, but the auction holds it
+    engine.startAuction(b, ev);
+    const Order s = stop(Side::Buy, 100, 5);
+    ev.clear();
+    engine.process(s, ev);
+    CHECK(bodies<Cancelled>(ev).empty());
+    CHECK(engine.find(s.internal_order_id) && isPendingStop(*engine.find(s.internal_order_id)));
+
+    // The uncross releases it into continuous matching
+    ev.clear();
+    engine.uncross(b, ev);
+    auto fills = bodies<Fill>(ev);
+    CHECK(fills.size() == 2 && fills[1].order_id == s.internal_order_id && fills[1].complete);
+    CHECK(bodies<Cancelled>(ev).empty());
+    CHECK(engine.find(s.internal_order_id) == nullptr);
+}
+
+static void testCallAuction() {
+    MatchingEngine engine;
+    std::vector<EnvelopeOut> ev;
+    OrderBook& b = engine.book("AAPL");
+    engine.startAuction(b, ev);
+
+    // Orders accumulate crossed without trading
+    engine.process(limit(Side::Buy, 102, 10), ev);
+    engine.process(limit(Side::Buy, 101, 10), ev);
+    engine.process(limit(Side::Buy, 99, 10), ev);
+    engine.process(limit(Side::Sell, 100, 5), ev);
+    engine.process(limit(Side::Sell, 101, 10), ev);
+    const Order ioc = limit(Side::Sell, 90, 5, 7, TimeInForce::IOC);
+    engine.process(ioc, ev);
+    CHECK(bodies<Fill>(ev).empty());
+    CHECK(bodies<Cancelled>(ev).size() == 1 && bodies<Cancelled>(ev)[0].order_id == ioc.internal_order_id);
+
+    // Demand >= 101 is 20, supply <= 101 is 15; at 102 only 10 is bid
+    auto infos = bodies<AuctionInfo>(ev);
+    CHECK(infos.size() == 7);
+    CHECK(infos.back().price == 101 && infos.back().qty == 15 && infos.back().imbalance == 5);
+    CHECK(!infos.back().uncrossed);
+
+    ev.clear();
+    CHECK(engine.uncross(b, ev) == 15);
+    auto fills = bodies<Fill>(ev);
+    CHECK(fills.size() == 6);
+    for (const Fill& f : fills) CHECK(f.fill_price == 101);
+    infos = bodies<AuctionInfo>(ev);
+    CHECK(infos.size() == 1 && infos[0].uncrossed && infos[0].qty == 15);
+    CHECK(!b.inAuction() && b.lastTradePrice() == 101);
+    CHECK(levelQty(engine, Side::Buy, 101) == 5);
+    CHECK(b.levels(Side::Sell).empty());
+
+    // Back to continuous matching
+    ev.clear();
+    engine.process(limit(Side::Sell, 101, 5), ev);
+    CHECK(bodies<Fill>(ev).size() == 2);
+    CHECK(bodies<AuctionInfo>(ev).empty());
+}
+
+static void testAuctionIcebergAndStp() {
+    MatchingEngine engine;
+    std::vector<EnvelopeOut> ev;
+    OrderBook& b = engine.book("AAPL");
+    engine.startAuction(b, ev);
+
+    // Only 10 of the bid's 30 shows, but all of it can execute
+    Order berg = limit(Side::Buy, 100, 30);
+    berg.display_qty = 10;
+    engine.process(berg, ev);
+    engine.process(limit(Side::Sell, 100, 25, 8), ev);
+    AuctionInfo info;
+    CHECK(engine.indicative(b, info) && info.qty == 25 && info.imbalance == 5);
+    ev.clear();
+    CHECK(engine.uncross(b, ev) == 25);
+    CHECK(engine.find(berg.internal_order_id)->qty + engine.find(berg.internal_order_id)->reserve == 5);
+
+    // Client 7's later sell meets its own bid first and cancels itself
+    engine.startAuction(b, ev);
+    Order own = limit(Side::Sell, 100, 5);
+    own.stp = StpMode::CancelAggressor;
+    engine.process(own, ev);
+    const Order other = limit(Side::Sell, 100, 5, 8);
+    engine.process(other, ev);
+    ev.clear();
+    CHECK(engine.uncross(b, ev) == 5);
+    auto cancels = bodies<Cancelled>(ev);
+    auto fills = bodies<Fill>(ev);
+    CHECK(cancels.size() == 1 && cancels[0].order_id == own.internal_order_id && cancels[0].cancelled_qty == 5);
+    CHECK(fills.size() == 2 && fills[1].order_id == other.internal_order_id);
+    CHECK(engine.find(own.internal_order_id) == nullptr);
+    CHECK(engine.find(berg.internal_order_id) == nullptr);
+}
+
+static void testSelfTradePrevention() {
+    // Client 7 rests 10 @ 100 behind client 8's 5 @ 100, then buys 12 @ 100
+    auto run = [](StpMode mode, std::vector<EnvelopeOut>& ev, MatchingEngine& engine,
+                  Order& own) {
+        engine.process(limit(Side::Sell, 100, 5, 8), ev);
+        own = limit(Side::Sell, 100, 10, 7);
+        engine.process(own, ev);
+        ev.clear();
+        Order buy = limit(Side::Buy, 100, 12, 7);
+        buy.stp = mode;
+        buy.seq = 55;
+        engine.process(buy, ev);
+        return buy;
+    };
+
+    {
+        MatchingEngine engine;
+        std::vector<EnvelopeOut> ev;
+        Order own;
+        run(StpMode::None, ev, engine, own);
+        CHECK(bodies<Fill>(ev).size() == 4);
+        CHECK(engine.find(own.internal_order_id)->qty == 3);
+    }
+    {
+        MatchingEngine engine;
+        std::vector<EnvelopeOut> ev;
+        Order own;
+        const Order buy = run(StpMode::CancelResting, ev, engine, own);
+        auto cancels = bodies<Cancelled>(ev);
+        CHECK(bodies<Fill>(ev).size() == 2);
+        CHECK(cancels.size() == 1 && cancels[0].order_id == own.internal_order_id && cancels[0].cancelled_qty == 10);
+        CHECK(levelQty(engine, Side::Buy, 100) == 7);
+        CHECK(engine.find(buy.internal_order_id) != nullptr);
+    }
+    {
+        MatchingEngine engine;
+        std::vector<EnvelopeOut> ev;
+        Order own;
+        const Order buy = run(StpMode::CancelAggressor, ev, engine, own);
+        auto cancels = bodies<Cancelled>(ev);
+        CHECK(bodies<Fill>(ev).size() == 2);
+        CHECK(cancels.size() == 1 && cancels[0].order_id == buy.internal_order_id);
+        CHECK(cancels[0].cancelled_qty == 7 && cancels[0].leaves_qty == 0);
+        // The taker's Cancelled answers its request, so it carries the seq
+        for (const EnvelopeOut& e : ev) {
+            if (e.header.type == MsgType::Cancelled) CHECK(e.header.seq == 55);
+        }
+        CHECK(engine.find(own.internal_order_id)->qty == 10);
+        CHECK(engine.find(buy.internal_order_id) == nullptr);
+    }
+    {
+        MatchingEngine engine;
+        std::vector<EnvelopeOut> ev;
+        Order own;
+        run(StpMode::CancelBoth, ev, engine, own);
+        CHECK(bodies<Cancelled>(ev).size() == 2);
+        CHECK(engine.restingCount() == 0);
+    }
+    {
+        MatchingEngine engine;
+        std::vector<EnvelopeOut> ev;
+        Order own;
+        const Order buy = run(StpMode::Decrement, ev, engine, own);
+        auto cancels = bodies<Cancelled>(ev);
+        CHECK(bodies<Fill>(ev).size() == 2);
+        CHECK(cancels.size() == 2);
+        CHECK(cancels[0].order_id == own.internal_order_id && cancels[0].cancelled_qty == 7 && cancels[0].leaves_qty == 3);
+        CHECK(cancels[1].order_id == buy.internal_order_id && cancels[1].leaves_qty == 0);
+        CHECK(levelQty(engine, Side::Sell, 100) == 3);
+        CHECK(engine.find(buy.internal_order_id) == nullptr);
+    }
+}
+
+static void testSessionExpiry() {
+    MatchingEngine engine;
+    std::vector<EnvelopeOut> ev;
+
+    const Order day = limit(Side::Buy, 90, 10);
+    const Order gtc = limit(Side::Buy, 91, 10, 7, TimeInForce::GTC);
+    Order gtd_today = limit(Side::Sell, 110, 10, 7, TimeInForce::GTD);
+    gtd_today.expire_date = 20261019;
+    Order gtd_later = limit(Side::Sell, 111, 10, 7, TimeInForce::GTD);
+    gtd_later.expire_date = 20261020;
+    const Order day_stop = stop(Side::Sell, 50, 5);
+    for (const Order& o : {day, gtc, gtd_today, gtd_later, day_stop}) engine.process(o, ev);
+
+    // An order that leaves the book early drops out of its expiry list too
+    const Order gone = limit(Side::Buy, 89, 10);
+    engine.process(gone, ev);
+    CHECK(engine.cancel(gone.internal_order_id, ev));
+
+    ev.clear();
+    CHECK(engine.expire(20261019, 2, ev) == 2);
+    CHECK(engine.expire(20261019, 2, ev) == 1);
+    CHECK(engine.expire(20261019, 2, ev) == 0);
+    auto cancels = bodies<Cancelled>(ev);
+    CHECK(cancels.size() == 3);
+    CHECK(cancels[0].order_id == day.internal_order_id);
+    CHECK(cancels[1].order_id == day_stop.internal_order_id);
+    CHECK(cancels[2].order_id == gtd_today.internal_order_id);
+    CHECK(engine.restingCount() == 2);
+
+    ev.clear();
+    CHECK(engine.expire(20261020, 100, ev) == 1);
+    CHECK(engine.find(gtc.internal_order_id) != nullptr);
+    CHECK(engine.restingCount() == 1);
+}
+
+static void testSnapshotValidation() {
+    MatchingEngine engine;
+    std::vector<EnvelopeOut> ev;
+    engine.process(limit(Side::Buy, 90, 10), ev);
+    engine.process(limit(Side::Sell, 110, 10), ev);
+    engine.startAuction(engine.book("AAPL"), ev);
+    const std::string path = "test_matching_engine." + std::to_string(::getpid()) + ".snapshot";
+
+    // A forked writer produces the same file; the auction and the sequencer
+    // position come back with the books
+    {
+        SnapshotWriter writer(path);
+        CHECK(writer.start(engine, 42, 77));
+    }
+    MatchingEngine restored;
+    uint64_t last_id = 0;
+    uint64_t last_seq = 0;
+    CHECK(loadSnapshot(path, restored, last_id, last_seq));
+    CHECK(last_id == 42 && last_seq == 77 && restored.restingCount() == 2);
+    CHECK(restored.book("AAPL").inAuction());
+
+    SnapshotHeader hdr;
+    {
+        std::ifstream in(path, std::ios::binary);
+        in.read(reinterpret_cast<char*>(&hdr), sizeof(hdr));
+    }
+
+    // An order count whose size wraps to 0 (sizeof(SnapshotOrder) is a
+    // multiple of 8) must not pass the bounds check
+    {
+        SnapshotHeader wrapped = hdr;
+        wrapped.order_count = uint64_t(1) << 61;
+        std::fstream f(path, std::ios::binary | std::ios::in | std::ios::out);
+        f.write(reinterpret_cast<const char*>(&wrapped), sizeof(wrapped));
+    }
+    MatchingEngine overflow;
+    CHECK(!loadSnapshot(path, overflow, last_id, last_seq));
+    CHECK(overflow.books().empty());
+
+    // An out-of-range side in the first order fails the whole file
+    {
+        std::fstream f(path, std::ios::binary | std::ios::in | std::ios::out);
+        f.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+        f.seekp(static_cast<std::streamoff>(hdr.orders_offset + offsetof(SnapshotOrder, side)));
+        f.put(static_cast<char>(7));
+    }
+    MatchingEngine corrupt;
+    CHECK(!loadSnapshot(path, corrupt, last_id, last_seq));
+    CHECK(corrupt.restingCount() == 0 && corrupt.books().empty());
+    std::remove(path.c_str());
+}
+
+int main() {
+    testLimitCrossAndRest();
+    testPriceTimePriority();
+    testIocRemainderNeverRests();
+    testMarketSweepsLevels();
+    testCancelAndMassCancel();
+    testReplace();
+    testIceberg();
+    testStops();
+    testReplacePendingStop();
+    testStopsHeldInAuction();
+    testCallAuction();
+    testAuctionIcebergAndStp();
+    testSelfTradePrevention();
+    testSessionExpiry();
+    testSnapshotValidation();
+
+    std::cout << (failures == 0 ? "PASS" : "FAIL") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
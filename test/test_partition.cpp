@@ -0,0 +1,180 @@
+// Unit tests for symbol partitions: reading the partition map and refusing
+// bad ones, where listed, unlisted and symbol-less messages are sent, and a
+// front end keeping its map when a new one would move unlisted symbols.
+//
+// g++ -std=c++17 -I./include -I./include/lib/zmq test/test_partition.cpp src/partition_router.cpp -lzmq -lpthread -o test_partition
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include <zmq.hpp>
+#include "partition_router.hpp"
+
+using namespace ex;
+
+static int failures = 0;
+
+#define CHECK(cond)                                                                   \
+    do {                                                                              \
+        if (!(cond)) {                                                                \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #cond << std::endl; \
+            failures++;                                                               \
+        }                                                                             \
+    } while (0)
+
+static const std::string kMapPath = "/tmp/test_partition." + std::to_string(::getpid()) + ".conf";
+
+static void writeMap(const std::string& text) {
+    std::ofstream(kMapPath) << text;
+}
+
+static bool load(const std::string& text, PartitionMap& m, std::string& error) {
+    writeMap(text);
+    return PartitionMap::load(kMapPath, m, error);
+}
+
+static void testLoad() {
+    PartitionMap m;
+    std::string error;
+    CHECK(load("# endpoint  symbols\n"
+               "tcp://a:1  AAPL MSFT   # big ones\n"
+               "\n"
+               "tcp://b:2  GOOG *\n", m, error));
+    CHECK((m.endpoints == std::vector<std::string>{"tcp://a:1", "tcp://b:2"}));
+    CHECK(m.owners.size() == 3 && m.fallback == 1);
+    CHECK(m.placement() == "* tcp://b:2");
+    // The names survive the move into m
+    CHECK(m.partitionOf("MSFT") == 0 && m.partitionOf("GOOG") == 1);
+
+    // A bad file leaves the map as it was
+    CHECK(!load("tcp://a:1 *\ntcp://b:2 *\n", m, error));
+    CHECK(error == kMapPath + ":2: second '*' partition");
+    CHECK(!load("tcp://a:1 AAPL\ntcp://b:2 AAPL\n", m, error));
+    CHECK(error == kMapPath + ":2: AAPL is listed twice");
+    CHECK(!load("# nothing\n\n", m, error));
+    CHECK(error == kMapPath + ": no partitions");
+    CHECK(!PartitionMap::load(kMapPath + ".missing", m, error));
+    CHECK(error == "cannot open " + kMapPath + ".missing");
+    CHECK(m.endpoints.size() == 2 && m.fallback == 1);
+}
+
+static void testPartitionOf() {
+    PartitionMap m;
+    std::string error;
+    CHECK(load("tcp://a:1 AAPL\ntcp://b:2 MSFT\ntcp://c:3 *\n", m, error));
+    CHECK(m.partitionOf("AAPL") == 0 && m.partitionOf("MSFT") == 1);
+    CHECK(m.partitionOf("GOOG") == 2 && m.partitionOf("") == 2);
+
+    // Without "*", unlisted symbols are spread over every partition, the
+    // same way every time
+    CHECK(load("tcp://a:1 AAPL\ntcp://b:2\ntcp://c:3\n", m, error));
+    CHECK(m.placement() == "fnv1a tcp://a:1 tcp://b:2 tcp://c:3");
+    std::set<size_t> used;
+    for (int i = 0; i < 100; ++i) {
+        const std::string symbol = "S" + std::to_string(i);
+        const size_t p = m.partitionOf(symbol);
+        CHECK(p < 3 && m.partitionOf(std::string(symbol)) == p);
+        used.insert(p);
+    }
+    CHECK(used.size() == 3);
+
+    CHECK(m.partitionOfOrder(partitionIdBase(1) + 5) == 1);
+    CHECK(m.partitionOfOrder(partitionIdBase(2)) == 2);
+    CHECK(m.partitionOfOrder(7) == 0);
+    CHECK(m.partitionOfOrder(partitionIdBase(3) + 1) == 0);
+}
+
+static std::string message(MsgType type, const std::string& body) {
+    return "{\"header\":{\"version\":1,\"type\":" + std::to_string(static_cast<int>(type)) +
+           ",\"seq\":1,\"client_id\":7},\"body\":{" + body + "}}";
+}
+
+// Everything that has reached a partition's PULL, waiting briefly for the first
+static std::vector<std::string> drain(zmq::socket_t& s) {
+    std::vector<std::string> got;
+    zmq::message_t m;
+    s.set(zmq::sockopt::rcvtimeo, 500);
+    while (s.recv(m, zmq::recv_flags::none)) {
+        got.push_back(m.to_string());
+        s.set(zmq::sockopt::rcvtimeo, 50);
+    }
+    return got;
+}
+
+static void testRouting(zmq::context_t& context) {
+    std::remove((kMapPath + ".placement").c_str());
+    writeMap("inproc://test_partition_0 AAPL\ninproc://test_partition_1 MSFT *\n");
+
+    zmq::socket_t p0(context, zmq::socket_type::pull), p1(context, zmq::socket_type::pull);
+    p0.bind("inproc://test_partition_0");
+    p1.bind("inproc://test_partition_1");
+    PartitionRouter router(context, "inproc://test_partition_in", kMapPath);
+    CHECK(router.load());
+    std::thread front(&PartitionRouter::run, &router);
+
+    const std::string aapl = message(MsgType::NewOrder, "\"symbol\":\"AAPL\",\"qty\":1");
+    const std::string goog = message(MsgType::NewOrder, "\"symbol\":\"GOOG\",\"qty\":1");
+    const std::string cancel0 = message(MsgType::Cancel, "\"order_id\":12");
+    const std::string replace1 = message(MsgType::Replace, "\"order_id\":" +
+                                         std::to_string(partitionIdBase(1) + 3) + ",\"qty\":5");
+    const std::string by_client_id = message(MsgType::Cancel, "\"client_order_id\":" +
+                                             std::to_string(partitionIdBase(1)));
+    const std::string heartbeat = message(MsgType::Heartbeat, "");
+    zmq::socket_t client(context, zmq::socket_type::push);
+    client.connect("inproc://test_partition_in");
+    for (const std::string* m : {&aapl, &goog, &cancel0, &replace1, &by_client_id}) {
+        client.send(zmq::buffer(*m), zmq::send_flags::none);
+    }
+    // One multipart batch, split between the partitions
+    client.send(zmq::buffer(aapl), zmq::send_flags::sndmore);
+    client.send(zmq::buffer(heartbeat), zmq::send_flags::sndmore);
+    client.send(zmq::buffer(goog), zmq::send_flags::none);
+
+    CHECK((drain(p0) == std::vector<std::string>{aapl, cancel0, by_client_id, aapl, heartbeat}));
+    CHECK((drain(p1) == std::vector<std::string>{goog, replace1, heartbeat, goog}));
+    CHECK(router.counters().forwarded == 7 && router.counters().broadcast == 1);
+
+    router.stop();
+    front.join();
+}
+
+static void testPlacementKept(zmq::context_t& context) {
+    std::remove((kMapPath + ".placement").c_str());
+    writeMap("inproc://test_placement_0\ninproc://test_placement_1\n");
+    PartitionRouter router(context, "inproc://test_placement_in", kMapPath);
+    CHECK(router.load());
+
+    // Listing a symbol is fine; another hashed partition would move the rest
+    writeMap("inproc://test_placement_0 AAPL\ninproc://test_placement_1\n");
+    CHECK(router.load());
+    writeMap("inproc://test_placement_0\ninproc://test_placement_1\ninproc://test_placement_2\n");
+    CHECK(!router.load());
+    CHECK(router.counters().reloads == 2 && router.counters().partitions == 2);
+
+    // Recorded under another hash: the same endpoints no longer mean the
+    // same placement
+    std::ofstream(kMapPath + ".placement") << "hash inproc://test_placement_0 inproc://test_placement_1\n";
+    writeMap("inproc://test_placement_0\ninproc://test_placement_1\n");
+    CHECK(!router.load());
+}
+
+int main() {
+    testLoad();
+    testPartitionOf();
+    {
+        zmq::context_t context(1);
+        testRouting(context);
+        testPlacementKept(context);
+    }
+    std::remove(kMapPath.c_str());
+    std::remove((kMapPath + ".placement").c_str());
+
+    std::cout << (failures == 0 ? "PASS" : "FAIL") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
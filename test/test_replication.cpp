@@ -0,0 +1,141 @@
+// Unit tests for primary/backup replication over loopback: records arrive
+// in order and are acked, the release watermark reaches the backup, the
+// primary fences itself when the backup goes or stops acking, and a backup
+// waits out the primary's silence before it may take over.
+//
+// g++ -std=c++17 -I./include test/test_replication.cpp src/replication.cpp -lpthread -o test_replication
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include "replication.hpp"
+
+using namespace ex;
+using Clock = std::chrono::steady_clock;
+
+static int failures = 0;
+
+#define CHECK(cond)                                                                   \
+    do {                                                                              \
+        if (!(cond)) {                                                                \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #cond << std::endl; \
+            failures++;                                                               \
+        }                                                                             \
+    } while (0)
+
+static std::atomic<int> fences{0};
+
+static void onFence() { fences.fetch_add(1); }
+
+static uint16_t port(int n) {
+    return static_cast<uint16_t>(10000 + (::getpid() % 5000) * 2 + n);
+}
+
+template <class Cond>
+static bool waitFor(Cond&& cond, int ms = 2000) {
+    const auto deadline = Clock::now() + std::chrono::milliseconds(ms);
+    while (!cond()) {
+        if (Clock::now() > deadline) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+// Connects backup to primary, which blocks in waitForBackup until it does
+static bool pair(ReplicationPrimary& primary, ReplicationBackup& backup, uint16_t p) {
+    bool listening = false;
+    std::thread accept([&] { listening = primary.waitForBackup(); });
+    const bool connected = waitFor([&] { return backup.connect("127.0.0.1", p); });
+    accept.join();
+    return connected && listening;
+}
+
+static void testStream() {
+    const uint16_t p = port(0);
+    ReplicationPrimary primary(p);
+    std::atomic<uint64_t> released{0};
+    primary.fenceWith(onFence);
+    primary.reportReleased(&released);
+    auto backup = std::make_unique<ReplicationBackup>();
+    CHECK(pair(primary, *backup, p));
+    primary.start();
+
+    for (uint64_t seq = 1; seq <= 3; ++seq) primary.append(seq, 100 + seq, "m" + std::to_string(seq));
+    std::vector<ReplicationRecord> got;
+    while (got.size() < 3 && backup->receive(got, 2000)) {}
+    CHECK(got.size() == 3);
+    for (size_t i = 0; i < got.size(); ++i) {
+        CHECK(got[i].seq == i + 1 && got[i].recv_ns == 101 + i && got[i].payload == "m" + std::to_string(i + 1));
+    }
+    CHECK(backup->lastSeq() == 3);
+    CHECK(waitFor([&] { return primary.replicated()->load() == 3; }));
+
+    // The primary's release watermark rides on its heartbeats
+    released.store(2);
+    CHECK(waitFor([&] { return backup->receive(got, 2000) && backup->released()->load() == 2; }));
+    CHECK(got.size() == 3);
+    CHECK(primary.counters().connected && primary.counters().sent == 3 && !primary.fenced());
+
+    // The backup goes: the primary fences itself and its watermark stops
+    backup.reset();
+    CHECK(waitFor([&] { return primary.fenced(); }));
+    CHECK(fences.load() == 1 && !primary.counters().connected);
+    primary.append(4, 104, "m4");
+    CHECK(waitFor([&] { return primary.counters().sent == 4; }));
+    CHECK(primary.replicated()->load() == 3);
+    primary.stop();
+}
+
+static void testAckTimeout() {
+    const uint16_t p = port(1);
+    ReplicationPrimary primary(p);
+    primary.fenceWith(onFence);
+    ReplicationBackup backup;
+    CHECK(pair(primary, backup, p));
+
+    // Connected but never reading, so never acking
+    const auto t0 = Clock::now();
+    primary.start();
+    CHECK(waitFor([&] { return primary.fenced(); }, 4 * kAckTimeoutMs));
+    CHECK(Clock::now() - t0 >= std::chrono::milliseconds(kAckTimeoutMs));
+    CHECK(fences.load() == 2);
+    primary.stop();
+}
+
+static void testTakeover() {
+    const uint16_t p = port(0);
+    ReplicationPrimary primary(p);
+    ReplicationBackup backup;
+    CHECK(pair(primary, backup, p));
+    primary.start();
+    primary.append(1, 0, "m1");
+    std::vector<ReplicationRecord> got;
+    while (got.empty() && backup.receive(got, 2000)) {}
+    CHECK(got.size() == 1);
+
+    // A primary gone quiet is given up on only after the silence timeout,
+    // and served over only once kTakeoverMs has passed since it last spoke
+    primary.stop();
+    const auto stopped = Clock::now();
+    while (backup.receive(got, 200)) {}
+    CHECK(Clock::now() - stopped >= std::chrono::milliseconds(200));
+    backup.awaitFence();
+    CHECK(Clock::now() - stopped >= std::chrono::milliseconds(kTakeoverMs - 150));
+    CHECK(!backup.receive(got, 0));
+    CHECK(got.size() == 1 && backup.lastSeq() == 1);
+}
+
+int main() {
+    testStream();
+    testAckTimeout();
+    testTakeover();
+
+    std::cout << (failures == 0 ? "PASS" : "FAIL") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
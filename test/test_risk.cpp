@@ -0,0 +1,178 @@
+// Unit tests for the pre-trade RiskChecker: one case per RejectCode it can
+// return, plus the open-order bookkeeping a rejected order must leave alone.
+//
+// g++ -std=c++17 -I./include test/test_risk.cpp src/risk_checker.cpp -o test_risk
+
+#include <cstdint>
+#include <iostream>
+#include "risk_checker.hpp"
+
+using namespace ex;
+
+static int failures = 0;
+
+#define CHECK(cond)                                                                   \
+    do {                                                                              \
+        if (!(cond)) {                                                                \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #cond << std::endl; \
+            failures++;                                                               \
+        }                                                                             \
+    } while (0)
+
+static constexpr ClientId kClient = 7;
+
+static Order limit(Side side, double px, Qty qty) {
+    Order o(0, 0, 0, "AAPL", side, MsgType::NewOrder, px, qty);
+    o.client_id = kClient;
+    return o;
+}
+
+static Order market(Side side, Qty qty) {
+    Order o = limit(side, 0, qty);
+    o.ord_type = OrdType::Market;
+    return o;
+}
+
+static RiskLimits limits() {
+    RiskLimits l;
+    l.max_order_qty = 1000;
+    l.max_notional = 100000;
+    l.price_collar_bps = 1000;
+    l.max_open_orders = 3;
+    l.max_gross_position = 2000;
+    return l;
+}
+
+static uint32_t openOrders(const RiskChecker& risk) {
+    const ClientRiskState* s = risk.state(kClient);
+    return s ? s->open_orders : 0;
+}
+
+static void testNone() {
+    RiskChecker risk(limits());
+    CHECK(risk.check(limit(Side::Buy, 100, 10), 100) == RejectCode::None);
+    CHECK(openOrders(risk) == 1 && risk.state(kClient)->open_buy_qty == 10);
+
+    // With no notional limit a market order needs no reference price
+    RiskLimits l = limits();
+    l.max_notional = 0;
+    RiskChecker unlimited(l);
+    CHECK(unlimited.check(market(Side::Sell, 10), 0) == RejectCode::None);
+}
+
+static void testInvalidOrder() {
+    RiskChecker risk(limits());
+    CHECK(risk.check(limit(Side::Buy, 100, 0), 100) == RejectCode::InvalidOrder);
+    CHECK(risk.check(limit(Side::Buy, 100, -5), 100) == RejectCode::InvalidOrder);
+    CHECK(risk.check(limit(Side::Buy, 100, Qty(UINT32_MAX) + 11), 100) == RejectCode::InvalidOrder);
+    CHECK(risk.check(limit(Side::Buy, -100, 10), 100) == RejectCode::InvalidOrder);
+    CHECK(risk.check(limit(Side::Buy, 0, 10), 100) == RejectCode::InvalidOrder);
+
+    Order iceberg = limit(Side::Buy, 100, 10);
+    iceberg.display_qty = -1;
+    CHECK(risk.check(iceberg, 100) == RejectCode::InvalidOrder);
+
+    Order stop = limit(Side::Sell, 0, 10);
+    stop.ord_type = OrdType::Stop;
+    CHECK(risk.check(stop, 100) == RejectCode::InvalidOrder);
+    Order stop_limit = limit(Side::Sell, 95, 10);
+    stop_limit.ord_type = OrdType::StopLimit;
+    stop_limit.stop_price = -1;
+    CHECK(risk.check(stop_limit, 100) == RejectCode::InvalidOrder);
+    stop_limit.stop_price = 96;
+    stop_limit.price = 0;
+    CHECK(risk.check(stop_limit, 100) == RejectCode::InvalidOrder);
+
+    // None of them is counted as open
+    CHECK(openOrders(risk) == 0);
+}
+
+static void testMaxOrderQty() {
+    RiskChecker risk(limits());
+    CHECK(risk.check(limit(Side::Buy, 10, 1001), 10) == RejectCode::MaxOrderQty);
+}
+
+static void testNoReferencePrice() {
+    RiskChecker risk(limits());
+    CHECK(risk.check(market(Side::Buy, 10), 0) == RejectCode::NoReferencePrice);
+    CHECK(openOrders(risk) == 0);
+    CHECK(risk.check(market(Side::Buy, 10), 100) == RejectCode::None);
+}
+
+static void testMaxNotional() {
+    RiskChecker risk(limits());
+    CHECK(risk.check(limit(Side::Buy, 101, 1000), 100) == RejectCode::MaxNotional);
+    // A market order is sized at the last trade
+    CHECK(risk.check(market(Side::Buy, 1000), 101) == RejectCode::MaxNotional);
+}
+
+static void testPriceCollar() {
+    RiskChecker risk(limits());
+    CHECK(risk.check(limit(Side::Buy, 111, 10), 100) == RejectCode::PriceCollar);
+    CHECK(risk.check(limit(Side::Buy, 89, 10), 100) == RejectCode::PriceCollar);
+    // No collar before the first trade
+    CHECK(risk.check(limit(Side::Buy, 111, 10), 0) == RejectCode::None);
+}
+
+static void testMaxOpenOrders() {
+    RiskChecker risk(limits());
+    for (int i = 0; i < 3; ++i) CHECK(risk.check(limit(Side::Buy, 100, 1), 100) == RejectCode::None);
+    CHECK(risk.check(limit(Side::Buy, 100, 1), 100) == RejectCode::MaxOpenOrders);
+    risk.onCancel(kClient, Side::Buy, 1, true);
+    CHECK(risk.check(limit(Side::Buy, 100, 1), 100) == RejectCode::None);
+}
+
+static void testMaxGrossPosition() {
+    RiskChecker risk(limits());
+    CHECK(risk.check(limit(Side::Buy, 10, 1000), 10) == RejectCode::None);
+    risk.onFill(kClient, Side::Buy, 1000, true);
+    CHECK(risk.check(limit(Side::Sell, 10, 1000), 10) == RejectCode::None);
+    CHECK(risk.check(limit(Side::Sell, 10, 1), 10) == RejectCode::MaxGrossPosition);
+}
+
+static void testKillSwitch() {
+    RiskChecker risk(limits());
+    risk.setBlocked(kClient, true);
+    CHECK(risk.check(limit(Side::Buy, 100, 10), 100) == RejectCode::KillSwitch);
+    CHECK(risk.checkReplace(limit(Side::Buy, 100, 10), Side::Buy, 10, 100) == RejectCode::KillSwitch);
+    risk.setBlocked(kClient, false);
+    CHECK(risk.check(limit(Side::Buy, 100, 10), 100) == RejectCode::None);
+}
+
+static void testReplace() {
+    RiskChecker risk(limits());
+    CHECK(risk.check(limit(Side::Buy, 100, 10), 100) == RejectCode::None);
+
+    CHECK(risk.checkReplace(limit(Side::Buy, 100, Qty(UINT32_MAX) + 1), Side::Buy, 10, 100) ==
+          RejectCode::InvalidReplace);
+    CHECK(risk.checkReplace(limit(Side::Buy, -1, 10), Side::Buy, 10, 100) == RejectCode::InvalidReplace);
+    CHECK(risk.checkReplace(limit(Side::Buy, 100, 1001), Side::Buy, 10, 100) == RejectCode::MaxOrderQty);
+    CHECK(risk.checkReplace(limit(Side::Buy, 101, 1000), Side::Buy, 10, 100) == RejectCode::MaxNotional);
+    CHECK(risk.checkReplace(limit(Side::Buy, 120, 10), Side::Buy, 10, 100) == RejectCode::PriceCollar);
+    CHECK(risk.checkReplace(limit(Side::Buy, 1, 999), Side::Buy, 10, 1) == RejectCode::None);
+    CHECK(risk.state(kClient)->open_buy_qty == 999);
+    risk.onFill(kClient, Side::Buy, 999, true);
+    CHECK(risk.check(limit(Side::Buy, 1, 999), 1) == RejectCode::None);
+    CHECK(risk.checkReplace(limit(Side::Buy, 1, 1002), Side::Buy, 999, 1) == RejectCode::MaxOrderQty);
+    CHECK(risk.checkReplace(limit(Side::Buy, 1, 1000), Side::Buy, 999, 1) == RejectCode::None);
+    CHECK(risk.check(limit(Side::Buy, 1, 2), 1) == RejectCode::MaxGrossPosition);
+
+    // A replace never changes the open-order count
+    CHECK(openOrders(risk) == 1);
+}
+
+int main() {
+    testNone();
+    testInvalidOrder();
+    testMaxOrderQty();
+    testNoReferencePrice();
+    testMaxNotional();
+    testPriceCollar();
+    testMaxOpenOrders();
+    testMaxGrossPosition();
+    testKillSwitch();
+    testReplace();
+
+    std::cout << (failures == 0 ? "PASS" : "FAIL") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,228 @@
+// Unit tests for the ingress scanners: the quote kernels against the plain
+// one, QuoteCursor over every length and escape, and scan_header against
+// nlohmann on well-formed messages, at every alignment and with each kernel,
+// and on every truncation of one.
+//
+// g++ -std=c++17 -I./include test/test_scan.cpp -o test_scan
+
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "net/codec_json.hpp"
+
+using namespace ex;
+
+static int failures = 0;
+
+#define CHECK(cond)                                                                   \
+    do {                                                                              \
+        if (!(cond)) {                                                                \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #cond << std::endl; \
+            failures++;                                                               \
+        }                                                                             \
+    } while (0)
+
+// Every kernel this CPU can run
+static std::vector<json_scan::Isa> isas() {
+    std::vector<json_scan::Isa> out{json_scan::Isa::Scalar};
+#ifdef EX_JSON_SCAN_X86
+    out.push_back(json_scan::Isa::Sse2);
+    if (json_scan::best_isa() == json_scan::Isa::Avx2) out.push_back(json_scan::Isa::Avx2);
+#endif
+    return out;
+}
+
+static void testKernels() {
+    std::mt19937 rng(7);
+    char block[64];
+    for (int n = 0; n < 10000; ++n) {
+        // From no quotes to all quotes, and bytes with the top bit set
+        const unsigned density = rng() % 65;
+        for (char& c : block) c = rng() % 64 < density ? '"' : static_cast<char>(rng());
+        const uint64_t want = json_scan::quotes_scalar(block);
+        for (json_scan::Isa isa : isas()) CHECK(json_scan::kernel_for(isa)(block) == want);
+    }
+}
+
+static void testQuoteCursor() {
+    std::mt19937 rng(11);
+    for (json_scan::Isa isa : isas()) {
+        json_scan::use_isa(isa);
+        for (size_t len = 0; len <= 200; ++len) {
+            std::string s(len, 'x');
+            std::vector<size_t> quotes;
+            for (size_t i = 0; i < len; ++i) {
+                if (rng() % 5 == 0) {
+                    s[i] = '"';
+                    quotes.push_back(i);
+                }
+            }
+            std::unique_ptr<char[]> buf(new char[len]);
+            std::copy(s.begin(), s.end(), buf.get());
+            json_scan::QuoteCursor cursor(buf.get(), len);
+            std::vector<size_t> got;
+            while (const char* q = cursor.next()) got.push_back(static_cast<size_t>(q - buf.get()));
+            CHECK(got == quotes);
+            CHECK(cursor.next() == nullptr);
+        }
+    }
+    json_scan::use_isa(json_scan::best_isa());
+
+    // close() passes over quotes escaped by an odd run of backslashes only
+    const std::string s = "\"a\\\"b\\\\\"c\\\\\\\"d\"";
+    json_scan::QuoteCursor cursor(s.data(), s.size());
+    CHECK(cursor.next() == s.data());
+    const char* close = cursor.close();
+    CHECK(close && static_cast<size_t>(close - s.data()) == s.find("\"c"));
+    close = cursor.close();
+    CHECK(close && static_cast<size_t>(close - s.data()) == s.size() - 1);
+    CHECK(cursor.close() == nullptr);
+
+    // parse_uint stops at the first non-digit
+    const std::string digits = "0012345x";
+    const char* p = digits.data();
+    uint64_t v = 0;
+    CHECK(json_scan::parse_uint(p, digits.data() + digits.size(), v) && v == 12345 && *p == 'x');
+    CHECK(!json_scan::parse_uint(p, digits.data() + digits.size(), v));
+}
+
+// What scan_header should find, from nlohmann's parse of the same bytes:
+// header.type, seq and client_id as the fast NewOrder parse takes them, and
+// body.symbol unless it was written with escapes
+static HeaderFields expected(const std::string& raw) {
+    HeaderFields h;
+    const json j = json::parse(raw);
+    const json& header = j.at("header");
+    auto it = header.find("type");
+    if (it != header.end()) {
+        if (it->is_number_unsigned() && it->get<uint64_t>() <= 0xFFFF) {
+            h.type = static_cast<MsgType>(it->get<uint64_t>());
+            h.found |= HeaderFields::kType;
+        } else if (it->is_string() && msgtype_from_name(it->get_ref<const std::string&>(), h.type)) {
+            h.found |= HeaderFields::kType;
+        }
+    }
+    it = header.find("seq");
+    if (it != header.end() && it->is_number_unsigned() && it->get<uint64_t>() <= 999999999999999999ull) {
+        h.seq = it->get<uint64_t>();
+        h.found |= HeaderFields::kSeq;
+    }
+    it = header.find("client_id");
+    if (it != header.end() && it->is_number_unsigned() && it->get<uint64_t>() <= 0xFFFFFFFFull) {
+        h.client_id = static_cast<ClientId>(it->get<uint64_t>());
+        h.found |= HeaderFields::kClientId;
+    }
+    auto body = j.find("body");
+    if (body != j.end() && body->contains("symbol") && body->at("symbol").is_string()) {
+        const std::string& symbol = body->at("symbol").get_ref<const std::string&>();
+        const size_t at = raw.find("\"" + symbol + "\"");
+        if (at != std::string::npos) {
+            h.symbol = std::string_view(raw).substr(at + 1, symbol.size());
+            h.found |= HeaderFields::kSymbol;
+        }
+    }
+    return h;
+}
+
+static bool same(const HeaderFields& a, const HeaderFields& b) {
+    return a.found == b.found && (!a.has(HeaderFields::kType) || a.type == b.type) &&
+           (!a.has(HeaderFields::kSeq) || a.seq == b.seq) &&
+           (!a.has(HeaderFields::kClientId) || a.client_id == b.client_id) &&
+           (!a.has(HeaderFields::kSymbol) || a.symbol == b.symbol);
+}
+
+static const std::string kOrder =
+    "\"client_order_id\":999,\"symbol\":\"AAPL\",\"side\":\"B\",\"ord_type\":\"LMT\",\"qty\":10,\"limit_price\":10123";
+
+// Well-formed messages whose fields appear once each
+static const std::vector<std::string> kMessages = {
+    "{\"header\":{\"version\":1,\"type\":1,\"seq\":12,\"client_id\":7},\"body\":{" + kOrder + "}}",
+    "{ \"body\" : {\n \"symbol\" : \"MSFT\", \"qty\" : 5 },\n \"header\" : { \"client_id\" : 4294967295 ,"
+    " \"seq\" : 999999999999999999, \"type\" : \"NEW_ORDER\" } }",
+    "{\"header\":{\"type\":\"Cancel\",\"seq\":3,\"client_id\":9},\"body\":{\"order_id\":5}}",
+    "{\"header\":{\"type\":3,\"seq\":1},\"body\":{\"scope\":\"ALL\"}}",
+    // Keys in string values, escaped quotes, and an escaped symbol
+    "{\"body\":{\"text\":\"\\\"type\\\":4,\\\"seq\\\":5\",\"note\":\"symbol\",\"symbol\":\"AA\\u0050L\"},"
+    "\"header\":{\"type\":1,\"seq\":2,\"client_id\":3}}",
+    "{\"header\":{\"type\":1,\"seq\":2,\"client_id\":3},\"body\":{\"symbol\":\"A\\\\\",\"x\":\"\\\\\"}}",
+    // Values that are not what the header wants
+    "{\"header\":{\"type\":-1,\"seq\":\"12\",\"client_id\":-7},\"body\":{\"symbol\":5}}",
+    "{\"header\":{\"type\":70000,\"seq\":12,\"client_id\":4294967296},\"body\":{}}",
+    "{\"header\":{\"type\":1.0,\"seq\":1e3,\"client_id\":7.5},\"body\":{\"symbol\":\"\"}}",
+    "{\"header\":{\"type\":\"NoSuchType\",\"seq\":1234567890123456789,\"client_id\":0},\"body\":{}}",
+};
+
+static void testAgainstNlohmann() {
+    for (json_scan::Isa isa : isas()) {
+        json_scan::use_isa(isa);
+        for (const std::string& message : kMessages) {
+            // Every alignment of the fields against the 64-byte blocks
+            for (size_t pad = 0; pad < 130; ++pad) {
+                const std::string raw = "{\"pad\":\"" + std::string(pad, 'x') + "\"," + message.substr(1);
+                HeaderFields h;
+                const bool routable = scan_header(raw.data(), raw.size(), h);
+                const HeaderFields want = expected(raw);
+                if (!same(h, want)) {
+                    std::cerr << json_scan::isa_name(isa) << " pad " << pad << ": " << raw << std::endl;
+                }
+                CHECK(same(h, want));
+                CHECK(routable == (h.has(HeaderFields::kType) && h.has(HeaderFields::kClientId)));
+            }
+        }
+    }
+    json_scan::use_isa(json_scan::best_isa());
+}
+
+// A number cut short by the truncation reads as a prefix of its digits
+static bool digitsPrefix(uint64_t part, uint64_t full) {
+    return std::to_string(full).compare(0, std::to_string(part).size(), std::to_string(part)) == 0;
+}
+
+static void testTruncated() {
+    for (json_scan::Isa isa : isas()) {
+        json_scan::use_isa(isa);
+        for (size_t m = 0; m < 4; ++m) {
+            const std::string& raw = kMessages[m];
+            HeaderFields full;
+            scan_header(raw.data(), raw.size(), full);
+            for (size_t n = 0; n <= raw.size(); ++n) {
+                // Exactly n bytes on the heap, so a sanitizer sees any read past them
+                std::unique_ptr<char[]> buf(new char[n]);
+                std::copy(raw.data(), raw.data() + n, buf.get());
+                HeaderFields h;
+                const bool routable = scan_header(buf.get(), n, h);
+                CHECK(routable == (h.has(HeaderFields::kType) && h.has(HeaderFields::kClientId)));
+                CHECK((h.found & ~full.found) == 0);
+                if (h.has(HeaderFields::kType)) CHECK(digitsPrefix(to_u(h.type), to_u(full.type)));
+                if (h.has(HeaderFields::kSeq)) CHECK(digitsPrefix(h.seq, full.seq));
+                if (h.has(HeaderFields::kClientId)) CHECK(digitsPrefix(h.client_id, full.client_id));
+                if (h.has(HeaderFields::kSymbol)) {
+                    CHECK(h.symbol.data() > buf.get() && h.symbol.data() + h.symbol.size() < buf.get() + n);
+                    CHECK(h.symbol == full.symbol);
+                }
+            }
+        }
+    }
+    json_scan::use_isa(json_scan::best_isa());
+
+    // Not JSON at all
+    for (const std::string& raw : {std::string("\"\"\""), std::string("\"type\"::1,\"client_id\":2"),
+                                   std::string("\"type\" 1 \"client_id\" 2"), std::string("{\"symbol\":\"AAPL")}) {
+        HeaderFields h;
+        CHECK(!scan_header(raw.data(), raw.size(), h));
+        CHECK(!h.has(HeaderFields::kSymbol));
+    }
+}
+
+int main() {
+    testKernels();
+    testQuoteCursor();
+    testAgainstNlohmann();
+    testTruncated();
+
+    std::cout << (failures == 0 ? "PASS" : "FAIL") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -5,18 +5,26 @@ import random
 import threading
 
 class ExchangeTester:
-    def __init__(self, in_port="5555", out_port="5556"):
+    def __init__(self, in_port="5555", out_port="5556", transport="tcp"):
         self.context = zmq.Context()
+
+        # transport must match the exchange's: `market_exchange ipc` for ipc
+        if transport == "ipc":
+            in_endpoint = f"ipc:///tmp/market_exchange_{in_port}"
+            out_endpoint = f"ipc:///tmp/market_exchange_{out_port}"
+        else:
+            in_endpoint = f"tcp://127.0.0.1:{in_port}"
+            out_endpoint = f"tcp://*:{out_port}"
         
         # Setup Senders (PUSH to 5555)
         self.sender = self.context.socket(zmq.PUSH)
         self.sender.set(zmq.SNDHWM, 100000)
-        self.sender.connect(f"tcp://127.0.0.1:{in_port}")
+        self.sender.connect(in_endpoint)
         
         # Setup Receiver (PULL from 5556)
         self.receiver = self.context.socket(zmq.PULL)
         self.receiver.set(zmq.RCVHWM, 100000)
-        self.receiver.bind(f"tcp://*:{out_port}")
+        self.receiver.bind(out_endpoint)
         
         self.running = False
         self.response_count = 0
@@ -44,6 +52,8 @@ class ExchangeTester:
         """Background thread loop to pull messages constantly."""
         self.ack_count = 0
         self.rej_count = 0
+        self.fill_count = 0
+        self.cancel_count = 0
 
         while self.running:
             if self.receiver.poll(100):
@@ -65,8 +75,14 @@ class ExchangeTester:
                         # print(f"[RECV REJECT] Reason: {reason} | Total Rejects: {self.rej_count}")
                     
                     elif msg_type == 102:  # MsgType::Fill
+                        self.fill_count += 1
                         # print(f"[RECV FILL] OrderID: {resp['body'].get('order_id')} filled.")
-                        return
+
+                    elif msg_type == 103:  # MsgType::Cancelled
+                        self.cancel_count += 1
+
+                    elif msg_type == 104:  # MsgType::MassCancelAck
+                        print(f"[RECV MASS CANCEL ACK] Cancelled: {resp['body'].get('cancelled_count')}")
                     
                     # Optional: Print the full raw JSON for deep debugging
                     # print(json.dumps(resp, indent=4))
@@ -79,12 +95,16 @@ class ExchangeTester:
         return {
             "total": self.response_count,
             "acks": self.ack_count,
-            "rejects": self.rej_count
+            "rejects": self.rej_count,
+            "fills": self.fill_count,
+            "cancels": self.cancel_count
         }
 
-    def send_valid(self, num=10):
+    def send_valid(self, num=10, batch=1):
+        """batch > 1 sends multipart messages of that many orders, one per part."""
         print(f"\n--- Sending {num} Valid Orders ---")
         symbols = ["AAPL", "TSLA", "GOOG", "MSFT"]
+        parts = []
         for i in range(num):
             client_id = 20000 + i
             order = {
@@ -98,7 +118,10 @@ class ExchangeTester:
                     "limit_price": 15000
                 }
             }
-            self.sender.send_json(order)
+            parts.append(json.dumps(order).encode())
+            if len(parts) == batch or i == num - 1:
+                self.sender.send_multipart(parts)
+                parts = []
         print(f"[DONE] Sent {num} valid orders.")
 
 
@@ -112,6 +135,16 @@ class ExchangeTester:
 
 
 
+    def send_mass_cancel(self, client_id=55, scope="CLIENT", symbol=None):
+        print(f"\n--- Mass cancel for client {client_id} (scope {scope}) ---")
+        body = {"client_order_id": 1, "scope": scope}
+        if symbol:
+            body["symbol"] = symbol
+        request = {"header": {"version": 1, "type": 3, "seq": 0, "client_id": client_id}, "body": body}
+        self.sender.send_json(request)
+
+
+
     def stop(self):
         """Gracefully stops the background thread and cleans up ZMQ."""
         print(f"\n[INFO] Stopping tester. Final Response Count: {self.response_count}")
@@ -127,14 +160,18 @@ class ExchangeTester:
 
 
 if __name__ == "__main__":
-    tester = ExchangeTester()
+    import sys
+    tester = ExchangeTester(transport=sys.argv[1] if len(sys.argv) > 1 else "tcp")
     
     # 1. Start the background consumer
     tester.start_listening()
     
     # 2. Run high-volume tests
     tester.send_valid(num=10)
+    tester.send_valid(num=10, batch=5)
     tester.send_invalid(num=10)
+    time.sleep(0.5)
+    tester.send_mass_cancel(client_id=55)
     
     # 3. Wait for workers to finish processing and sending Acks
     print("Waiting for final responses...")
@@ -149,4 +186,5 @@ if __name__ == "__main__":
     print(f"Total Acknowledgements: {stats.get('acks')}")
 
     # Full summary line
-    print(f"Final Report -> ACKs: {stats.get('acks')} | Rejects: {stats.get('rejects')} | Total: {stats.get('total')}")
\ No newline at end of file
+    print(f"Final Report -> ACKs: {stats.get('acks')} | Rejects: {stats.get('rejects')} | Total: {stats.get('total')}")
+    print(f"Fills: {stats.get('fills')} | Cancelled: {stats.get('cancels')}")
\ No newline at end of file
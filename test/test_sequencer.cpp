@@ -0,0 +1,147 @@
+// Unit tests for the Sequencer and the ReorderBuffer behind it: gapless
+// numbering, reordering, giving up on gaps by timeout and by window, late
+// arrivals and restarts.
+//
+// g++ -std=c++17 -I./include test/test_sequencer.cpp -lpthread -o test_sequencer
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "reorder_buffer.hpp"
+#include "sequencer.hpp"
+
+using namespace ex;
+
+static int failures = 0;
+
+#define CHECK(cond)                                                                   \
+    do {                                                                              \
+        if (!(cond)) {                                                                \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #cond << std::endl; \
+            failures++;                                                               \
+        }                                                                             \
+    } while (0)
+
+static constexpr uint64_t kTimeout = 1000;
+
+// A buffer whose items are their own numbers, and what it has delivered
+struct Reorder {
+    explicit Reorder(size_t window = 16, uint64_t first_seq = 1) : buf(first_seq, window, kTimeout) {}
+
+    void push(uint64_t seq, uint64_t now_ns = 0) {
+        buf.push(seq, seq, now_ns, [this](uint64_t& s) { delivered.push_back(s); });
+    }
+    void expire(uint64_t now_ns) {
+        buf.expire(now_ns, [this](uint64_t& s) { delivered.push_back(s); });
+    }
+
+    ReorderBuffer<uint64_t> buf;
+    std::vector<uint64_t> delivered;
+};
+
+static void testInOrder() {
+    Reorder r;
+    for (uint64_t s = 1; s <= 5; ++s) r.push(s);
+    CHECK((r.delivered == std::vector<uint64_t>{1, 2, 3, 4, 5}));
+    CHECK(!r.buf.waiting() && r.buf.nextSeq() == 6);
+    CHECK(r.buf.counters().skipped == 0 && r.buf.counters().late == 0);
+}
+
+static void testReorders() {
+    Reorder r;
+    r.push(3);
+    r.push(2);
+    CHECK(r.delivered.empty() && r.buf.waiting());
+    r.push(1);
+    CHECK((r.delivered == std::vector<uint64_t>{1, 2, 3}));
+    CHECK(!r.buf.waiting() && r.buf.counters().max_held == 3);
+}
+
+static void testGapTimeout() {
+    Reorder r;
+    r.push(1, 0);
+    r.push(5, 100);
+    r.push(6, 200);
+    CHECK((r.delivered == std::vector<uint64_t>{1}));
+    CHECK(r.buf.untilExpiryNs(300) == kTimeout - 200);
+
+    // Not yet overdue, then the whole run 2..4 is given up on at once
+    r.expire(100 + kTimeout - 1);
+    CHECK(r.delivered.size() == 1);
+    r.expire(100 + kTimeout);
+    CHECK((r.delivered == std::vector<uint64_t>{1, 5, 6}));
+    CHECK(r.buf.counters().skipped == 3 && r.buf.nextSeq() == 7);
+
+    // One turning up afterwards is delivered at once, as late
+    r.push(3);
+    CHECK(r.delivered.back() == 3 && r.buf.counters().late == 1);
+    CHECK(!r.buf.waiting());
+}
+
+static void testWindow() {
+    // Four slots: 2..4 held behind 1, then 5 does not fit and 1 is skipped
+    Reorder r(4);
+    for (uint64_t s = 2; s <= 4; ++s) r.push(s);
+    CHECK(r.delivered.empty());
+    r.push(5);
+    CHECK((r.delivered == std::vector<uint64_t>{2, 3, 4, 5}));
+    CHECK(r.buf.counters().skipped == 1);
+
+    // Nothing held: a far number is jumped to, not walked to
+    r.push(1000);
+    CHECK(r.delivered.back() == 1000 && r.buf.nextSeq() == 1001);
+    CHECK(r.buf.counters().skipped == 1 + 994);
+}
+
+static void testRestart() {
+    Reorder r;
+    r.push(1);
+    r.buf.restart(50);
+    r.push(51);
+    CHECK(r.delivered.size() == 1 && r.buf.waiting());
+    r.push(50);
+    CHECK((r.delivered == std::vector<uint64_t>{1, 50, 51}));
+}
+
+static void testSequencer() {
+    ThreadSafeQueue<InboundMessage> q(4, OverflowPolicy::Block);
+    Sequencer seq(&q, 10);
+    seq.push("a", 7);
+
+    std::vector<InboundMessage> batch(2);
+    batch[0].payload = "b";
+    batch[1].payload = "c";
+    seq.pushAll(batch);
+    CHECK(seq.next() == 13);
+
+    InboundMessage m = q.pop();
+    CHECK(m.seq == 10 && m.payload == "a" && m.session == 7 && m.recv_ns != 0);
+    m = q.pop();
+    CHECK(m.seq == 11 && m.payload == "b");
+    const uint64_t batch_ns = m.recv_ns;
+    m = q.pop();
+    CHECK(m.seq == 12 && m.payload == "c" && m.recv_ns == batch_ns);
+
+    // Only what fits is numbered, so no number is left unqueued
+    std::vector<InboundMessage> more(6);
+    CHECK(seq.tryPushAll(more) == 4);
+    CHECK(seq.full() && seq.next() == 17);
+    for (uint64_t s = 13; s < 17; ++s) CHECK(q.pop().seq == s);
+
+    seq.restart(100);
+    seq.push("d");
+    CHECK(q.pop().seq == 100 && seq.next() == 101);
+}
+
+int main() {
+    testInOrder();
+    testReorders();
+    testGapTimeout();
+    testWindow();
+    testRestart();
+    testSequencer();
+
+    std::cout << (failures == 0 ? "PASS" : "FAIL") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
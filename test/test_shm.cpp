@@ -0,0 +1,142 @@
+// Unit tests for the shared-memory sessions: ShmClient to ShmGateway and
+// back, messages longer than a slot, the client_id check, a full ring, and a
+// client reconnecting after the exchange retires its rings.
+//
+// g++ -std=c++17 -I./include test/test_shm.cpp src/shm_gateway.cpp -lpthread -o test_shm
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "shm_gateway.hpp"
+#include "net/codec_json.hpp"
+#include "net/shm_client.hpp"
+
+using namespace ex;
+
+static int failures = 0;
+
+#define CHECK(cond)                                                                   \
+    do {                                                                              \
+        if (!(cond)) {                                                                \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #cond << std::endl; \
+            failures++;                                                               \
+        }                                                                             \
+    } while (0)
+
+// Out of the way of a running exchange's sessions
+static const ClientId kClient = 1000000 + static_cast<ClientId>(::getpid());
+
+static std::string heartbeat(ClientId client_id, size_t pad = 0) {
+    return "{\"header\":{\"version\":1,\"type\":900,\"seq\":3,\"client_id\":" + std::to_string(client_id) +
+           "},\"body\":{\"pad\":\"" + std::string(pad, 'x') + "\"}}";
+}
+
+// Everything the gateway delivers in one poll
+static std::vector<std::string> poll(ShmGateway& gateway) {
+    std::vector<std::string> got;
+    gateway.poll([&](ClientId client_id, const char* data, size_t len) {
+        CHECK(client_id == kClient);
+        got.emplace_back(data, len);
+    });
+    return got;
+}
+
+static uint64_t rejected(const ShmGateway& gateway) {
+    uint64_t n = 0;
+    gateway.forEachSession([&](const ShmSessionCounters& c) { n += c.rejected; });
+    return n;
+}
+
+static void testRoundTrip() {
+    ShmGateway gateway({kClient}, 16);
+    ShmClient client;
+    CHECK(client.connect(kClient) && !client.closed());
+
+    // One slot, then one spread over three
+    const std::string small = heartbeat(kClient);
+    const std::string large = heartbeat(kClient, 2 * kShmPayload);
+    CHECK(client.send(small) == ShmWrite::Ok);
+    CHECK(client.send(large) == ShmWrite::Ok);
+    const std::vector<std::string> got = poll(gateway);
+    CHECK(got.size() == 2 && got[0] == small && got[1] == large);
+    CHECK(poll(gateway).empty());
+
+    CHECK(gateway.send(kClient, large));
+    CHECK(!gateway.send(kClient + 1, small));
+    std::string msg;
+    CHECK(client.poll(msg) && msg == large);
+    CHECK(!client.poll(msg));
+}
+
+static void testClientIdChecked() {
+    ShmGateway gateway({kClient}, 16);
+    ShmClient client;
+    CHECK(client.connect(kClient));
+
+    // Another client's id, and none at all, are answered on the session
+    CHECK(client.send(heartbeat(kClient + 1)) == ShmWrite::Ok);
+    CHECK(client.send("{\"header\":{\"type\":900,\"seq\":4},\"body\":{}}") == ShmWrite::Ok);
+    CHECK(poll(gateway).empty());
+    CHECK(rejected(gateway) == 2);
+
+    std::string msg;
+    CHECK(client.poll(msg));
+    EnvelopeOut e = json::parse(msg).get<EnvelopeOut>();
+    const Reject* r = std::get_if<Reject>(&e.body);
+    CHECK(r && r->info.code == to_u(RejectCode::NotAuthorized) && e.header.seq == 3);
+    CHECK(client.poll(msg));
+    e = json::parse(msg).get<EnvelopeOut>();
+    r = std::get_if<Reject>(&e.body);
+    CHECK(r && r->info.code == to_u(RejectCode::ParseError) && e.header.seq == 4);
+}
+
+static void testFull() {
+    ShmGateway gateway({kClient}, 4);
+    ShmClient client;
+    CHECK(client.connect(kClient));
+
+    const std::string msg = heartbeat(kClient);
+    for (int i = 0; i < 4; ++i) CHECK(client.send(msg) == ShmWrite::Ok);
+    CHECK(client.send(msg) == ShmWrite::Full);
+    CHECK(client.send(heartbeat(kClient, 4 * kShmPayload)) == ShmWrite::TooLarge);
+    CHECK(poll(gateway).size() == 4);
+    CHECK(client.send(msg) == ShmWrite::Ok);
+
+    // The exchange drops a response rather than wait for the client
+    for (int i = 0; i < 5; ++i) CHECK(gateway.send(kClient, msg));
+    uint64_t dropped = 0;
+    gateway.forEachSession([&](const ShmSessionCounters& c) { dropped += c.dropped; });
+    CHECK(dropped == 1);
+}
+
+static void testReconnect() {
+    ShmClient client;
+    {
+        ShmGateway gateway({kClient}, 16);
+        CHECK(client.connect(kClient));
+        CHECK(gateway.send(kClient, heartbeat(kClient)));
+    }
+    // The exchange went away: its rings are retired, but what it wrote can
+    // still be read
+    CHECK(client.closed());
+    CHECK(client.send(heartbeat(kClient)) == ShmWrite::Closed);
+    std::string msg;
+    CHECK(client.poll(msg));
+
+    ShmGateway restarted({kClient}, 16);
+    CHECK(client.connect(kClient) && !client.closed());
+    CHECK(client.send(heartbeat(kClient)) == ShmWrite::Ok);
+    CHECK(poll(restarted).size() == 1);
+}
+
+int main() {
+    testRoundTrip();
+    testClientIdChecked();
+    testFull();
+    testReconnect();
+
+    std::cout << (failures == 0 ? "PASS" : "FAIL") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,97 @@
+// Unit tests for ClientThrottle: burst, refill at the configured rate, the
+// burst cap on refill, per-client buckets and their counters.
+//
+// g++ -std=c++17 -I./include test/test_throttle.cpp -o test_throttle
+
+#include <cstdint>
+#include <iostream>
+#include "client_throttle.hpp"
+
+using namespace ex;
+
+static int failures = 0;
+
+#define CHECK(cond)                                                                   \
+    do {                                                                              \
+        if (!(cond)) {                                                                \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #cond << std::endl; \
+            failures++;                                                               \
+        }                                                                             \
+    } while (0)
+
+static constexpr uint64_t kMs = 1000000;
+static constexpr uint64_t kStart = 1000 * kMs;
+
+static ThrottleConfig config(double rate, double burst, uint32_t max_clients = 16) {
+    ThrottleConfig c;
+    c.rate_per_sec = rate;
+    c.burst = burst;
+    c.max_clients = max_clients;
+    return c;
+}
+
+// How many of n messages sent at the same instant pass
+static int allowed(ClientThrottle& t, ClientId client_id, uint64_t now_ns, int n) {
+    int passed = 0;
+    for (int i = 0; i < n; ++i) passed += t.allow(client_id, now_ns);
+    return passed;
+}
+
+static void testBurst() {
+    ClientThrottle t(config(1000, 10));
+    CHECK(t.enabled());
+    // A new client starts with a full bucket
+    CHECK(allowed(t, 7, kStart, 15) == 10);
+    CHECK(t.dropped(7) == 5);
+    CHECK(!ClientThrottle(config(0, 10)).enabled());
+}
+
+static void testRefill() {
+    ClientThrottle t(config(1000, 10));
+    CHECK(allowed(t, 7, kStart, 10) == 10);
+    CHECK(!t.allow(7, kStart));
+
+    // 1000/s is one token per millisecond
+    CHECK(allowed(t, 7, kStart + 3 * kMs, 5) == 3);
+    // Half a token is not enough, the other half arrives later
+    CHECK(!t.allow(7, kStart + 3 * kMs + kMs / 2));
+    CHECK(t.allow(7, kStart + 4 * kMs));
+
+    // A long idle spell refills only up to the burst
+    CHECK(allowed(t, 7, kStart + 10000 * kMs, 20) == 10);
+}
+
+static void testClientsIndependent() {
+    ClientThrottle t(config(1000, 2));
+    CHECK(allowed(t, 1, kStart, 3) == 2);
+    CHECK(allowed(t, 2, kStart, 3) == 2);
+
+    uint64_t clients = 0, passed = 0, dropped = 0;
+    t.forEachClient([&](const ThrottleCounters& c) {
+        ++clients;
+        passed += c.passed;
+        dropped += c.dropped;
+    });
+    CHECK(clients == 2 && passed == 4 && dropped == 2);
+}
+
+static void testTableFull() {
+    // Two slots: a third client shares one instead of failing
+    ClientThrottle t(config(1000, 1, 2));
+    CHECK(t.allow(1, kStart));
+    CHECK(t.allow(2, kStart));
+    CHECK(!t.allow(3, kStart));
+    uint64_t clients = 0;
+    t.forEachClient([&](const ThrottleCounters&) { ++clients; });
+    CHECK(clients == 2);
+}
+
+int main() {
+    testBurst();
+    testRefill();
+    testClientsIndependent();
+    testTableFull();
+
+    std::cout << (failures == 0 ? "PASS" : "FAIL") << std::endl;
+    return failures == 0 ? 0 : 1;
+}